@@ -0,0 +1,460 @@
+//
+// Microbenchmarks of individual SPERR pipeline stages, built with Google Benchmark.
+//
+// Throughput of every stage is reported as "GB/s" of the equivalent single-precision input,
+//    i.e., 4 bytes per value, so numbers from different stages are directly comparable.
+//    This rate is shown as the "GB" counter (and also as "bytes_per_second").
+//
+// To produce a JSON report for regression tracking:
+//    ./sperr_benchmark --benchmark_out=sperr_benchmark.json --benchmark_out_format=json
+//
+// Volumes in `test_data` are read from "../test_data/"; synthetic fields are generated.
+//
+
+#include "CDF97.h"
+#include "Conditioner.h"
+#include "Outlier_Coder.h"
+#include "SPECK2D_INT_DEC.h"
+#include "SPECK2D_INT_ENC.h"
+#include "SPECK3D_FLT.h"
+#include "SPECK3D_INT_DEC.h"
+#include "SPECK3D_INT_ENC.h"
+#include "SPERR3D_OMP_C.h"
+#include "SPERR3D_OMP_D.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+// Chunk shapes to sweep. The first two use dyadic wavelet decomposition, and the last two
+//    use wavelet packet decomposition (see `sperr::can_use_dyadic()`).
+const auto chunk_shapes = std::array<sperr::dims_type, 4>{sperr::dims_type{64, 64, 64},
+                                                          sperr::dims_type{128, 128, 128},
+                                                          sperr::dims_type{128, 128, 16},
+                                                          sperr::dims_type{256, 64, 16}};
+
+void set_throughput(benchmark::State& state, size_t num_vals)
+{
+  const auto bytes = int64_t(num_vals * sizeof(float));
+  state.SetBytesProcessed(int64_t(state.iterations()) * bytes);
+  state.counters["GB"] =
+      benchmark::Counter(double(bytes) * 1e-9, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+auto set_shape_label(benchmark::State& state, sperr::dims_type dims)
+{
+  auto label = std::to_string(dims[0]) + "x" + std::to_string(dims[1]) + "x" +
+               std::to_string(dims[2]);
+  label += sperr::can_use_dyadic(dims) ? "-dyadic" : "-packet";
+  state.SetLabel(label);
+}
+
+// A smooth field with some noise, which resembles many scientific data sets.
+auto synthetic_field(sperr::dims_type dims) -> sperr::vecd_type
+{
+  auto gen = std::mt19937{1234};
+  auto noise = std::normal_distribution<double>{0.0, 0.01};
+  auto field = sperr::vecd_type(dims[0] * dims[1] * dims[2]);
+  size_t idx = 0;
+  for (size_t z = 0; z < dims[2]; z++)
+    for (size_t y = 0; y < dims[1]; y++)
+      for (size_t x = 0; x < dims[0]; x++) {
+        const auto fx = double(x) / double(dims[0]);
+        const auto fy = double(y) / double(dims[1]);
+        const auto fz = double(z) / double(dims[2]);
+        field[idx++] = std::sin(6.0 * fx) * std::cos(4.0 * fy) + std::exp(fz) + noise(gen);
+      }
+  return field;
+}
+
+// Random integer coefficients that use (most of) the bitplanes of type T, with signs.
+template <typename T>
+auto random_coeffs(size_t len) -> std::pair<std::vector<T>, sperr::Bitmask>
+{
+  auto gen = std::mt19937{5678};
+  const auto stddev = std::min(double(std::numeric_limits<T>::max()) / 8.0, 1e15);
+  auto dist = std::normal_distribution<double>{0.0, stddev};
+
+  auto coeffs = std::vector<T>(len);
+  auto signs = sperr::Bitmask(len);
+  signs.reset_true();
+  for (size_t i = 0; i < len; i++) {
+    const auto v = dist(gen);
+    coeffs[i] = static_cast<T>(std::min(std::abs(v), double(std::numeric_limits<T>::max())));
+    signs.wbit(i, v >= 0.0);
+  }
+  return {std::move(coeffs), std::move(signs)};
+}
+
+// Exposes the quantization step of SPECK_FLT, which is otherwise internal.
+class Quantizer : public sperr::SPECK3D_FLT {
+ public:
+  auto quantize(double q) -> sperr::RTNType
+  {
+    m_q = q;
+    return m_midtread_quantize();
+  }
+  void set_vals(const sperr::vecd_type& vals) { m_vals_d = vals; }
+};
+
+//
+// Wavelet transforms
+//
+void BM_DWT3D(benchmark::State& state)
+{
+  const auto dims = chunk_shapes[state.range(0)];
+  const auto field = synthetic_field(dims);
+  auto cdf = sperr::CDF97();
+  for (auto _ : state) {
+    state.PauseTiming();
+    cdf.copy_data(field.data(), field.size(), dims);
+    state.ResumeTiming();
+    cdf.dwt3d();
+    benchmark::DoNotOptimize(cdf.view_data().data());
+  }
+  set_throughput(state, field.size());
+  set_shape_label(state, dims);
+}
+BENCHMARK(BM_DWT3D)->DenseRange(0, chunk_shapes.size() - 1)->Unit(benchmark::kMillisecond);
+
+void BM_IDWT3D(benchmark::State& state)
+{
+  const auto dims = chunk_shapes[state.range(0)];
+  auto cdf = sperr::CDF97();
+  cdf.take_data(synthetic_field(dims), dims);
+  cdf.dwt3d();
+  const auto coeffs = cdf.view_data();
+  for (auto _ : state) {
+    state.PauseTiming();
+    cdf.copy_data(coeffs.data(), coeffs.size(), dims);
+    state.ResumeTiming();
+    cdf.idwt3d();
+    benchmark::DoNotOptimize(cdf.view_data().data());
+  }
+  set_throughput(state, coeffs.size());
+  set_shape_label(state, dims);
+}
+BENCHMARK(BM_IDWT3D)->DenseRange(0, chunk_shapes.size() - 1)->Unit(benchmark::kMillisecond);
+
+//
+// Conditioner
+//
+void BM_Conditioner(benchmark::State& state)
+{
+  const auto dims = chunk_shapes[state.range(0)];
+  auto field = synthetic_field(dims);
+  auto condi = sperr::Conditioner();
+  for (auto _ : state) {
+    auto header = condi.condition(field, dims);
+    condi.inverse_condition(field, dims, header);
+    benchmark::DoNotOptimize(field.data());
+  }
+  set_throughput(state, field.size());
+  set_shape_label(state, dims);
+}
+BENCHMARK(BM_Conditioner)->DenseRange(0, chunk_shapes.size() - 1)->Unit(benchmark::kMillisecond);
+
+//
+// Quantization, with the integer width (8, 16, 32, or 64 bits) as an argument.
+//
+void BM_Quantize(benchmark::State& state)
+{
+  const auto dims = chunk_shapes[0];
+  auto cdf = sperr::CDF97();
+  cdf.take_data(synthetic_field(dims), dims);
+  cdf.dwt3d();
+  const auto coeffs = cdf.view_data();
+  const auto maxabs = std::abs(*std::max_element(
+      coeffs.cbegin(), coeffs.cend(), [](auto a, auto b) { return std::abs(a) < std::abs(b); }));
+  const auto bits = state.range(0);
+  const auto q = maxabs / std::min(std::exp2(double(bits)) - 1.0, 1e15);
+
+  auto quantizer = Quantizer();
+  for (auto _ : state) {
+    state.PauseTiming();
+    quantizer.set_vals(coeffs);
+    state.ResumeTiming();
+    auto rtn = quantizer.quantize(q);
+    benchmark::DoNotOptimize(rtn);
+  }
+  set_throughput(state, coeffs.size());
+}
+BENCHMARK(BM_Quantize)->RangeMultiplier(2)->Range(8, 64)->Unit(benchmark::kMillisecond);
+
+//
+// Integer SPECK3D encoding and decoding, with bit-per-value budgets as an argument.
+//    A budget of 0 means no budget, i.e., encoding all bitplanes.
+//
+template <typename T>
+void BM_SPECK3D_INT_Encode(benchmark::State& state)
+{
+  const auto dims = chunk_shapes[0];
+  const auto len = dims[0] * dims[1] * dims[2];
+  const auto [coeffs, signs] = random_coeffs<T>(len);
+  auto encoder = sperr::SPECK3D_INT_ENC<T>();
+  encoder.set_dims(dims);
+  encoder.set_budget(size_t(state.range(0)) * len);
+  for (auto _ : state) {
+    state.PauseTiming();
+    encoder.use_coeffs(coeffs, signs);
+    state.ResumeTiming();
+    encoder.encode();
+  }
+  set_throughput(state, len);
+}
+BENCHMARK_TEMPLATE(BM_SPECK3D_INT_Encode, uint8_t)->Arg(0)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SPECK3D_INT_Encode, uint16_t)->Arg(0)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SPECK3D_INT_Encode, uint32_t)
+    ->Arg(2)
+    ->Arg(8)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SPECK3D_INT_Encode, uint64_t)
+    ->Arg(2)
+    ->Arg(8)
+    ->Arg(32)
+    ->Unit(benchmark::kMillisecond);
+
+template <typename T>
+void BM_SPECK3D_INT_Decode(benchmark::State& state)
+{
+  const auto dims = chunk_shapes[0];
+  const auto len = dims[0] * dims[1] * dims[2];
+  auto [coeffs, signs] = random_coeffs<T>(len);
+  auto encoder = sperr::SPECK3D_INT_ENC<T>();
+  encoder.set_dims(dims);
+  encoder.set_budget(size_t(state.range(0)) * len);
+  encoder.use_coeffs(std::move(coeffs), std::move(signs));
+  encoder.encode();
+  auto stream = sperr::vec8_type();
+  encoder.append_encoded_bitstream(stream);
+
+  auto decoder = sperr::SPECK3D_INT_DEC<T>();
+  decoder.set_dims(dims);
+  for (auto _ : state) {
+    decoder.use_bitstream(stream.data(), stream.size());
+    decoder.decode();
+    benchmark::DoNotOptimize(decoder.view_coeffs().data());
+  }
+  set_throughput(state, len);
+}
+BENCHMARK_TEMPLATE(BM_SPECK3D_INT_Decode, uint8_t)->Arg(0)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SPECK3D_INT_Decode, uint16_t)->Arg(0)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SPECK3D_INT_Decode, uint32_t)
+    ->Arg(2)
+    ->Arg(8)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_SPECK3D_INT_Decode, uint64_t)
+    ->Arg(2)
+    ->Arg(8)
+    ->Arg(32)
+    ->Unit(benchmark::kMillisecond);
+
+//
+// Integer SPECK2D encoding and decoding of a 512x512 slice, with the same budgets as above.
+//
+template <typename T>
+void BM_SPECK2D_INT_Encode(benchmark::State& state)
+{
+  const auto dims = sperr::dims_type{512, 512, 1};
+  const auto len = dims[0] * dims[1];
+  const auto [coeffs, signs] = random_coeffs<T>(len);
+  auto encoder = sperr::SPECK2D_INT_ENC<T>();
+  encoder.set_dims(dims);
+  encoder.set_budget(size_t(state.range(0)) * len);
+  for (auto _ : state) {
+    state.PauseTiming();
+    encoder.use_coeffs(coeffs, signs);
+    state.ResumeTiming();
+    encoder.encode();
+  }
+  set_throughput(state, len);
+}
+BENCHMARK_TEMPLATE(BM_SPECK2D_INT_Encode, uint32_t)
+    ->Arg(2)
+    ->Arg(8)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond);
+
+template <typename T>
+void BM_SPECK2D_INT_Decode(benchmark::State& state)
+{
+  const auto dims = sperr::dims_type{512, 512, 1};
+  const auto len = dims[0] * dims[1];
+  auto [coeffs, signs] = random_coeffs<T>(len);
+  auto encoder = sperr::SPECK2D_INT_ENC<T>();
+  encoder.set_dims(dims);
+  encoder.set_budget(size_t(state.range(0)) * len);
+  encoder.use_coeffs(std::move(coeffs), std::move(signs));
+  encoder.encode();
+  auto stream = sperr::vec8_type();
+  encoder.append_encoded_bitstream(stream);
+
+  auto decoder = sperr::SPECK2D_INT_DEC<T>();
+  decoder.set_dims(dims);
+  for (auto _ : state) {
+    decoder.use_bitstream(stream.data(), stream.size());
+    decoder.decode();
+    benchmark::DoNotOptimize(decoder.view_coeffs().data());
+  }
+  set_throughput(state, len);
+}
+BENCHMARK_TEMPLATE(BM_SPECK2D_INT_Decode, uint32_t)
+    ->Arg(2)
+    ->Arg(8)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond);
+
+//
+// Outlier coding, with the percentage of outliers as an argument.
+//
+auto random_outliers(size_t len, double tol, size_t pct) -> std::vector<sperr::Outlier>
+{
+  auto gen = std::mt19937{910};
+  auto pos = std::uniform_int_distribution<size_t>{0, 99};
+  auto err = std::uniform_real_distribution<double>{1.01 * tol, 4.0 * tol};
+  auto sign = std::bernoulli_distribution{0.5};
+  auto LOS = std::vector<sperr::Outlier>();
+  for (size_t i = 0; i < len; i++)
+    if (pos(gen) < pct)
+      LOS.emplace_back(i, sign(gen) ? err(gen) : -err(gen));
+  return LOS;
+}
+
+void BM_Outlier_Encode(benchmark::State& state)
+{
+  const auto len = size_t{64 * 64 * 64};
+  const auto tol = 0.1;
+  const auto LOS = random_outliers(len, tol, state.range(0));
+  auto coder = sperr::Outlier_Coder();
+  coder.set_length(len);
+  coder.set_tolerance(tol);
+  for (auto _ : state) {
+    state.PauseTiming();
+    coder.use_outlier_list(LOS);
+    state.ResumeTiming();
+    coder.encode();
+  }
+  set_throughput(state, len);
+}
+BENCHMARK(BM_Outlier_Encode)->Arg(1)->Arg(5)->Arg(20)->Unit(benchmark::kMillisecond);
+
+void BM_Outlier_Decode(benchmark::State& state)
+{
+  const auto len = size_t{64 * 64 * 64};
+  const auto tol = 0.1;
+  auto coder = sperr::Outlier_Coder();
+  coder.set_length(len);
+  coder.set_tolerance(tol);
+  coder.use_outlier_list(random_outliers(len, tol, state.range(0)));
+  coder.encode();
+  auto stream = sperr::vec8_type();
+  coder.append_encoded_bitstream(stream);
+
+  for (auto _ : state) {
+    coder.use_bitstream(stream.data(), stream.size());
+    coder.decode();
+    benchmark::DoNotOptimize(coder.view_outlier_list().data());
+  }
+  set_throughput(state, len);
+}
+BENCHMARK(BM_Outlier_Decode)->Arg(1)->Arg(5)->Arg(20)->Unit(benchmark::kMillisecond);
+
+//
+// SPERR3D_OMP_C/D drivers on a real volume, with arguments of
+//    {chunk shape index, bit-per-value, number of threads}.
+//
+auto read_volume() -> std::vector<float>
+{
+  return sperr::read_whole_file<float>("../test_data/wmag128.float");
+}
+const auto volume_dims = sperr::dims_type{128, 128, 128};
+
+void driver_args(benchmark::internal::Benchmark* b)
+{
+  for (int64_t shape : {0, 2})
+    for (int64_t bpp : {1, 4})
+      for (int64_t threads : {1, 2, 4, 8})
+        b->Args({shape, bpp, threads});
+}
+
+void BM_SPERR3D_OMP_C(benchmark::State& state)
+{
+  const auto vol = read_volume();
+  if (vol.size() != volume_dims[0] * volume_dims[1] * volume_dims[2]) {
+    state.SkipWithError("Cannot read ../test_data/wmag128.float");
+    return;
+  }
+  const auto chunks = chunk_shapes[state.range(0)];
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(volume_dims, chunks);
+  encoder.set_bitrate(double(state.range(1)));
+  encoder.set_num_threads(state.range(2));
+  for (auto _ : state) {
+    auto rtn = encoder.compress(vol.data(), vol.size());
+    benchmark::DoNotOptimize(rtn);
+  }
+  set_throughput(state, vol.size());
+  set_shape_label(state, chunks);
+}
+BENCHMARK(BM_SPERR3D_OMP_C)->Apply(driver_args)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+void BM_SPERR3D_OMP_D(benchmark::State& state)
+{
+  const auto vol = read_volume();
+  if (vol.size() != volume_dims[0] * volume_dims[1] * volume_dims[2]) {
+    state.SkipWithError("Cannot read ../test_data/wmag128.float");
+    return;
+  }
+  const auto chunks = chunk_shapes[state.range(0)];
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(volume_dims, chunks);
+  encoder.set_bitrate(double(state.range(1)));
+  encoder.set_num_threads(0);
+  encoder.compress(vol.data(), vol.size());
+  const auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(state.range(2));
+  for (auto _ : state) {
+    decoder.use_bitstream(stream.data(), stream.size());
+    auto rtn = decoder.decompress(stream.data());
+    benchmark::DoNotOptimize(rtn);
+  }
+  set_throughput(state, vol.size());
+  set_shape_label(state, chunks);
+}
+BENCHMARK(BM_SPERR3D_OMP_D)->Apply(driver_args)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+//
+// Synthetic field through the same drivers, with {chunk shape index, threads} as arguments.
+//
+void BM_SPERR3D_OMP_Synthetic(benchmark::State& state)
+{
+  const auto dims = sperr::dims_type{256, 256, 128};
+  const auto field = synthetic_field(dims);
+  const auto chunks = chunk_shapes[state.range(0)];
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_tolerance(1e-3);
+  encoder.set_num_threads(state.range(1));
+  for (auto _ : state) {
+    auto rtn = encoder.compress(field.data(), field.size());
+    benchmark::DoNotOptimize(rtn);
+  }
+  set_throughput(state, field.size());
+  set_shape_label(state, chunks);
+}
+BENCHMARK(BM_SPERR3D_OMP_Synthetic)
+    ->ArgsProduct({{0, 1, 2, 3}, {1, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // anonymous namespace
+
+BENCHMARK_MAIN();
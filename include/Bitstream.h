@@ -28,6 +28,13 @@
  *      a Bitstream itself will lose track of how many useful bits are there after flush().
  *   7. Unlike std::vector, a bitstream does NOT have an equivalent concept of "size."
  *      Thus, capacity change brought by `reserve()` can be immediately used to read/write.
+ *   8. view_bitstream() puts a Bitstream in a read-only view mode, where words are read
+ *      directly from the memory provided by the caller instead of being copied over.
+ *      That memory needs to remain valid (and unchanged) as long as reads are performed.
+ *      Bits past the specified number of bits are read as 0's, and the memory pointed to
+ *      is never accessed past ceil(num_bits / 8) bytes.
+ *      A subsequent call to reserve(), reset(), wseek(), or parse_bitstream() ends the
+ *      view mode, and write functions should not be called while in view mode.
  */
 
 #include <cstddef>
@@ -66,6 +73,7 @@ class Bitstream {
   //
   void write_bitstream(void* p, size_t num_bits) const;
   void parse_bitstream(const void* p, size_t num_bits);
+  void view_bitstream(const void* p, size_t num_bits);
   auto get_bitstream(size_t num_bits) const -> std::vector<std::byte>;
 
  private:
@@ -74,6 +82,14 @@ class Bitstream {
 
   std::vector<uint64_t>::iterator m_itr;  // Iterator to the next word to be read/written.
   std::vector<uint64_t> m_buf;
+
+  // Data members for the read-only view mode.
+  const std::byte* m_view = nullptr;  // Memory provided by the caller; nullptr if not viewing.
+  size_t m_view_bits = 0;             // Number of useful bits in `m_view`.
+  size_t m_view_idx = 0;              // Index of the next word to be read from `m_view`.
+
+  // Retrieve the idx-th word from `m_view`, with zeros padded past `m_view_bits`.
+  auto m_view_word(size_t idx) const -> uint64_t;
 };
 
 };  // namespace sperr
@@ -32,6 +32,7 @@ class CDF97 {
   auto view_data() const -> const vecd_type&;
   auto release_data() -> vecd_type&&;
   auto get_dims() const -> std::array<size_t, 3>;  // In 2D case, the 3rd value equals 1.
+  auto memory_usage() const -> size_t;             // Bytes held by internal buffers.
 
   //
   // Action items
@@ -19,6 +19,12 @@ class Conditioner {
 
   auto is_constant(uint8_t) const -> bool;
 
+  // The header of a constant field of `nval` values of `val`, the same as `condition()` produces.
+  auto constant_header(double val, size_t nval) const -> condi_type;
+
+  // Retrieve the mean subtracted from the data, or the value of a constant field.
+  auto retrieve_mean(condi_type header) const -> double;
+
   // Save a double to the last 8 bytes of a condi_type.
   void save_q(condi_type& header, double q) const;
   auto retrieve_q(condi_type header) const -> double;
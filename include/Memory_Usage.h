@@ -0,0 +1,57 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+//
+// Accounting of the memory held by the major buffers of the compression and decompression
+//    pipelines. Numbers are reported in bytes by component, both as the current value and as the
+//    peak value since the accounting object was created (or reset).
+//
+// Note: the numbers reflect the capacity of the buffers that SPERR allocates; they don't include
+//    memory owned by the caller, or small objects and allocator overhead.
+//
+
+#include "sperr_helper.h"
+
+namespace sperr {
+
+enum class MemComp : unsigned char {
+  Coeffs,     // floating-point values, e.g., a chunk of input data or its wavelet coefficients
+  Original,   // a copy of the original values (PWE mode)
+  Quantized,  // quantized integers and their signs
+  Wavelet,    // buffers internal to the wavelet transform
+  Speck,      // buffers internal to the SPECK coder: coefficients, LIS, bitmasks, bitstream
+  Outlier,    // buffers internal to the outlier coder
+  Output,     // encoded bitstreams, or a decoded volume
+  NumComps    // Not a real component; keep it the last one.
+};
+
+class Memory_Usage {
+ public:
+  // Record the current number of bytes held by a component, or by all components at once,
+  //    and update peak values. Use the latter when buffers are moved between components.
+  void set_current(MemComp, size_t bytes);
+  void set_current(const std::array<size_t, size_t(MemComp::NumComps)>& bytes);
+
+  // Accumulate another record, whose buffers are assumed to be alive at the same time as
+  //    buffers of this record (e.g., they belong to another thread). Both current and peak
+  //    values are summed, so the aggregated peak values are upper bounds.
+  void merge(const Memory_Usage&);
+  void reset();
+
+  auto current(MemComp) const -> size_t;
+  auto peak(MemComp) const -> size_t;
+  auto current_total() const -> size_t;
+  auto peak_total() const -> size_t;
+
+  // A human-readable breakdown of all components.
+  auto to_string() const -> std::string;
+
+ private:
+  std::array<size_t, size_t(MemComp::NumComps)> m_current = {};
+  std::array<size_t, size_t(MemComp::NumComps)> m_peak = {};
+  size_t m_peak_total = 0;
+};
+
+};  // namespace sperr
+
+#endif
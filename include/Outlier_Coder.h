@@ -34,7 +34,10 @@ class Outlier_Coder {
   //
   auto view_outlier_list() const -> const std::vector<Outlier>&;
   void append_encoded_bitstream(vec8_type& buf) const;
+  auto encoded_bitstream_len() const -> size_t;
+  void write_encoded_bitstream(void* p) const;  // Writes `encoded_bitstream_len()` bytes.
   auto get_stream_full_len(const void*) const -> size_t;
+  auto memory_usage() const -> size_t;  // Bytes held by internal buffers.
 
   //
   // Action items
@@ -0,0 +1,109 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+//
+// Optional instrumentation of the compression and decompression pipelines.
+//
+// When SPERR is configured with SPERR_INSTRUMENT=ON, each stage records its wall time and the
+//    number of bytes it touches, and the SPECK and outlier coders record a few counters.
+//    When it's OFF (default), the macros below expand to nothing, and a Profile object
+//    simply stays empty.
+//
+
+#include "sperr_helper.h"
+
+#include <chrono>
+
+namespace sperr {
+
+enum class Stage : unsigned char {
+  ChunkCopy,  // gather a chunk from, or scatter a chunk to, a bigger volume
+  Condition,
+  Wavelet,
+  EstimateQ,
+  Quantize,
+  SpeckSorting,
+  SpeckRefinement,
+  Outlier,
+  InverseQuantize,
+  InverseWavelet,
+  InverseCondition,
+  NumStages  // Not a real stage; keep it the last one.
+};
+
+class Profile {
+ public:
+  // Record info of a stage or the entire operation.
+  void add_time(Stage, double seconds);
+  void add_bytes(Stage, size_t bytes);
+  void set_wall_time(double seconds);
+
+  // Record counters.
+  void add_chunks(size_t);
+  void add_bitplanes(size_t);
+  void add_outliers(size_t);
+  void update_LIS_size(size_t);  // Only the peak value is kept.
+
+  // Accumulate another profile (e.g., of a chunk) to this one. Stage times, bytes, and counters
+  //    are summed, while the peak LIS size and the wall time keep the bigger values.
+  void merge(const Profile&);
+  void reset();
+
+  auto time(Stage) const -> double;
+  auto bytes(Stage) const -> size_t;
+  auto wall_time() const -> double;
+  auto num_chunks() const -> size_t;
+  auto num_bitplanes() const -> size_t;
+  auto num_outliers() const -> size_t;
+  auto peak_LIS_size() const -> size_t;
+
+  // A human-readable breakdown of all stages and counters.
+  auto to_string() const -> std::string;
+
+ private:
+  std::array<double, size_t(Stage::NumStages)> m_times = {};
+  std::array<size_t, size_t(Stage::NumStages)> m_bytes = {};
+  double m_wall_time = 0.0;
+  size_t m_chunks = 0;
+  size_t m_bitplanes = 0;
+  size_t m_outliers = 0;
+  size_t m_peak_LIS = 0;
+};
+
+// Add the time elapsed between its construction and destruction to a stage of a profile,
+//    or record it as the wall time of a profile when no stage is given.
+class Profile_Timer {
+ public:
+  explicit Profile_Timer(Profile* prof);
+  Profile_Timer(Profile* prof, Stage stage, size_t bytes);
+  Profile_Timer(const Profile_Timer&) = delete;
+  Profile_Timer& operator=(const Profile_Timer&) = delete;
+  ~Profile_Timer();
+
+ private:
+  Profile* m_prof = nullptr;
+  Stage m_stage = Stage::NumStages;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+};  // namespace sperr
+
+#define SPERR_PROFILE_CONCAT_IMPL(a, b) a##b
+#define SPERR_PROFILE_CONCAT(a, b) SPERR_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef SPERR_INSTRUMENT
+// Time the rest of the current scope as `stage`, which touches `bytes` bytes.
+#define SPERR_PROFILE_SCOPE(prof, stage, bytes) \
+  sperr::Profile_Timer SPERR_PROFILE_CONCAT(sperr_profile_timer_, __LINE__)(prof, stage, bytes)
+// Execute a statement (e.g., recording a counter) only when instrumentation is compiled in.
+#define SPERR_PROFILE_EXEC(statement) statement
+// Record the rest of the current scope as the wall time of a profile.
+#define SPERR_PROFILE_WALL(prof) \
+  sperr::Profile_Timer SPERR_PROFILE_CONCAT(sperr_profile_wall_, __LINE__)(prof)
+#else
+#define SPERR_PROFILE_SCOPE(prof, stage, bytes)
+#define SPERR_PROFILE_EXEC(statement)
+#define SPERR_PROFILE_WALL(prof)
+#endif
+
+#endif
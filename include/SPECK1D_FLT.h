@@ -12,6 +12,7 @@ class SPECK1D_FLT : public SPECK_FLT {
 
   void m_wavelet_xform() override;
   void m_inverse_wavelet_xform(bool) override;
+  auto m_lowest_subband() const -> std::tuple<dims_type, size_t> override;
 };
 
 };  // namespace sperr
@@ -44,6 +44,9 @@ class Set1D {
 //
 template <typename T>
 class SPECK1D_INT : public SPECK_INT<T> {
+ public:
+  auto memory_usage() const -> size_t override;
+
  protected:
   //
   // Bring members from the base class to this derived class.
@@ -59,6 +62,7 @@ class SPECK1D_INT : public SPECK_INT<T> {
   //    during decoding/encoding, so they're implemented in their respective subclasses.
   //
   void m_clean_LIS() final;
+  auto m_LIS_size() const -> size_t final;
   void m_initialize_lists() final;
 
   auto m_partition_set(Set1D) const -> std::array<Set1D, 2>;
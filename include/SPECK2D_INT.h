@@ -12,6 +12,7 @@ class Set2D {
   uint32_t length_x = 0;
   uint32_t length_y = 0;
   uint16_t part_level = 0;
+  uint32_t morton = 0;  // Offset of this set in the morton order of the encoder.
 
  public:
   auto is_pixel() const -> bool { return (size_t{length_x} * length_y == 1); };
@@ -21,9 +22,14 @@ class Set2D {
 
 //
 // Main SPECK2D_INT class; intended to be the base class of both encoder and decoder.
+//    The encoder or decoder passes itself in as `Derived`, so the per-set and per-pixel
+//    procedures it implements are called without virtual dispatch and can be inlined.
 //
-template <typename T>
+template <typename T, typename Derived>
 class SPECK2D_INT : public SPECK_INT<T> {
+ public:
+  auto memory_usage() const -> size_t override;
+
  protected:
   //
   // Bring members from the base class to this derived class.
@@ -36,15 +42,21 @@ class SPECK2D_INT : public SPECK_INT<T> {
 
   void m_sorting_pass() final;
   void m_clean_LIS() final;
+  auto m_LIS_size() const -> size_t final;
   void m_initialize_lists() final;
 
   void m_code_S(size_t idx1, size_t idx2);
   void m_code_I();
 
-  virtual void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool need_decide) = 0;
-  virtual void m_process_P(size_t idx, size_t& counter, bool need_decide) = 0;
-  virtual void m_process_I(bool need_decide) = 0;
+  // `Derived` implements the following procedures:
+  //    void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool need_decide);
+  //    void m_process_P(size_t idx, size_t& counter, bool need_decide);
+  //    void m_process_I(bool need_decide);
+  //    void m_additional_initialization();
+  auto m_derived() -> Derived& { return static_cast<Derived&>(*this); }
 
+  // Subsets occupy consecutive ranges of their parent's morton range, in the order returned.
+  //    `m_I` is always the last range, following the subsets partitioned from it.
   auto m_partition_S(Set2D) const -> std::array<Set2D, 4>;
   auto m_partition_I() -> std::array<Set2D, 3>;
 
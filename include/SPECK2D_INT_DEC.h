@@ -9,7 +9,7 @@ namespace sperr {
 // Main SPECK2D_INT_DEC class
 //
 template <typename T>
-class SPECK2D_INT_DEC final : public SPECK2D_INT<T> {
+class SPECK2D_INT_DEC final : public SPECK2D_INT<T, SPECK2D_INT_DEC<T>> {
  private:
   //
   // Bring members from parent classes to this derived class.
@@ -19,14 +19,17 @@ class SPECK2D_INT_DEC final : public SPECK2D_INT<T> {
   using SPECK_INT<T>::m_LSP_new;
   using SPECK_INT<T>::m_bit_buffer;
   using SPECK_INT<T>::m_sign_array;
-  using SPECK2D_INT<T>::m_LIS;
-  using SPECK2D_INT<T>::m_I;
-  using SPECK2D_INT<T>::m_code_S;
-  using SPECK2D_INT<T>::m_code_I;
+  using SPECK2D_INT<T, SPECK2D_INT_DEC<T>>::m_LIS;
+  using SPECK2D_INT<T, SPECK2D_INT_DEC<T>>::m_I;
+  using SPECK2D_INT<T, SPECK2D_INT_DEC<T>>::m_code_S;
+  using SPECK2D_INT<T, SPECK2D_INT_DEC<T>>::m_code_I;
 
-  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool need_decide) final;
-  void m_process_P(size_t idx, size_t& counter, bool need_decide) final;
-  void m_process_I(bool need_decide) final;
+  // The base class calls the following procedures directly.
+  friend class SPECK2D_INT<T, SPECK2D_INT_DEC<T>>;
+  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool need_decide);
+  void m_process_P(size_t idx, size_t& counter, bool need_decide);
+  void m_process_I(bool need_decide);
+  void m_additional_initialization() {}  // empty function
 };
 
 };  // namespace sperr
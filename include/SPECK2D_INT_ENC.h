@@ -3,14 +3,39 @@
 
 #include "SPECK2D_INT.h"
 
+#include <memory>
+
 namespace sperr {
 
+//
+// The morton order that the encoder copies coefficients in: the coefficient at raster index `i`
+//    goes to position `dest[i]`. Same as `Morton_Order3D`, it depends only on the dimensions,
+//    so it's computed once per dimension and shared by all encoders.
+//
+struct Morton_Order2D {
+  dims_type dims = {0, 0, 0};
+  std::vector<uint32_t> dest;
+};
+
 //
 // Main SPECK2D_INT_ENC class
 //
 template <typename T>
-class SPECK2D_INT_ENC final : public SPECK2D_INT<T> {
+class SPECK2D_INT_ENC final : public SPECK2D_INT<T, SPECK2D_INT_ENC<T>> {
+ public:
+  auto memory_usage() const -> size_t override;
+
+  // Optional: turn off the morton-ordered copy, which is on by default, and test sets in raster
+  //    order instead. Either way produces the same bitstream.
+  void set_morton_layout(bool);
+
  private:
+  //
+  // Consistant with the base class.
+  //
+  using uint_type = T;
+  using vecui_type = std::vector<uint_type>;
+
   //
   // Bring members from parent classes to this derived class.
   //
@@ -21,14 +46,34 @@ class SPECK2D_INT_ENC final : public SPECK2D_INT<T> {
   using SPECK_INT<T>::m_coeff_buf;
   using SPECK_INT<T>::m_bit_buffer;
   using SPECK_INT<T>::m_sign_array;
-  using SPECK2D_INT<T>::m_LIS;
-  using SPECK2D_INT<T>::m_I;
-  using SPECK2D_INT<T>::m_code_S;
-  using SPECK2D_INT<T>::m_code_I;
-
-  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool need_decide) final;
-  void m_process_P(size_t idx, size_t& counter, bool need_decide) final;
-  void m_process_I(bool need_decide) final;
+  using SPECK2D_INT<T, SPECK2D_INT_ENC<T>>::m_LIS;
+  using SPECK2D_INT<T, SPECK2D_INT_ENC<T>>::m_I;
+  using SPECK2D_INT<T, SPECK2D_INT_ENC<T>>::m_code_S;
+  using SPECK2D_INT<T, SPECK2D_INT_ENC<T>>::m_code_I;
+  using SPECK2D_INT<T, SPECK2D_INT_ENC<T>>::m_partition_S;
+  using SPECK2D_INT<T, SPECK2D_INT_ENC<T>>::m_partition_I;
+
+  // The base class calls the following procedures directly.
+  friend class SPECK2D_INT<T, SPECK2D_INT_ENC<T>>;
+  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool need_decide);
+  void m_process_P(size_t idx, size_t& counter, bool need_decide);
+  void m_process_I(bool need_decide);
+  void m_additional_initialization();
+  void m_release_encoding_buffers() override;
+
+  // Data structures and functions for morton data layout: a copy of the coefficients where every
+  //    set, including `m_I`, occupies a contiguous range, and the maximum of every `m_block_len`
+  //    values of the copy. The copy stays unchanged during encoding, so a set is tested by the
+  //    maxima of the blocks it covers, plus the values of the partial blocks at its two ends.
+  //    Slices with 2^32 or more values are tested in raster order instead.
+  static constexpr size_t m_block_len = 64;
+  bool m_morton_layout = true;
+  vecui_type m_morton_buf;
+  vecui_type m_block_max;
+  std::shared_ptr<const Morton_Order2D> m_order;
+  auto m_build_order() -> std::shared_ptr<const Morton_Order2D>;
+  void m_record_set(const Set2D&, std::vector<uint32_t>& dest) const;
+  auto m_any_significant(size_t first, size_t len) const -> bool;
 
   auto m_decide_S_significance(const Set2D&) const -> bool;
   auto m_decide_I_significance() const -> bool;
@@ -1,6 +1,7 @@
 #ifndef SPECK3D_FLT_H
 #define SPECK3D_FLT_H
 
+#include "SPECK3D_INT_ENC.h"
 #include "SPECK_FLT.h"
 
 namespace sperr {
@@ -12,6 +13,11 @@ class SPECK3D_FLT : public SPECK_FLT {
 
   void m_wavelet_xform() override;
   void m_inverse_wavelet_xform(bool) override;
+  auto m_lowest_subband() const -> std::tuple<dims_type, size_t> override;
+
+  // Quantize directly into the morton order of the 3D encoder.
+  auto m_quantization_order() -> const uint32_t* override;
+  std::shared_ptr<const Morton_Order3D> m_order;
 };
 
 };  // namespace sperr
@@ -3,16 +3,13 @@
 
 #include "SPECK_INT.h"
 
-#include <cstring>  // std::memcpy()
 #include <tuple>
 
 namespace sperr {
 
 class Set3D {
  private:
-  // The first 6 bytes of the morton offset in uint64_t. Because each set dimension is
-  // stored using 16-bit integers, these 48 bits are big enough too!
-  std::array<uint8_t, 6> m_morton = {0, 0, 0, 0, 0, 0};
+  uint64_t m_morton = 0;
 
  public:
   //
@@ -29,22 +26,88 @@ class Set3D {
   //
   // Member functions (intended to be inline)
   //
-  auto get_morton() const -> uint64_t
-  {
-    auto tmp = uint64_t{0};
-    std::memcpy(&tmp, m_morton.data(), sizeof(m_morton));
-    return tmp;
-  }
-  void set_morton(uint64_t val) { std::memcpy(m_morton.data(), &val, sizeof(m_morton)); }
+  auto get_morton() const -> uint64_t { return m_morton; }
+  void set_morton(uint64_t val) { m_morton = val; }
   void make_empty() { length_x = 0; }
   auto num_elem() const -> size_t { return (size_t{length_x} * length_y * length_z); }
 };
 
+//
+// A list of sets stored as a structure of arrays, so that passes over the LIS only stream
+//    through the fields they need. E.g., the encoder's significance test reads the morton
+//    offsets and lengths, but never the starting coordinates.
+//
+class SetList3D {
+ private:
+  std::vector<uint64_t> m_morton;
+  std::vector<std::array<uint16_t, 3>> m_start;
+  std::vector<std::array<uint16_t, 3>> m_length;
+
+ public:
+  auto size() const -> size_t { return m_morton.size(); }
+  auto get(size_t i) const -> Set3D
+  {
+    auto set = Set3D();
+    set.set_morton(m_morton[i]);
+    set.start_x = m_start[i][0];
+    set.start_y = m_start[i][1];
+    set.start_z = m_start[i][2];
+    set.length_x = m_length[i][0];
+    set.length_y = m_length[i][1];
+    set.length_z = m_length[i][2];
+    return set;
+  }
+  void push_back(const Set3D& set)
+  {
+    m_morton.push_back(set.get_morton());
+    m_start.push_back({set.start_x, set.start_y, set.start_z});
+    m_length.push_back({set.length_x, set.length_y, set.length_z});
+  }
+  auto morton(size_t i) const -> uint64_t { return m_morton[i]; }
+  void set_morton(size_t i, uint64_t val) { m_morton[i] = val; }
+  auto num_elem(size_t i) const -> size_t
+  {
+    return size_t{m_length[i][0]} * m_length[i][1] * m_length[i][2];
+  }
+  void make_empty(size_t i) { m_length[i][0] = 0; }
+
+  void clear();
+  void insert_front(const Set3D&);
+  void remove_empty();
+  auto memory_usage() const -> size_t;
+};
+
+//
+// Helpers for volumes that are cubes with a power-of-two edge length (e.g., 64^3, 128^3).
+//    Every set in such a volume partitions evenly down to single voxels, so the morton offset
+//    of a set is exactly the Morton code of its starting coordinate (x in the lowest bit).
+//
+constexpr auto morton_spread_3d(uint32_t v) -> uint64_t
+{
+  auto code = uint64_t{0};
+  for (size_t i = 0; i < 16; i++)
+    code |= uint64_t((v >> i) & 1u) << (3 * i);
+  return code;
+}
+constexpr auto morton_code_3d(uint32_t x, uint32_t y, uint32_t z) -> uint64_t
+{
+  return morton_spread_3d(x) | (morton_spread_3d(y) << 1) | (morton_spread_3d(z) << 2);
+}
+
 //
 // Main SPECK3D_INT class; intended to be the base class of both encoder and decoder.
+//    The encoder or decoder passes itself in as `Derived`, so the per-set and per-pixel
+//    procedures it implements are called without virtual dispatch and can be inlined.
 //
-template <typename T>
+template <typename T, typename Derived>
 class SPECK3D_INT : public SPECK_INT<T> {
+ public:
+  auto memory_usage() const -> size_t override;
+
+  // Optional: turn off the specialized paths for power-of-two cubes, which are on by default.
+  //    Either way produces the same bitstream.
+  void set_cube_paths(bool);
+
  protected:
   //
   // Bring members from the base class to this derived class.
@@ -58,13 +121,18 @@ class SPECK3D_INT : public SPECK_INT<T> {
   void m_initialize_lists() final;
   void m_sorting_pass() final;
   void m_clean_LIS() final;
+  auto m_LIS_size() const -> size_t final;
 
-  virtual void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool) = 0;
-  virtual void m_process_P(size_t i, size_t m, size_t& c, bool) = 0;  // Called by `m_code_S()`.
-  virtual void m_process_P_lite(size_t idx) = 0;  // Called by `m_sorting_pass()` directly.
-  virtual void m_additional_initialization() = 0;
+  // `Derived` implements the following procedures:
+  //    void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool);
+  //    void m_process_P(size_t idx, size_t morton, size_t& counter, bool);  // By `m_code_S()`.
+  //    void m_process_P_lite(size_t idx);  // Called by `m_sorting_pass()` directly.
+  //    void m_additional_initialization();
+  auto m_derived() -> Derived& { return static_cast<Derived&>(*this); }
 
   void m_code_S(size_t idx1, size_t idx2);
+  template <size_t Log2Edge>
+  void m_code_S_cube(size_t idx1, size_t idx2);  // Specialization for power-of-two cubes.
   auto m_partition_S_XYZ(Set3D, uint16_t) const -> std::tuple<std::array<Set3D, 8>, uint16_t>;
   auto m_partition_S_XY(Set3D, uint16_t) const -> std::tuple<std::array<Set3D, 4>, uint16_t>;
   auto m_partition_S_Z(Set3D, uint16_t) const -> std::tuple<std::array<Set3D, 2>, uint16_t>;
@@ -72,7 +140,9 @@ class SPECK3D_INT : public SPECK_INT<T> {
   //
   // SPECK3D_INT specific data members
   //
-  std::vector<std::vector<Set3D>> m_LIS;
+  std::vector<SetList3D> m_LIS;
+  size_t m_cube_log2 = 0;  // log2 of the edge length of a power-of-two cube, 0 otherwise.
+  bool m_cube_paths = true;
 };
 
 };  // namespace sperr
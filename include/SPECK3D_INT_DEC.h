@@ -9,7 +9,7 @@ namespace sperr {
 // Main SPECK3D_INT_DEC class
 //
 template <typename T>
-class SPECK3D_INT_DEC final : public SPECK3D_INT<T> {
+class SPECK3D_INT_DEC final : public SPECK3D_INT<T, SPECK3D_INT_DEC<T>> {
  private:
   //
   // Bring members from parent classes to this derived class.
@@ -18,13 +18,15 @@ class SPECK3D_INT_DEC final : public SPECK3D_INT<T> {
   using SPECK_INT<T>::m_LSP_new;
   using SPECK_INT<T>::m_bit_buffer;
   using SPECK_INT<T>::m_sign_array;
-  using SPECK3D_INT<T>::m_LIS;
-  using SPECK3D_INT<T>::m_code_S;
+  using SPECK3D_INT<T, SPECK3D_INT_DEC<T>>::m_LIS;
+  using SPECK3D_INT<T, SPECK3D_INT_DEC<T>>::m_code_S;
 
-  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool read) final;
-  void m_process_P(size_t idx, size_t no_use, size_t& counter, bool read) final;
-  void m_process_P_lite(size_t idx) final;
-  void m_additional_initialization() final{};  // empty function
+  // The base class calls the following procedures directly.
+  friend class SPECK3D_INT<T, SPECK3D_INT_DEC<T>>;
+  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool read);
+  void m_process_P(size_t idx, size_t no_use, size_t& counter, bool read);
+  void m_process_P_lite(size_t idx);
+  void m_additional_initialization() {}  // empty function
 };
 
 };  // namespace sperr
@@ -3,15 +3,32 @@
 
 #include "SPECK3D_INT.h"
 
+#include <memory>
 #include <optional>
 
 namespace sperr {
 
+//
+// The morton order that the encoder keeps coefficients in: the coefficient at raster index `i`
+//    is stored at position `dest[i]`. `cycles` holds one index from each cycle of this
+//    permutation, so that coefficients are re-arranged in place. It depends only on the volume
+//    dimensions, so it's computed once per dimension and shared by all encoders.
+//
+struct Morton_Order3D {
+  dims_type dims = {0, 0, 0};
+  std::vector<uint32_t> dest;
+  std::vector<uint32_t> cycles;
+};
+
+// Retrieve the morton order of a volume, computing it if necessary. It returns an empty pointer
+//    for volumes with 2^32 or more values, which the encoder keeps in raster order.
+auto speck3d_morton_order(dims_type) -> std::shared_ptr<const Morton_Order3D>;
+
 //
 // Main SPECK3D_INT_ENC class
 //
 template <typename T>
-class SPECK3D_INT_ENC final : public SPECK3D_INT<T> {
+class SPECK3D_INT_ENC final : public SPECK3D_INT<T, SPECK3D_INT_ENC<T>> {
  private:
   //
   // Consistant with the base class.
@@ -27,20 +44,32 @@ class SPECK3D_INT_ENC final : public SPECK3D_INT<T> {
   using SPECK_INT<T>::m_LSP_new;
   using SPECK_INT<T>::m_threshold;
   using SPECK_INT<T>::m_coeff_buf;
+  using SPECK_INT<T>::m_coeff_order;
+  using SPECK_INT<T>::m_coeffs_arranged;
   using SPECK_INT<T>::m_bit_buffer;
   using SPECK_INT<T>::m_sign_array;
-  using SPECK3D_INT<T>::m_LIS;
-  using SPECK3D_INT<T>::m_partition_S_XYZ;
-  using SPECK3D_INT<T>::m_code_S;
+  using SPECK3D_INT<T, SPECK3D_INT_ENC<T>>::m_LIS;
+  using SPECK3D_INT<T, SPECK3D_INT_ENC<T>>::m_partition_S_XYZ;
+  using SPECK3D_INT<T, SPECK3D_INT_ENC<T>>::m_code_S;
+  using SPECK3D_INT<T, SPECK3D_INT_ENC<T>>::m_cube_log2;
 
-  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool output) final;
-  void m_process_P(size_t idx, size_t morton, size_t& counter, bool output) final;
-  void m_process_P_lite(size_t idx) final;
-  void m_additional_initialization() final;
+  // The base class calls the following procedures directly.
+  friend class SPECK3D_INT<T, SPECK3D_INT_ENC<T>>;
+  void m_process_S(size_t idx1, size_t idx2, size_t& counter, bool output);
+  void m_process_P(size_t idx, size_t morton, size_t& counter, bool output);
+  void m_process_P_lite(size_t idx);
+  void m_additional_initialization();
 
   // Data structures and functions for morton data layout.
-  vecui_type m_morton_buf;
-  void m_deposit_set(Set3D);
+  //    Volumes with 2^32 or more values are kept in raster order, with `m_order` being empty.
+  friend auto speck3d_morton_order(dims_type) -> std::shared_ptr<const Morton_Order3D>;
+  std::shared_ptr<const Morton_Order3D> m_order;
+  auto m_build_order() const -> std::shared_ptr<const Morton_Order3D>;
+  void m_record_set(Set3D, std::vector<uint32_t>& dest) const;
+
+  // Test if any value of a set is significant, with coefficients in morton or raster order.
+  auto m_any_significant(size_t first, size_t len) const -> bool;
+  auto m_any_significant(const Set3D&) const -> bool;
 };
 
 };  // namespace sperr
@@ -7,13 +7,29 @@
 
 #include "CDF97.h"
 #include "Conditioner.h"
+#include "Memory_Usage.h"
 #include "Outlier_Coder.h"
 #include "SPECK_INT.h"
 
+#include <tuple>
 #include <variant>
 
 namespace sperr {
 
+// Estimated size and distortion of compressing a field, see `SPECK_FLT::estimate()`.
+struct RD_Estimate {
+  double bits = 0.0;  // Total bits of the bitstream.
+  double sse = 0.0;   // Sum of squared errors.
+};
+
+// Caps on the effort of decoding, see `SPECK_FLT::set_decode_effort()`. Zeros mean no cap.
+struct Decode_Effort {
+  size_t bitplanes = 0;       // Maximal number of bitplanes.
+  double bit_fraction = 0.0;  // Fraction of the bits of a bitstream, in (0, 1].
+  double psnr = 0.0;          // Target PSNR over `data_range`.
+  double data_range = 0.0;
+};
+
 class SPECK_FLT {
  public:
   //
@@ -25,7 +41,7 @@ class SPECK_FLT {
   // Input
   //
   // Accept incoming data: copy from a raw memory block.
-  // Note: `len` is the number of values.
+  // Note: `len` is the number of values, which can be of any type in sperr::DataType.
   template <typename T>
   void copy_data(const T* p, size_t len);
 
@@ -33,17 +49,31 @@ class SPECK_FLT {
   void take_data(std::vector<double>&&);
 
   // Use an encoded bitstream
-  // Note: `len` is the number of bytes.
+  // Note: `len` is the number of bytes. The memory pointed to by `p` is read in place,
+  //       so it needs to remain valid until `decompress()` returns.
   virtual auto use_bitstream(const void* p, size_t len) -> RTNType;
 
   //
   // Output
   //
   void append_encoded_bitstream(vec8_type& buf) const;
+  // Write the encoded bitstream to a caller-provided buffer of `len` bytes, which needs to be
+  //    at least `encoded_bitstream_len()` bytes long.
+  auto encoded_bitstream_len() const -> size_t;
+  auto write_encoded_bitstream(void* p, size_t len) const -> RTNType;
   auto view_decoded_data() const -> const vecd_type&;
   auto view_hierarchy() const -> const std::vector<vecd_type>&;
   auto release_decoded_data() -> vecd_type&&;
   auto release_hierarchy() -> std::vector<vecd_type>&&;
+  // Per-stage timing and counters of the most recent `compress()` or `decompress()`.
+  //    It stays empty unless SPERR is built with SPERR_INSTRUMENT.
+  auto view_profile() const -> const Profile&;
+  // Current and peak bytes held by the buffers of this object. Peak values are over the
+  //    lifetime of this object, because buffers are kept and reused across calls.
+  auto view_memory_usage() const -> const Memory_Usage&;
+  // The mean of the data, which the bitstream keeps exactly, and an approximation of its
+  //    variance: the energy of the coefficients decoded by the most recent `decompress_coarse()`.
+  auto get_mean_var() const -> std::array<double, 2>;
 
   //
   // General configuration and info.
@@ -54,6 +84,12 @@ class SPECK_FLT {
   void set_dims(dims_type);
   auto integer_len() const -> size_t;
 
+  // Optional: decode with less effort, stopping early on the bitstream in place rather than on
+  //    a truncated copy of it. Decoding stops at whichever cap comes first: the number of
+  //    bitplanes, the fraction of bits, or the bitplane where the estimated PSNR reaches the
+  //    target. Outliers are not corrected when decoding stops early.
+  void set_decode_effort(Decode_Effort);
+
 #ifdef EXPERIMENTING
   void set_direct_q(double q);
 #endif
@@ -64,6 +100,19 @@ class SPECK_FLT {
   auto compress() -> RTNType;
   auto decompress(bool multi_res = false) -> RTNType;
 
+  // Decode only the first `num_bitplanes` bitplanes of wavelet coefficients, and skip the inverse
+  //    wavelet transform and outlier correction, which costs a small fraction of `decompress()`.
+  //    The decoded data is the lowest wavelet subband, rescaled to be a coarse approximation of
+  //    the data, with dimensions of `get_coarse_dims()`. With zero bitplanes, it's the mean.
+  auto decompress_coarse(size_t num_bitplanes) -> RTNType;
+  auto get_coarse_dims() const -> dims_type;
+
+  // Estimate the outcome of `compress()` in `mode` at each of the `qualities`, which are PSNR,
+  //    PWE, or BPP values, at the cost of roughly one compression. The data is encoded once at
+  //    the finest of them, and the sizes at the others are extrapolated from the bits spent on
+  //    each bitplane. It consumes the data, and returns an empty vector upon errors.
+  auto estimate(CompMode mode, const std::vector<double>& qualities) -> std::vector<RD_Estimate>;
+
  protected:
   UINTType m_uint_flag = UINTType::UINT64;
   bool m_has_outlier = false;           // encoding (PWE mode) and decoding
@@ -76,10 +125,17 @@ class SPECK_FLT {
   condi_type m_condi_bitstream;
   Bitmask m_sign_array;
   std::vector<vecd_type> m_hierarchy;  // multi-resolution decoding
+  const uint32_t* m_quant_order = nullptr;  // encoding only, see `m_quantization_order()`
+  double m_coarse_var = 0.0;                // decoding only, see `get_mean_var()`
+  Decode_Effort m_effort;                   // decoding only
+  size_t m_num_bitplanes = 0;               // decoding only
+  uint64_t m_speck_bits = 0;                // decoding only
 
   CDF97 m_cdf;
   Conditioner m_conditioner;
   Outlier_Coder m_out_coder;
+  Profile m_profile;
+  Memory_Usage m_mem;
 
   std::variant<std::vector<uint8_t>,
                std::vector<uint16_t>,
@@ -93,6 +149,9 @@ class SPECK_FLT {
                std::unique_ptr<SPECK_INT<uint64_t>>>
       m_encoder, m_decoder;
 
+  // Record the bytes currently held by each buffer in `m_mem`.
+  void m_account_memory();
+
   // Instantiate `m_vals_ui` based on the chosen integer length.
   void m_instantiate_int_vec();
 
@@ -105,12 +164,21 @@ class SPECK_FLT {
   virtual void m_wavelet_xform() = 0;
   virtual void m_inverse_wavelet_xform(bool multi_res) = 0;
 
+  // Dimensions of the lowest wavelet subband, and the total number of transform levels applied
+  //    along all dimensions. The lowest subband is scaled by sqrt(2) to the power of the latter.
+  virtual auto m_lowest_subband() const -> std::tuple<dims_type, size_t> = 0;
+
   // This base class provides two midtread quantization implementations.
   //    Quantization reads from `m_vals_d`, and writes to `m_vals_ui` and `m_sign_array`.
   //    Inverse quantization reads from `m_vals_ui` and `m_sign_array`, and writes to `m_vals_d`.
   auto m_midtread_quantize() -> RTNType;
   void m_midtread_inv_quantize();
 
+  // Derived classes may have the quantized coefficients arranged in the order that their
+  //    encoder works in: the coefficient at raster index `i` is then kept at `m_vals_ui[order[i]]`
+  //    during compression. Returning nullptr, which is the default, indicates the raster order.
+  virtual auto m_quantization_order() -> const uint32_t*;
+
   // Estimate MSE assuming midtread quantization strategy.
   auto m_estimate_mse_midtread(double q) const -> double;
 
@@ -120,6 +188,13 @@ class SPECK_FLT {
   //    - Rate: `param` must be the biggest magnitude of transformed wavelet coefficients;
   //            `high_prec` should be false at first, and true if not enough bits are produced.
   auto m_estimate_q(double param, bool high_prec) const -> double;
+
+  // The bitplane cap and bit cap of the SPECK decoder from `m_effort`; zeros mean no cap.
+  auto m_effort_caps() const -> std::pair<size_t, uint64_t>;
+
+  // Encode `m_vals_ui` and `m_sign_array` with at most `budget` bits; zero means no budget.
+  //    The SPECK encoder records its stages and counters in `prof`.
+  auto m_speck_encode(size_t budget, Profile* prof) -> RTNType;
 };
 
 };  // namespace sperr
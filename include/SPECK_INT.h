@@ -9,6 +9,7 @@
 
 #include "Bitmask.h"
 #include "Bitstream.h"
+#include "Profile.h"
 
 namespace sperr {
 
@@ -39,7 +40,16 @@ class SPECK_INT {
   // Optional: set a bit budget (num. of bits) for encoding, which is the maximum value of
   // type size_t by default. Passing in zero here resets it to the maximum of size_t.
   void set_budget(size_t);
+  // Optional: decode at most this many bitplanes, stopping early on a complete bitstream.
+  //    Passing in zero here resets it to decode all bitplanes, which is the default.
+  void set_bitplane_cap(size_t);
+  // Optional: decode about this many bits, as if the bitstream were truncated there, except that
+  //    the pass crossing the cap is finished. Passing in zero resets it to decode all bits.
+  void set_bit_cap(uint64_t);
   void set_dims(dims_type);
+  // Optional: record bitplanes coded, peak LIS size, and time spent in sorting and refinement
+  //    passes to a profile. It's effective only when SPERR is built with SPERR_INSTRUMENT.
+  void set_profile(Profile*);
 
   // Note: `speck_int_get_num_bitplanes()` is provided as a free-standing helper function (above).
   //
@@ -54,23 +64,39 @@ class SPECK_INT {
 
   // Input
   auto use_coeffs(vecui_type coeffs, Bitmask signs) -> RTNType;
+  // Same as `use_coeffs()`, but the coefficients are already arranged in the order that the
+  //    encoder works in, saving it a re-arrangement. Only the 3D encoder has such an order
+  //    (see `speck3d_morton_order()`); it's the raster order for the other encoders.
+  auto use_arranged_coeffs(vecui_type coeffs, Bitmask signs) -> RTNType;
+  // Note: the memory pointed to by `p` is read in place, so it needs to remain valid
+  //       until `decode()` returns.
   void use_bitstream(const void* p, size_t len);
 
   // Output
   auto encoded_bitstream_len() const -> size_t;
   void append_encoded_bitstream(vec8_type& buf) const;
+  // Write `encoded_bitstream_len()` bytes to `p`.
+  void write_encoded_bitstream(void* p) const;
+  // Encoding only: the number of bits produced by the end of each complete bitplane.
+  auto view_bitplane_bits() const -> const std::vector<uint64_t>&;
   auto release_coeffs() -> vecui_type&&;
   auto release_signs() -> Bitmask&&;
   auto view_coeffs() const -> const vecui_type&;
   auto view_signs() const -> const Bitmask&;
 
+  // Number of bytes held by the internal buffers of this coder.
+  virtual auto memory_usage() const -> size_t;
+
  protected:
   // Core SPECK procedures
   virtual void m_clean_LIS() = 0;
   virtual void m_sorting_pass() = 0;
   virtual void m_initialize_lists() = 0;
+  virtual auto m_LIS_size() const -> size_t = 0;  // Total number of sets in the LIS.
   void m_refinement_pass_encode();
   void m_refinement_pass_decode();
+  // Encoding only: free the buffers that are needed only while `encode()` runs.
+  virtual void m_release_encoding_buffers() {}
 
   // Data members
   uint8_t m_num_bitplanes = 0;
@@ -78,12 +104,21 @@ class SPECK_INT {
   uint64_t m_total_bits = 0;  // The number of bits of a complete SPECK stream.
   uint64_t m_avail_bits = 0;  // Decoding only. `m_avail_bits` <= `m_total_bits`
   size_t m_budget = std::numeric_limits<size_t>::max();
+  size_t m_bitplane_cap = std::numeric_limits<size_t>::max();  // Decoding only.
+  uint64_t m_bit_cap = std::numeric_limits<uint64_t>::max();    // Decoding only.
 
   dims_type m_dims = {0, 0, 0};
   vecui_type m_coeff_buf;
   std::vector<uint64_t> m_LSP_new;
   Bitmask m_LSP_mask, m_LIP_mask, m_sign_array;
   Bitstream m_bit_buffer;
+  std::vector<uint64_t> m_bitplane_bits;  // Encoding only.
+  Profile* m_profile = nullptr;
+
+  // Encoding only: if set, the coefficient at raster index `i` is stored at
+  //    `m_coeff_buf[m_coeff_order[i]]` instead of `m_coeff_buf[i]`.
+  const uint32_t* m_coeff_order = nullptr;
+  bool m_coeffs_arranged = false;
 };
 
 };  // namespace sperr
@@ -0,0 +1,66 @@
+//
+// This is a class that performs SPERR1D compression, and also utilizes OpenMP
+// to achieve parallelization: the input array is divided into smaller chunks
+// and then they're processed individually.
+//
+
+#ifndef SPERR1D_OMP_C_H
+#define SPERR1D_OMP_C_H
+
+#include "SPECK1D_FLT.h"
+
+namespace sperr {
+
+class SPERR1D_OMP_C {
+ public:
+  // If 0 is passed in, the maximal number of threads will be used.
+  void set_num_threads(size_t);
+
+  // Note on `chunk_len`: it's a preferred value, but when the array length is not
+  //    divisible by the chunk length, the actual chunk length will change.
+  void set_length_and_chunk(size_t total_len, size_t chunk_len);
+
+  void set_psnr(double);
+  void set_tolerance(double);
+  void set_bitrate(double);
+
+  // Apply compression on an array pointed to by `buf`.
+  template <typename T>
+  auto compress(const T* buf, size_t buf_len) -> RTNType;
+
+  // Output: produce a vector containing the encoded bitstream.
+  auto get_encoded_bitstream() const -> vec8_type;
+
+  // Output: write the encoded bitstream to a caller-provided buffer of `len` bytes, which
+  //    needs to be at least `encoded_bitstream_len()` bytes long.
+  auto encoded_bitstream_len() const -> size_t;
+  auto write_encoded_bitstream(void* p, size_t len) const -> RTNType;
+
+ private:
+  bool m_orig_is_float = true;  // The original input precision is saved in header.
+  CompMode m_mode = CompMode::Unknown;
+  double m_quality = 0.0;
+  size_t m_total_len = 0;  // Length of the entire array
+  size_t m_chunk_len = 0;  // Preferred length of a chunk
+  std::vector<vec8_type> m_encoded_streams;
+
+#ifdef USE_OMP
+  size_t m_num_threads = 1;
+  std::vector<std::unique_ptr<SPECK1D_FLT>> m_compressors;
+#else
+  std::unique_ptr<SPECK1D_FLT> m_compressor;
+#endif
+
+  // The eventual header size would be this magic number + num_chunks * 4
+  const size_t m_header_magic_nchunks = 14;
+  const size_t m_header_magic_1chunk = 10;
+
+  //
+  // Private methods
+  //
+  auto m_generate_header() const -> vec8_type;
+};
+
+}  // End of namespace sperr
+
+#endif
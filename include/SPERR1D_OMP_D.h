@@ -0,0 +1,56 @@
+//
+// This is a class that performs SPERR1D decompression, and also utilizes OpenMP
+// to achieve parallelization: input to this class is supposed to be smaller
+// chunks of a longer array, and each chunk is decompressed individually before
+// returning back the entire array.
+//
+
+#ifndef SPERR1D_OMP_D_H
+#define SPERR1D_OMP_D_H
+
+#include "SPECK1D_FLT.h"
+
+namespace sperr {
+
+class SPERR1D_OMP_D {
+ public:
+  // If 0 is passed in here, the maximum number of threads will be used.
+  void set_num_threads(size_t);
+
+  // Parse the header of this stream, and stores the pointer.
+  auto use_bitstream(const void*, size_t) -> RTNType;
+
+  // The pointer passed in here MUST be the same as the one passed to `use_bitstream()`.
+  auto decompress(const void* bitstream) -> RTNType;
+
+  auto view_decoded_data() const -> const sperr::vecd_type&;
+  auto release_decoded_data() -> sperr::vecd_type&&;
+
+  auto get_length() const -> size_t;
+  auto get_chunk_length() const -> size_t;
+  auto get_orig_is_float() const -> bool;
+
+ private:
+  size_t m_total_len = 0;  // Length of the entire array
+  size_t m_chunk_len = 0;  // Preferred length of a chunk
+  bool m_orig_is_float = true;
+
+#ifdef USE_OMP
+  size_t m_num_threads = 1;
+  std::vector<std::unique_ptr<SPECK1D_FLT>> m_decompressors;
+#else
+  std::unique_ptr<SPECK1D_FLT> m_decompressor;
+#endif
+
+  sperr::vecd_type m_vol_buf;
+  std::vector<size_t> m_offsets;  // Address offset to locate each bitstream chunk.
+  const uint8_t* m_bitstream_ptr = nullptr;
+
+  // Header size would be the magic number + num_chunks * 4
+  const size_t m_header_magic_nchunks = 14;
+  const size_t m_header_magic_1chunk = 10;
+};
+
+}  // End of namespace sperr
+
+#endif
@@ -0,0 +1,71 @@
+//
+// This is a class that performs SPERR2D compression on large 2D fields, and also utilizes
+// OpenMP to achieve parallelization: the input slice is divided into smaller tiles (chunks)
+// and then they're processed individually.
+//
+
+#ifndef SPERR2D_OMP_C_H
+#define SPERR2D_OMP_C_H
+
+#include "SPECK2D_FLT.h"
+
+namespace sperr {
+
+class SPERR2D_OMP_C {
+ public:
+  // If 0 is passed in, the maximal number of threads will be used.
+  void set_num_threads(size_t);
+
+  // Note on `chunk_dims`: it's a preferred value, but when the slice dimension is not
+  //    divisible by the chunk dimension, the actual chunk dimension will change.
+  //    Both dimensions have their Z component being 1, and a chunk dimension is at most 65,535.
+  void set_dims_and_chunks(dims_type slice_dims, dims_type chunk_dims);
+
+  void set_psnr(double);
+  void set_tolerance(double);
+  void set_bitrate(double);
+
+  // Apply compression on a 2D slice pointed to by `buf`.
+  template <typename T>
+  auto compress(const T* buf, size_t buf_len) -> RTNType;
+
+  // Output: produce a vector containing the encoded bitstream.
+  auto get_encoded_bitstream() const -> vec8_type;
+
+  // Output: write the encoded bitstream to a caller-provided buffer of `len` bytes, which
+  //    needs to be at least `encoded_bitstream_len()` bytes long.
+  auto encoded_bitstream_len() const -> size_t;
+  auto write_encoded_bitstream(void* p, size_t len) const -> RTNType;
+
+ private:
+  bool m_orig_is_float = true;  // The original input precision is saved in header.
+  CompMode m_mode = CompMode::Unknown;
+  double m_quality = 0.0;
+  dims_type m_dims = {0, 0, 1};        // Dimension of the entire slice
+  dims_type m_chunk_dims = {0, 0, 1};  // Preferred dimensions for a chunk
+  std::vector<vec8_type> m_encoded_streams;
+
+#ifdef USE_OMP
+  size_t m_num_threads = 1;
+  std::vector<std::unique_ptr<SPECK2D_FLT>> m_compressors;
+#else
+  std::unique_ptr<SPECK2D_FLT> m_compressor;
+#endif
+
+  // The eventual header size would be this magic number + num_chunks * 4
+  const size_t m_header_magic_nchunks = 14;
+  const size_t m_header_magic_1chunk = 10;
+
+  //
+  // Private methods
+  //
+  auto m_generate_header() const -> vec8_type;
+
+  // Gather a chunk from a bigger slice.
+  template <typename T>
+  auto m_gather_chunk(const T* slice, std::array<size_t, 6> chunk) const -> vecd_type;
+};
+
+}  // End of namespace sperr
+
+#endif
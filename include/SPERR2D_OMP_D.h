@@ -0,0 +1,64 @@
+//
+// This is a class that performs SPERR2D decompression, and also utilizes OpenMP
+// to achieve parallelization: input to this class is supposed to be tiles (chunks)
+// of a bigger 2D slice, and each chunk is decompressed individually before
+// returning back the slice, or a rectangular region of it.
+//
+
+#ifndef SPERR2D_OMP_D_H
+#define SPERR2D_OMP_D_H
+
+#include "SPECK2D_FLT.h"
+
+namespace sperr {
+
+class SPERR2D_OMP_D {
+ public:
+  // If 0 is passed in here, the maximum number of threads will be used.
+  void set_num_threads(size_t);
+
+  // Parse the header of this stream, and stores the pointer.
+  auto use_bitstream(const void*, size_t) -> RTNType;
+
+  // The pointer passed in here MUST be the same as the one passed to `use_bitstream()`.
+  auto decompress(const void* bitstream) -> RTNType;
+
+  // Decompress a rectangular region of interest (ROI) that starts at (`start[0]`, `start[1]`)
+  //    and spans `size[0]` x `size[1]` values. Only the chunks intersecting the region are
+  //    decoded, and the decoded data contains just the region, with X varying fastest.
+  //    The pointer passed in here MUST be the same as the one passed to `use_bitstream()`.
+  auto decompress_region(const void* bitstream,
+                         std::array<size_t, 2> start,
+                         std::array<size_t, 2> size) -> RTNType;
+
+  auto view_decoded_data() const -> const sperr::vecd_type&;
+  auto release_decoded_data() -> sperr::vecd_type&&;
+
+  auto get_dims() const -> sperr::dims_type;
+  auto get_chunk_dims() const -> sperr::dims_type;
+  auto get_orig_is_float() const -> bool;
+
+ private:
+  sperr::dims_type m_dims = {0, 0, 1};        // Dimension of the entire slice
+  sperr::dims_type m_chunk_dims = {0, 0, 1};  // Preferred dimensions for a chunk
+  bool m_orig_is_float = true;
+
+#ifdef USE_OMP
+  size_t m_num_threads = 1;
+  std::vector<std::unique_ptr<SPECK2D_FLT>> m_decompressors;
+#else
+  std::unique_ptr<SPECK2D_FLT> m_decompressor;
+#endif
+
+  sperr::vecd_type m_vol_buf;
+  std::vector<size_t> m_offsets;  // Address offset to locate each bitstream chunk.
+  const uint8_t* m_bitstream_ptr = nullptr;
+
+  // Header size would be the magic number + num_chunks * 4
+  const size_t m_header_magic_nchunks = 14;
+  const size_t m_header_magic_1chunk = 10;
+};
+
+}  // End of namespace sperr
+
+#endif
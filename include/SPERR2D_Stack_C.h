@@ -0,0 +1,64 @@
+//
+// This is a class that compresses a stack of independent 2D slices of the same dimension,
+// e.g., per-level atmospheric fields or image stacks, and utilizes OpenMP to compress
+// different slices in parallel. Each slice is compressed as a whole by a SPECK2D_FLT
+// instance that's reused by the same thread.
+//
+
+#ifndef SPERR2D_STACK_C_H
+#define SPERR2D_STACK_C_H
+
+#include "SPECK2D_FLT.h"
+
+namespace sperr {
+
+class SPERR2D_Stack_C {
+ public:
+  // If 0 is passed in, the maximal number of threads will be used.
+  void set_num_threads(size_t);
+
+  // Dimension of every slice in the stack. The Z component needs to be 1.
+  void set_slice_dims(dims_type);
+
+  void set_psnr(double);
+  void set_tolerance(double);
+  void set_bitrate(double);
+
+  // Apply compression on a stack of slices pointed to by `buf`, which are stored one after
+  //    another. `buf_len` needs to be a multiple of the number of values in a slice.
+  template <typename T>
+  auto compress(const T* buf, size_t buf_len) -> RTNType;
+
+  // Output: a single container holding all slices with a slice index.
+  auto get_encoded_bitstream() const -> vec8_type;
+  auto encoded_bitstream_len() const -> size_t;
+  auto write_encoded_bitstream(void* p, size_t len) const -> RTNType;
+
+  // Output: individual bitstreams of each slice. They contain no header, and each one can be
+  //    decoded by a SPECK2D_FLT or `sperr_decomp_2d()` on its own.
+  auto view_slice_streams() const -> const std::vector<vec8_type>&;
+  auto release_slice_streams() -> std::vector<vec8_type>&&;
+
+ private:
+  bool m_orig_is_float = true;  // The original input precision is saved in header.
+  CompMode m_mode = CompMode::Unknown;
+  double m_quality = 0.0;
+  dims_type m_dims = {0, 0, 1};  // Dimension of each slice
+  std::vector<vec8_type> m_encoded_streams;
+
+#ifdef USE_OMP
+  size_t m_num_threads = 1;
+  std::vector<std::unique_ptr<SPECK2D_FLT>> m_compressors;
+#else
+  std::unique_ptr<SPECK2D_FLT> m_compressor;
+#endif
+
+  // The eventual header size would be this magic number + num_slices * 4
+  const size_t m_header_magic = 14;
+
+  auto m_generate_header() const -> vec8_type;
+};
+
+}  // End of namespace sperr
+
+#endif
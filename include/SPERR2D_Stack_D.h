@@ -0,0 +1,58 @@
+//
+// This is a class that decompresses a container produced by SPERR2D_Stack_C, and utilizes
+// OpenMP to decompress different slices in parallel. Any subset of the slices can be
+// decompressed without touching the bitstreams of the other slices.
+//
+
+#ifndef SPERR2D_STACK_D_H
+#define SPERR2D_STACK_D_H
+
+#include "SPECK2D_FLT.h"
+
+namespace sperr {
+
+class SPERR2D_Stack_D {
+ public:
+  // If 0 is passed in here, the maximum number of threads will be used.
+  void set_num_threads(size_t);
+
+  // Parse the header and the slice index of this container, and stores the pointer.
+  auto use_bitstream(const void*, size_t) -> RTNType;
+
+  // Decompress all slices. The pointer passed in here MUST be the same as the one passed
+  //    to `use_bitstream()`.
+  auto decompress(const void* bitstream) -> RTNType;
+
+  // Decompress the slices at `indices`, which are placed in the decoded data in the same order.
+  auto decompress_slices(const void* bitstream, const std::vector<size_t>& indices) -> RTNType;
+  auto decompress_slice(const void* bitstream, size_t idx) -> RTNType;
+
+  auto view_decoded_data() const -> const sperr::vecd_type&;
+  auto release_decoded_data() -> sperr::vecd_type&&;
+
+  auto get_slice_dims() const -> sperr::dims_type;
+  auto get_num_slices() const -> size_t;
+  auto get_orig_is_float() const -> bool;
+
+ private:
+  sperr::dims_type m_dims = {0, 0, 1};  // Dimension of each slice
+  bool m_orig_is_float = true;
+
+#ifdef USE_OMP
+  size_t m_num_threads = 1;
+  std::vector<std::unique_ptr<SPECK2D_FLT>> m_decompressors;
+#else
+  std::unique_ptr<SPECK2D_FLT> m_decompressor;
+#endif
+
+  sperr::vecd_type m_vol_buf;
+  std::vector<size_t> m_offsets;  // Address offset to locate each slice bitstream.
+  const uint8_t* m_bitstream_ptr = nullptr;
+
+  // Header size would be the magic number + num_slices * 4
+  const size_t m_header_magic = 14;
+};
+
+}  // End of namespace sperr
+
+#endif
@@ -0,0 +1,88 @@
+//
+// Decoded chunks of 3D bitstream files, which are kept in memory so that repeated requests of the
+// same regions, resolutions, and precisions skip opening, parsing, and decoding again. It's the
+// engine of the `sperrd` daemon (utilities/sperrd.cpp), and is safe to use from many threads.
+//
+
+#ifndef SPERR3D_CHUNK_CACHE_H
+#define SPERR3D_CHUNK_CACHE_H
+
+#include "SPERR3D_Stream.h"
+
+#include <list>
+#include <map>
+
+namespace sperr {
+
+class SPERR3D_Chunk_Cache {
+ public:
+  // Maximal bytes of decoded chunks to keep; the least recently used ones are evicted first.
+  //    Passing in zero disables caching. The default is 1 GiB.
+  void set_capacity(size_t bytes);
+
+  // Number of threads decoding the chunks of one request. If 0 is passed in, the maximum number
+  //    of threads will be used.
+  void set_num_threads(size_t);
+
+  // Open a bitstream file (see `SPERR3D_Stream::open_file()`), or find it opened already.
+  //    Files are identified by their names as given.
+  auto open_file(const std::string& filename, std::shared_ptr<const SPERR3D_Stream>& stream)
+      -> RTNType;
+
+  // Forget an opened file and its decoded chunks, e.g., after it changed on disk.
+  void close_file(const std::string& filename);
+
+  // A region of a volume, at one of its resolutions, decoded from a portion of its bitstream.
+  //    `level` counts the coarsening steps from the native resolution (0), and `start` and
+  //    `size` are in the dimensions of that resolution (see `level_dims()`). `pct` is the
+  //    percentage of each chunk bitstream to decode, the same as progressive access.
+  struct Request {
+    dims_type start = {0, 0, 0};
+    dims_type size = {0, 0, 0};
+    size_t level = 0;
+    unsigned pct = 100;
+  };
+
+  // Dimensions of a volume after `level` coarsening steps, or zeros if that's not available.
+  auto level_dims(const SPERR3D_Stream&, size_t level) const -> dims_type;
+
+  // Decode the region of a request into `dst`, which needs to hold the values of the region,
+  //    with X varying fastest. `T` can be float or double.
+  template <typename T>
+  auto decode(const std::string& filename, const Request&, T* dst) -> RTNType;
+
+  // Counters of chunk lookups, and bytes of decoded chunks currently kept.
+  struct Counters {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t bytes = 0;
+  };
+  auto get_counters() const -> Counters;
+
+ private:
+  // A decoded chunk is identified by its stream, the chunk whose bitstream it uses, the
+  //    resolution level, and the precision.
+  using Key = std::tuple<const SPERR3D_Stream*, size_t, size_t, unsigned>;
+  using Entry = std::pair<Key, std::shared_ptr<const vecd_type>>;
+
+  size_t m_capacity = size_t{1} << 30;
+  size_t m_num_threads = 1;
+  Decoder_Pool m_pool;
+
+  mutable std::mutex m_mutex;  // Guards all members below.
+  std::map<std::string, std::shared_ptr<const SPERR3D_Stream>> m_files;
+  std::list<Entry> m_lru;  // Most recently used first.
+  std::map<Key, std::list<Entry>::iterator> m_index;
+  Counters m_counters;
+
+  // Find a decoded chunk, or decode and insert it.
+  auto m_get_chunk(const SPERR3D_Stream&, size_t chunk, size_t level, unsigned pct)
+      -> std::pair<std::shared_ptr<const vecd_type>, RTNType>;
+  auto m_decode_chunk(const SPERR3D_Stream&, size_t chunk, size_t level, unsigned pct)
+      -> std::pair<std::shared_ptr<const vecd_type>, RTNType>;
+  void m_insert(const Key&, std::shared_ptr<const vecd_type>);
+};
+
+}  // End of namespace sperr
+
+#endif
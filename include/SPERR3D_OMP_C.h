@@ -8,6 +8,7 @@
 #define SPERR3D_OMP_C_H
 
 #include "SPECK3D_FLT.h"
+#include "SPERR3D_Stream_Tools.h"
 
 namespace sperr {
 
@@ -16,10 +17,35 @@ class SPERR3D_OMP_C {
   // If 0 is passed in, the maximal number of threads will be used.
   void set_num_threads(size_t);
 
+  // Optional: cap the memory (in bytes) of compression, including the input volume and the
+  //    bitstreams produced. The number of threads in use is lowered so the estimated memory
+  //    fits the cap, and bitstreams are trimmed as they finish. `compress()` returns
+  //    RTNType::Error if not even one thread fits, or once the bitstreams outgrow the cap.
+  //    Passing in zero removes the cap, which is the default.
+  void set_memory_budget(size_t bytes);
+
   // Note on `chunk_dims`: it's a preferred value, but when the volume dimension is not
   //    divisible by chunk dimensions, the actual chunk dimension will change.
   void set_dims_and_chunks(dims_type vol_dims, dims_type chunk_dims);
 
+  // Optional: record the min, max, mean, and variance of each chunk in an index section of the
+  //    header, so that `SPERR3D_Stream_Tools` can answer range and threshold queries without
+  //    decompression. It costs 32 bytes per chunk, and is off by default.
+  void set_chunk_stats(bool);
+
+  // Optional: compress identical chunks of the same dimensions only once, e.g., in masked or
+  //    constant regions. Later copies refer to the first one in the header, and decoders decode
+  //    it once as well. It costs one pass over the input to find them, and is off by default.
+  void set_dedup_chunks(bool);
+
+  // Optional: group neighbouring chunks into super-chunks of `super_dims` chunks along each axis,
+  //    whose bitstreams are stored together and start at multiples of `stripe` bytes (e.g., the
+  //    stripe size of a parallel file system). Reading a region then takes a few large aligned
+  //    reads (see `SPERR3D_Stream_Tools::region_sections()`), while chunks are still compressed
+  //    in parallel. Zeros in `super_dims` disable it, which is the default. It returns
+  //    RTNType::Error, and changes nothing, if a dimension is over 65,535 or `stripe` over 2^32-1.
+  auto set_super_chunks(dims_type super_dims, size_t stripe) -> RTNType;
+
   void set_psnr(double);
   void set_tolerance(double);
   void set_bitrate(double);
@@ -28,19 +54,67 @@ class SPERR3D_OMP_C {
 #endif
 
   // Apply compression on a volume pointed to by `buf`.
+  //    Besides float and double, `T` can be fp16_type, bf16_type, int8_t, uint8_t, int16_t,
+  //    uint16_t, and int32_t. Values are converted to double as chunks are gathered, and the
+  //    original type is recorded in the header.
   template <typename T>
   auto compress(const T* buf, size_t buf_len) -> RTNType;
 
+  // Predict the outcome of `compress()` in `mode` at each of the `qualities` (PSNR, PWE, or
+  //    BPP values), at a few percent of its cost. A stratified sample of `fraction` of the chunks
+  //    (at least two) is encoded once each (see `SPECK_FLT::estimate()`), and the totals are
+  //    extrapolated to all chunks, together with their standard errors due to sampling.
+  //    Deduplication of chunks is not considered. It returns an empty vector upon errors.
+  //    PSNR is capped at that of an error of double round-off (about 313 dB), which is also
+  //    what a lossless outcome (e.g., constant data) reports.
+  struct Prediction {
+    double bytes = 0.0;
+    double bytes_err = 0.0;
+    double psnr = 0.0;  // Over the data range of the entire volume; see `predict()`.
+    double psnr_err = 0.0;
+  };
+  template <typename T>
+  auto predict(const T* buf,
+               size_t buf_len,
+               CompMode mode,
+               const std::vector<double>& qualities,
+               double fraction = 0.02) -> std::vector<Prediction>;
+
   // Output: produce a vector containing the encoded bitstream.
   auto get_encoded_bitstream() const -> vec8_type;
 
+  // Output: write the encoded bitstream to a caller-provided buffer of `len` bytes, which
+  //    needs to be at least `encoded_bitstream_len()` bytes long.
+  auto encoded_bitstream_len() const -> size_t;
+  auto write_encoded_bitstream(void* p, size_t len) const -> RTNType;
+
+  // Output: per-stage timing and counters of the most recent `compress()`, aggregated over
+  //    all chunks or of individual chunks. They stay empty unless built with SPERR_INSTRUMENT.
+  auto view_profile() const -> const Profile&;
+  auto view_chunk_profiles() const -> const std::vector<Profile>&;
+
+  // Output: current and peak bytes held by the internal buffers of all compressor instances
+  //    and the encoded bitstreams. Compressor instances in different threads are considered
+  //    to reach their peak values at the same time.
+  auto get_memory_usage() const -> Memory_Usage;
+
  private:
-  bool m_orig_is_float = true;  // The original input precision is saved in header.
+  DataType m_orig_type = DataType::Float;  // The original input type is saved in header.
   CompMode m_mode = CompMode::Unknown;
   double m_quality = 0.0;
   dims_type m_dims = {0, 0, 0};        // Dimension of the entire volume
   dims_type m_chunk_dims = {0, 0, 0};  // Preferred dimensions for a chunk
   std::vector<vec8_type> m_encoded_streams;
+  std::vector<Profile> m_chunk_profiles;
+  Profile m_profile;
+  Memory_Usage m_mem;       // Only records the encoded bitstreams.
+  size_t m_mem_budget = 0;  // 0 means no budget.
+  bool m_record_stats = false;
+  bool m_dedup = false;
+  std::vector<size_t> m_chunk_sources;  // The first identical chunk of each chunk.
+  std::vector<Chunk_Stats> m_chunk_stats;
+  dims_type m_super_dims = {0, 0, 0};  // Zeros mean no super-chunks.
+  size_t m_stripe = 1;
 
 #ifdef USE_OMP
   size_t m_num_threads = 1;
@@ -56,15 +130,48 @@ class SPERR3D_OMP_C {
   std::unique_ptr<SPECK3D_FLT> m_compressor;
 #endif
 
-  // The eventual header size would be this magic number + num_chunks * 4
+  // The eventual header size would be this magic number + num_chunks * 4, plus
+  //    num_chunks * 32 with the statistics index, and 10 bytes with super-chunks.
   const size_t m_header_magic_nchunks = 20;
   const size_t m_header_magic_1chunk = 14;
+  const size_t m_header_super = 10;
 
   //
   // Private methods
   //
   auto m_generate_header() const -> vec8_type;
 
+  // Length of the bitstream with `header`. With super-chunks, `layout` receives the chunk
+  //    offsets parsed from `header`, which `m_write_stream()` then uses.
+  auto m_stream_len(const vec8_type& header, SPERR3D_Header& layout) const -> size_t;
+  void m_write_stream(const vec8_type& header, const SPERR3D_Header& layout, uint8_t* dst) const;
+
+  // If the bitstream groups chunks into super-chunks.
+  auto m_use_super_chunks() const -> bool;
+
+  // If the bitstream refers duplicate chunks to their sources. It doesn't when any bitstream is
+  //    too long to tell apart from a reference (see `chunk_ref_flag`).
+  auto m_use_dedup() const -> bool;
+
+  // The bitstream written for chunk `i`: duplicate chunks repeat their sources without dedup.
+  auto m_chunk_stream(size_t i, bool dedup) const -> const vec8_type&;
+
+  // Make sure there are at least `num_threads` compressor instances. Existing ones are kept.
+  void m_prepare_compressors(size_t num_threads);
+
+  // Estimate the memory of compressing with `num_threads` threads, each on a chunk of up to
+  //    `chunk_vals` values, given the bytes of the input volume and the bitstreams so far.
+  auto m_estimate_mem(size_t chunk_vals, size_t num_threads, size_t input_bytes,
+                      size_t output_bytes) const -> size_t;
+
+  // Find the first identical chunk of each chunk, and put them in `m_chunk_sources`.
+  template <typename T>
+  void m_find_duplicates(const T* vol, const std::vector<std::array<size_t, 6>>& chunks);
+
+  // Test if a chunk of the volume is constant directly on the input, and return its value if so.
+  template <typename T>
+  auto m_constant_value(const T* vol, std::array<size_t, 6> chunk) const -> std::optional<double>;
+
   // Gather a chunk from a bigger volume.
   // If the requested chunk lives outside of the volume, whole or part,
   //    this function returns an empty vector.
@@ -4,11 +4,15 @@
 // chunks of a bigger volume, and each chunk is decompressed individually before
 // returning back the big volume.
 //
+// An object of this class is a decoding session: a dataset opened once as a `SPERR3D_Stream`
+// can be shared by many sessions, e.g., one per request of a data server, each decoding
+// different regions or resolutions concurrently. Sessions can also share a `Decoder_Pool`.
+//
 
 #ifndef SPERR3D_OMP_D_H
 #define SPERR3D_OMP_D_H
 
-#include "SPECK3D_FLT.h"
+#include "SPERR3D_Stream.h"
 
 namespace sperr {
 
@@ -17,12 +21,67 @@ class SPERR3D_OMP_D {
   // If 0 is passed in here, the maximum number of threads will be used.
   void set_num_threads(size_t);
 
+  // Optional: cap the working memory (in bytes) of decompression, including the output volume.
+  //    The number of threads in use is lowered (down to one) so the estimated memory fits the
+  //    cap, and decompressor instances of idle threads are released. The cap is a best effort,
+  //    since the output volume and one chunk need a minimum amount of memory.
+  //    Passing in zero removes the cap, which is the default.
+  void set_memory_budget(size_t bytes);
+
   // Parse the header of this stream, and stores the pointer.
   auto use_bitstream(const void*, size_t) -> RTNType;
 
+  // Use a stream that's opened already, possibly shared with other sessions. The bitstream
+  //    pointer to pass to the decompress functions is then `stream->data()`.
+  auto use_stream(std::shared_ptr<const SPERR3D_Stream>) -> RTNType;
+
+  // Optional: borrow decompressors from a pool for the duration of each decoding call,
+  //    instead of keeping them in this session.
+  void use_decoder_pool(std::shared_ptr<Decoder_Pool>);
+
+  // Optional: cap the effort of decoding each chunk by `decompress()`, `decompress_into()`, and
+  //    `decompress_region()` (see `SPECK_FLT::set_decode_effort()`), for fast previews straight
+  //    from the bitstream in use. A PSNR target without a data range uses the range in the
+  //    statistics index of the stream, and is ignored if there's none.
+  void set_decode_effort(Decode_Effort);
+
   // The pointer passed in here MUST be the same as the one passed to `use_bitstream()`.
   auto decompress(const void* bitstream, bool multi_res = false) -> RTNType;
 
+  // Same as `decompress()`, but write the decoded volume directly to `dst`, which needs to
+  //    hold `get_dims()` values. `T` can be any type that SPERR3D_OMP_C::compress() accepts,
+  //    and values are rounded (and clamped for integers) to that type. `dst` is better left
+  //    uninitialized (e.g., from malloc()), so each worker thread is the first one to touch the
+  //    pages of the chunks that it decodes.
+  //    Note: `view_decoded_data()` and `release_decoded_data()` are empty after this call.
+  template <typename T>
+  auto decompress_into(const void* bitstream, T* dst, bool multi_res = false) -> RTNType;
+
+  // Decompress a box of interest that starts at `start` and spans `size` values in each
+  //    dimension. Only the chunks intersecting the box are decoded, and the decoded data
+  //    contains just the box, with X varying fastest.
+  auto decompress_region(const void* bitstream, dims_type start, dims_type size) -> RTNType;
+
+  // Compressed-domain queries, which cost a small fraction of `decompress()`: each chunk decodes
+  //    only its first `num_bitplanes` bitplanes (see `SPECK_FLT::decompress_coarse()`), giving
+  //    its mean, an approximate variance, and a coarse approximation of its values. With zero
+  //    bitplanes, nothing but the means are read from the bitstream.
+  auto decompress_coarse(const void* bitstream, size_t num_bitplanes) -> RTNType;
+
+  // Output of `decompress_coarse()`: the coarse chunks tiled into a coarse volume. It's empty,
+  //    with zero dimensions, if the coarse chunks don't line up with each other, which happens
+  //    only when chunks of different dimensions are transformed differently.
+  auto view_coarse_data() const -> const vecd_type&;
+  auto get_coarse_dims() const -> dims_type;
+  // Output of `decompress_coarse()`: the mean and approximate variance of each chunk, numbered
+  //    as in `sperr::chunk_volume()`, and of the entire volume.
+  auto view_chunk_mean_var() const -> const std::vector<std::array<double, 2>>&;
+  auto get_mean_var() const -> std::array<double, 2>;
+
+  // Optional: spread worker threads over, and bind them to, the places specified by OMP_PLACES
+  //    (e.g., "sockets" or "numa_domains") so they stay on the NUMA node owning their slabs.
+  void set_thread_binding(bool);
+
   auto view_decoded_data() const -> const sperr::vecd_type&;
   auto view_hierarchy() const -> const std::vector<vecd_type>&;
   auto release_decoded_data() -> sperr::vecd_type&&;
@@ -30,10 +89,21 @@ class SPERR3D_OMP_D {
 
   auto get_dims() const -> sperr::dims_type;
   auto get_chunk_dims() const -> sperr::dims_type;
+  auto get_orig_type() const -> DataType;
+
+  // Per-stage timing and counters of the most recent `decompress()`, aggregated over all chunks
+  //    or of individual chunks. They stay empty unless SPERR is built with SPERR_INSTRUMENT.
+  auto view_profile() const -> const Profile&;
+  auto view_chunk_profiles() const -> const std::vector<Profile>&;
+
+  // Current and peak bytes held by the internal buffers of all decompressor instances and the
+  //    output volume. Instances in different threads are considered to peak at the same time.
+  auto get_memory_usage() const -> Memory_Usage;
 
  private:
   sperr::dims_type m_dims = {0, 0, 0};        // Dimension of the entire volume
   sperr::dims_type m_chunk_dims = {0, 0, 0};  // Preferred dimensions for a chunk
+  DataType m_orig_type = DataType::Float;
 
 #ifdef USE_OMP
   size_t m_num_threads = 1;
@@ -52,16 +122,48 @@ class SPERR3D_OMP_D {
 
   sperr::vecd_type m_vol_buf;
   std::vector<vecd_type> m_hierarchy;  // multi-resolution decoding
-  std::vector<size_t> m_offsets;       // Address offset to locate each bitstream chunk.
-  const uint8_t* m_bitstream_ptr = nullptr;
-
-  // Header size would be the magic number + num_chunks * 4
-  const size_t m_header_magic_nchunks = 20;
-  const size_t m_header_magic_1chunk = 14;
+  sperr::vecd_type m_coarse_buf;       // coarse decoding
+  sperr::dims_type m_coarse_dims = {0, 0, 0};
+  std::vector<std::array<double, 2>> m_chunk_mean_var;
+  std::shared_ptr<const SPERR3D_Stream> m_stream;
+  std::shared_ptr<Decoder_Pool> m_pool;
+  std::vector<Profile> m_chunk_profiles;
+  Profile m_profile;
+  Memory_Usage m_mem;       // Only records the output volume and hierarchy.
+  size_t m_mem_budget = 0;  // 0 means no budget.
+  bool m_bind_threads = false;
+  Decode_Effort m_effort;
+
+  // Estimate the working memory of decompressing a chunk of `num_vals` values.
+  auto m_estimate_chunk_mem(size_t num_vals) const -> size_t;
+
+  // The decode effort of each chunk, with the data range filled in if needed.
+  auto m_chunk_effort() const -> Decode_Effort;
+
+  // Test if `p` is the bitstream in use, with valid dimensions.
+  auto m_check_stream(const void* p) const -> bool;
+
+  // Make `num_threads` decompressors available, taking them from the pool if there's one, and
+  //    give them back to the pool once a decoding call finishes.
+  void m_prepare_decompressors(size_t num_threads);
+  void m_return_decompressors();
+
+  // Decompress all chunks, and put them in `dst`.
+  template <typename T>
+  auto m_decompress(const void* bitstream, T* dst, bool multi_res) -> RTNType;
+
+  // Fill a chunk of a bigger volume with a constant value.
+  template <typename T>
+  void m_fill_chunk(T* big_vol, dims_type vol_dim, double val, std::array<size_t, 6> chunk_info);
+
+  // Copy the decoded values of chunk `src` to chunk `dst` of the same dimensions in `vol`.
+  template <typename T>
+  void m_copy_chunk(T* vol, std::array<size_t, 6> src, std::array<size_t, 6> dst) const;
 
   // Put this chunk to a bigger volume
   // Memory errors will occur if the big and small volumes are not the same size as described.
-  void m_scatter_chunk(vecd_type& big_vol,
+  template <typename T>
+  void m_scatter_chunk(T* big_vol,
                        dims_type vol_dim,
                        const vecd_type& small_vol,
                        std::array<size_t, 6> chunk_info);
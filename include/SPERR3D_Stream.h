@@ -0,0 +1,79 @@
+//
+// An opened 3D bitstream, and a pool of decompressors, which are shared by decoding sessions
+// (`SPERR3D_OMP_D`) so that one dataset can serve many concurrent requests.
+//
+
+#ifndef SPERR3D_STREAM_H
+#define SPERR3D_STREAM_H
+
+#include "SPECK3D_FLT.h"
+#include "SPERR3D_Stream_Tools.h"
+
+#include <memory>
+#include <mutex>
+
+namespace sperr {
+
+//
+// The bitstream and its parsed header. Once opened, it doesn't change, so a single object
+//    (e.g., held by `std::shared_ptr<const SPERR3D_Stream>`) can be used by any number of
+//    sessions in different threads without re-parsing the header.
+//
+class SPERR3D_Stream {
+ public:
+  SPERR3D_Stream() = default;
+  SPERR3D_Stream(const SPERR3D_Stream&) = delete;
+  SPERR3D_Stream& operator=(const SPERR3D_Stream&) = delete;
+  ~SPERR3D_Stream();
+
+  // Open a bitstream of `len` bytes in memory, which needs to outlive this object.
+  auto open(const void* p, size_t len) -> RTNType;
+
+  // Open a bitstream file. It's memory-mapped read-only where supported, so that only the
+  //    chunks being decoded are read from the file; otherwise, the whole file is read in.
+  auto open_file(std::string filename) -> RTNType;
+
+  auto data() const -> const uint8_t*;
+  auto size() const -> size_t;
+  auto view_header() const -> const SPERR3D_Header&;
+
+  // Chunks of the volume, as returned by `sperr::chunk_volume()`.
+  auto view_chunks() const -> const std::vector<std::array<size_t, 6>>&;
+
+ private:
+  SPERR3D_Header m_header;
+  std::vector<std::array<size_t, 6>> m_chunks;
+  const uint8_t* m_data = nullptr;
+  size_t m_len = 0;
+  void* m_map = nullptr;  // Memory mapping of an opened file.
+  vec8_type m_buf;        // Contents of an opened file when it's not memory-mapped.
+
+  void m_close();
+  auto m_parse() -> RTNType;
+};
+
+//
+// A pool of decompressors, which sessions borrow for the duration of each decoding call, so that
+//    the number of instances (and their internal buffers) follows the number of concurrently
+//    working threads rather than the number of sessions. It's thread-safe.
+//
+class Decoder_Pool {
+ public:
+  // Take an idle decompressor, or create one if there's none.
+  auto acquire() -> std::unique_ptr<SPECK3D_FLT>;
+
+  // Give back a decompressor, keeping at most `max_idle` of them (0 means no limit).
+  void release(std::unique_ptr<SPECK3D_FLT>);
+  void set_max_idle(size_t);
+
+  auto num_idle() const -> size_t;
+
+ private:
+  mutable std::mutex m_mutex;
+  std::vector<std::unique_ptr<SPECK3D_FLT>> m_idle;
+  size_t m_max_idle = 0;
+};
+
+}  // End of namespace sperr
+
+#endif
@@ -3,10 +3,37 @@
 
 #include "sperr_helper.h"
 
+#include <optional>
+
 namespace sperr {
 
+// In the table of chunk lengths of a 3D header flagged by `dedup_flag`, an entry with this bit
+//    set is not a length, but refers to an earlier identical chunk (given by the remaining bits)
+//    whose bitstream is shared.
+constexpr uint32_t chunk_ref_flag = uint32_t{1} << 31;
+
+// In the version byte of a 3D header, this bit marks a bitstream with deduplicated chunks (see
+//    `SPERR3D_OMP_C::set_dedup_chunks()`). Without it, every entry of the table is a length.
+constexpr uint8_t dedup_flag = 0x40;
+
+// In the version byte of a 3D header, this bit marks a bitstream whose chunks are grouped into
+//    super-chunks aligned to a stripe size (see `SPERR3D_OMP_C::set_super_chunks()`). Readers that
+//    don't know the layout see a version mismatch.
+constexpr uint8_t super_chunk_flag = 0x80;
+
+// Statistics of one chunk of the original data, which are recorded in an optional index of the
+//    3D header (see `SPERR3D_OMP_C::set_chunk_stats()`).
+struct Chunk_Stats {
+  double min = 0.0;
+  double max = 0.0;
+  double mean = 0.0;
+  double var = 0.0;
+};
+
 //
-// The 3D SPERR header definition is in SPERR3D_OMP_C.cpp::m_generate_header().
+// The 3D SPERR header definition is in SPERR3D_OMP_C.cpp::m_generate_header(), and the
+// chunked 2D SPERR header definition is in SPERR2D_OMP_C.cpp::m_generate_header().
+// These tools work with both, and 2D slices have their Z dimension being 1.
 //
 struct SPERR3D_Header {
   // Info directly stored in the header
@@ -15,23 +42,34 @@ struct SPERR3D_Header {
   bool is_3D = false;
   bool is_float = false;
   bool multi_chunk = false;
+  bool has_stats = false;
+  DataType data_type = DataType::Float;
   dims_type vol_dims = {0, 0, 0};
   dims_type chunk_dims = {0, 0, 0};
+  bool super_chunks = false;
+  dims_type super_dims = {1, 1, 1};  // Number of chunks in a super-chunk along each axis.
+  size_t stripe = 1;                 // Super-chunks start at multiples of this many bytes.
 
   // Info calculated from above
   size_t header_len = 0;
   size_t stream_len = 0;
   std::vector<size_t> chunk_offsets;
+  std::vector<size_t> chunk_sources;    // The chunk whose bitstream each chunk uses.
+  std::vector<Chunk_Stats> chunk_stats;  // Empty unless the header has a statistics index.
+  std::vector<size_t> super_offsets;     // Offset and length of each super-chunk, if any.
 };
 
 class SPERR3D_Stream_Tools {
  public:
   // Read the first 20 bytes of a bitstream, and determine the total length of the header.
   // Need 20 bytes because it's the larger of the header magic number (in multi-chunk case).
+  // It returns 0 for bitstreams other than 3D volumes and chunked 2D slices.
   auto get_header_len(std::array<uint8_t, 20>) const -> size_t;
 
   // Read a bitstream that's at least as long as what's determined by `get_header_len()`, and
-  // return an object of `SPERR3D_Stream_Header`.
+  // return an object of `SPERR3D_Stream_Header`. If a chunk refers to anything other than an
+  // earlier chunk with its own bitstream, or the bitstream is not of a 3D volume or a chunked 2D
+  // slice, `chunk_offsets` and `chunk_sources` are left empty.
   auto get_stream_header(const void*) const -> SPERR3D_Header;
 
   // Function that reads in portions of a file only to facilitate progressive access.
@@ -45,19 +83,62 @@ class SPERR3D_Stream_Tools {
   //  - multiple chunks: probably easier to just use the full bitstream length.
   auto progressive_truncate(const void* stream, size_t stream_len, unsigned pct) const -> vec8_type;
 
- private:
-  const size_t m_header_magic_nchunks = 20;
-  const size_t m_header_magic_1chunk = 14;
+  // Number of bytes that progressive access keeps from a chunk bitstream of `chunk_len` bytes.
+  auto progressive_chunk_len(size_t chunk_len, unsigned pct) const -> size_t;
 
+  // Sections, as a list of {offset, len}, of a bitstream to read in order to decode the box
+  //    starting at `start` with `len` values in each dimension. Adjacent sections are merged,
+  //    so with super-chunks a region becomes a few large reads aligned to the stripe size.
+  auto region_sections(const void* stream, dims_type start, dims_type len) const
+      -> std::vector<size_t>;
+
+  // Queries answered by the chunk statistics index alone, without decompression. Chunks are
+  //    numbered the same way as `sperr::chunk_volume()`, and the statistics describe the original
+  //    data. Chunks listed in `to_decode` are the ones that the index cannot settle; decoding them
+  //    gives the exact answer (up to the compression error). Both queries return std::nullopt
+  //    if the bitstream has no statistics index.
+  //
+  // Range query: bounds of the values in the box starting at `start` with `len` values in each
+  //    dimension. The bounds are exact when `to_decode` is empty; otherwise, they are bounds of
+  //    all chunks the box touches, and only partially covered chunks that could extend the range
+  //    of the fully covered ones are listed.
+  struct Range_Result {
+    double min = 0.0;
+    double max = 0.0;
+    std::vector<size_t> to_decode;
+  };
+  auto query_range(const void* stream, dims_type start, dims_type len) const
+      -> std::optional<Range_Result>;
+
+  // Threshold query: chunks with all values above `thld`, and chunks that straddle it.
+  //    The remaining chunks have no value above `thld`.
+  struct Threshold_Result {
+    std::vector<size_t> above;
+    std::vector<size_t> to_decode;
+  };
+  auto query_threshold(const void* stream, double thld) const -> std::optional<Threshold_Result>;
+
+ private:
   // To simplify logic with progressive read, we set a minimum number of bytes to read from
   // a chunk, unless the chunk doesn't have that many bytes (e.g., a constant chunk).
   const size_t m_progressive_min_chunk_bytes = 64;
 
+  // Each chunk takes 4 doubles (min, max, mean, variance) in the statistics index.
+  const size_t m_stats_bytes = sizeof(double) * 4;
+
+  // Super-chunk dimensions (3 x uint16) and the stripe size (uint32) follow the chunk dimensions.
+  const size_t m_super_bytes = 10;
+
   // Given the header of a bitstream and a desired percentage to truncate, return an
   //    updated header and a list of {offset, len} to access.
   //    Note: this function assumes that the header is complete.
   auto m_progressive_helper(const void* header_buf, size_t buf_len, unsigned pct) const
       -> std::tuple<vec8_type, std::vector<size_t>>;
+
+  // Read the 8 booleans and the volume and chunk dimensions into `header`, and return the
+  //    number of bytes they occupy together with the version number, or 0 if the bitstream
+  //    is not of a 3D volume or a chunked 2D slice.
+  auto m_read_dims(const uint8_t* p, SPERR3D_Header& header) const -> size_t;
 };
 
 }  // End of namespace sperr
@@ -61,6 +61,29 @@ int sperr_comp_2d(
     void** dst,         /* Output: buffer for the output bitstream, allocated by this function */
     size_t* dst_len);   /* Output: length of `dst` in byte */
 
+/*
+ * Same as sperr_comp_2d(), but write the output bitstream to a buffer provided by the caller.
+ *    `dst_cap` is the capacity of `dst` in byte, and sperr_comp_bound() gives a capacity
+ *    that is always big enough.
+ *
+ * Return value meanings:
+ *  0: success
+ *  1: `dst_cap` is too small; `dst_len` holds the number of bytes needed.
+ *  2: one or more of the parameters are not supported.
+ * -1: other error
+ */
+int sperr_comp_2d_into(
+    const void* src,    /* Input: buffer that contains a 2D slice */
+    int is_float,       /* Input: input buffer type: 1 == float, 0 == double */
+    size_t dimx,        /* Input: X (fastest-varying) dimension */
+    size_t dimy,        /* Input: Y (slowest-varying) dimension */
+    int mode,           /* Input: compression mode to use */
+    double quality,     /* Input: target quality */
+    int out_inc_header, /* Input: include a header in the output bitstream? 1 == yes, 0 == no */
+    void* dst,          /* Output: buffer for the output bitstream, provided by the caller */
+    size_t dst_cap,     /* Input: capacity of `dst` in byte */
+    size_t* dst_len);   /* Output: number of bytes written to `dst` */
+
 /*
  * Decompress a 2D SPERR-compressed buffer that is produced by sperr_comp_2d().
  *  Note that this bitstream shoult NOT contain a header. I.e., a bitstream produced by
@@ -82,7 +105,9 @@ int sperr_decomp_2d(
 
 /*
  * Parse the header of a bitstream and extract various information. The bitstream can be produced
- * by sperr_comp_3d(), or by sperr_comp_2d() with the `out_inc_header` option on.
+ * by sperr_comp_3d(), sperr_comp_1d(), sperr_comp_2d_stack(), or by sperr_comp_2d() with the
+ * `out_inc_header` option on. 1D arrays will have dimy == dimz == 1, and stacks of 2D slices will
+ * have the number of slices in dimz.
  */
 void sperr_parse_header(
     const void* src, /* Input: a SPERR bitstream */
@@ -118,6 +143,56 @@ int sperr_comp_3d(
     void** dst,       /* Output: buffer for the output bitstream, allocated by this function */
     size_t* dst_len); /* Output: length of `dst` in byte */
 
+/*
+ * Same as sperr_comp_3d(), but write the output bitstream to a buffer provided by the caller.
+ *    `dst_cap` is the capacity of `dst` in byte, and sperr_comp_bound() gives a capacity
+ *    that is always big enough.
+ *
+ * Return value meanings:
+ *  0: success
+ *  1: `dst_cap` is too small; `dst_len` holds the number of bytes needed.
+ *  2: one or more parameters isn't valid.
+ * -1: other error
+ */
+int sperr_comp_3d_into(
+    const void* src,  /* Input: buffer that contains a 3D volume */
+    int is_float,     /* Input: input buffer type: 1 == float, 0 = double */
+    size_t dimx,      /* Input: X (fastest-varying) dimension */
+    size_t dimy,      /* Input: Y dimension */
+    size_t dimz,      /* Input: Z (slowest-varying) dimension */
+    size_t chunk_x,   /* Input: preferred chunk dimension in X */
+    size_t chunk_y,   /* Input: preferred chunk dimension in Y */
+    size_t chunk_z,   /* Input: preferred chunk dimension in Z */
+    int mode,         /* Input: compression mode to use */
+    double quality,   /* Input: target quality */
+    size_t nthreads,  /* Input: number of OpenMP threads to use. 0 means using all threads. */
+    void* dst,        /* Output: buffer for the output bitstream, provided by the caller */
+    size_t dst_cap,   /* Input: capacity of `dst` in byte */
+    size_t* dst_len); /* Output: number of bytes written to `dst` */
+
+/*
+ * Calculate the worst-case size (in byte) of a bitstream produced by sperr_comp_3d() or
+ *    sperr_comp_2d() (with or without a header) for given dimensions and quality controls.
+ *    For 2D slices, pass in `dimz = 1` and chunk dimensions that are the same as the slice.
+ *    For 1D arrays (sperr_comp_1d()), pass in `dimy = dimz = 1` and `chunk_x = chunk_len`.
+ *
+ *    In fixed bit-per-pixel mode (mode == 1), the bound is close to the requested bitrate.
+ *    In the other modes, the bound covers the extreme case of all 64 bitplanes being coded,
+ *    so it is much bigger than the typical output size. Callers wanting a smaller buffer can
+ *    try a guess with the `*_into` functions, which report the needed size upon failure.
+ *
+ * Return value: the worst-case size, or 0 if one or more parameters isn't valid.
+ */
+size_t sperr_comp_bound(
+    size_t dimx,     /* Input: X (fastest-varying) dimension */
+    size_t dimy,     /* Input: Y dimension */
+    size_t dimz,     /* Input: Z (slowest-varying) dimension */
+    size_t chunk_x,  /* Input: preferred chunk dimension in X */
+    size_t chunk_y,  /* Input: preferred chunk dimension in Y */
+    size_t chunk_z,  /* Input: preferred chunk dimension in Z */
+    int mode,        /* Input: compression mode to use */
+    double quality); /* Input: target quality */
+
 /*
  * Decompress a 3D SPERR-compressed buffer that is produced by sperr_comp_3d().
  *
@@ -136,6 +211,168 @@ int sperr_decomp_3d(
     size_t* dimz,     /* Output: Z (slowest-varying) dimension */
     void** dst);      /* Output: buffer for the output 3D slice, allocated by this function */
 
+/*
+ * Compress a 1D array targetting different quality controls (modes):
+ *   mode == 1 --> fixed bit-per-pixel (BPP)
+ *   mode == 2 --> fixed peak signal-to-noise ratio (PSNR)
+ *   mode == 3 --> fixed point-wise error (PWE)
+ *
+ *   The array is divided into chunks of (about) `chunk_len` values, and the chunks are
+ *   compressed in parallel. The output bitstream always includes a header, and
+ *   sperr_comp_bound() with `dimy = dimz = 1` gives a capacity that is big enough for it.
+ *
+ * Return value meanings:
+ *  0: success
+ *  1: `dst` is not pointing to a NULL pointer!
+ *  2: one or more parameters isn't valid.
+ * -1: other error
+ */
+int sperr_comp_1d(
+    const void* src,  /* Input: buffer that contains a 1D array */
+    int is_float,     /* Input: input buffer type: 1 == float, 0 = double */
+    size_t len,       /* Input: number of values in the array */
+    size_t chunk_len, /* Input: preferred chunk length */
+    int mode,         /* Input: compression mode to use */
+    double quality,   /* Input: target quality */
+    size_t nthreads,  /* Input: number of OpenMP threads to use. 0 means using all threads. */
+    void** dst,       /* Output: buffer for the output bitstream, allocated by this function */
+    size_t* dst_len); /* Output: length of `dst` in byte */
+
+/*
+ * Decompress a 1D SPERR-compressed buffer that is produced by sperr_comp_1d().
+ *
+ * Return value meanings:
+ *  0: success
+ *  1: `dst` is not pointing to a NULL pointer!
+ * -1: other error
+ */
+int sperr_decomp_1d(
+    const void* src,  /* Input: buffer that contains a compressed bitstream */
+    size_t src_len,   /* Input: length of the input bitstream in byte */
+    int output_float, /* Input: output data type: 1 == float, 0 == double */
+    size_t nthreads,  /* Input: number of OMP threads to use. 0 means using all threads. */
+    size_t* len,      /* Output: number of values in the array */
+    void** dst);      /* Output: buffer for the output 1D array, allocated by this function */
+
+/*
+ * Compress a stack of `nslices` 2D slices of the same dimension, which are stored one after
+ *    another in `src`, targetting the same quality controls (modes) as sperr_comp_2d().
+ *    The slices are compressed in parallel, and the output is a single container with a slice
+ *    index, so any slice can be decompressed on its own by sperr_decomp_2d_slice().
+ *
+ * Return value meanings:
+ *  0: success
+ *  1: `dst` is not pointing to a NULL pointer!
+ *  2: one or more parameters isn't valid.
+ * -1: other error
+ */
+int sperr_comp_2d_stack(
+    const void* src,  /* Input: buffer that contains a stack of 2D slices */
+    int is_float,     /* Input: input buffer type: 1 == float, 0 = double */
+    size_t dimx,      /* Input: X (fastest-varying) dimension of each slice */
+    size_t dimy,      /* Input: Y dimension of each slice */
+    size_t nslices,   /* Input: number of slices in the stack */
+    int mode,         /* Input: compression mode to use */
+    double quality,   /* Input: target quality */
+    size_t nthreads,  /* Input: number of OpenMP threads to use. 0 means using all threads. */
+    void** dst,       /* Output: buffer for the output bitstream, allocated by this function */
+    size_t* dst_len); /* Output: length of `dst` in byte */
+
+/*
+ * Decompress one slice from a container produced by sperr_comp_2d_stack().
+ *    sperr_parse_header() reports the slice dimensions in `dimx` and `dimy`, and the number
+ *    of slices in `dimz`. Only the bitstream of the requested slice is decoded.
+ *
+ * Return value meanings:
+ *  0: success
+ *  1: `dst` is not pointing to a NULL pointer!
+ *  2: `idx` is out of range.
+ * -1: other error
+ */
+int sperr_decomp_2d_slice(
+    const void* src,  /* Input: buffer that contains a compressed stack */
+    size_t src_len,   /* Input: length of the input bitstream in byte */
+    int output_float, /* Input: output data type: 1 == float, 0 == double */
+    size_t idx,       /* Input: index of the slice to decompress */
+    void** dst);      /* Output: buffer for the output 2D slice, allocated by this function */
+
+/*
+ * Reusable compression and decompression contexts for 3D volumes.
+ *    A context keeps its compressor (or decompressor) instances and their internal buffers
+ *    across calls, which saves repeated memory allocation when many volumes are processed.
+ *    A context is not thread safe: use one context per calling thread.
+ *    sperr_cctx_create() and sperr_dctx_create() return NULL upon failure, and the contexts
+ *    need to be released by sperr_cctx_free() and sperr_dctx_free(), respectively.
+ */
+typedef struct sperr_cctx sperr_cctx;
+typedef struct sperr_dctx sperr_dctx;
+
+sperr_cctx* sperr_cctx_create(void);
+void sperr_cctx_free(sperr_cctx* ctx);
+sperr_dctx* sperr_dctx_create(void);
+void sperr_dctx_free(sperr_dctx* ctx);
+
+/*
+ * Same as sperr_comp_3d_into(), but use a compression context.
+ *
+ * Return value meanings:
+ *  0: success
+ *  1: `dst_cap` is too small; `dst_len` holds the number of bytes needed.
+ *  2: one or more parameters isn't valid.
+ * -1: other error
+ */
+int sperr_compress_cctx(
+    sperr_cctx* ctx,  /* Input: a compression context created by sperr_cctx_create() */
+    const void* src,  /* Input: buffer that contains a 3D volume */
+    int is_float,     /* Input: input buffer type: 1 == float, 0 = double */
+    size_t dimx,      /* Input: X (fastest-varying) dimension */
+    size_t dimy,      /* Input: Y dimension */
+    size_t dimz,      /* Input: Z (slowest-varying) dimension */
+    size_t chunk_x,   /* Input: preferred chunk dimension in X */
+    size_t chunk_y,   /* Input: preferred chunk dimension in Y */
+    size_t chunk_z,   /* Input: preferred chunk dimension in Z */
+    int mode,         /* Input: compression mode to use */
+    double quality,   /* Input: target quality */
+    size_t nthreads,  /* Input: number of OpenMP threads to use. 0 means using all threads. */
+    void* dst,        /* Output: buffer for the output bitstream, provided by the caller */
+    size_t dst_cap,   /* Input: capacity of `dst` in byte */
+    size_t* dst_len); /* Output: number of bytes written to `dst` */
+
+/*
+ * Decompress a 3D SPERR-compressed buffer that is produced by sperr_comp_3d() (or its
+ *    variants) using a decompression context, and write the output volume to a buffer
+ *    provided by the caller.
+ *
+ * Return value meanings:
+ *  0: success
+ *  1: `dst_cap` is too small; `dimx`, `dimy`, and `dimz` hold the volume dimensions.
+ *  2: one or more parameters isn't valid.
+ * -1: other error
+ */
+int sperr_decompress_dctx(
+    sperr_dctx* ctx,  /* Input: a decompression context created by sperr_dctx_create() */
+    const void* src,  /* Input: buffer that contains a compressed bitstream */
+    size_t src_len,   /* Input: length of the input bitstream in byte */
+    int output_float, /* Input: output data type: 1 == float, 0 == double */
+    size_t nthreads,  /* Input: number of OMP threads to use. 0 means using all threads. */
+    size_t* dimx,     /* Output: X (fast-varying) dimension */
+    size_t* dimy,     /* Output: Y dimension */
+    size_t* dimz,     /* Output: Z (slowest-varying) dimension */
+    void* dst,        /* Output: buffer for the output 3D volume, provided by the caller */
+    size_t dst_cap);  /* Input: capacity of `dst` in byte */
+
+/*
+ * Write a human-readable breakdown of per-stage timing and counters of the most recent
+ *    compression (or decompression) performed with a context to `buf` as a null-terminated
+ *    string, truncated to fit `buf_len` bytes. `buf` can be NULL if `buf_len` is zero.
+ *    The breakdown is only populated when SPERR is built with SPERR_INSTRUMENT=ON.
+ *
+ * Return value: the length of the complete breakdown, not counting the terminating null
+ *    character, in the same way as snprintf(). A return value >= `buf_len` means truncation.
+ */
+size_t sperr_cctx_profile(const sperr_cctx* ctx, char* buf, size_t buf_len);
+size_t sperr_dctx_profile(const sperr_dctx* ctx, char* buf, size_t buf_len);
+
 /*
  * Truncate a 3D SPERR-compressed bitstream to a percentage of its original length.
  *    Note on `src_len`: it does not to be the full length of the original bitstream, rather,
@@ -5,15 +5,19 @@
 // We put common functions that are used across the project here.
 //
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstddef>  // std::size_t
 #include <cstdint>  // fixed width integers
 #include <cstdlib>
+#include <cstring>
 #include <iterator>
 #include <limits>
 #include <memory>
 #include <optional>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #ifndef USE_VANILLA_CONFIG
@@ -63,6 +67,28 @@ enum class RTNType {
   Error
 };
 
+// 16-bit floating point values are passed around in their storage format, i.e., the bits of an
+//    IEEE 754 half precision value (fp16_type) or a bfloat16 value (bf16_type).
+struct fp16_type {
+  uint16_t bits = 0;
+};
+struct bf16_type {
+  uint16_t bits = 0;
+};
+
+// Data types of the input (and output) values, as recorded in a bitstream header.
+enum class DataType : unsigned char {
+  Float,
+  Double,
+  FP16,
+  BF16,
+  Int8,
+  UInt8,
+  Int16,
+  UInt16,
+  Int32
+};
+
 //
 // Helper functions
 //
@@ -126,6 +152,11 @@ auto unpack_booleans(std::vector<bool>& dest,
 auto pack_8_booleans(std::array<bool, 8>) -> uint8_t;
 auto unpack_8_booleans(uint8_t) -> std::array<bool, 8>;
 
+// Record a data type in bool[2] and bool[5-7] of the 8 booleans of a 3D header, and read it back.
+//    bool[2] keeps telling if float (true) or double (false) holds the data type exactly.
+void encode_data_type(DataType, std::array<bool, 8>&);
+auto decode_data_type(const std::array<bool, 8>&) -> DataType;
+
 // Read from and write to a file
 // Note: not using references for `filename` to allow a c-style string literal to be passed in.
 auto write_n_bytes(std::string filename, size_t n_bytes, const void* buffer) -> RTNType;
@@ -170,6 +201,12 @@ auto kahan_summation(const T*, size_t) -> T;
 // Note 2: this function works on degraded 2D or 1D volumes too.
 auto chunk_volume(dims_type vol_dim, dims_type chunk_dim) -> std::vector<std::array<size_t, 6>>;
 
+// Group the chunks given by `chunk_volume()` into super-chunks of (up to) `super_dim` chunks
+// along each axis. It returns the chunk indices in each super-chunk, where both the super-chunks
+// and the chunks within a super-chunk are in the same order as chunks (X varying fastest).
+auto super_chunk_volume(dims_type vol_dim, dims_type chunk_dim, dims_type super_dim)
+    -> std::vector<std::vector<size_t>>;
+
 // Calculate the mean and variance of a given array.
 // In case of arrays of size zero, it will return {NaN, NaN}.
 // In case of `omp_nthreads == 0`, it will use all available OpenMP threads.
@@ -178,6 +215,101 @@ auto chunk_volume(dims_type vol_dim, dims_type chunk_dim) -> std::vector<std::ar
 template <typename T>
 auto calc_mean_var(const T*, size_t len, size_t omp_nthreads = 0) -> std::array<T, 2>;
 
+//
+// Conversions between the supported data types and double. They're defined here so they
+// can be inlined into the loops that gather and scatter chunks.
+//
+template <typename T>
+constexpr auto data_type_of() -> DataType
+{
+  if constexpr (std::is_same_v<T, float>)
+    return DataType::Float;
+  else if constexpr (std::is_same_v<T, double>)
+    return DataType::Double;
+  else if constexpr (std::is_same_v<T, fp16_type>)
+    return DataType::FP16;
+  else if constexpr (std::is_same_v<T, bf16_type>)
+    return DataType::BF16;
+  else if constexpr (std::is_same_v<T, int8_t>)
+    return DataType::Int8;
+  else if constexpr (std::is_same_v<T, uint8_t>)
+    return DataType::UInt8;
+  else if constexpr (std::is_same_v<T, int16_t>)
+    return DataType::Int16;
+  else if constexpr (std::is_same_v<T, uint16_t>)
+    return DataType::UInt16;
+  else {
+    static_assert(std::is_same_v<T, int32_t>, "!! Unsupported data type !!");
+    return DataType::Int32;
+  }
+}
+
+template <typename T>
+inline auto to_double(T val) -> double
+{
+  if constexpr (std::is_same_v<T, fp16_type>) {
+    const auto sign = (val.bits & 0x8000) ? -1.0 : 1.0;
+    const int exp = (val.bits >> 10) & 0x1f;
+    const int mant = val.bits & 0x3ff;
+    if (exp == 0)  // zero and subnormals
+      return sign * std::ldexp(double(mant), -24);
+    else if (exp == 0x1f)
+      return mant ? std::numeric_limits<double>::quiet_NaN()
+                  : sign * std::numeric_limits<double>::infinity();
+    else
+      return sign * std::ldexp(double(mant | 0x400), exp - 25);
+  }
+  else if constexpr (std::is_same_v<T, bf16_type>) {
+    const uint32_t bits = uint32_t{val.bits} << 16;
+    float f = 0.f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+  }
+  else
+    return static_cast<double>(val);
+}
+
+// Floating point types are rounded to the nearest even, and integer types are rounded to the
+//    nearest and clamped to their range.
+template <typename T>
+inline auto from_double(double val) -> T
+{
+  if constexpr (std::is_same_v<T, fp16_type>) {
+    const auto f = static_cast<float>(val);
+    uint32_t x = 0;
+    std::memcpy(&x, &f, sizeof(x));
+    const auto sign = static_cast<uint16_t>((x >> 16) & 0x8000);
+    const auto abs = x & 0x7fffffffu;
+    if (abs >= 0x7f800000u)  // infinity and NaN
+      return {static_cast<uint16_t>(sign | 0x7c00 | (abs > 0x7f800000u ? 0x200 : 0))};
+    else if (abs >= 0x477ff000u)  // rounds to beyond 65504
+      return {static_cast<uint16_t>(sign | 0x7c00)};
+    else if (abs < 0x38800000u)  // subnormals
+      return {static_cast<uint16_t>(sign | uint16_t(std::nearbyint(std::fabs(f) * 16777216.f)))};
+    else {
+      const auto r = abs - 0x38000000u;
+      return {static_cast<uint16_t>(sign | ((r + 0xfffu + ((r >> 13) & 1u)) >> 13))};
+    }
+  }
+  else if constexpr (std::is_same_v<T, bf16_type>) {
+    const auto f = static_cast<float>(val);
+    uint32_t x = 0;
+    std::memcpy(&x, &f, sizeof(x));
+    if ((x & 0x7fffffffu) > 0x7f800000u)  // NaN
+      return {static_cast<uint16_t>((x >> 16) | 0x40)};
+    return {static_cast<uint16_t>((x + 0x7fffu + ((x >> 16) & 1u)) >> 16)};
+  }
+  else if constexpr (std::is_integral_v<T>) {
+    constexpr auto lo = double(std::numeric_limits<T>::lowest());
+    constexpr auto hi = double(std::numeric_limits<T>::max());
+    if (std::isnan(val))
+      return T{0};
+    return static_cast<T>(std::nearbyint(std::clamp(val, lo, hi)));
+  }
+  else
+    return static_cast<T>(val);
+}
+
 };  // namespace sperr
 
 #endif
@@ -15,6 +15,7 @@ sperr::Bitstream::Bitstream(size_t nbits)
 void sperr::Bitstream::rewind()
 {
   m_itr = m_buf.begin();
+  m_view_idx = 0;
   m_buffer = 0;
   m_bits = 0;
 }
@@ -26,6 +27,9 @@ auto sperr::Bitstream::capacity() const -> size_t
 
 void sperr::Bitstream::reserve(size_t nbits)
 {
+  m_view = nullptr;
+  m_view_bits = 0;
+
   if (nbits > m_buf.size() * 64) {
     // Number of longs that's absolutely needed.
     auto num_longs = nbits / 64;
@@ -41,12 +45,17 @@ void sperr::Bitstream::reserve(size_t nbits)
 
 void sperr::Bitstream::reset()
 {
+  m_view = nullptr;
+  m_view_bits = 0;
   std::fill(m_buf.begin(), m_buf.end(), 0);
 }
 
 // Functions for read
 auto sperr::Bitstream::rtell() const -> size_t
 {
+  if (m_view)
+    return m_view_idx * 64 - m_bits;
+
   // Stupid C++ insists that `m_buf.begin()` gives me a const iterator...
   std::vector<uint64_t>::const_iterator itr2 = m_itr;  // NOLINT
   return std::distance(m_buf.begin(), itr2) * 64 - m_bits;
@@ -54,6 +63,21 @@ auto sperr::Bitstream::rtell() const -> size_t
 
 void sperr::Bitstream::rseek(size_t offset)
 {
+  if (m_view) {
+    m_view_idx = offset / 64;
+    const auto rem = offset % 64;
+    if (rem) {
+      m_buffer = m_view_word(m_view_idx) >> rem;
+      ++m_view_idx;
+      m_bits = 64 - rem;
+    }
+    else {
+      m_buffer = 0;
+      m_bits = 0;
+    }
+    return;
+  }
+
   m_itr = m_buf.begin() + offset / 64;
   const auto rem = offset % 64;
   if (rem) {
@@ -70,8 +94,14 @@ void sperr::Bitstream::rseek(size_t offset)
 auto sperr::Bitstream::rbit() -> bool
 {
   if (m_bits == 0) {
-    m_buffer = *m_itr;
-    ++m_itr;
+    if (m_view) {
+      m_buffer = m_view_word(m_view_idx);
+      ++m_view_idx;
+    }
+    else {
+      m_buffer = *m_itr;
+      ++m_itr;
+    }
     m_bits = 64;
   }
   --m_bits;
@@ -90,6 +120,9 @@ auto sperr::Bitstream::wtell() const -> size_t
 
 void sperr::Bitstream::wseek(size_t offset)
 {
+  m_view = nullptr;
+  m_view_bits = 0;
+
   m_itr = m_buf.begin() + offset / 64;
   const auto rem = offset % 64;
   if (rem) {
@@ -191,3 +224,32 @@ void sperr::Bitstream::parse_bitstream(const void* p, size_t num_bits)
 
   this->rewind();
 }
+
+void sperr::Bitstream::view_bitstream(const void* p, size_t num_bits)
+{
+  this->rewind();
+  m_view = static_cast<const std::byte*>(p);
+  m_view_bits = num_bits;
+}
+
+auto sperr::Bitstream::m_view_word(size_t idx) const -> uint64_t
+{
+  const auto num_longs = m_view_bits / 64;
+  if (idx < num_longs) {
+    uint64_t value = 0;
+    std::memcpy(&value, m_view + idx * sizeof(uint64_t), sizeof(uint64_t));
+    return value;
+  }
+  else if (idx == num_longs) {
+    // The last partial word, if exists, is padded with 0's.
+    auto rem_bytes = m_view_bits / 8 - num_longs * sizeof(uint64_t);
+    if (m_view_bits % 8 != 0)
+      rem_bytes++;
+    uint64_t value = 0;
+    if (rem_bytes > 0)
+      std::memcpy(&value, m_view + idx * sizeof(uint64_t), rem_bytes);
+    return value;
+  }
+  else
+    return 0;
+}
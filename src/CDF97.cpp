@@ -64,6 +64,11 @@ auto sperr::CDF97::get_dims() const -> std::array<size_t, 3>
   return m_dims;
 }
 
+auto sperr::CDF97::memory_usage() const -> size_t
+{
+  return (m_data_buf.capacity() + m_qcc_buf.capacity() + m_slice_buf.capacity()) * sizeof(double);
+}
+
 void sperr::CDF97::dwt1d()
 {
   auto num_xforms = sperr::num_of_xforms(m_dims[0]);
@@ -25,23 +25,8 @@ auto sperr::Conditioner::condition(vecd_type& buf, dims_type dims) -> condi_type
 
   // Operation 1
   //
-  if (std::all_of(buf.cbegin(), buf.cend(), [v0 = buf[0]](auto v) { return v == v0; })) {
-    meta[m_constant_field_idx] = true;
-    const double val = buf[0];
-    const uint64_t nval = buf.size();
-    //
-    // Assemble a header of the following info and ordering:
-    // meta   nval  val
-    //
-    auto header = condi_type();
-    header[0] = sperr::pack_8_booleans(meta);
-    size_t pos = 1;
-    std::memcpy(header.data() + pos, &nval, sizeof(nval));
-    pos += sizeof(nval);
-    std::memcpy(header.data() + pos, &val, sizeof(val));
-
-    return header;
-  }
+  if (std::all_of(buf.cbegin(), buf.cend(), [v0 = buf[0]](auto v) { return v == v0; }))
+    return constant_header(buf[0], buf.size());
 
   // Operation 2
   //
@@ -100,6 +85,43 @@ auto sperr::Conditioner::is_constant(uint8_t byte) const -> bool
   return b8[m_constant_field_idx];
 }
 
+auto sperr::Conditioner::constant_header(double val, size_t nval) const -> condi_type
+{
+  auto meta = std::array<bool, 8>{true,    // subtract mean
+                                  false,   // unused
+                                  false,   // unused
+                                  false,   // unused
+                                  false,   // unused
+                                  false,   // unused
+                                  false,   // unused
+                                  false};  // [7]: is this a constant field?
+  meta[m_constant_field_idx] = true;
+  const uint64_t nval64 = nval;
+
+  // Assemble a header of the following info and ordering:
+  // meta   nval  val
+  //
+  auto header = condi_type();
+  header[0] = sperr::pack_8_booleans(meta);
+  size_t pos = 1;
+  std::memcpy(header.data() + pos, &nval64, sizeof(nval64));
+  pos += sizeof(nval64);
+  std::memcpy(header.data() + pos, &val, sizeof(val));
+
+  return header;
+}
+
+auto sperr::Conditioner::retrieve_mean(condi_type header) const -> double
+{
+  // A constant field records the number of values before its value; see `condition()`.
+  size_t pos = 1;
+  if (is_constant(header[0]))
+    pos += sizeof(uint64_t);
+  double mean = 0.0;
+  std::memcpy(&mean, header.data() + pos, sizeof(mean));
+  return mean;
+}
+
 void sperr::Conditioner::save_q(condi_type& header, double q) const
 {
   // Save at position 9, the same as in `retrieve_q()`.
@@ -0,0 +1,75 @@
+#include "Memory_Usage.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+void sperr::Memory_Usage::set_current(MemComp c, size_t bytes)
+{
+  const auto i = size_t(c);
+  m_current[i] = bytes;
+  m_peak[i] = std::max(m_peak[i], bytes);
+  m_peak_total = std::max(m_peak_total, current_total());
+}
+
+void sperr::Memory_Usage::set_current(const std::array<size_t, size_t(MemComp::NumComps)>& bytes)
+{
+  m_current = bytes;
+  for (size_t i = 0; i < m_current.size(); i++)
+    m_peak[i] = std::max(m_peak[i], bytes[i]);
+  m_peak_total = std::max(m_peak_total, current_total());
+}
+
+void sperr::Memory_Usage::merge(const Memory_Usage& other)
+{
+  for (size_t i = 0; i < m_current.size(); i++) {
+    m_current[i] += other.m_current[i];
+    m_peak[i] += other.m_peak[i];
+  }
+  m_peak_total += other.m_peak_total;
+}
+
+void sperr::Memory_Usage::reset()
+{
+  *this = Memory_Usage();
+}
+
+auto sperr::Memory_Usage::current(MemComp c) const -> size_t
+{
+  return m_current[size_t(c)];
+}
+
+auto sperr::Memory_Usage::peak(MemComp c) const -> size_t
+{
+  return m_peak[size_t(c)];
+}
+
+auto sperr::Memory_Usage::current_total() const -> size_t
+{
+  return std::accumulate(m_current.cbegin(), m_current.cend(), size_t{0});
+}
+
+auto sperr::Memory_Usage::peak_total() const -> size_t
+{
+  return m_peak_total;
+}
+
+auto sperr::Memory_Usage::to_string() const -> std::string
+{
+  const auto names = std::array<const char*, size_t(MemComp::NumComps)>{
+      "coefficients", "original copy", "quantized", "wavelet", "speck", "outlier", "output"};
+
+  auto str = std::string();
+  char line[128];
+  std::snprintf(line, sizeof(line), "%-16s %14s %14s\n", "Component", "Current (B)", "Peak (B)");
+  str += line;
+  for (size_t i = 0; i < m_current.size(); i++) {
+    std::snprintf(line, sizeof(line), "%-16s %14zu %14zu\n", names[i], m_current[i], m_peak[i]);
+    str += line;
+  }
+  std::snprintf(line, sizeof(line), "%-16s %14zu %14zu\n", "Total", current_total(),
+                m_peak_total);
+  str += line;
+
+  return str;
+}
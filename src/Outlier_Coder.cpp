@@ -33,12 +33,31 @@ auto sperr::Outlier_Coder::view_outlier_list() const -> const std::vector<Outlie
   return m_LOS;
 }
 
+auto sperr::Outlier_Coder::memory_usage() const -> size_t
+{
+  auto bytes = m_LOS.capacity() * sizeof(Outlier) + (m_sign_array.size() + 63) / 64 * 8;
+  bytes += std::visit([](auto&& vec) { return vec.capacity() * sizeof(vec[0]); }, m_vals_ui);
+  bytes += std::visit([](auto&& enc) { return enc.memory_usage(); }, m_encoder);
+  bytes += std::visit([](auto&& dec) { return dec.memory_usage(); }, m_decoder);
+  return bytes;
+}
+
 void sperr::Outlier_Coder::append_encoded_bitstream(vec8_type& buf) const
 {
   // Just append the bitstream produced by `m_encoder` is fine.
   std::visit([&buf](auto&& enc) { enc.append_encoded_bitstream(buf); }, m_encoder);
 }
 
+auto sperr::Outlier_Coder::encoded_bitstream_len() const -> size_t
+{
+  return std::visit([](auto&& enc) { return enc.encoded_bitstream_len(); }, m_encoder);
+}
+
+void sperr::Outlier_Coder::write_encoded_bitstream(void* p) const
+{
+  std::visit([p](auto&& enc) { enc.write_encoded_bitstream(p); }, m_encoder);
+}
+
 auto sperr::Outlier_Coder::get_stream_full_len(const void* p) const -> size_t
 {
   return std::visit([p](auto&& dec) { return dec.get_stream_full_len(p); }, m_decoder);
@@ -0,0 +1,156 @@
+#include "Profile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+
+void sperr::Profile::add_time(Stage s, double seconds)
+{
+  m_times[size_t(s)] += seconds;
+}
+
+void sperr::Profile::add_bytes(Stage s, size_t bytes)
+{
+  m_bytes[size_t(s)] += bytes;
+}
+
+void sperr::Profile::set_wall_time(double seconds)
+{
+  m_wall_time = seconds;
+}
+
+void sperr::Profile::add_chunks(size_t n)
+{
+  m_chunks += n;
+}
+
+void sperr::Profile::add_bitplanes(size_t n)
+{
+  m_bitplanes += n;
+}
+
+void sperr::Profile::add_outliers(size_t n)
+{
+  m_outliers += n;
+}
+
+void sperr::Profile::update_LIS_size(size_t n)
+{
+  m_peak_LIS = std::max(m_peak_LIS, n);
+}
+
+void sperr::Profile::merge(const Profile& other)
+{
+  for (size_t i = 0; i < m_times.size(); i++) {
+    m_times[i] += other.m_times[i];
+    m_bytes[i] += other.m_bytes[i];
+  }
+  m_wall_time = std::max(m_wall_time, other.m_wall_time);
+  m_chunks += other.m_chunks;
+  m_bitplanes += other.m_bitplanes;
+  m_outliers += other.m_outliers;
+  m_peak_LIS = std::max(m_peak_LIS, other.m_peak_LIS);
+}
+
+void sperr::Profile::reset()
+{
+  *this = Profile();
+}
+
+auto sperr::Profile::time(Stage s) const -> double
+{
+  return m_times[size_t(s)];
+}
+
+auto sperr::Profile::bytes(Stage s) const -> size_t
+{
+  return m_bytes[size_t(s)];
+}
+
+auto sperr::Profile::wall_time() const -> double
+{
+  return m_wall_time;
+}
+
+auto sperr::Profile::num_chunks() const -> size_t
+{
+  return m_chunks;
+}
+
+auto sperr::Profile::num_bitplanes() const -> size_t
+{
+  return m_bitplanes;
+}
+
+auto sperr::Profile::num_outliers() const -> size_t
+{
+  return m_outliers;
+}
+
+auto sperr::Profile::peak_LIS_size() const -> size_t
+{
+  return m_peak_LIS;
+}
+
+auto sperr::Profile::to_string() const -> std::string
+{
+#ifndef SPERR_INSTRUMENT
+  return "Profiling is unavailable: SPERR is built without SPERR_INSTRUMENT.\n";
+#else
+  const auto names = std::array<const char*, size_t(Stage::NumStages)>{
+      "chunk copy",     "conditioning",     "wavelet",          "q estimation",
+      "quantization",   "speck sorting",    "speck refinement", "outlier coding",
+      "inv. quantize",  "inverse wavelet",  "inv. condition"};
+  const auto total = std::accumulate(m_times.cbegin(), m_times.cend(), 0.0);
+
+  auto str = std::string();
+  char line[128];
+  std::snprintf(line, sizeof(line), "%-18s %12s %8s %14s %10s\n", "Stage", "Time (s)", "Share",
+                "Bytes", "GB/s");
+  str += line;
+  for (size_t i = 0; i < m_times.size(); i++) {
+    if (m_times[i] == 0.0 && m_bytes[i] == 0)
+      continue;
+    const auto share = total > 0.0 ? m_times[i] / total * 100.0 : 0.0;
+    const auto gbps = m_times[i] > 0.0 ? double(m_bytes[i]) / m_times[i] * 1e-9 : 0.0;
+    std::snprintf(line, sizeof(line), "%-18s %12.6f %7.2f%% %14zu %10.3f\n", names[i], m_times[i],
+                  share, m_bytes[i], gbps);
+    str += line;
+  }
+  std::snprintf(line, sizeof(line), "%-18s %12.6f (summed over chunks and threads)\n",
+                "Stages total", total);
+  str += line;
+  std::snprintf(line, sizeof(line), "%-18s %12.6f\n", "Wall time", m_wall_time);
+  str += line;
+  std::snprintf(line, sizeof(line),
+                "Chunks: %zu, bitplanes coded: %zu, peak LIS size: %zu, outliers: %zu\n",
+                m_chunks, m_bitplanes, m_peak_LIS, m_outliers);
+  str += line;
+
+  return str;
+#endif
+}
+
+sperr::Profile_Timer::Profile_Timer(Profile* prof)
+    : m_prof(prof), m_stage(Stage::NumStages), m_start(std::chrono::steady_clock::now())
+{
+}
+
+sperr::Profile_Timer::Profile_Timer(Profile* prof, Stage stage, size_t bytes)
+    : m_prof(prof), m_stage(stage), m_start(std::chrono::steady_clock::now())
+{
+  if (m_prof)
+    m_prof->add_bytes(m_stage, bytes);
+}
+
+sperr::Profile_Timer::~Profile_Timer()
+{
+  if (m_prof) {
+    const auto end = std::chrono::steady_clock::now();
+    const auto seconds = std::chrono::duration<double>(end - m_start).count();
+    if (m_stage == Stage::NumStages)
+      m_prof->set_wall_time(seconds);
+    else
+      m_prof->add_time(m_stage, seconds);
+  }
+}
@@ -54,3 +54,10 @@ void sperr::SPECK1D_FLT::m_inverse_wavelet_xform(bool multi_res)
   // Unfortunately, there's no multi-resolution support for 1D arrays...
   m_cdf.idwt1d();
 }
+
+auto sperr::SPECK1D_FLT::m_lowest_subband() const -> std::tuple<dims_type, size_t>
+{
+  // The same number of levels as in `CDF97::dwt1d()`.
+  const auto lev = sperr::num_of_xforms(m_dims[0]);
+  return {{sperr::calc_approx_detail_len(m_dims[0], lev)[0], 1, 1}, lev};
+}
@@ -15,6 +15,22 @@ void sperr::SPECK1D_INT<T>::m_clean_LIS()
   }
 }
 
+template <typename T>
+auto sperr::SPECK1D_INT<T>::m_LIS_size() const -> size_t
+{
+  return std::accumulate(m_LIS.cbegin(), m_LIS.cend(), size_t{0},
+                         [](size_t a, const auto& list) { return a + list.size(); });
+}
+
+template <typename T>
+auto sperr::SPECK1D_INT<T>::memory_usage() const -> size_t
+{
+  auto bytes = SPECK_INT<T>::memory_usage() + m_LIS.capacity() * sizeof(m_LIS[0]);
+  for (const auto& list : m_LIS)
+    bytes += list.capacity() * sizeof(Set1D);
+  return bytes;
+}
+
 template <typename T>
 void sperr::SPECK1D_INT<T>::m_initialize_lists()
 {
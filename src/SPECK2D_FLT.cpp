@@ -56,3 +56,12 @@ void sperr::SPECK2D_FLT::m_inverse_wavelet_xform(bool multi_res)
   else
     m_hierarchy = m_cdf.idwt2d_multi_res();
 }
+
+auto sperr::SPECK2D_FLT::m_lowest_subband() const -> std::tuple<dims_type, size_t>
+{
+  // The same number of levels as in `CDF97::dwt2d()`.
+  const auto lev = sperr::num_of_xforms(std::min(m_dims[0], m_dims[1]));
+  return {{sperr::calc_approx_detail_len(m_dims[0], lev)[0],
+           sperr::calc_approx_detail_len(m_dims[1], lev)[0], 1},
+          lev * 2};
+}
@@ -1,10 +1,13 @@
 #include "SPECK2D_INT.h"
+#include "SPECK2D_INT_DEC.h"
+#include "SPECK2D_INT_ENC.h"
 
 #include <algorithm>
 #include <cassert>
+#include <numeric>
 
-template <typename T>
-void sperr::SPECK2D_INT<T>::m_sorting_pass()
+template <typename T, typename Derived>
+void sperr::SPECK2D_INT<T, Derived>::m_sorting_pass()
 {
   // First, process all insignificant pixels.
   //
@@ -16,7 +19,7 @@ void sperr::SPECK2D_INT<T>::m_sorting_pass()
       for (size_t j = 0; j < 64; j++) {
         if ((value >> j) & uint64_t{1}) {
           size_t dummy = 0;
-          m_process_P(i + j, dummy, true);
+          m_derived().m_process_P(i + j, dummy, true);
         }
       }
     }
@@ -24,7 +27,7 @@ void sperr::SPECK2D_INT<T>::m_sorting_pass()
   for (auto i = bits_x64; i < m_LIP_mask.size(); i++) {
     if (m_LIP_mask.rbit(i)) {
       size_t dummy = 0;
-      m_process_P(i, dummy, true);
+      m_derived().m_process_P(i, dummy, true);
     }
   }
 
@@ -34,17 +37,17 @@ void sperr::SPECK2D_INT<T>::m_sorting_pass()
     auto idx1 = m_LIS.size() - tmp;
     for (size_t idx2 = 0; idx2 < m_LIS[idx1].size(); idx2++) {
       size_t dummy = 0;
-      m_process_S(idx1, idx2, dummy, true);
+      m_derived().m_process_S(idx1, idx2, dummy, true);
     }
   }
 
   // Third, process the sole TypeI set.
   //
-  m_process_I(true);
+  m_derived().m_process_I(true);
 }
 
-template <typename T>
-void sperr::SPECK2D_INT<T>::m_code_S(size_t idx1, size_t idx2)
+template <typename T, typename Derived>
+void sperr::SPECK2D_INT<T, Derived>::m_code_S(size_t idx1, size_t idx2)
 {
   auto set = m_LIS[idx1][idx2];
   auto subsets = m_partition_S(set);
@@ -57,18 +60,18 @@ void sperr::SPECK2D_INT<T>::m_code_S(size_t idx1, size_t idx2)
     if (it->is_pixel()) {
       auto pixel_idx = it->start_y * m_dims[0] + it->start_x;
       m_LIP_mask.wtrue(pixel_idx);
-      m_process_P(pixel_idx, counter, need_decide);
+      m_derived().m_process_P(pixel_idx, counter, need_decide);
     }
     else {
       auto newidx1 = it->part_level;
       m_LIS[newidx1].push_back(*it);
-      m_process_S(newidx1, m_LIS[newidx1].size() - 1, counter, need_decide);
+      m_derived().m_process_S(newidx1, m_LIS[newidx1].size() - 1, counter, need_decide);
     }
   }
 }
 
-template <typename T>
-void sperr::SPECK2D_INT<T>::m_code_I()
+template <typename T, typename Derived>
+void sperr::SPECK2D_INT<T, Derived>::m_code_I()
 {
   auto subsets = m_partition_I();
 
@@ -77,14 +80,14 @@ void sperr::SPECK2D_INT<T>::m_code_I()
     if (!set.is_empty()) {
       auto newidx1 = set.part_level;
       m_LIS[newidx1].push_back(set);
-      m_process_S(newidx1, m_LIS[newidx1].size() - 1, counter, true);
+      m_derived().m_process_S(newidx1, m_LIS[newidx1].size() - 1, counter, true);
     }
   }
-  m_process_I(counter != 0);
+  m_derived().m_process_I(counter != 0);
 }
 
-template <typename T>
-void sperr::SPECK2D_INT<T>::m_clean_LIS()
+template <typename T, typename Derived>
+void sperr::SPECK2D_INT<T, Derived>::m_clean_LIS()
 {
   for (auto& list : m_LIS) {
     auto it = std::remove_if(list.begin(), list.end(), [](auto& s) { return s.is_empty(); });
@@ -92,8 +95,24 @@ void sperr::SPECK2D_INT<T>::m_clean_LIS()
   }
 }
 
-template <typename T>
-auto sperr::SPECK2D_INT<T>::m_partition_S(Set2D set) const -> std::array<Set2D, 4>
+template <typename T, typename Derived>
+auto sperr::SPECK2D_INT<T, Derived>::m_LIS_size() const -> size_t
+{
+  return std::accumulate(m_LIS.cbegin(), m_LIS.cend(), size_t{0},
+                         [](size_t a, const auto& list) { return a + list.size(); });
+}
+
+template <typename T, typename Derived>
+auto sperr::SPECK2D_INT<T, Derived>::memory_usage() const -> size_t
+{
+  auto bytes = SPECK_INT<T>::memory_usage() + m_LIS.capacity() * sizeof(m_LIS[0]);
+  for (const auto& list : m_LIS)
+    bytes += list.capacity() * sizeof(Set2D);
+  return bytes;
+}
+
+template <typename T, typename Derived>
+auto sperr::SPECK2D_INT<T, Derived>::m_partition_S(Set2D set) const -> std::array<Set2D, 4>
 {
   auto subsets = std::array<Set2D, 4>();
 
@@ -131,11 +150,17 @@ auto sperr::SPECK2D_INT<T>::m_partition_S(Set2D set) const -> std::array<Set2D,
   TL.length_y = approx_len_y;
   TL.part_level = set.part_level + 1;
 
+  auto morton = set.morton;
+  for (auto& sub : subsets) {
+    sub.morton = morton;
+    morton += sub.length_x * sub.length_y;
+  }
+
   return subsets;
 }
 
-template <typename T>
-auto sperr::SPECK2D_INT<T>::m_partition_I() -> std::array<Set2D, 3>
+template <typename T, typename Derived>
+auto sperr::SPECK2D_INT<T, Derived>::m_partition_I() -> std::array<Set2D, 3>
 {
   auto subsets = std::array<Set2D, 3>();
   auto [approx_len_x, detail_len_x] = sperr::calc_approx_detail_len(m_dims[0], m_I.part_level);
@@ -163,16 +188,23 @@ auto sperr::SPECK2D_INT<T>::m_partition_I() -> std::array<Set2D, 3>
   BL.length_y = detail_len_y;
   BL.part_level = m_I.part_level;
 
+  auto morton = m_I.morton;
+  for (auto& sub : subsets) {
+    sub.morton = morton;
+    morton += sub.length_x * sub.length_y;
+  }
+
   // Also update m_I
   m_I.start_x += detail_len_x;
   m_I.start_y += detail_len_y;
   m_I.part_level--;
+  m_I.morton = morton;
 
   return subsets;
 }
 
-template <typename T>
-void sperr::SPECK2D_INT<T>::m_initialize_lists()
+template <typename T, typename Derived>
+void sperr::SPECK2D_INT<T, Derived>::m_initialize_lists()
 {
   // prepare m_LIS
   auto num_of_parts = sperr::num_of_partitions(std::max(m_dims[0], m_dims[1])) + 1ul;
@@ -199,9 +231,17 @@ void sperr::SPECK2D_INT<T>::m_initialize_lists()
   m_I.length_x = m_dims[0];
   m_I.length_y = m_dims[1];
   m_I.part_level = num_of_xforms;
+  m_I.morton = root.length_x * root.length_y;
+
+  // Encoder and decoder might have different additional tasks.
+  m_derived().m_additional_initialization();
 }
 
-template class sperr::SPECK2D_INT<uint8_t>;
-template class sperr::SPECK2D_INT<uint16_t>;
-template class sperr::SPECK2D_INT<uint32_t>;
-template class sperr::SPECK2D_INT<uint64_t>;
+template class sperr::SPECK2D_INT<uint8_t, sperr::SPECK2D_INT_ENC<uint8_t>>;
+template class sperr::SPECK2D_INT<uint16_t, sperr::SPECK2D_INT_ENC<uint16_t>>;
+template class sperr::SPECK2D_INT<uint32_t, sperr::SPECK2D_INT_ENC<uint32_t>>;
+template class sperr::SPECK2D_INT<uint64_t, sperr::SPECK2D_INT_ENC<uint64_t>>;
+template class sperr::SPECK2D_INT<uint8_t, sperr::SPECK2D_INT_DEC<uint8_t>>;
+template class sperr::SPECK2D_INT<uint16_t, sperr::SPECK2D_INT_DEC<uint16_t>>;
+template class sperr::SPECK2D_INT<uint32_t, sperr::SPECK2D_INT_DEC<uint32_t>>;
+template class sperr::SPECK2D_INT<uint64_t, sperr::SPECK2D_INT_DEC<uint64_t>>;
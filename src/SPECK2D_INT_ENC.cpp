@@ -2,6 +2,115 @@
 
 #include <algorithm>
 #include <cassert>
+#include <map>
+#include <mutex>
+
+namespace {
+
+// Morton orders computed so far, keyed by slice dimensions. Only a handful of chunk shapes
+//    are typically in use, so the cache is simply emptied if it ever grows large.
+auto order_cache = std::map<sperr::dims_type, std::shared_ptr<const sperr::Morton_Order2D>>();
+auto order_cache_mutex = std::mutex();
+constexpr size_t order_cache_capacity = 16;
+
+};  // namespace
+
+template <typename T>
+auto sperr::SPECK2D_INT_ENC<T>::memory_usage() const -> size_t
+{
+  return SPECK2D_INT<T, SPECK2D_INT_ENC<T>>::memory_usage() +
+         (m_morton_buf.capacity() + m_block_max.capacity()) * sizeof(uint_type);
+}
+
+template <typename T>
+void sperr::SPECK2D_INT_ENC<T>::set_morton_layout(bool use)
+{
+  m_morton_layout = use;
+}
+
+template <typename T>
+void sperr::SPECK2D_INT_ENC<T>::m_release_encoding_buffers()
+{
+  m_morton_buf = vecui_type();
+  m_block_max = vecui_type();
+}
+
+template <typename T>
+void sperr::SPECK2D_INT_ENC<T>::m_additional_initialization()
+{
+  // For the encoder, this function makes a copy of the coefficients in a morton order, and
+  //    summarizes it in blocks.
+  const auto total_vals = m_dims[0] * m_dims[1];
+  if (!m_morton_layout || m_coeff_buf.empty() ||
+      total_vals > std::numeric_limits<uint32_t>::max()) {
+    m_morton_buf.clear();
+    m_block_max.clear();
+    return;
+  }
+  assert(m_coeff_buf.size() == total_vals);
+
+  // Find the morton order of this slice, which is very likely to be computed already.
+  if (m_order == nullptr || m_order->dims != m_dims) {
+    auto lock = std::lock_guard(order_cache_mutex);
+    auto it = order_cache.find(m_dims);
+    if (it != order_cache.end())
+      m_order = it->second;
+    else {
+      m_order = m_build_order();
+      if (order_cache.size() >= order_cache_capacity)
+        order_cache.clear();
+      order_cache.emplace(m_dims, m_order);
+    }
+  }
+
+  const auto& dest = m_order->dest;
+  m_morton_buf.resize(total_vals);
+  for (size_t i = 0; i < total_vals; i++)
+    m_morton_buf[dest[i]] = m_coeff_buf[i];
+
+  m_block_max.resize((total_vals + m_block_len - 1) / m_block_len);
+  for (size_t b = 0; b < m_block_max.size(); b++) {
+    const auto first = m_morton_buf.cbegin() + b * m_block_len;
+    const auto last = m_morton_buf.cbegin() + std::min(total_vals, (b + 1) * m_block_len);
+    m_block_max[b] = *std::max_element(first, last);
+  }
+}
+
+template <typename T>
+auto sperr::SPECK2D_INT_ENC<T>::m_build_order() -> std::shared_ptr<const Morton_Order2D>
+{
+  auto order = std::make_shared<Morton_Order2D>();
+  order->dims = m_dims;
+  order->dest.resize(m_dims[0] * m_dims[1]);
+
+  // The root set comes first, followed by the sets partitioned from `m_I` in turn, each of them
+  //    recursively partitioned the same way as in `SPECK2D_INT::m_code_S()`.
+  for (const auto& list : m_LIS) {
+    for (const auto& set : list)
+      m_record_set(set, order->dest);
+  }
+  const auto I = m_I;
+  while (m_I.part_level > 0) {
+    for (const auto& set : m_partition_I())
+      m_record_set(set, order->dest);
+  }
+  m_I = I;
+
+  return order;
+}
+
+template <typename T>
+void sperr::SPECK2D_INT_ENC<T>::m_record_set(const Set2D& set, std::vector<uint32_t>& dest) const
+{
+  if (set.is_empty())
+    return;
+  if (set.is_pixel()) {
+    dest[size_t{set.start_y} * m_dims[0] + set.start_x] = set.morton;
+    return;
+  }
+  for (const auto& sub : m_partition_S(set))
+    m_record_set(sub, dest);
+}
 
 template <typename T>
 void sperr::SPECK2D_INT_ENC<T>::m_process_S(size_t idx1,
@@ -14,7 +123,10 @@ void sperr::SPECK2D_INT_ENC<T>::m_process_S(size_t idx1,
   bool is_sig = true;
 
   if (need_decide) {
-    is_sig = m_decide_S_significance(set);
+    if (m_morton_buf.empty())
+      is_sig = m_decide_S_significance(set);
+    else
+      is_sig = m_any_significant(set.morton, size_t{set.length_x} * set.length_y);
     m_bit_buffer.wbit(is_sig);
   }
 
@@ -50,7 +162,10 @@ void sperr::SPECK2D_INT_ENC<T>::m_process_I(bool need_decide)
   if (m_I.part_level > 0) {  // Only process `m_I` when it's not empty
     bool is_sig = true;
     if (need_decide) {
-      is_sig = m_decide_I_significance();
+      if (m_morton_buf.empty())
+        is_sig = m_decide_I_significance();
+      else
+        is_sig = m_any_significant(m_I.morton, m_morton_buf.size() - m_I.morton);
       m_bit_buffer.wbit(is_sig);
     }
 
@@ -59,9 +174,36 @@ void sperr::SPECK2D_INT_ENC<T>::m_process_I(bool need_decide)
   }
 }
 
+template <typename T>
+auto sperr::SPECK2D_INT_ENC<T>::m_any_significant(size_t first, size_t len) const -> bool
+{
+  const auto* const buf = m_morton_buf.data();
+  const auto thld = m_threshold;
+  const auto last = first + len;
+  auto i = first;
+
+  // Values before the first whole block are compared one by one, whole blocks are settled by
+  //    their maxima, and then the values after the last whole block are compared.
+  const auto head = std::min(last, (first + m_block_len - 1) / m_block_len * m_block_len);
+  for (; i < head; i++) {
+    if (buf[i] >= thld)
+      return true;
+  }
+  for (; i + m_block_len <= last; i += m_block_len) {
+    if (m_block_max[i / m_block_len] >= thld)
+      return true;
+  }
+  for (; i < last; i++) {
+    if (buf[i] >= thld)
+      return true;
+  }
+  return false;
+}
+
 template <typename T>
 auto sperr::SPECK2D_INT_ENC<T>::m_decide_S_significance(const Set2D& set) const -> bool
 {
+  // Coefficients in raster order: scan the set one row at a time.
   assert(!set.is_empty());
 
   const auto gtr = [thrd = m_threshold](auto v) { return v >= thrd; };
@@ -56,3 +56,25 @@ void sperr::SPECK3D_FLT::m_inverse_wavelet_xform(bool multi_res)
   else
     m_cdf.idwt3d_multi_res(m_hierarchy);
 }
+
+auto sperr::SPECK3D_FLT::m_lowest_subband() const -> std::tuple<dims_type, size_t>
+{
+  // The same numbers of levels as in `CDF97::dwt3d()`: either dyadic, or a wavelet packet of
+  //    transforms along Z followed by transforms of XY planes.
+  auto lev_xy = sperr::num_of_xforms(std::min(m_dims[0], m_dims[1]));
+  auto lev_z = sperr::num_of_xforms(m_dims[2]);
+  const auto dyadic = sperr::can_use_dyadic(m_dims);
+  if (dyadic)
+    lev_xy = lev_z = *dyadic;
+  return {{sperr::calc_approx_detail_len(m_dims[0], lev_xy)[0],
+           sperr::calc_approx_detail_len(m_dims[1], lev_xy)[0],
+           sperr::calc_approx_detail_len(m_dims[2], lev_z)[0]},
+          lev_xy * 2 + lev_z};
+}
+
+auto sperr::SPECK3D_FLT::m_quantization_order() -> const uint32_t*
+{
+  if (m_order == nullptr || m_order->dims != m_dims)
+    m_order = speck3d_morton_order(m_dims);
+  return m_order ? m_order->dest.data() : nullptr;
+}
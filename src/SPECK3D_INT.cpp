@@ -1,22 +1,81 @@
 #include "SPECK3D_INT.h"
+#include "SPECK3D_INT_DEC.h"
+#include "SPECK3D_INT_ENC.h"
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cstring>
 #include <numeric>
 
-template <typename T>
-void sperr::SPECK3D_INT<T>::m_clean_LIS()
+void sperr::SetList3D::clear()
 {
-  for (auto& list : m_LIS) {
-    auto it =
-        std::remove_if(list.begin(), list.end(), [](const auto& s) { return s.num_elem() == 0; });
-    list.erase(it, list.end());
+  m_morton.clear();
+  m_start.clear();
+  m_length.clear();
+}
+
+void sperr::SetList3D::insert_front(const Set3D& set)
+{
+  m_morton.insert(m_morton.begin(), set.get_morton());
+  m_start.insert(m_start.begin(), {set.start_x, set.start_y, set.start_z});
+  m_length.insert(m_length.begin(), {set.length_x, set.length_y, set.length_z});
+}
+
+void sperr::SetList3D::remove_empty()
+{
+  // Compact all arrays in one pass, keeping the relative order of the remaining sets.
+  size_t keep = 0;
+  for (size_t i = 0; i < m_length.size(); i++) {
+    if (m_length[i][0] != 0) {
+      m_morton[keep] = m_morton[i];
+      m_start[keep] = m_start[i];
+      m_length[keep] = m_length[i];
+      keep++;
+    }
   }
+  m_morton.resize(keep);
+  m_start.resize(keep);
+  m_length.resize(keep);
 }
 
-template <typename T>
-void sperr::SPECK3D_INT<T>::m_initialize_lists()
+auto sperr::SetList3D::memory_usage() const -> size_t
+{
+  return m_morton.capacity() * sizeof(uint64_t) + m_start.capacity() * sizeof(m_start[0]) +
+         m_length.capacity() * sizeof(m_length[0]);
+}
+
+template <typename T, typename Derived>
+void sperr::SPECK3D_INT<T, Derived>::m_clean_LIS()
+{
+  for (auto& list : m_LIS)
+    list.remove_empty();
+}
+
+template <typename T, typename Derived>
+auto sperr::SPECK3D_INT<T, Derived>::m_LIS_size() const -> size_t
+{
+  return std::accumulate(m_LIS.cbegin(), m_LIS.cend(), size_t{0},
+                         [](size_t a, const auto& list) { return a + list.size(); });
+}
+
+template <typename T, typename Derived>
+auto sperr::SPECK3D_INT<T, Derived>::memory_usage() const -> size_t
+{
+  auto bytes = SPECK_INT<T>::memory_usage() + m_LIS.capacity() * sizeof(m_LIS[0]);
+  for (const auto& list : m_LIS)
+    bytes += list.memory_usage();
+  return bytes;
+}
+
+template <typename T, typename Derived>
+void sperr::SPECK3D_INT<T, Derived>::set_cube_paths(bool use)
+{
+  m_cube_paths = use;
+}
+
+template <typename T, typename Derived>
+void sperr::SPECK3D_INT<T, Derived>::m_initialize_lists()
 {
   std::array<size_t, 3> num_of_parts;  // how many times each dimension could be partitioned?
   num_of_parts[0] = sperr::num_of_partitions(m_dims[0]);
@@ -39,13 +98,22 @@ void sperr::SPECK3D_INT<T>::m_initialize_lists()
 
   auto curr_lev = uint16_t{0};
 
+  // Power-of-two cubes with the common chunk edges (64, 128, 256) take the specialized paths.
+  m_cube_log2 = 0;
+  if (m_cube_paths && m_dims[0] == m_dims[1] && m_dims[0] == m_dims[2] &&
+      std::has_single_bit(m_dims[0])) {
+    const auto log2 = size_t(std::bit_width(m_dims[0]) - 1);
+    if (log2 >= 6 && log2 <= 8)
+      m_cube_log2 = log2;
+  }
+
   const auto dyadic = sperr::can_use_dyadic(m_dims);
   if (dyadic) {
     for (size_t i = 0; i < *dyadic; i++) {
       auto [subsets, next_lev] = m_partition_S_XYZ(big, curr_lev);
       big = subsets[0];
       for (auto it = std::next(subsets.cbegin()); it != subsets.cend(); ++it)
-        m_LIS[next_lev].emplace_back(*it);
+        m_LIS[next_lev].push_back(*it);
       curr_lev = next_lev;
     }
   }
@@ -57,7 +125,7 @@ void sperr::SPECK3D_INT<T>::m_initialize_lists()
       auto [subsets, next_lev] = m_partition_S_XYZ(big, curr_lev);
       big = subsets[0];
       for (auto it = std::next(subsets.cbegin()); it != subsets.cend(); ++it)
-        m_LIS[next_lev].emplace_back(*it);
+        m_LIS[next_lev].push_back(*it);
       curr_lev = next_lev;
       xf++;
     }
@@ -68,7 +136,7 @@ void sperr::SPECK3D_INT<T>::m_initialize_lists()
         auto [subsets, next_lev] = m_partition_S_XY(big, curr_lev);
         big = subsets[0];
         for (auto it = std::next(subsets.cbegin()); it != subsets.cend(); ++it)
-          m_LIS[next_lev].emplace_back(*it);
+          m_LIS[next_lev].push_back(*it);
         curr_lev = next_lev;
         xf++;
       }
@@ -77,7 +145,7 @@ void sperr::SPECK3D_INT<T>::m_initialize_lists()
       while (xf < num_xforms_z) {
         auto [subsets, next_lev] = m_partition_S_Z(big, curr_lev);
         big = subsets[0];
-        m_LIS[next_lev].emplace_back(subsets[1]);
+        m_LIS[next_lev].push_back(subsets[1]);
         curr_lev = next_lev;
         xf++;
       }
@@ -86,14 +154,14 @@ void sperr::SPECK3D_INT<T>::m_initialize_lists()
 
   // Right now big is the set that's most likely to be significant, so insert
   // it at the front of it's corresponding vector. One-time expense.
-  m_LIS[curr_lev].insert(m_LIS[curr_lev].begin(), big);
+  m_LIS[curr_lev].insert_front(big);
 
   // Encoder and decoder might have different additional tasks.
-  m_additional_initialization();
+  m_derived().m_additional_initialization();
 }
 
-template <typename T>
-void sperr::SPECK3D_INT<T>::m_sorting_pass()
+template <typename T, typename Derived>
+void sperr::SPECK3D_INT<T, Derived>::m_sorting_pass()
 {
   // Since we have a separate representation of LIP, let's process that list first!
   //
@@ -104,13 +172,13 @@ void sperr::SPECK3D_INT<T>::m_sorting_pass()
     if (value != 0) {
       for (size_t j = 0; j < 64; j++) {
         if ((value >> j) & uint64_t{1})
-          m_process_P_lite(i + j);
+          m_derived().m_process_P_lite(i + j);
       }
     }
   }
   for (auto i = bits_x64; i < m_LIP_mask.size(); i++) {
     if (m_LIP_mask.rbit(i))
-      m_process_P_lite(i);
+      m_derived().m_process_P_lite(i);
   }
 
   // Then we process regular sets in LIS.
@@ -119,15 +187,29 @@ void sperr::SPECK3D_INT<T>::m_sorting_pass()
     auto idx1 = m_LIS.size() - tmp;
     for (size_t idx2 = 0; idx2 < m_LIS[idx1].size(); idx2++) {
       size_t dummy = 0;
-      m_process_S(idx1, idx2, dummy, true);
+      m_derived().m_process_S(idx1, idx2, dummy, true);
     }
   }
 }
 
-template <typename T>
-void sperr::SPECK3D_INT<T>::m_code_S(size_t idx1, size_t idx2)
+template <typename T, typename Derived>
+void sperr::SPECK3D_INT<T, Derived>::m_code_S(size_t idx1, size_t idx2)
 {
-  auto [subsets, next_lev] = m_partition_S_XYZ(m_LIS[idx1][idx2], uint16_t(idx1));
+  switch (m_cube_log2) {
+    case 6:
+      m_code_S_cube<6>(idx1, idx2);
+      return;
+    case 7:
+      m_code_S_cube<7>(idx1, idx2);
+      return;
+    case 8:
+      m_code_S_cube<8>(idx1, idx2);
+      return;
+    default:
+      break;
+  }
+
+  auto [subsets, next_lev] = m_partition_S_XYZ(m_LIS[idx1].get(idx2), uint16_t(idx1));
 
   // Since some subsets could be empty, let's put empty sets at the end.
   const auto set_end =
@@ -142,18 +224,66 @@ void sperr::SPECK3D_INT<T>::m_code_S(size_t idx1, size_t idx2)
     if (it->num_elem() == 1) {
       auto idx = it->start_z * m_dims[0] * m_dims[1] + it->start_y * m_dims[0] + it->start_x;
       m_LIP_mask.wtrue(idx);
-      m_process_P(idx, it->get_morton(), sig_counter, need_decide);
+      m_derived().m_process_P(idx, it->get_morton(), sig_counter, need_decide);
     }
     else {
-      m_LIS[next_lev].emplace_back(*it);
+      m_LIS[next_lev].push_back(*it);
+      const auto newidx2 = m_LIS[next_lev].size() - 1;
+      m_derived().m_process_S(next_lev, newidx2, sig_counter, need_decide);
+    }
+  }
+}
+
+template <typename T, typename Derived>
+template <size_t Log2Edge>
+void sperr::SPECK3D_INT<T, Derived>::m_code_S_cube(size_t idx1, size_t idx2)
+{
+  // In a power-of-two cube, every set is a cube too, and it always splits into 8 cubes with
+  //    half the edge length. Subset `i` sits at the corner given by the bits of `i` (x being the
+  //    lowest bit), and occupies the i-th eighth of the parent's morton range.
+  //
+  constexpr auto corners = std::array<std::array<uint16_t, 3>, 8>{
+      {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}, {0, 0, 1}, {1, 0, 1}, {0, 1, 1}, {1, 1, 1}}};
+
+  const auto set = m_LIS[idx1].get(idx2);
+  assert(set.length_x == set.length_y && set.length_x == set.length_z && set.length_x > 1);
+  const auto half = uint16_t(set.length_x / 2);
+  const auto morton = set.get_morton();
+
+  // Counter for the number of discovered significant sets; see the generic `m_code_S()`.
+  size_t sig_counter = 0;
+
+  if (half == 1) {
+    for (size_t i = 0; i < 8; i++) {
+      const auto x = size_t{set.start_x} + corners[i][0];
+      const auto y = size_t{set.start_y} + corners[i][1];
+      const auto z = size_t{set.start_z} + corners[i][2];
+      const auto idx = (z << (2 * Log2Edge)) | (y << Log2Edge) | x;
+      m_LIP_mask.wtrue(idx);
+      m_derived().m_process_P(idx, morton + i, sig_counter, (sig_counter != 0 || i != 7));
+    }
+  }
+  else {
+    const auto sub_elem = size_t{half} * half * half;
+    const auto next_lev = idx1 + 3;
+    auto sub = Set3D();
+    sub.length_x = half;
+    sub.length_y = half;
+    sub.length_z = half;
+    for (size_t i = 0; i < 8; i++) {
+      sub.set_morton(morton + i * sub_elem);
+      sub.start_x = set.start_x + corners[i][0] * half;
+      sub.start_y = set.start_y + corners[i][1] * half;
+      sub.start_z = set.start_z + corners[i][2] * half;
+      m_LIS[next_lev].push_back(sub);
       const auto newidx2 = m_LIS[next_lev].size() - 1;
-      m_process_S(next_lev, newidx2, sig_counter, need_decide);
+      m_derived().m_process_S(next_lev, newidx2, sig_counter, (sig_counter != 0 || i != 7));
     }
   }
 }
 
-template <typename T>
-auto sperr::SPECK3D_INT<T>::m_partition_S_XYZ(Set3D set, uint16_t lev) const
+template <typename T, typename Derived>
+auto sperr::SPECK3D_INT<T, Derived>::m_partition_S_XYZ(Set3D set, uint16_t lev) const
     -> std::tuple<std::array<Set3D, 8>, uint16_t>
 {
   // Integer promotion rules (https://en.cppreference.com/w/c/language/conversion) say that types
@@ -275,8 +405,8 @@ auto sperr::SPECK3D_INT<T>::m_partition_S_XYZ(Set3D set, uint16_t lev) const
   return subsets;
 }
 
-template <typename T>
-auto sperr::SPECK3D_INT<T>::m_partition_S_XY(Set3D set, uint16_t lev) const
+template <typename T, typename Derived>
+auto sperr::SPECK3D_INT<T, Derived>::m_partition_S_XY(Set3D set, uint16_t lev) const
     -> std::tuple<std::array<Set3D, 4>, uint16_t>
 {
   // This partition scheme is only used during initialization; no need to calculate morton offset.
@@ -337,8 +467,8 @@ auto sperr::SPECK3D_INT<T>::m_partition_S_XY(Set3D set, uint16_t lev) const
   return subsets;
 }
 
-template <typename T>
-auto sperr::SPECK3D_INT<T>::m_partition_S_Z(Set3D set, uint16_t lev) const
+template <typename T, typename Derived>
+auto sperr::SPECK3D_INT<T, Derived>::m_partition_S_Z(Set3D set, uint16_t lev) const
     -> std::tuple<std::array<Set3D, 2>, uint16_t>
 {
   // This partition scheme is only used during initialization; no need to calculate morton offset.
@@ -374,7 +504,11 @@ auto sperr::SPECK3D_INT<T>::m_partition_S_Z(Set3D set, uint16_t lev) const
   return subsets;
 }
 
-template class sperr::SPECK3D_INT<uint64_t>;
-template class sperr::SPECK3D_INT<uint32_t>;
-template class sperr::SPECK3D_INT<uint16_t>;
-template class sperr::SPECK3D_INT<uint8_t>;
+template class sperr::SPECK3D_INT<uint64_t, sperr::SPECK3D_INT_ENC<uint64_t>>;
+template class sperr::SPECK3D_INT<uint32_t, sperr::SPECK3D_INT_ENC<uint32_t>>;
+template class sperr::SPECK3D_INT<uint16_t, sperr::SPECK3D_INT_ENC<uint16_t>>;
+template class sperr::SPECK3D_INT<uint8_t, sperr::SPECK3D_INT_ENC<uint8_t>>;
+template class sperr::SPECK3D_INT<uint64_t, sperr::SPECK3D_INT_DEC<uint64_t>>;
+template class sperr::SPECK3D_INT<uint32_t, sperr::SPECK3D_INT_DEC<uint32_t>>;
+template class sperr::SPECK3D_INT<uint16_t, sperr::SPECK3D_INT_DEC<uint16_t>>;
+template class sperr::SPECK3D_INT<uint8_t, sperr::SPECK3D_INT_DEC<uint8_t>>;
@@ -8,8 +8,6 @@
 template <typename T>
 void sperr::SPECK3D_INT_DEC<T>::m_process_S(size_t idx1, size_t idx2, size_t& counter, bool read)
 {
-  auto& set = m_LIS[idx1][idx2];
-
   bool is_sig = true;
   if (read)
     is_sig = m_bit_buffer.rbit();
@@ -17,7 +15,7 @@ void sperr::SPECK3D_INT_DEC<T>::m_process_S(size_t idx1, size_t idx2, size_t& co
   if (is_sig) {
     counter++;
     m_code_S(idx1, idx2);
-    set.make_empty();  // this current set is gonna be discarded.
+    m_LIS[idx1].make_empty(idx2);  // this current set is gonna be discarded.
   }
 }
 
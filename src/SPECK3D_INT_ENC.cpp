@@ -2,140 +2,106 @@
 
 #include <algorithm>
 #include <cassert>
-#include <cstring>  // std::memcpy()
+#include <map>
+#include <mutex>
 #include <numeric>
 
+namespace {
+
+// Morton orders computed so far, keyed by volume dimensions. Only a handful of chunk shapes
+//    are typically in use, so the cache is simply emptied if it ever grows large.
+auto order_cache = std::map<sperr::dims_type, std::shared_ptr<const sperr::Morton_Order3D>>();
+auto order_cache_mutex = std::mutex();
+constexpr size_t order_cache_capacity = 16;
+
+};  // namespace
+
+auto sperr::speck3d_morton_order(dims_type dims) -> std::shared_ptr<const Morton_Order3D>
+{
+  {
+    auto lock = std::lock_guard(order_cache_mutex);
+    auto it = order_cache.find(dims);
+    if (it != order_cache.end())
+      return it->second;
+  }
+
+  // Let an encoder with no coefficients find the order, which also puts it in the cache.
+  auto encoder = SPECK3D_INT_ENC<uint8_t>();
+  encoder.set_dims(dims);
+  encoder.m_initialize_lists();
+  return encoder.m_order;
+}
+
 template <typename T>
-void sperr::SPECK3D_INT_ENC<T>::m_deposit_set(Set3D set)
+void sperr::SPECK3D_INT_ENC<T>::m_record_set(Set3D set, std::vector<uint32_t>& dest) const
 {
   switch (set.num_elem()) {
     case 0:
       return;
     case 1: {
       auto id = set.start_z * m_dims[0] * m_dims[1] + set.start_y * m_dims[0] + set.start_x;
-      m_morton_buf[set.get_morton()] = m_coeff_buf[id];
+      dest[id] = static_cast<uint32_t>(set.get_morton());
       return;
     }
-    case 2: {
-      // We directly deposit the 2 elements in `set` instead of performing another partition.
-      //
-      // Deposit the 1st element.
-      auto id = set.start_z * m_dims[0] * m_dims[1] + set.start_y * m_dims[0] + set.start_x;
-      auto morton_id = set.get_morton();
-      m_morton_buf[morton_id] = m_coeff_buf[id];
-
-      // Deposit the 2nd element.
-      if (set.length_x == 2)
-        id++;
-      else if (set.length_y == 2)
-        id += m_dims[0];
-      else
-        id += m_dims[0] * m_dims[1];
-      m_morton_buf[++morton_id] = m_coeff_buf[id];
-
-      return;
+    default: {
+      auto [subsets, lev] = m_partition_S_XYZ(set, 0);
+      for (auto& sub : subsets)
+        m_record_set(sub, dest);
     }
-    case 4: {
-      const auto id = set.start_z * m_dims[0] * m_dims[1] + set.start_y * m_dims[0] + set.start_x;
-      auto morton_id = set.get_morton();
-
-      if (set.length_x == 2 && set.length_y == 2) {
-        // Element (0, 0, 0)
-        m_morton_buf[morton_id] = m_coeff_buf[id];
-
-        // Element (1, 0, 0)
-        m_morton_buf[++morton_id] = m_coeff_buf[id + 1];
-
-        // Element (0, 1, 0)
-        auto id2 = id + m_dims[0];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        // Element (1, 1, 0)
-        m_morton_buf[++morton_id] = m_coeff_buf[++id2];
-
-        return;
-      }
-      else if (set.length_x == 2 && set.length_z == 2) {
-        // Element (0, 0, 0)
-        m_morton_buf[morton_id] = m_coeff_buf[id];
-
-        // Element (1, 0, 0)
-        m_morton_buf[++morton_id] = m_coeff_buf[id + 1];
-
-        // Element (0, 0, 1)
-        auto id2 = id + m_dims[0] * m_dims[1];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        // Element (1, 0, 1)
-        m_morton_buf[++morton_id] = m_coeff_buf[++id2];
-
-        return;
-      }
-      else if (set.length_y == 2 && set.length_z == 2) {
-        // Element (0, 0, 0)
-        m_morton_buf[morton_id] = m_coeff_buf[id];
-
-        // Element (0, 1, 0)
-        auto id2 = id + m_dims[0];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        // Element (0, 0, 1)
-        id2 = id + m_dims[0] * m_dims[1];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        // Element (0, 1, 1)
-        id2 += m_dims[0];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
+  }
+}
 
-        return;
+template <typename T>
+auto sperr::SPECK3D_INT_ENC<T>::m_build_order() const -> std::shared_ptr<const Morton_Order3D>
+{
+  const auto total_vals = m_dims[0] * m_dims[1] * m_dims[2];
+  auto order = std::make_shared<Morton_Order3D>();
+  order->dims = m_dims;
+  order->dest.resize(total_vals);
+  auto& dest = order->dest;
+
+  if (m_cube_log2 != 0) {
+    // A power-of-two cube uses a pure Morton layout, so the position of each coefficient is
+    //    given by the Morton code of its coordinates.
+    static constexpr auto spread = []() {
+      auto table = std::array<uint64_t, 256>();
+      for (size_t i = 0; i < table.size(); i++)
+        table[i] = morton_spread_3d(uint32_t(i));
+      return table;
+    }();
+
+    const auto edge = m_dims[0];
+    assert(edge <= spread.size());
+    size_t idx = 0;
+    for (size_t z = 0; z < edge; z++) {
+      const auto mz = spread[z] << 2;
+      for (size_t y = 0; y < edge; y++) {
+        const auto myz = mz | (spread[y] << 1);
+        for (size_t x = 0; x < edge; x++)
+          dest[idx++] = static_cast<uint32_t>(myz | spread[x]);
       }
-      else
-        break;  // Fall back to the recursive case.
     }
-    case 8: {
-      if (set.length_x == 2 && set.length_y == 2) {
-        // Element (0, 0, 0)
-        const auto id = set.start_z * m_dims[0] * m_dims[1] + set.start_y * m_dims[0] + set.start_x;
-        auto morton_id = set.get_morton();
-        m_morton_buf[morton_id] = m_coeff_buf[id];
-
-        // Element (1, 0, 0)
-        m_morton_buf[++morton_id] = m_coeff_buf[id + 1];
-
-        // Element (0, 1, 0)
-        auto id2 = id + m_dims[0];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        // Element (1, 1, 0)
-        m_morton_buf[++morton_id] = m_coeff_buf[++id2];
-
-        // Element (0, 0, 1)
-        id2 = id + m_dims[0] * m_dims[1];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        // Element (1, 0, 1)
-        m_morton_buf[++morton_id] = m_coeff_buf[++id2];
-
-        // Element (0, 1, 1)
-        id2 = id + m_dims[0] * (m_dims[1] + 1);
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        // Element (1, 1, 1)
-        m_morton_buf[++morton_id] = m_coeff_buf[++id2];
-
-        return;
-      }
-      else
-        break;  // Fall back to the recursive case.
+  }
+  else {
+    // Otherwise, the sets in the LIS are recursively partitioned, the same way as in
+    //    `SPECK3D_INT::m_code_S()`, until reaching individual coefficients.
+    for (const auto& list : m_LIS) {
+      for (size_t i = 0; i < list.size(); i++)
+        m_record_set(list.get(i), dest);
     }
-    default:
-      break;  // Fall back to the recursive case.
   }
 
-  // The recursive case.
-  auto [subsets, lev] = m_partition_S_XYZ(set, 0);
-  for (auto& sub : subsets)
-    m_deposit_set(sub);
+  // Identify the cycles of this permutation; fixed points need no work at all.
+  auto visited = std::vector<bool>(total_vals, false);
+  for (size_t i = 0; i < total_vals; i++) {
+    if (visited[i] || dest[i] == i)
+      continue;
+    order->cycles.push_back(static_cast<uint32_t>(i));
+    for (auto j = i; !visited[j]; j = dest[j])
+      visited[j] = true;
+  }
+
+  return order;
 }
 
 template <typename T>
@@ -143,58 +109,132 @@ void sperr::SPECK3D_INT_ENC<T>::m_additional_initialization()
 {
   // For the encoder, this function re-organizes the coefficients in a morton order.
   //
-  m_morton_buf.resize(m_dims[0] * m_dims[1] * m_dims[2]);
-
   // The same traversing order as in `SPECK3D_INT::m_sorting_pass()`
   size_t morton_offset = 0;
   for (size_t tmp = 1; tmp <= m_LIS.size(); tmp++) {
     auto idx1 = m_LIS.size() - tmp;
     for (size_t idx2 = 0; idx2 < m_LIS[idx1].size(); idx2++) {
-      auto& set = m_LIS[idx1][idx2];
-      set.set_morton(morton_offset);
-      m_deposit_set(set);
-      morton_offset += set.num_elem();
+      m_LIS[idx1].set_morton(idx2, morton_offset);
+      [[maybe_unused]] const auto set = m_LIS[idx1].get(idx2);
+      assert(m_cube_log2 == 0 ||
+             morton_offset == morton_code_3d(set.start_x, set.start_y, set.start_z));
+      morton_offset += m_LIS[idx1].num_elem(idx2);
+    }
+  }
+
+  m_coeff_order = nullptr;
+  const auto total_vals = m_dims[0] * m_dims[1] * m_dims[2];
+  if (total_vals > std::numeric_limits<uint32_t>::max()) {
+    assert(!m_coeffs_arranged);
+    m_order.reset();
+    return;
+  }
+
+  // Find the morton order of this volume, which is very likely to be computed already.
+  if (m_order == nullptr || m_order->dims != m_dims) {
+    auto lock = std::lock_guard(order_cache_mutex);
+    auto it = order_cache.find(m_dims);
+    if (it != order_cache.end())
+      m_order = it->second;
+    else {
+      m_order = m_build_order();
+      if (order_cache.size() >= order_cache_capacity)
+        order_cache.clear();
+      order_cache.emplace(m_dims, m_order);
     }
   }
+  m_coeff_order = m_order->dest.data();
+
+  // Re-arrange the coefficients in place, one cycle of the permutation at a time, so that
+  //    no second copy of the coefficients is needed. It's skipped when the coefficients come in
+  //    arranged already (e.g., by the quantization step of `SPECK3D_FLT`), or don't come at all.
+  if (m_coeffs_arranged || m_coeff_buf.empty())
+    return;
+  assert(m_coeff_buf.size() == total_vals);
+  const auto& dest = m_order->dest;
+  for (auto start : m_order->cycles) {
+    auto carry = m_coeff_buf[start];
+    for (auto i = dest[start]; i != start; i = dest[i])
+      std::swap(carry, m_coeff_buf[i]);
+    m_coeff_buf[start] = carry;
+  }
 }
 
 template <typename T>
 void sperr::SPECK3D_INT_ENC<T>::m_process_S(size_t idx1, size_t idx2, size_t& counter, bool output)
 {
-  auto& set = m_LIS[idx1][idx2];
   auto is_sig = true;
 
   // If need to output, it means the current set has unknown significance.
   if (output) {
-    auto first = m_morton_buf.cbegin() + set.get_morton();
-    auto last = first + set.num_elem();
-    is_sig = std::any_of(first, last, [thld = m_threshold](auto v) { return v >= thld; });
+    if (m_coeff_order)
+      is_sig = m_any_significant(m_LIS[idx1].morton(idx2), m_LIS[idx1].num_elem(idx2));
+    else
+      is_sig = m_any_significant(m_LIS[idx1].get(idx2));
     m_bit_buffer.wbit(is_sig);
   }
 
   if (is_sig) {
     counter++;
     m_code_S(idx1, idx2);
-    set.make_empty();  // this current set is gonna be discarded.
+    m_LIS[idx1].make_empty(idx2);  // this current set is gonna be discarded.
+  }
+}
+
+template <typename T>
+auto sperr::SPECK3D_INT_ENC<T>::m_any_significant(size_t first, size_t len) const -> bool
+{
+  // Compare whole blocks of values without exiting early, so that the compiler is able to
+  //    vectorize the comparisons, and only check for a significant value between blocks.
+  constexpr size_t block = 32;
+  const auto* const buf = m_coeff_buf.data() + first;
+  const auto thld = m_threshold;
+
+  size_t i = 0;
+  for (; i + block <= len; i += block) {
+    auto sig = uint8_t{0};
+    for (size_t j = 0; j < block; j++)
+      sig |= uint8_t(buf[i + j] >= thld);
+    if (sig)
+      return true;
   }
+  for (; i < len; i++) {
+    if (buf[i] >= thld)
+      return true;
+  }
+  return false;
+}
+
+template <typename T>
+auto sperr::SPECK3D_INT_ENC<T>::m_any_significant(const Set3D& set) const -> bool
+{
+  // Coefficients in raster order: scan the set one row at a time.
+  const auto slice = m_dims[0] * m_dims[1];
+  for (size_t z = set.start_z; z < size_t{set.start_z} + set.length_z; z++) {
+    for (size_t y = set.start_y; y < size_t{set.start_y} + set.length_y; y++) {
+      if (m_any_significant(z * slice + y * m_dims[0] + set.start_x, set.length_x))
+        return true;
+    }
+  }
+  return false;
 }
 
 template <typename T>
 void sperr::SPECK3D_INT_ENC<T>::m_process_P(size_t idx, size_t morton, size_t& counter, bool output)
 {
+  assert(m_coeff_order == nullptr || m_coeff_order[idx] == morton);
+  const auto pos = m_coeff_order ? morton : idx;
   bool is_sig = true;
 
   if (output) {
-    assert(m_coeff_buf[idx] == m_morton_buf[morton]);
-    is_sig = (m_morton_buf[morton] >= m_threshold);
+    is_sig = (m_coeff_buf[pos] >= m_threshold);
     m_bit_buffer.wbit(is_sig);
   }
 
+  // Coefficients are left untouched; see `SPECK_INT::m_refinement_pass_encode()`.
   if (is_sig) {
     counter++;  // Let's increment the counter first!
-    assert(m_coeff_buf[idx] >= m_threshold);
-    m_coeff_buf[idx] -= m_threshold;
-
+    assert(m_coeff_buf[pos] >= m_threshold);
     m_bit_buffer.wbit(m_sign_array.rbit(idx));
     m_LSP_new.push_back(idx);
     m_LIP_mask.wfalse(idx);
@@ -204,13 +244,11 @@ void sperr::SPECK3D_INT_ENC<T>::m_process_P(size_t idx, size_t morton, size_t& c
 template <typename T>
 void sperr::SPECK3D_INT_ENC<T>::m_process_P_lite(size_t idx)
 {
-  auto is_sig = (m_coeff_buf[idx] >= m_threshold);
+  const auto pos = m_coeff_order ? size_t{m_coeff_order[idx]} : idx;
+  auto is_sig = (m_coeff_buf[pos] >= m_threshold);
   m_bit_buffer.wbit(is_sig);
 
   if (is_sig) {
-    assert(m_coeff_buf[idx] >= m_threshold);
-    m_coeff_buf[idx] -= m_threshold;
-
     m_bit_buffer.wbit(m_sign_array.rbit(idx));
     m_LSP_new.push_back(idx);
     m_LIP_mask.wfalse(idx);
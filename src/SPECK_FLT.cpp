@@ -11,13 +11,18 @@
 template <typename T>
 void sperr::SPECK_FLT::copy_data(const T* p, size_t len)
 {
-  static_assert(std::is_floating_point<T>::value, "!! Only floating point values are supported !!");
-
   m_vals_d.resize(len);
-  std::copy(p, p + len, m_vals_d.begin());
+  std::transform(p, p + len, m_vals_d.begin(), [](auto v) { return sperr::to_double(v); });
 }
 template void sperr::SPECK_FLT::copy_data(const double*, size_t);
 template void sperr::SPECK_FLT::copy_data(const float*, size_t);
+template void sperr::SPECK_FLT::copy_data(const fp16_type*, size_t);
+template void sperr::SPECK_FLT::copy_data(const bf16_type*, size_t);
+template void sperr::SPECK_FLT::copy_data(const int8_t*, size_t);
+template void sperr::SPECK_FLT::copy_data(const uint8_t*, size_t);
+template void sperr::SPECK_FLT::copy_data(const int16_t*, size_t);
+template void sperr::SPECK_FLT::copy_data(const uint16_t*, size_t);
+template void sperr::SPECK_FLT::copy_data(const int32_t*, size_t);
 
 void sperr::SPECK_FLT::take_data(sperr::vecd_type&& buf)
 {
@@ -32,6 +37,8 @@ auto sperr::SPECK_FLT::use_bitstream(const void* p, size_t len) -> RTNType
   std::visit([](auto&& vec) { vec.clear(); }, m_vals_ui);
   m_q = 0.0;
   m_has_outlier = false;
+  m_num_bitplanes = 0;
+  m_speck_bits = 0;
 
   const auto* const ptr = static_cast<const uint8_t*>(p);
 
@@ -62,6 +69,7 @@ auto sperr::SPECK_FLT::use_bitstream(const void* p, size_t len) -> RTNType
   assert(remaining_len >= SPECK_INT<uint8_t>::header_size);
   const uint8_t* const speck_p = ptr + pos;
   const auto num_bitplanes = speck_int_get_num_bitplanes(speck_p);
+  m_num_bitplanes = num_bitplanes;
   if (num_bitplanes <= 8)
     m_uint_flag = UINTType::UINT8;
   else if (num_bitplanes <= 16)
@@ -81,6 +89,8 @@ auto sperr::SPECK_FLT::use_bitstream(const void* p, size_t len) -> RTNType
   auto speck_suppose_len =
       std::visit([speck_p](auto&& dec) { return dec->get_stream_full_len(speck_p); }, m_decoder);
   auto speck_len = std::min(size_t{speck_suppose_len}, remaining_len);
+  m_speck_bits =
+      std::visit([speck_p](auto&& dec) { return dec->get_speck_bits(speck_p); }, m_decoder);
   std::visit([speck_p, speck_len](auto&& dec) { return dec->use_bitstream(speck_p, speck_len); },
              m_decoder);
   pos += speck_len;
@@ -110,17 +120,46 @@ auto sperr::SPECK_FLT::use_bitstream(const void* p, size_t len) -> RTNType
 
 void sperr::SPECK_FLT::append_encoded_bitstream(vec8_type& buf) const
 {
-  // Append `m_condi_bitstream` no matter what.
-  std::copy(m_condi_bitstream.cbegin(), m_condi_bitstream.cend(), std::back_inserter(buf));
+  const auto orig_size = buf.size();
+  buf.resize(orig_size + encoded_bitstream_len());
+  write_encoded_bitstream(buf.data() + orig_size, buf.size() - orig_size);
+}
 
+auto sperr::SPECK_FLT::encoded_bitstream_len() const -> size_t
+{
+  auto len = m_condi_bitstream.size();
   if (!m_conditioner.is_constant(m_condi_bitstream[0])) {
-    // Append SPECK_INT bitstream.
-    std::visit([&buf](auto&& enc) { enc->append_encoded_bitstream(buf); }, m_encoder);
+    len += std::visit([](auto&& enc) { return enc->encoded_bitstream_len(); }, m_encoder);
+    if (m_has_outlier)
+      len += m_out_coder.encoded_bitstream_len();
+  }
+  return len;
+}
+
+auto sperr::SPECK_FLT::write_encoded_bitstream(void* p, size_t len) const -> RTNType
+{
+  if (len < encoded_bitstream_len())
+    return RTNType::WrongLength;
+
+  // Write `m_condi_bitstream` no matter what.
+  auto* ptr = std::copy(m_condi_bitstream.cbegin(), m_condi_bitstream.cend(),
+                        static_cast<uint8_t*>(p));
 
-    // Append outlier coder bitstream.
+  if (!m_conditioner.is_constant(m_condi_bitstream[0])) {
+    // Write SPECK_INT bitstream.
+    std::visit(
+        [&ptr](auto&& enc) {
+          enc->write_encoded_bitstream(ptr);
+          ptr += enc->encoded_bitstream_len();
+        },
+        m_encoder);
+
+    // Write outlier coder bitstream.
     if (m_has_outlier)
-      m_out_coder.append_encoded_bitstream(buf);
+      m_out_coder.write_encoded_bitstream(ptr);
   }
+
+  return RTNType::Good;
 }
 
 auto sperr::SPECK_FLT::view_decoded_data() const -> const vecd_type&
@@ -133,6 +172,26 @@ auto sperr::SPECK_FLT::release_decoded_data() -> vecd_type&&
   return std::move(m_vals_d);
 }
 
+auto sperr::SPECK_FLT::view_profile() const -> const Profile&
+{
+  return m_profile;
+}
+
+auto sperr::SPECK_FLT::view_memory_usage() const -> const Memory_Usage&
+{
+  return m_mem;
+}
+
+auto sperr::SPECK_FLT::get_mean_var() const -> std::array<double, 2>
+{
+  return {m_conditioner.retrieve_mean(m_condi_bitstream), m_coarse_var};
+}
+
+auto sperr::SPECK_FLT::get_coarse_dims() const -> dims_type
+{
+  return std::get<0>(m_lowest_subband());
+}
+
 auto sperr::SPECK_FLT::release_hierarchy() -> std::vector<vecd_type>&&
 {
   return std::move(m_hierarchy);
@@ -190,6 +249,32 @@ void sperr::SPECK_FLT::set_dims(dims_type dims)
   m_dims = dims;
 }
 
+void sperr::SPECK_FLT::set_decode_effort(Decode_Effort effort)
+{
+  m_effort = effort;
+}
+
+auto sperr::SPECK_FLT::m_effort_caps() const -> std::pair<size_t, uint64_t>
+{
+  auto planes = m_effort.bitplanes;
+  if (m_effort.psnr > 0.0 && m_effort.data_range > 0.0 && m_num_bitplanes > 0) {
+    // Decoding down to a threshold of `t` quantization steps leaves coefficients known within
+    //    intervals of `t` steps, which gives an MSE of about (t * m_q)^2 / 12.
+    const auto rmse = m_effort.data_range * std::pow(10.0, -m_effort.psnr / 20.0);
+    const auto t = rmse * std::sqrt(12.0) / m_q;
+    auto needed = m_num_bitplanes;
+    if (t >= 2.0)
+      needed -= std::min(m_num_bitplanes - 1, static_cast<size_t>(std::floor(std::log2(t))));
+    planes = (planes == 0) ? needed : std::min(planes, needed);
+  }
+
+  auto bits = uint64_t{0};
+  if (m_effort.bit_fraction > 0.0 && m_effort.bit_fraction < 1.0)
+    bits = std::max(uint64_t{1}, uint64_t(std::ceil(m_effort.bit_fraction * m_speck_bits)));
+
+  return {planes, bits};
+}
+
 auto sperr::SPECK_FLT::integer_len() const -> size_t
 {
   switch (m_uint_flag) {
@@ -213,6 +298,22 @@ auto sperr::SPECK_FLT::integer_len() const -> size_t
   }
 }
 
+void sperr::SPECK_FLT::m_account_memory()
+{
+  auto coder_bytes = [](auto&& coder) -> size_t { return coder ? coder->memory_usage() : 0; };
+  auto bytes = std::array<size_t, size_t(MemComp::NumComps)>{};
+  bytes[size_t(MemComp::Coeffs)] = m_vals_d.capacity() * sizeof(double);
+  bytes[size_t(MemComp::Original)] = m_vals_orig.capacity() * sizeof(double);
+  bytes[size_t(MemComp::Quantized)] =
+      std::visit([](auto&& vec) { return vec.capacity() * sizeof(vec[0]); }, m_vals_ui) +
+      (m_sign_array.size() + 63) / 64 * sizeof(uint64_t);
+  bytes[size_t(MemComp::Wavelet)] = m_cdf.memory_usage();
+  bytes[size_t(MemComp::Speck)] =
+      std::visit(coder_bytes, m_encoder) + std::visit(coder_bytes, m_decoder);
+  bytes[size_t(MemComp::Outlier)] = m_out_coder.memory_usage();
+  m_mem.set_current(bytes);
+}
+
 void sperr::SPECK_FLT::m_instantiate_int_vec()
 {
   switch (m_uint_flag) {
@@ -341,8 +442,9 @@ auto sperr::SPECK_FLT::m_midtread_quantize() -> RTNType
   std::visit([total_vals](auto&& vec) { vec.resize(total_vals); }, m_vals_ui);
   m_sign_array.resize(total_vals);
 
+  // Magnitudes go to where the encoder wants them (`m_quant_order`); signs stay in raster order.
   std::visit(
-      [&vals_d = m_vals_d, &signs = m_sign_array, q = m_q](auto&& vec) {
+      [&vals_d = m_vals_d, &signs = m_sign_array, q = m_q, order = m_quant_order](auto&& vec) {
         auto inv = 1.0 / q;
         auto bits_x64 = vals_d.size() - vals_d.size() % 64;
 
@@ -352,7 +454,7 @@ auto sperr::SPECK_FLT::m_midtread_quantize() -> RTNType
           for (size_t j = 0; j < 64; j++) {
             auto ll = std::llrint(vals_d[i + j] * inv);
             bits64 |= uint64_t{ll >= 0} << j;
-            vec[i + j] = std::abs(ll);
+            vec[order ? size_t{order[i + j]} : i + j] = std::abs(ll);
           }
           signs.wlong(i, bits64);
         }
@@ -361,7 +463,7 @@ auto sperr::SPECK_FLT::m_midtread_quantize() -> RTNType
         for (size_t i = bits_x64; i < vals_d.size(); i++) {
           auto ll = std::llrint(vals_d[i] * inv);
           signs.wbit(i, (ll >= 0));
-          vec[i] = std::abs(ll);
+          vec[order ? size_t{order[i]} : i] = std::abs(ll);
         }
       },
       m_vals_ui);
@@ -369,6 +471,11 @@ auto sperr::SPECK_FLT::m_midtread_quantize() -> RTNType
   return RTNType::Good;
 }
 
+auto sperr::SPECK_FLT::m_quantization_order() -> const uint32_t*
+{
+  return nullptr;
+}
+
 void sperr::SPECK_FLT::m_midtread_inv_quantize()
 {
   assert(m_sign_array.size() == std::visit([](auto&& vec) { return vec.size(); }, m_vals_ui));
@@ -378,7 +485,8 @@ void sperr::SPECK_FLT::m_midtread_inv_quantize()
   m_vals_d.resize(m_sign_array.size());
 
   std::visit(
-      [&vals_d = m_vals_d, &signs = m_sign_array, q = m_q, tmpd](auto&& vec) {
+      [&vals_d = m_vals_d, &signs = m_sign_array, q = m_q, tmpd, order = m_quant_order](
+          auto&& vec) {
         auto bits_x64 = vals_d.size() - vals_d.size() % 64;
 
         // Process 64 values at a time.
@@ -386,13 +494,16 @@ void sperr::SPECK_FLT::m_midtread_inv_quantize()
           const auto bits64 = signs.rlong(i);
           for (size_t j = 0; j < 64; j++) {
             auto bit = (bits64 >> j) & uint64_t{1};
-            vals_d[i + j] = q * static_cast<double>(vec[i + j]) * tmpd[bit];
+            auto mag = vec[order ? size_t{order[i + j]} : i + j];
+            vals_d[i + j] = q * static_cast<double>(mag) * tmpd[bit];
           }
         }
 
         // Process the remaining bits.
-        for (size_t i = bits_x64; i < vals_d.size(); i++)
-          vals_d[i] = q * static_cast<double>(vec[i]) * tmpd[signs.rbit(i)];
+        for (size_t i = bits_x64; i < vals_d.size(); i++) {
+          auto mag = vec[order ? size_t{order[i]} : i];
+          vals_d[i] = q * static_cast<double>(mag) * tmpd[signs.rbit(i)];
+        }
       },
       m_vals_ui);
 }
@@ -407,11 +518,17 @@ auto sperr::SPECK_FLT::compress() -> RTNType
     return RTNType::CompModeUnknown;
 
   m_has_outlier = false;
+  m_profile.reset();
+  SPERR_PROFILE_WALL(&m_profile);
+  [[maybe_unused]] const auto total_bytes = total_vals * sizeof(double);
 
   // Step 1: data goes through the conditioner
   //    Believe it or not, there are constant fields passed in for compression!
   //    Let's detect that case and skip the rest of the compression routine if it occurs.
-  m_condi_bitstream = m_conditioner.condition(m_vals_d, m_dims);
+  {
+    SPERR_PROFILE_SCOPE(&m_profile, Stage::Condition, total_bytes);
+    m_condi_bitstream = m_conditioner.condition(m_vals_d, m_dims);
+  }
   if (m_conditioner.is_constant(m_condi_bitstream[0]))
     return RTNType::Good;
 
@@ -430,11 +547,16 @@ auto sperr::SPECK_FLT::compress() -> RTNType
     }
     default:;  // So the compiler doesn't complain about missing switch cases.
   }
+  m_account_memory();
 
   // Step 2: wavelet transform
-  m_cdf.take_data(std::move(m_vals_d), m_dims);
-  m_wavelet_xform();
-  m_vals_d = m_cdf.release_data();
+  {
+    SPERR_PROFILE_SCOPE(&m_profile, Stage::Wavelet, total_bytes);
+    m_cdf.take_data(std::move(m_vals_d), m_dims);
+    m_wavelet_xform();
+    m_vals_d = m_cdf.release_data();
+  }
+  m_account_memory();
 
   // Step 2.1: Estimate `m_q`, and store it as part of `m_condi_stream`.
   if (m_mode == CompMode::Rate) {
@@ -446,18 +568,28 @@ auto sperr::SPECK_FLT::compress() -> RTNType
 
   bool high_prec = false;
 FIXED_RATE_HIGH_PREC_LABEL:
-  m_q = m_estimate_q(param_q, high_prec);
+  {
+    SPERR_PROFILE_SCOPE(&m_profile, Stage::EstimateQ, 0);
+    m_q = m_estimate_q(param_q, high_prec);
+  }
   assert(m_q > 0.0);
   m_conditioner.save_q(m_condi_bitstream, m_q);
 
   // Step 3: quantize floating-point coefficients to integers.
   // This step also establishes the integer length used by the encoder/decoder.
-  auto rtn = m_midtread_quantize();
+  auto rtn = RTNType::Good;
+  m_quant_order = m_quantization_order();
+  {
+    SPERR_PROFILE_SCOPE(&m_profile, Stage::Quantize, total_bytes);
+    rtn = m_midtread_quantize();
+  }
   if (rtn != RTNType::Good)
     return rtn;
+  m_account_memory();
 
   // CompMode::PWE only: perform outlier coding: find out all the outliers, and encode them!
   if (m_mode == CompMode::PWE) {
+    SPERR_PROFILE_SCOPE(&m_profile, Stage::Outlier, total_bytes * 2);
     m_midtread_inv_quantize();
     rtn = m_cdf.take_data(std::move(m_vals_d), m_dims);
     if (rtn != RTNType::Good)
@@ -475,6 +607,7 @@ FIXED_RATE_HIGH_PREC_LABEL:
       m_has_outlier = false;
     else {
       m_has_outlier = true;
+      SPERR_PROFILE_EXEC(m_profile.add_outliers(LOS.size()));
       m_out_coder.set_length(total_vals);
       m_out_coder.set_tolerance(m_quality);
       m_out_coder.use_outlier_list(std::move(LOS));
@@ -482,97 +615,319 @@ FIXED_RATE_HIGH_PREC_LABEL:
       if (rtn != RTNType::Good)
         return rtn;
     }
+    m_account_memory();
   }
 
-  // Step 4: Integer SPECK encoding
-  m_instantiate_encoder();
-  if (m_mode == CompMode::Rate) {
-    auto budget = static_cast<size_t>(m_quality * double(total_vals));  // total num of bits
-    std::visit([budget](auto&& encoder) { encoder->set_budget(budget); }, m_encoder);
+  // Step 4: Integer SPECK encoding. In CompMode::Rate mode, the first attempt might be redone
+  //    with a higher precision (see below), so it records to a separate profile, and only its
+  //    stage times are kept then.
+  auto budget = size_t{0};  // Zero means no budget.
+  if (m_mode == CompMode::Rate)
+    budget = static_cast<size_t>(m_quality * double(total_vals));  // total num of bits
+  auto attempt = Profile();
+  const auto first_rate = (m_mode == CompMode::Rate && high_prec == false);
+  rtn = m_speck_encode(budget, first_rate ? &attempt : &m_profile);
+  if (rtn != RTNType::Good)
+    return rtn;
+
+  // In CompMode::Rate mode, we see if there's enough bits produced. If not, we adjust `m_q`
+  //    so quantiztion is done with a higher precision.
+  //    Btw I know that GOTO should be used very sparsely and with great caution. I think this
+  //    is one place where it's making the code most clean and not introducing additional risks.
+  //
+  if (m_mode == CompMode::Rate && high_prec == false) {
+    assert(m_encoder.index() == 2);
+    auto actual = std::get<2>(m_encoder)->encoded_bitstream_len() * size_t{8};
+    if (actual < budget) {
+      for (auto s : {Stage::SpeckSorting, Stage::SpeckRefinement})
+        m_profile.add_time(s, attempt.time(s));
+      high_prec = true;
+      goto FIXED_RATE_HIGH_PREC_LABEL;
+    }
   }
+  if (first_rate)
+    m_profile.merge(attempt);
+
+  return RTNType::Good;
+}
+
+auto sperr::SPECK_FLT::m_speck_encode(size_t budget, Profile* prof) -> RTNType
+{
+  auto rtn = RTNType::Good;
+  m_instantiate_encoder();
+  std::visit([budget](auto&& encoder) { encoder->set_budget(budget); }, m_encoder);
   std::visit([&dims = m_dims](auto&& encoder) { encoder->set_dims(dims); }, m_encoder);
+  std::visit([prof](auto&& encoder) { encoder->set_profile(prof); }, m_encoder);
+  const auto arranged = (m_quant_order != nullptr);
+  auto feed = [&signs = m_sign_array, arranged](auto& enc, auto& vec) {
+    if (arranged)
+      return enc->use_arranged_coeffs(std::move(vec), std::move(signs));
+    else
+      return enc->use_coeffs(std::move(vec), std::move(signs));
+  };
   switch (m_uint_flag) {
     case UINTType::UINT8:
       assert(m_vals_ui.index() == 0);
       assert(m_encoder.index() == 0);
-      rtn = std::get<0>(m_encoder)->use_coeffs(std::move(std::get<0>(m_vals_ui)),
-                                               std::move(m_sign_array));
+      rtn = feed(std::get<0>(m_encoder), std::get<0>(m_vals_ui));
       break;
     case UINTType::UINT16:
       assert(m_vals_ui.index() == 1);
       assert(m_encoder.index() == 1);
-      rtn = std::get<1>(m_encoder)->use_coeffs(std::move(std::get<1>(m_vals_ui)),
-                                               std::move(m_sign_array));
+      rtn = feed(std::get<1>(m_encoder), std::get<1>(m_vals_ui));
       break;
     case UINTType::UINT32:
       assert(m_vals_ui.index() == 2);
       assert(m_encoder.index() == 2);
-      rtn = std::get<2>(m_encoder)->use_coeffs(std::move(std::get<2>(m_vals_ui)),
-                                               std::move(m_sign_array));
+      rtn = feed(std::get<2>(m_encoder), std::get<2>(m_vals_ui));
       break;
     default:
       assert(m_vals_ui.index() == 3);
       assert(m_encoder.index() == 3);
-      rtn = std::get<3>(m_encoder)->use_coeffs(std::move(std::get<3>(m_vals_ui)),
-                                               std::move(m_sign_array));
+      rtn = feed(std::get<3>(m_encoder), std::get<3>(m_vals_ui));
   }
   if (rtn != RTNType::Good)
     return rtn;
 
   std::visit([](auto&& encoder) { encoder->encode(); }, m_encoder);
+  m_account_memory();
 
-  // In CompMode::Rate mode, we see if there's enough bits produced. If not, we adjust `m_q`
-  //    so quantiztion is done with a higher precision.
-  //    Btw I know that GOTO should be used very sparsely and with great caution. I think this
-  //    is one place where it's making the code most clean and not introducing additional risks.
-  //
-  if (m_mode == CompMode::Rate && high_prec == false) {
-    assert(m_encoder.index() == 2);
-    auto budget = static_cast<size_t>(m_quality * double(total_vals));
-    auto actual = std::get<2>(m_encoder)->encoded_bitstream_len() * size_t{8};
-    if (actual < budget) {
-      high_prec = true;
-      goto FIXED_RATE_HIGH_PREC_LABEL;
+  return RTNType::Good;
+}
+
+auto sperr::SPECK_FLT::estimate(CompMode mode, const std::vector<double>& qualities)
+    -> std::vector<RD_Estimate>
+{
+  const auto total_vals = size_t(m_dims[0]) * m_dims[1] * m_dims[2];
+  if (m_vals_d.empty() || m_vals_d.size() != total_vals || qualities.empty())
+    return {};
+  if (std::any_of(qualities.cbegin(), qualities.cend(), [](auto v) { return v <= 0.0; }))
+    return {};
+  if (mode != CompMode::PSNR && mode != CompMode::PWE && mode != CompMode::Rate)
+    return {};
+
+  m_has_outlier = false;
+  m_profile.reset();
+  auto est = std::vector<RD_Estimate>(qualities.size());
+  const auto condi_bits = double(m_condi_bitstream.size() * 8);
+  const auto header_bits = condi_bits + double(SPECK_INT<uint8_t>::header_size * 8);
+
+  // Step 1: conditioning. A constant field costs nothing but the conditioner header.
+  m_condi_bitstream = m_conditioner.condition(m_vals_d, m_dims);
+  if (m_conditioner.is_constant(m_condi_bitstream[0])) {
+    for (auto& e : est)
+      e.bits = condi_bits;
+    return est;
+  }
+  auto [min, max] = std::minmax_element(m_vals_d.cbegin(), m_vals_d.cend());
+  const auto range = *max - *min;
+  if (mode == CompMode::PWE)
+    m_vals_orig = m_vals_d;
+
+  // Step 2: wavelet transform.
+  m_cdf.take_data(std::move(m_vals_d), m_dims);
+  m_wavelet_xform();
+  m_vals_d = m_cdf.release_data();
+
+  // Step 3: the quantization step of each setting, the same as `compress()` would pick.
+  m_mode = mode;
+  auto param_q = range;
+  if (mode == CompMode::Rate) {
+    auto itr = std::max_element(m_vals_d.cbegin(), m_vals_d.cend(),
+                                [](auto a, auto b) { return std::abs(a) < std::abs(b); });
+    param_q = std::abs(*itr);
+  }
+  auto steps = vecd_type(qualities.size());
+  for (size_t i = 0; i < qualities.size(); i++) {
+    m_quality = qualities[i];
+    steps[i] = m_estimate_q(param_q, false);
+  }
+  m_quality = *std::max_element(qualities.cbegin(), qualities.cend());
+  m_q = *std::min_element(steps.cbegin(), steps.cend());
+  if (!(m_q > 0.0))
+    return {};
+  m_conditioner.save_q(m_condi_bitstream, m_q);
+
+  // Step 4: a single encoding at the finest step, or the highest rate.
+  auto budget = size_t{0};
+  if (mode == CompMode::Rate)
+    budget = static_cast<size_t>(m_quality * double(total_vals));
+  m_quant_order = m_quantization_order();
+  if (m_midtread_quantize() != RTNType::Good ||
+      m_speck_encode(budget, &m_profile) != RTNType::Good)
+    return {};
+  const auto plane_bits = std::visit(
+      [](auto&& enc) {
+        auto bits = std::vector<double>();
+        for (auto b : enc->view_bitplane_bits())
+          bits.push_back(double(b));
+        bits.push_back(double((enc->encoded_bitstream_len() - enc->header_size) * 8));
+        return bits;
+      },
+      m_encoder);
+  const auto num_planes = plane_bits.size() - 1;  // The last entry is the whole stream.
+
+  if (mode == CompMode::Rate) {
+    // Bitplane `j` ends at a threshold of `top` / 2^j quantization steps, and the decoder
+    //    reconstructs significant coefficients at the middle of their intervals.
+    //    The distortion at a given number of bits is interpolated between bitplane ends.
+    const auto top = std::exp2(std::floor(std::log2(std::round(param_q / m_q))));
+    auto truncated_mse = [&vals = m_vals_d](double t) {
+      auto sum = 0.0;
+      for (auto v : vals) {
+        auto a = std::abs(v);
+        auto e = a < t ? a : a - (std::floor(a / t) + 0.5) * t;
+        sum += e * e;
+      }
+      return sum / double(vals.size());
+    };
+    auto points = std::vector<std::array<double, 2>>();  // bits and log(mse)
+    points.push_back({0.0, std::log(truncated_mse(std::numeric_limits<double>::max()))});
+    for (size_t j = 0; j < plane_bits.size() - 1; j++) {
+      auto t = m_q * top / std::exp2(double(j));
+      points.push_back({plane_bits[j], std::log(truncated_mse(t))});
+    }
+    for (size_t i = 0; i < qualities.size(); i++) {
+      auto bits = qualities[i] * double(total_vals);
+      auto it = std::find_if(points.cbegin(), points.cend(), [bits](auto p) {
+        return p[0] >= bits;
+      });
+      auto log_mse = points.back()[1];
+      if (it != points.cend() && it != points.cbegin()) {
+        auto lo = *(it - 1), hi = *it;
+        log_mse = lo[1] + (hi[1] - lo[1]) * (bits - lo[0]) / (hi[0] - lo[0]);
+      }
+      est[i].bits = std::ceil(bits / 8.0) * 8.0 + header_bits;
+      est[i].sse = std::exp(log_mse) * double(total_vals);
     }
+    return est;
   }
 
-  return RTNType::Good;
+  // Encoding at a coarser step `q` keeps the coefficients of at least q / 2, which are the
+  //    ones of at least (q / m_q + 1) / 2 steps here. The bits of the bitplane ending at that
+  //    threshold are interpolated geometrically, and then each of those coefficients has one
+  //    refinement bit fewer when encoded at step `q`.
+  auto speck_bits = [&plane_bits, num_planes, q0 = m_q, &vals = m_vals_d](double q) {
+    if (q <= q0 || num_planes == 0)
+      return plane_bits.back();
+    const auto thrd = std::log2((q / q0 + 1.0) * 0.5);
+    const auto j = std::clamp(double(num_planes - 1) - thrd, 0.0, double(num_planes - 1));
+    const auto lo = static_cast<size_t>(j);
+    const auto hi = std::min(lo + 1, num_planes - 1);
+    const auto frac = j - double(lo);
+    const auto bits = std::exp2(std::log2(plane_bits[lo] + 1.0) * (1.0 - frac) +
+                                std::log2(plane_bits[hi] + 1.0) * frac);
+    const auto nsig = std::count_if(vals.cbegin(), vals.cend(),
+                                    [h = q * 0.5](auto v) { return std::abs(v) >= h; });
+    return std::max(bits - double(nsig), 0.0);
+  };
+
+  for (size_t i = 0; i < qualities.size(); i++) {
+    est[i].bits = std::ceil(speck_bits(steps[i]) / 8.0) * 8.0 + header_bits;
+    if (mode == CompMode::PSNR)
+      est[i].sse = m_estimate_mse_midtread(steps[i]) * double(total_vals);
+  }
+
+  // PWE mode: find the outliers of each setting in the data domain, and encode them. The
+  //    corrected outliers are assumed to have errors uniformly distributed within tolerance.
+  if (mode == CompMode::PWE) {
+    const auto coeffs = m_vals_d;
+    for (size_t i = 0; i < qualities.size(); i++) {
+      const auto q = steps[i];
+      const auto tol = qualities[i];
+      auto recon = vecd_type(total_vals);
+      std::transform(coeffs.cbegin(), coeffs.cend(), recon.begin(),
+                     [q](auto v) { return q * std::nearbyint(v / q); });
+      if (m_cdf.take_data(std::move(recon), m_dims) != RTNType::Good)
+        return {};
+      m_inverse_wavelet_xform(false);
+      recon = m_cdf.release_data();
+      auto LOS = std::vector<Outlier>();
+      auto sse = 0.0;
+      for (size_t j = 0; j < total_vals; j++) {
+        auto diff = m_vals_orig[j] - recon[j];
+        if (std::abs(diff) > tol) {
+          LOS.emplace_back(j, diff);
+          sse += tol * tol / 3.0;
+        }
+        else
+          sse += diff * diff;
+      }
+      est[i].sse = sse;
+      if (!LOS.empty()) {
+        m_out_coder.set_length(total_vals);
+        m_out_coder.set_tolerance(tol);
+        m_out_coder.use_outlier_list(std::move(LOS));
+        if (m_out_coder.encode() != RTNType::Good)
+          return {};
+        auto buf = vec8_type();
+        m_out_coder.append_encoded_bitstream(buf);
+        est[i].bits += double(buf.size() * 8);
+      }
+    }
+  }
+  m_account_memory();
+
+  return est;
 }
 
 auto sperr::SPECK_FLT::decompress(bool multi_res) -> RTNType
 {
   m_vals_d.clear();
+  m_quant_order = nullptr;  // Decoders always produce coefficients in raster order.
   // m_hierarchy.clear(); // Intentionally not clearing, reusing already-allocated memory.
   std::visit([](auto&& vec) { vec.clear(); }, m_vals_ui);
   m_sign_array.resize(0);
+  m_profile.reset();
+  SPERR_PROFILE_WALL(&m_profile);
+  [[maybe_unused]] const auto total_bytes = m_dims[0] * m_dims[1] * m_dims[2] * sizeof(double);
 
   // `m_condi_bitstream` might be indicating a constant field, so let's see if that's
   // the case, and if it is, we don't need to go through wavelet and speck stuff anymore.
   if (m_conditioner.is_constant(m_condi_bitstream[0])) {
+    SPERR_PROFILE_SCOPE(&m_profile, Stage::InverseCondition, total_bytes);
     auto rtn = m_conditioner.inverse_condition(m_vals_d, m_dims, m_condi_bitstream);
     return rtn;
   }
 
-  // Step 1: Integer SPECK decode.
+  // Step 1: Integer SPECK decode, stopping early if the decode effort is capped.
   // Note: the decoder has already parsed the bitstream in function `use_bitstream()`.
   assert(m_q > 0.0);
+  const auto [plane_cap, bit_cap] = m_effort_caps();
+  const auto capped = (plane_cap > 0 && plane_cap < m_num_bitplanes) ||
+                      (bit_cap > 0 && bit_cap < m_speck_bits);
   std::visit([dims = m_dims](auto&& decoder) { decoder->set_dims(dims); }, m_decoder);
+  std::visit([prof = &m_profile](auto&& decoder) { decoder->set_profile(prof); }, m_decoder);
+  std::visit([cap = plane_cap](auto&& dec) { dec->set_bitplane_cap(cap); }, m_decoder);
+  std::visit([cap = bit_cap](auto&& dec) { dec->set_bit_cap(cap); }, m_decoder);
   std::visit([](auto&& decoder) { decoder->decode(); }, m_decoder);
   std::visit([&vec = m_vals_ui](auto&& dec) { vec = dec->release_coeffs(); }, m_decoder);
   m_sign_array = std::visit([](auto&& dec) { return dec->release_signs(); }, m_decoder);
+  m_account_memory();
 
   // Step 2: Inverse quantization
-  m_midtread_inv_quantize();
+  {
+    SPERR_PROFILE_SCOPE(&m_profile, Stage::InverseQuantize, total_bytes);
+    m_midtread_inv_quantize();
+  }
+  m_account_memory();
 
   // Step 3: Inverse wavelet transform
-  auto rtn = m_cdf.take_data(std::move(m_vals_d), m_dims);
-  if (rtn != RTNType::Good)
-    return rtn;
-  m_inverse_wavelet_xform(multi_res);
-  m_vals_d = m_cdf.release_data();
+  auto rtn = RTNType::Good;
+  {
+    SPERR_PROFILE_SCOPE(&m_profile, Stage::InverseWavelet, total_bytes);
+    rtn = m_cdf.take_data(std::move(m_vals_d), m_dims);
+    if (rtn != RTNType::Good)
+      return rtn;
+    m_inverse_wavelet_xform(multi_res);
+    m_vals_d = m_cdf.release_data();
+  }
+  m_account_memory();
 
-  // Side step: outlier correction, if needed
-  if (m_has_outlier) {
+  // Side step: outlier correction, if needed. Outliers of the full decode don't apply to a
+  //    decode that stopped early.
+  if (m_has_outlier && !capped) {
+    SPERR_PROFILE_SCOPE(&m_profile, Stage::Outlier, total_bytes);
     m_out_coder.set_length(m_dims[0] * m_dims[1] * m_dims[2]);
     m_out_coder.set_tolerance(m_q / 1.5);  // `m_quality` is not set during decompression.
     rtn = m_out_coder.decode();
@@ -581,10 +936,14 @@ auto sperr::SPECK_FLT::decompress(bool multi_res) -> RTNType
     const auto& recovered = m_out_coder.view_outlier_list();
     for (auto out : recovered)
       m_vals_d[out.pos] += out.err;
+    SPERR_PROFILE_EXEC(m_profile.add_outliers(recovered.size()));
   }
 
   // Step 4: Inverse Conditioning
-  rtn = m_conditioner.inverse_condition(m_vals_d, m_dims, m_condi_bitstream);
+  {
+    SPERR_PROFILE_SCOPE(&m_profile, Stage::InverseCondition, total_bytes);
+    rtn = m_conditioner.inverse_condition(m_vals_d, m_dims, m_condi_bitstream);
+  }
   if (rtn != RTNType::Good)
     return rtn;
 
@@ -603,3 +962,62 @@ auto sperr::SPECK_FLT::decompress(bool multi_res) -> RTNType
 
   return RTNType::Good;
 }
+
+auto sperr::SPECK_FLT::decompress_coarse(size_t num_bitplanes) -> RTNType
+{
+  m_vals_d.clear();
+  m_quant_order = nullptr;
+  std::visit([](auto&& vec) { vec.clear(); }, m_vals_ui);
+  m_sign_array.resize(0);
+  m_coarse_var = 0.0;
+  m_profile.reset();
+  SPERR_PROFILE_WALL(&m_profile);
+
+  const auto total_vals = m_dims[0] * m_dims[1] * m_dims[2];
+  const auto [coarse_dims, num_levels] = m_lowest_subband();
+  const auto mean = m_conditioner.retrieve_mean(m_condi_bitstream);
+  if (m_conditioner.is_constant(m_condi_bitstream[0]) || num_bitplanes == 0) {
+    m_vals_d.assign(coarse_dims[0] * coarse_dims[1] * coarse_dims[2], mean);
+    return RTNType::Good;
+  }
+
+  // Step 1: Integer SPECK decode of the first bitplanes only.
+  assert(m_q > 0.0);
+  std::visit([dims = m_dims](auto&& decoder) { decoder->set_dims(dims); }, m_decoder);
+  std::visit([prof = &m_profile](auto&& decoder) { decoder->set_profile(prof); }, m_decoder);
+  std::visit([num_bitplanes](auto&& dec) { dec->set_bitplane_cap(num_bitplanes); }, m_decoder);
+  std::visit([](auto&& decoder) { decoder->set_bit_cap(0); }, m_decoder);
+  std::visit([](auto&& decoder) { decoder->decode(); }, m_decoder);
+  std::visit([](auto&& decoder) { decoder->set_bitplane_cap(0); }, m_decoder);
+  std::visit([&vec = m_vals_ui](auto&& dec) { vec = dec->release_coeffs(); }, m_decoder);
+  m_sign_array = std::visit([](auto&& dec) { return dec->release_signs(); }, m_decoder);
+
+  // Step 2: Inverse quantization
+  {
+    SPERR_PROFILE_SCOPE(&m_profile, Stage::InverseQuantize, total_vals * sizeof(double));
+    m_midtread_inv_quantize();
+  }
+  m_account_memory();
+
+  // Step 3: the wavelet transform (nearly) preserves energy, and the conditioned data has a zero
+  //    mean, so the energy of the decoded coefficients approximates the variance of the data.
+  assert(m_vals_d.size() == total_vals);
+  m_coarse_var = std::accumulate(m_vals_d.cbegin(), m_vals_d.cend(), 0.0,
+                                 [](double a, double v) { return a + v * v; });
+  m_coarse_var /= static_cast<double>(total_vals);
+
+  // Step 4: the lowest subband is at the beginning of every dimension. Move it to the front of
+  //    `m_vals_d` in place, undo the transform gain, and add back the mean.
+  const auto gain = std::pow(std::sqrt(2.0), static_cast<double>(num_levels));
+  auto* dst = m_vals_d.data();
+  for (size_t z = 0; z < coarse_dims[2]; z++) {
+    for (size_t y = 0; y < coarse_dims[1]; y++) {
+      const auto* src = m_vals_d.data() + z * m_dims[0] * m_dims[1] + y * m_dims[0];
+      dst = std::transform(src, src + coarse_dims[0], dst,
+                           [gain, mean](auto v) { return v / gain + mean; });
+    }
+  }
+  m_vals_d.resize(coarse_dims[0] * coarse_dims[1] * coarse_dims[2]);
+
+  return RTNType::Good;
+}
@@ -41,6 +41,12 @@ void sperr::SPECK_INT<T>::set_dims(dims_type dims)
   m_dims = dims;
 }
 
+template <typename T>
+void sperr::SPECK_INT<T>::set_profile(Profile* prof)
+{
+  m_profile = prof;
+}
+
 template <typename T>
 void sperr::SPECK_INT<T>::set_budget(size_t bud)
 {
@@ -53,6 +59,24 @@ void sperr::SPECK_INT<T>::set_budget(size_t bud)
   }
 }
 
+template <typename T>
+void sperr::SPECK_INT<T>::set_bitplane_cap(size_t cap)
+{
+  if (cap == 0)
+    m_bitplane_cap = std::numeric_limits<size_t>::max();
+  else
+    m_bitplane_cap = cap;
+}
+
+template <typename T>
+void sperr::SPECK_INT<T>::set_bit_cap(uint64_t cap)
+{
+  if (cap == 0)
+    m_bit_cap = std::numeric_limits<uint64_t>::max();
+  else
+    m_bit_cap = cap;
+}
+
 template <typename T>
 auto sperr::SPECK_INT<T>::get_speck_bits(const void* buf) const -> uint64_t
 {
@@ -84,21 +108,16 @@ void sperr::SPECK_INT<T>::use_bitstream(const void* p, size_t len)
   std::memcpy(&m_num_bitplanes, p8, sizeof(m_num_bitplanes));
   std::memcpy(&m_total_bits, p8 + sizeof(m_num_bitplanes), sizeof(m_total_bits));
 
-  // Step 2: unpack bits.
+  // Step 2: view bits in place (no copy); `p` needs to remain valid until decode() finishes.
   //    Note that the bitstream passed in might not be of its original length as a result of
-  //    progressive access. In that case, we parse available bits, and pad 0's to make the
-  //    bitstream still have `m_total_bits`.
+  //    progressive access. In that case, we view available bits, and the view pads 0's to
+  //    make the bitstream still have `m_total_bits`.
   m_avail_bits = (len - header_size) * 8;
-  if (m_avail_bits < m_total_bits) {
-    m_bit_buffer.reserve(m_total_bits);
-    m_bit_buffer.reset();  // Set buffer to contain all 0's.
-    m_bit_buffer.parse_bitstream(p8 + header_size, m_avail_bits);
-  }
-  else {
+  if (m_avail_bits >= m_total_bits) {
     assert(m_avail_bits - m_total_bits < 64);
     m_avail_bits = m_total_bits;
-    m_bit_buffer.parse_bitstream(p8 + header_size, m_total_bits);
   }
+  m_bit_buffer.view_bitstream(p8 + header_size, m_avail_bits);
 
   // After parsing an incoming bitstream, m_avail_bits <= m_total_bits.
 }
@@ -111,6 +130,7 @@ void sperr::SPECK_INT<T>::encode()
   m_bit_buffer.reserve(coeff_len);  // A good starting point
   m_bit_buffer.rewind();
   m_total_bits = 0;
+  m_bitplane_bits.clear();
 
   // Mark every coefficient as insignificant
   m_LSP_mask.resize(coeff_len);
@@ -125,6 +145,7 @@ void sperr::SPECK_INT<T>::encode()
   //    Of course, `m_total_bits` is also zero.
   if (std::all_of(m_coeff_buf.cbegin(), m_coeff_buf.cend(), [](auto v) { return v == 0; })) {
     m_num_bitplanes = 0;
+    m_release_encoding_buffers();
     return;
   }
 
@@ -138,23 +159,43 @@ void sperr::SPECK_INT<T>::encode()
     m_num_bitplanes++;
   }
 
-  // Marching over bitplanes.
+  // Marching over bitplanes. The profile records the bytes each pass produces; bits past the
+  //    budget are not packed (see `append_encoded_bitstream()`), so they're not counted.
+  SPERR_PROFILE_EXEC(auto sorting_bits = size_t{0});
+  SPERR_PROFILE_EXEC(auto refinement_bits = size_t{0});
   for (uint8_t bitplane = 0; bitplane < m_num_bitplanes; bitplane++) {
-    m_sorting_pass();
+    SPERR_PROFILE_EXEC(if (m_profile) m_profile->add_bitplanes(1));
+    SPERR_PROFILE_EXEC(auto bits = m_bit_buffer.wtell());
+    {
+      SPERR_PROFILE_SCOPE(m_profile, Stage::SpeckSorting, 0);
+      m_sorting_pass();
+    }
+    SPERR_PROFILE_EXEC(sorting_bits += std::min(m_bit_buffer.wtell(), m_budget) - bits);
     if (m_bit_buffer.wtell() >= m_budget)  // Happens only when fixed-rate compression.
       break;
 
-    m_refinement_pass_encode();
+    SPERR_PROFILE_EXEC(bits = m_bit_buffer.wtell());
+    {
+      SPERR_PROFILE_SCOPE(m_profile, Stage::SpeckRefinement, 0);
+      m_refinement_pass_encode();
+    }
+    SPERR_PROFILE_EXEC(refinement_bits += std::min(m_bit_buffer.wtell(), m_budget) - bits);
     if (m_bit_buffer.wtell() >= m_budget)  // Happens only when fixed-rate compression.
       break;
+    m_bitplane_bits.push_back(m_bit_buffer.wtell());
 
     m_threshold /= uint_type{2};
     m_clean_LIS();
+    SPERR_PROFILE_EXEC(if (m_profile) m_profile->update_LIS_size(m_LIS_size()));
   }
 
   // Record the total number of bits produced, and flush the stream.
   m_total_bits = m_bit_buffer.wtell();
   m_bit_buffer.flush();
+  SPERR_PROFILE_EXEC(if (m_profile) m_profile->add_bytes(Stage::SpeckSorting, sorting_bits / 8));
+  SPERR_PROFILE_EXEC(if (m_profile)
+                         m_profile->add_bytes(Stage::SpeckRefinement, refinement_bits / 8));
+  m_release_encoding_buffers();
 }
 
 template <typename T>
@@ -184,23 +225,36 @@ void sperr::SPECK_INT<T>::decode()
     return;
   }
 
+  // A bit cap makes fewer bits available for the duration of this call.
+  const auto avail_bits = m_avail_bits;
+  m_avail_bits = std::min(m_avail_bits, m_bit_cap);
+
   // Restore the biggest `m_threshold`.
   m_threshold = 1;
   for (uint8_t i = 1; i < m_num_bitplanes; i++)
     m_threshold *= uint_type{2};
 
-  // Marching over bitplanes.
-  for (uint8_t bitplane = 0; bitplane < m_num_bitplanes; bitplane++) {
-    m_sorting_pass();
+  // Marching over bitplanes, up to the cap.
+  const auto num_bitplanes = std::min(size_t{m_num_bitplanes}, m_bitplane_cap);
+  for (size_t bitplane = 0; bitplane < num_bitplanes; bitplane++) {
+    SPERR_PROFILE_EXEC(if (m_profile) m_profile->add_bitplanes(1));
+    {
+      SPERR_PROFILE_SCOPE(m_profile, Stage::SpeckSorting, 0);
+      m_sorting_pass();
+    }
     if (m_bit_buffer.rtell() >= m_avail_bits)  // Happens when a partial bitstream is available,
       break;                                   // because of progressive decoding or fixed-rate.
 
-    m_refinement_pass_decode();
+    {
+      SPERR_PROFILE_SCOPE(m_profile, Stage::SpeckRefinement, 0);
+      m_refinement_pass_decode();
+    }
     if (m_bit_buffer.rtell() >= m_avail_bits)  // Happens when a partial bitstream is available,
       break;                                   // because of progressive decoding or fixed-rate.
 
     m_threshold /= uint_type{2};
     m_clean_LIS();
+    SPERR_PROFILE_EXEC(if (m_profile) m_profile->update_LIS_size(m_LIS_size()));
   }
 
   // The majority of newly identified significant points are initialized by the refinement pass.
@@ -214,12 +268,15 @@ void sperr::SPECK_INT<T>::decode()
       m_coeff_buf[idx] = init_val;
   }
 
-  if (m_avail_bits == m_total_bits)
+  if (num_bitplanes < m_num_bitplanes)
+    assert(m_bit_buffer.rtell() <= m_total_bits);
+  else if (m_avail_bits == m_total_bits)
     assert(m_bit_buffer.rtell() == m_total_bits);
   else {
     assert(m_bit_buffer.rtell() >= m_avail_bits);
     assert(m_bit_buffer.rtell() <= m_total_bits);
   }
+  m_avail_bits = avail_bits;
 }
 
 template <typename T>
@@ -229,9 +286,24 @@ auto sperr::SPECK_INT<T>::use_coeffs(vecui_type coeffs, Bitmask signs) -> RTNTyp
     return RTNType::Error;
   m_coeff_buf = std::move(coeffs);
   m_sign_array = std::move(signs);
+  m_coeffs_arranged = false;
   return RTNType::Good;
 }
 
+template <typename T>
+auto sperr::SPECK_INT<T>::use_arranged_coeffs(vecui_type coeffs, Bitmask signs) -> RTNType
+{
+  auto rtn = use_coeffs(std::move(coeffs), std::move(signs));
+  m_coeffs_arranged = (rtn == RTNType::Good);
+  return rtn;
+}
+
+template <typename T>
+auto sperr::SPECK_INT<T>::view_bitplane_bits() const -> const std::vector<uint64_t>&
+{
+  return m_bitplane_bits;
+}
+
 template <typename T>
 auto sperr::SPECK_INT<T>::release_coeffs() -> vecui_type&&
 {
@@ -256,6 +328,15 @@ auto sperr::SPECK_INT<T>::view_signs() const -> const Bitmask&
   return m_sign_array;
 }
 
+template <typename T>
+auto sperr::SPECK_INT<T>::memory_usage() const -> size_t
+{
+  auto mask_bytes = [](const Bitmask& mask) { return (mask.size() + 63) / 64 * sizeof(uint64_t); };
+  return m_coeff_buf.capacity() * sizeof(uint_type) + m_LSP_new.capacity() * sizeof(uint64_t) +
+         mask_bytes(m_LSP_mask) + mask_bytes(m_LIP_mask) + mask_bytes(m_sign_array) +
+         m_bit_buffer.capacity() / 8;
+}
+
 template <typename T>
 auto sperr::SPECK_INT<T>::encoded_bitstream_len() const -> size_t
 {
@@ -279,24 +360,27 @@ auto sperr::SPECK_INT<T>::encoded_bitstream_len() const -> size_t
 template <typename T>
 void sperr::SPECK_INT<T>::append_encoded_bitstream(vec8_type& buffer) const
 {
-  // Step 1: calculate size and allocate space for the encoded bitstream
+  const auto orig_size = buffer.size();
+  buffer.resize(orig_size + this->encoded_bitstream_len());
+  this->write_encoded_bitstream(buffer.data() + orig_size);
+}
+
+template <typename T>
+void sperr::SPECK_INT<T>::write_encoded_bitstream(void* p) const
+{
+  // Step 1: fill header
   //
   // Header definition: 9 bytes in total:
   // num_bitplanes (uint8_t), num_useful_bits (uint64_t)
   //
-  const auto app_size = this->encoded_bitstream_len();
-  const auto orig_size = buffer.size();
-  buffer.resize(orig_size + app_size);
-  auto* const ptr = buffer.data() + orig_size;
-
-  // Step 2: fill header
+  auto* const ptr = static_cast<uint8_t*>(p);
   size_t pos = 0;
   std::memcpy(ptr + pos, &m_num_bitplanes, sizeof(m_num_bitplanes));
   pos += sizeof(m_num_bitplanes);
   std::memcpy(ptr + pos, &m_total_bits, sizeof(m_total_bits));
   pos += sizeof(m_total_bits);
 
-  // Step 3: assemble the right amount of bits into bytes.
+  // Step 2: assemble the right amount of bits into bytes.
   // See discussion on the number of bits to pack in function `encoded_bitstream_len()`.
   auto bits_to_pack = std::min(m_budget, size_t{m_total_bits});
   m_bit_buffer.write_bitstream(ptr + header_size, bits_to_pack);
@@ -307,27 +391,28 @@ void sperr::SPECK_INT<T>::m_refinement_pass_encode()
 {
   // First, process significant pixels previously found.
   //
-  const auto tmp1 = std::array<uint_type, 2>{uint_type{0}, m_threshold};
+  //    Thresholds are powers of two, and all bits above the current threshold are already coded,
+  //    so the refinement bit is simply the bit of the current threshold in each coefficient.
+  //    The coefficients are thus only read, never updated.
   const auto bits_x64 = m_LSP_mask.size() - m_LSP_mask.size() % 64;
+  const auto* const order = m_coeff_order;
+  auto refine = [&](size_t i) {
+    const auto pos = order ? size_t{order[i]} : i;
+    m_bit_buffer.wbit((m_coeff_buf[pos] & m_threshold) != 0);
+  };
 
   for (size_t i = 0; i < bits_x64; i += 64) {  // Evaluate 64 bits at a time.
     const auto value = m_LSP_mask.rlong(i);
     if (value != 0) {
       for (size_t j = 0; j < 64; j++) {
-        if ((value >> j) & uint64_t{1}) {
-          const bool o1 = m_coeff_buf[i + j] >= m_threshold;
-          m_coeff_buf[i + j] -= tmp1[o1];
-          m_bit_buffer.wbit(o1);
-        }
+        if ((value >> j) & uint64_t{1})
+          refine(i + j);
       }
     }
   }
   for (auto i = bits_x64; i < m_LSP_mask.size(); i++) {  // Evaluate the remaining bits.
-    if (m_LSP_mask.rbit(i)) {
-      const bool o1 = m_coeff_buf[i] >= m_threshold;
-      m_coeff_buf[i] -= tmp1[o1];
-      m_bit_buffer.wbit(o1);
-    }
+    if (m_LSP_mask.rbit(i))
+      refine(i);
   }
 
   // Second, mark newly found significant pixels in `m_LSP_mask`.
@@ -0,0 +1,167 @@
+#include "SPERR1D_OMP_D.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+void sperr::SPERR1D_OMP_D::set_num_threads(size_t n)
+{
+#ifdef USE_OMP
+  if (n == 0)
+    m_num_threads = omp_get_max_threads();
+  else
+    m_num_threads = n;
+#endif
+}
+
+auto sperr::SPERR1D_OMP_D::use_bitstream(const void* p, size_t total_len) -> RTNType
+{
+  // This method gathers information from the header.
+  //    It does NOT, however, read the actual bitstream. The actual bitstream
+  //    will be provided when the decompress() method is called.
+  //    The header definition is in SPERR1D_OMP_C.cpp::m_generate_header().
+  //
+  if (total_len < m_header_magic_1chunk + 4)
+    return RTNType::WrongLength;
+  const auto* const u8p = static_cast<const uint8_t*>(p);
+
+  // Verify some info.
+  if (u8p[0] != static_cast<uint8_t>(SPERR_VERSION_MAJOR))
+    return RTNType::VersionMismatch;
+  const auto b8 = sperr::unpack_8_booleans(u8p[1]);
+  if (b8[1] || !b8[4])
+    return RTNType::SliceVolumeMismatch;
+  m_orig_is_float = b8[2];
+  const auto multi_chunk = b8[3];
+  size_t pos = 2;
+
+  // Collect essential info.
+  uint64_t len = 0;
+  std::memcpy(&len, u8p + pos, sizeof(len));
+  pos += sizeof(len);
+  m_total_len = len;
+  m_chunk_len = m_total_len;
+  if (multi_chunk) {
+    uint32_t chunk_len = 0;
+    std::memcpy(&chunk_len, u8p + pos, sizeof(chunk_len));
+    pos += sizeof(chunk_len);
+    m_chunk_len = chunk_len;
+  }
+  if (m_total_len == 0 || m_chunk_len == 0)
+    return RTNType::Error;
+
+  const auto chunks = sperr::chunk_volume({m_total_len, 1, 1}, {m_chunk_len, 1, 1});
+  const auto num_chunks = chunks.size();
+  if (multi_chunk != (num_chunks > 1))
+    return RTNType::Error;
+  const auto header_len =
+      (multi_chunk ? m_header_magic_nchunks : m_header_magic_1chunk) + num_chunks * 4;
+  if (total_len < header_len)
+    return RTNType::WrongLength;
+
+  // Figure out the location of each chunk.
+  auto chunk_len = std::vector<uint32_t>(num_chunks);
+  std::memcpy(chunk_len.data(), u8p + pos, num_chunks * sizeof(uint32_t));
+  m_offsets.resize(num_chunks * 2);
+  m_offsets[0] = header_len;
+  m_offsets[1] = chunk_len[0];
+  for (size_t i = 1; i < num_chunks; i++) {
+    m_offsets[i * 2] = m_offsets[i * 2 - 2] + m_offsets[i * 2 - 1];
+    m_offsets[i * 2 + 1] = chunk_len[i];
+  }
+  if (m_offsets[num_chunks * 2 - 2] + m_offsets[num_chunks * 2 - 1] != total_len)
+    return RTNType::WrongLength;
+
+  // Finally, we keep a copy of the bitstream pointer
+  m_bitstream_ptr = u8p;
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR1D_OMP_D::decompress(const void* p) -> RTNType
+{
+  if (p == nullptr || m_bitstream_ptr == nullptr)
+    return RTNType::Error;
+  if (static_cast<const uint8_t*>(p) != m_bitstream_ptr)
+    return RTNType::Error;
+  if (m_total_len == 0 || m_chunk_len == 0)
+    return RTNType::Error;
+
+  // Let's figure out the chunk information
+  const auto chunks = sperr::chunk_volume({m_total_len, 1, 1}, {m_chunk_len, 1, 1});
+  const auto num_chunks = chunks.size();
+
+  // Allocate a buffer to store the entire array
+  m_vol_buf.resize(m_total_len);
+
+  // Create number of decompressor instances equal to the number of threads
+  auto chunk_rtn = std::vector<RTNType>(num_chunks * 2, RTNType::Good);
+
+#ifdef USE_OMP
+  m_decompressors.resize(m_num_threads);
+  std::for_each(m_decompressors.begin(), m_decompressors.end(), [](auto& p) {
+    if (p == nullptr)
+      p = std::make_unique<SPECK1D_FLT>();
+  });
+#else
+  if (m_decompressor == nullptr)
+    m_decompressor = std::make_unique<SPECK1D_FLT>();
+#endif
+
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t chunkI = 0; chunkI < num_chunks; chunkI++) {
+#ifdef USE_OMP
+    auto& decompressor = m_decompressors[omp_get_thread_num()];
+#else
+    auto& decompressor = m_decompressor;
+#endif
+
+    // Setup decompressor parameters, and decompress!
+    decompressor->set_dims({chunks[chunkI][1], 1, 1});
+    chunk_rtn[chunkI * 2] = decompressor->use_bitstream(m_bitstream_ptr + m_offsets[chunkI * 2],
+                                                        m_offsets[chunkI * 2 + 1]);
+    chunk_rtn[chunkI * 2 + 1] = decompressor->decompress();
+    const auto& small_vol = decompressor->view_decoded_data();
+    if (small_vol.size() == chunks[chunkI][1])
+      std::copy(small_vol.cbegin(), small_vol.cend(), m_vol_buf.begin() + chunks[chunkI][0]);
+    else
+      chunk_rtn[chunkI * 2 + 1] = RTNType::WrongLength;
+  }  // End of OMP parallel section.
+
+  auto fail = std::find_if_not(chunk_rtn.begin(), chunk_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != chunk_rtn.end())
+    return *fail;
+  else
+    return RTNType::Good;
+}
+
+auto sperr::SPERR1D_OMP_D::release_decoded_data() -> sperr::vecd_type&&
+{
+  return std::move(m_vol_buf);
+}
+
+auto sperr::SPERR1D_OMP_D::view_decoded_data() const -> const sperr::vecd_type&
+{
+  return m_vol_buf;
+}
+
+auto sperr::SPERR1D_OMP_D::get_length() const -> size_t
+{
+  return m_total_len;
+}
+
+auto sperr::SPERR1D_OMP_D::get_chunk_length() const -> size_t
+{
+  return m_chunk_len;
+}
+
+auto sperr::SPERR1D_OMP_D::get_orig_is_float() const -> bool
+{
+  return m_orig_is_float;
+}
@@ -0,0 +1,289 @@
+#include "SPERR2D_OMP_C.h"
+
+#include <algorithm>  // std::all_of()
+#include <cassert>
+#include <cstring>
+#include <numeric>  // std::accumulate()
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+void sperr::SPERR2D_OMP_C::set_num_threads(size_t n)
+{
+#ifdef USE_OMP
+  if (n == 0)
+    m_num_threads = omp_get_max_threads();
+  else
+    m_num_threads = n;
+#endif
+}
+
+void sperr::SPERR2D_OMP_C::set_dims_and_chunks(dims_type slice_dims, dims_type chunk_dims)
+{
+  assert(slice_dims[2] == 1);
+  m_dims = {slice_dims[0], slice_dims[1], 1};
+
+  // The preferred chunk size has to be between 1 and m_dims, and representable
+  //    by a uint16_t in the header.
+  for (size_t i = 0; i < 2; i++) {
+    m_chunk_dims[i] = std::min(std::max(size_t{1}, chunk_dims[i]), m_dims[i]);
+    m_chunk_dims[i] = std::min(m_chunk_dims[i], size_t{std::numeric_limits<uint16_t>::max()});
+  }
+  m_chunk_dims[2] = 1;
+}
+
+void sperr::SPERR2D_OMP_C::set_psnr(double psnr)
+{
+  assert(psnr > 0.0);
+  m_mode = CompMode::PSNR;
+  m_quality = psnr;
+}
+
+void sperr::SPERR2D_OMP_C::set_tolerance(double pwe)
+{
+  assert(pwe > 0.0);
+  m_mode = CompMode::PWE;
+  m_quality = pwe;
+}
+
+void sperr::SPERR2D_OMP_C::set_bitrate(double bpp)
+{
+  assert(bpp > 0.0);
+  m_mode = CompMode::Rate;
+  m_quality = bpp;
+}
+
+template <typename T>
+auto sperr::SPERR2D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
+{
+  static_assert(std::is_floating_point<T>::value, "!! Only floating point values are supported !!");
+  if constexpr (std::is_same<T, float>::value)
+    m_orig_is_float = true;
+  else
+    m_orig_is_float = false;
+
+  if (m_mode == sperr::CompMode::Unknown)
+    return RTNType::CompModeUnknown;
+  if (buf_len != m_dims[0] * m_dims[1] || buf_len == 0)
+    return RTNType::WrongLength;
+
+  // First, calculate the extent of individual chunks.
+  //    A 2D slice is treated as a volume of dimension (x, y, 1) so the chunking logic is
+  //    exactly the same as in the 3D case.
+  const auto chunk_idx = sperr::chunk_volume(m_dims, m_chunk_dims);
+  const auto num_chunks = chunk_idx.size();
+
+  // Let's prepare some data structures for compression!
+  auto chunk_rtn = std::vector<RTNType>(num_chunks, RTNType::Good);
+  m_encoded_streams.resize(num_chunks);
+
+#ifdef USE_OMP
+  m_compressors.resize(m_num_threads);
+  for (auto& p : m_compressors) {
+    if (p == nullptr)
+      p = std::make_unique<SPECK2D_FLT>();
+  }
+#else
+  if (m_compressor == nullptr)
+    m_compressor = std::make_unique<SPECK2D_FLT>();
+#endif
+
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < num_chunks; i++) {
+#ifdef USE_OMP
+    auto& compressor = m_compressors[omp_get_thread_num()];
+#else
+    auto& compressor = m_compressor;
+#endif
+
+    // Gather data for this chunk, and setup compressor parameters.
+    auto chunk = m_gather_chunk<T>(buf, chunk_idx[i]);
+    assert(!chunk.empty());
+    compressor->take_data(std::move(chunk));
+    compressor->set_dims({chunk_idx[i][1], chunk_idx[i][3], 1});
+    switch (m_mode) {
+      case CompMode::PSNR:
+        compressor->set_psnr(m_quality);
+        break;
+      case CompMode::PWE:
+        compressor->set_tolerance(m_quality);
+        break;
+      case CompMode::Rate:
+        compressor->set_bitrate(m_quality);
+        break;
+      default:;  // So the compiler doesn't complain about missing cases.
+    }
+    chunk_rtn[i] = compressor->compress();
+
+    // Save bitstream for each chunk in `m_encoded_stream`.
+    m_encoded_streams[i].clear();
+    m_encoded_streams[i].reserve(128);
+    compressor->append_encoded_bitstream(m_encoded_streams[i]);
+  }
+
+  auto fail = std::find_if_not(chunk_rtn.begin(), chunk_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != chunk_rtn.end())
+    return (*fail);
+
+  assert(std::none_of(m_encoded_streams.cbegin(), m_encoded_streams.cend(),
+                      [](auto& s) { return s.empty(); }));
+
+  return RTNType::Good;
+}
+template auto sperr::SPERR2D_OMP_C::compress(const float*, size_t) -> RTNType;
+template auto sperr::SPERR2D_OMP_C::compress(const double*, size_t) -> RTNType;
+
+auto sperr::SPERR2D_OMP_C::get_encoded_bitstream() const -> vec8_type
+{
+  auto header = m_generate_header();
+  assert(!header.empty());
+  auto header_size = header.size();
+  auto stream_size = std::accumulate(m_encoded_streams.cbegin(), m_encoded_streams.cend(), 0lu,
+                                     [](size_t a, const auto& b) { return a + b.size(); });
+  header.resize(header_size + stream_size);
+
+  auto itr = header.begin() + header_size;
+  for (const auto& s : m_encoded_streams) {
+    std::copy(s.cbegin(), s.cend(), itr);
+    itr += s.size();
+  }
+
+  return header;
+}
+
+auto sperr::SPERR2D_OMP_C::encoded_bitstream_len() const -> size_t
+{
+  const auto num_chunks = m_encoded_streams.size();
+  if (num_chunks == 0)
+    return 0;
+
+  auto header_size = size_t{0};
+  if (num_chunks > 1)
+    header_size = m_header_magic_nchunks + num_chunks * 4;
+  else
+    header_size = m_header_magic_1chunk + num_chunks * 4;
+  auto stream_size = std::accumulate(m_encoded_streams.cbegin(), m_encoded_streams.cend(), 0lu,
+                                     [](size_t a, const auto& b) { return a + b.size(); });
+
+  return header_size + stream_size;
+}
+
+auto sperr::SPERR2D_OMP_C::write_encoded_bitstream(void* p, size_t len) const -> RTNType
+{
+  if (len < encoded_bitstream_len())
+    return RTNType::WrongLength;
+
+  const auto header = m_generate_header();
+  if (header.empty())
+    return RTNType::Error;
+
+  auto* itr = std::copy(header.cbegin(), header.cend(), static_cast<uint8_t*>(p));
+  for (const auto& s : m_encoded_streams)
+    itr = std::copy(s.cbegin(), s.cend(), itr);
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR2D_OMP_C::m_generate_header() const -> sperr::vec8_type
+{
+  auto header = sperr::vec8_type();
+
+  // The header would contain the following information
+  //  -- a version number                     (1 byte)
+  //  -- 8 booleans                           (1 byte)
+  //  -- slice dimensions                     (4 x 2 = 8 bytes)
+  //  -- (optional) chunk dimensions          (2 x 2 = 4 bytes)
+  //  -- length of bitstream for each chunk   (4 x num_chunks)
+  //
+  auto chunk_idx = sperr::chunk_volume(m_dims, m_chunk_dims);
+  const auto num_chunks = chunk_idx.size();
+  assert(num_chunks != 0);
+  if (num_chunks != m_encoded_streams.size())
+    return header;
+  auto header_size = size_t{0};
+  if (num_chunks > 1)
+    header_size = m_header_magic_nchunks + num_chunks * 4;
+  else
+    header_size = m_header_magic_1chunk + num_chunks * 4;
+
+  header.resize(header_size);
+
+  // Version number
+  header[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+  size_t pos = 1;
+
+  // 8 booleans:
+  // bool[0]  : if this bitstream is a portion of another complete bitstream (progressive access).
+  // bool[1]  : if this bitstream is for 3D (true) or 2D/1D (false) data.
+  // bool[2]  : if the original data is float (true) or double (false).
+  // bool[3]  : if there are multiple chunks (true) or a single chunk (false).
+  // bool[4]  : if this bitstream is for 1D (true) or not (false) data.
+  // bool[5]  : if this bitstream is a stack of 2D slices (true) or not (false).
+  // bool[6]  : always true, which tells this header from the one of `sperr_comp_2d()`, as
+  //            the two are otherwise the same with a single chunk.
+  // bool[7]  : unused
+  //
+  const auto b8 = std::array<bool, 8>{false,  // not a portion
+                                      false,  // not 3D
+                                      m_orig_is_float,
+                                      (num_chunks > 1),
+                                      false,   // not 1D
+                                      false,   // not a stack
+                                      true,    // chunk lengths follow
+                                      false};  // unused
+
+  header[pos++] = sperr::pack_8_booleans(b8);
+
+  // Slice dimensions
+  const auto dims = std::array<uint32_t, 2>{static_cast<uint32_t>(m_dims[0]),
+                                            static_cast<uint32_t>(m_dims[1])};
+  std::memcpy(&header[pos], dims.data(), sizeof(dims));
+  pos += sizeof(dims);
+
+  // Chunk dimensions, if there are more than one chunk.
+  if (num_chunks > 1) {
+    const auto cdims = std::array<uint16_t, 2>{static_cast<uint16_t>(m_chunk_dims[0]),
+                                               static_cast<uint16_t>(m_chunk_dims[1])};
+    std::memcpy(&header[pos], cdims.data(), sizeof(cdims));
+    pos += sizeof(cdims);
+  }
+
+  // Length of bitstream for each chunk.
+  for (const auto& stream : m_encoded_streams) {
+    assert(stream.size() <= uint64_t{std::numeric_limits<uint32_t>::max()});
+    uint32_t len = stream.size();
+    std::memcpy(&header[pos], &len, sizeof(len));
+    pos += sizeof(len);
+  }
+  assert(pos == header_size);
+
+  return header;
+}
+
+template <typename T>
+auto sperr::SPERR2D_OMP_C::m_gather_chunk(const T* slice, std::array<size_t, 6> chunk) const
+    -> vecd_type
+{
+  auto chunk_buf = vecd_type();
+  if (chunk[0] + chunk[1] > m_dims[0] || chunk[2] + chunk[3] > m_dims[1])
+    return chunk_buf;
+
+  chunk_buf.resize(chunk[1] * chunk[3]);
+  const auto row_len = chunk[1];
+
+  size_t idx = 0;
+  for (size_t y = chunk[2]; y < chunk[2] + chunk[3]; y++) {
+    const auto start_i = y * m_dims[0] + chunk[0];
+    std::copy(slice + start_i, slice + start_i + row_len, chunk_buf.begin() + idx);
+    idx += row_len;
+  }
+
+  // Will be subject to Named Return Value Optimization.
+  return chunk_buf;
+}
+template auto sperr::SPERR2D_OMP_C::m_gather_chunk(const float*, std::array<size_t, 6>) const
+    -> vecd_type;
+template auto sperr::SPERR2D_OMP_C::m_gather_chunk(const double*, std::array<size_t, 6>) const
+    -> vecd_type;
@@ -0,0 +1,199 @@
+#include "SPERR2D_OMP_D.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+void sperr::SPERR2D_OMP_D::set_num_threads(size_t n)
+{
+#ifdef USE_OMP
+  if (n == 0)
+    m_num_threads = omp_get_max_threads();
+  else
+    m_num_threads = n;
+#endif
+}
+
+auto sperr::SPERR2D_OMP_D::use_bitstream(const void* p, size_t total_len) -> RTNType
+{
+  // This method gathers information from the header.
+  //    It does NOT, however, read the actual bitstream. The actual bitstream
+  //    will be provided when the decompress() method is called.
+  //    The header definition is in SPERR2D_OMP_C.cpp::m_generate_header().
+  //
+  if (total_len < m_header_magic_1chunk + 4)
+    return RTNType::WrongLength;
+  const auto* const u8p = static_cast<const uint8_t*>(p);
+
+  // Verify some info.
+  if (u8p[0] != static_cast<uint8_t>(SPERR_VERSION_MAJOR))
+    return RTNType::VersionMismatch;
+  const auto b8 = sperr::unpack_8_booleans(u8p[1]);
+  if (b8[1] || b8[4] || b8[5])
+    return RTNType::SliceVolumeMismatch;
+  if (!b8[6])
+    return RTNType::Error;  // A slice from `sperr_comp_2d()`, which has no chunk lengths.
+  m_orig_is_float = b8[2];
+  const auto multi_chunk = b8[3];
+  size_t pos = 2;
+
+  // Collect essential info.
+  uint32_t dims[2] = {0, 0};
+  std::memcpy(dims, u8p + pos, sizeof(dims));
+  pos += sizeof(dims);
+  m_dims = {dims[0], dims[1], 1};
+  m_chunk_dims = m_dims;
+  if (multi_chunk) {
+    uint16_t cdims[2] = {0, 0};
+    std::memcpy(cdims, u8p + pos, sizeof(cdims));
+    pos += sizeof(cdims);
+    m_chunk_dims = {cdims[0], cdims[1], 1};
+  }
+  if (m_dims[0] * m_dims[1] == 0 || m_chunk_dims[0] * m_chunk_dims[1] == 0)
+    return RTNType::Error;
+
+  const auto chunks = sperr::chunk_volume(m_dims, m_chunk_dims);
+  const auto num_chunks = chunks.size();
+  if (multi_chunk != (num_chunks > 1))
+    return RTNType::Error;
+  const auto header_len =
+      (multi_chunk ? m_header_magic_nchunks : m_header_magic_1chunk) + num_chunks * 4;
+  if (total_len < header_len)
+    return RTNType::WrongLength;
+
+  // Figure out the location of each chunk.
+  auto chunk_len = std::vector<uint32_t>(num_chunks);
+  std::memcpy(chunk_len.data(), u8p + pos, num_chunks * sizeof(uint32_t));
+  m_offsets.resize(num_chunks * 2);
+  m_offsets[0] = header_len;
+  m_offsets[1] = chunk_len[0];
+  for (size_t i = 1; i < num_chunks; i++) {
+    m_offsets[i * 2] = m_offsets[i * 2 - 2] + m_offsets[i * 2 - 1];
+    m_offsets[i * 2 + 1] = chunk_len[i];
+  }
+  if (m_offsets[num_chunks * 2 - 2] + m_offsets[num_chunks * 2 - 1] != total_len)
+    return RTNType::WrongLength;
+
+  // Finally, we keep a copy of the bitstream pointer
+  m_bitstream_ptr = u8p;
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR2D_OMP_D::decompress(const void* p) -> RTNType
+{
+  return decompress_region(p, {0, 0}, {m_dims[0], m_dims[1]});
+}
+
+auto sperr::SPERR2D_OMP_D::decompress_region(const void* p,
+                                             std::array<size_t, 2> start,
+                                             std::array<size_t, 2> size) -> RTNType
+{
+  if (p == nullptr || m_bitstream_ptr == nullptr)
+    return RTNType::Error;
+  if (static_cast<const uint8_t*>(p) != m_bitstream_ptr)
+    return RTNType::Error;
+  if (size[0] == 0 || size[1] == 0 || start[0] + size[0] > m_dims[0] ||
+      start[1] + size[1] > m_dims[1])
+    return RTNType::Error;
+
+  // Let's figure out the chunk information, and keep only those intersecting the region.
+  const auto chunks = sperr::chunk_volume(m_dims, m_chunk_dims);
+  auto roi_chunks = std::vector<size_t>();
+  roi_chunks.reserve(chunks.size());
+  for (size_t i = 0; i < chunks.size(); i++) {
+    const auto& c = chunks[i];
+    if (c[0] < start[0] + size[0] && start[0] < c[0] + c[1] && c[2] < start[1] + size[1] &&
+        start[1] < c[2] + c[3])
+      roi_chunks.push_back(i);
+  }
+  const auto num_chunks = roi_chunks.size();
+
+  // Allocate a buffer to store the region
+  m_vol_buf.resize(size[0] * size[1]);
+
+  // Create number of decompressor instances equal to the number of threads
+  auto chunk_rtn = std::vector<RTNType>(num_chunks * 2, RTNType::Good);
+
+#ifdef USE_OMP
+  m_decompressors.resize(m_num_threads);
+  std::for_each(m_decompressors.begin(), m_decompressors.end(), [](auto& p) {
+    if (p == nullptr)
+      p = std::make_unique<SPECK2D_FLT>();
+  });
+#else
+  if (m_decompressor == nullptr)
+    m_decompressor = std::make_unique<SPECK2D_FLT>();
+#endif
+
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < num_chunks; i++) {
+#ifdef USE_OMP
+    auto& decompressor = m_decompressors[omp_get_thread_num()];
+#else
+    auto& decompressor = m_decompressor;
+#endif
+
+    // Setup decompressor parameters, and decompress!
+    const auto chunkI = roi_chunks[i];
+    const auto& c = chunks[chunkI];
+    decompressor->set_dims({c[1], c[3], 1});
+    chunk_rtn[i * 2] = decompressor->use_bitstream(m_bitstream_ptr + m_offsets[chunkI * 2],
+                                                   m_offsets[chunkI * 2 + 1]);
+    chunk_rtn[i * 2 + 1] = decompressor->decompress();
+    const auto& small_vol = decompressor->view_decoded_data();
+    if (small_vol.size() != c[1] * c[3]) {
+      chunk_rtn[i * 2 + 1] = RTNType::WrongLength;
+      continue;
+    }
+
+    // Copy the intersection of this chunk and the region to the output buffer.
+    const auto x0 = std::max(c[0], start[0]);
+    const auto x1 = std::min(c[0] + c[1], start[0] + size[0]);
+    const auto y0 = std::max(c[2], start[1]);
+    const auto y1 = std::min(c[2] + c[3], start[1] + size[1]);
+    for (size_t y = y0; y < y1; y++) {
+      const auto src_i = (y - c[2]) * c[1] + (x0 - c[0]);
+      const auto dst_i = (y - start[1]) * size[0] + (x0 - start[0]);
+      std::copy(small_vol.begin() + src_i, small_vol.begin() + src_i + (x1 - x0),
+                m_vol_buf.begin() + dst_i);
+    }
+  }  // End of OMP parallel section.
+
+  auto fail = std::find_if_not(chunk_rtn.begin(), chunk_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != chunk_rtn.end())
+    return *fail;
+  else
+    return RTNType::Good;
+}
+
+auto sperr::SPERR2D_OMP_D::release_decoded_data() -> sperr::vecd_type&&
+{
+  return std::move(m_vol_buf);
+}
+
+auto sperr::SPERR2D_OMP_D::view_decoded_data() const -> const sperr::vecd_type&
+{
+  return m_vol_buf;
+}
+
+auto sperr::SPERR2D_OMP_D::get_dims() const -> sperr::dims_type
+{
+  return m_dims;
+}
+
+auto sperr::SPERR2D_OMP_D::get_chunk_dims() const -> sperr::dims_type
+{
+  return m_chunk_dims;
+}
+
+auto sperr::SPERR2D_OMP_D::get_orig_is_float() const -> bool
+{
+  return m_orig_is_float;
+}
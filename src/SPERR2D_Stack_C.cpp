@@ -0,0 +1,226 @@
+#include "SPERR2D_Stack_C.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>  // std::accumulate()
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+void sperr::SPERR2D_Stack_C::set_num_threads(size_t n)
+{
+#ifdef USE_OMP
+  if (n == 0)
+    m_num_threads = omp_get_max_threads();
+  else
+    m_num_threads = n;
+#endif
+}
+
+void sperr::SPERR2D_Stack_C::set_slice_dims(dims_type dims)
+{
+  assert(dims[2] == 1);
+  m_dims = {dims[0], dims[1], 1};
+}
+
+void sperr::SPERR2D_Stack_C::set_psnr(double psnr)
+{
+  assert(psnr > 0.0);
+  m_mode = CompMode::PSNR;
+  m_quality = psnr;
+}
+
+void sperr::SPERR2D_Stack_C::set_tolerance(double pwe)
+{
+  assert(pwe > 0.0);
+  m_mode = CompMode::PWE;
+  m_quality = pwe;
+}
+
+void sperr::SPERR2D_Stack_C::set_bitrate(double bpp)
+{
+  assert(bpp > 0.0);
+  m_mode = CompMode::Rate;
+  m_quality = bpp;
+}
+
+template <typename T>
+auto sperr::SPERR2D_Stack_C::compress(const T* buf, size_t buf_len) -> RTNType
+{
+  static_assert(std::is_floating_point<T>::value, "!! Only floating point values are supported !!");
+  if constexpr (std::is_same<T, float>::value)
+    m_orig_is_float = true;
+  else
+    m_orig_is_float = false;
+
+  if (m_mode == sperr::CompMode::Unknown)
+    return RTNType::CompModeUnknown;
+  const auto slice_len = m_dims[0] * m_dims[1];
+  if (slice_len == 0 || buf_len == 0 || buf_len % slice_len != 0)
+    return RTNType::WrongLength;
+  const auto num_slices = buf_len / slice_len;
+  if (num_slices > std::numeric_limits<uint32_t>::max())
+    return RTNType::WrongLength;
+
+  auto slice_rtn = std::vector<RTNType>(num_slices, RTNType::Good);
+  m_encoded_streams.resize(num_slices);
+
+#ifdef USE_OMP
+  m_compressors.resize(m_num_threads);
+  for (auto& p : m_compressors) {
+    if (p == nullptr)
+      p = std::make_unique<SPECK2D_FLT>();
+  }
+#else
+  if (m_compressor == nullptr)
+    m_compressor = std::make_unique<SPECK2D_FLT>();
+#endif
+
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < num_slices; i++) {
+#ifdef USE_OMP
+    auto& compressor = m_compressors[omp_get_thread_num()];
+#else
+    auto& compressor = m_compressor;
+#endif
+
+    // A slice is contiguous in the stack, so there's no need to gather it.
+    compressor->copy_data(buf + i * slice_len, slice_len);
+    compressor->set_dims(m_dims);
+    switch (m_mode) {
+      case CompMode::PSNR:
+        compressor->set_psnr(m_quality);
+        break;
+      case CompMode::PWE:
+        compressor->set_tolerance(m_quality);
+        break;
+      case CompMode::Rate:
+        compressor->set_bitrate(m_quality);
+        break;
+      default:;  // So the compiler doesn't complain about missing cases.
+    }
+    slice_rtn[i] = compressor->compress();
+
+    m_encoded_streams[i].clear();
+    compressor->append_encoded_bitstream(m_encoded_streams[i]);
+  }
+
+  auto fail = std::find_if_not(slice_rtn.begin(), slice_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != slice_rtn.end())
+    return (*fail);
+
+  return RTNType::Good;
+}
+template auto sperr::SPERR2D_Stack_C::compress(const float*, size_t) -> RTNType;
+template auto sperr::SPERR2D_Stack_C::compress(const double*, size_t) -> RTNType;
+
+auto sperr::SPERR2D_Stack_C::get_encoded_bitstream() const -> vec8_type
+{
+  auto stream = vec8_type(encoded_bitstream_len());
+  if (!stream.empty() && write_encoded_bitstream(stream.data(), stream.size()) != RTNType::Good)
+    stream.clear();
+
+  return stream;
+}
+
+auto sperr::SPERR2D_Stack_C::encoded_bitstream_len() const -> size_t
+{
+  const auto num_slices = m_encoded_streams.size();
+  if (num_slices == 0)
+    return 0;
+
+  auto stream_size = std::accumulate(m_encoded_streams.cbegin(), m_encoded_streams.cend(), 0lu,
+                                     [](size_t a, const auto& b) { return a + b.size(); });
+
+  return m_header_magic + num_slices * 4 + stream_size;
+}
+
+auto sperr::SPERR2D_Stack_C::write_encoded_bitstream(void* p, size_t len) const -> RTNType
+{
+  if (len < encoded_bitstream_len())
+    return RTNType::WrongLength;
+
+  const auto header = m_generate_header();
+  if (header.empty())
+    return RTNType::Error;
+
+  auto* itr = std::copy(header.cbegin(), header.cend(), static_cast<uint8_t*>(p));
+  for (const auto& s : m_encoded_streams)
+    itr = std::copy(s.cbegin(), s.cend(), itr);
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR2D_Stack_C::view_slice_streams() const -> const std::vector<vec8_type>&
+{
+  return m_encoded_streams;
+}
+
+auto sperr::SPERR2D_Stack_C::release_slice_streams() -> std::vector<vec8_type>&&
+{
+  return std::move(m_encoded_streams);
+}
+
+auto sperr::SPERR2D_Stack_C::m_generate_header() const -> sperr::vec8_type
+{
+  auto header = sperr::vec8_type();
+
+  // The header would contain the following information
+  //  -- a version number                     (1 byte)
+  //  -- 8 booleans                           (1 byte)
+  //  -- slice dimensions                     (4 x 2 = 8 bytes)
+  //  -- number of slices                     (4 bytes)
+  //  -- length of bitstream for each slice   (4 x num_slices)
+  //
+  const auto num_slices = m_encoded_streams.size();
+  if (num_slices == 0)
+    return header;
+  const auto header_size = m_header_magic + num_slices * 4;
+  header.resize(header_size);
+
+  // Version number
+  header[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+  size_t pos = 1;
+
+  // 8 booleans:
+  // bool[0]  : if this bitstream is a portion of another complete bitstream (progressive access).
+  // bool[1]  : if this bitstream is for 3D (true) or 2D/1D (false) data.
+  // bool[2]  : if the original data is float (true) or double (false).
+  // bool[3]  : if there are multiple chunks (true) or a single chunk (false).
+  // bool[4]  : if this bitstream is for 1D (true) or not (false) data.
+  // bool[5]  : if this bitstream is a stack of 2D slices (true) or not (false).
+  // bool[6]  : if chunk lengths follow (true), which is how SPERR2D_OMP_C marks its header.
+  // bool[7]  : unused
+  //
+  const auto b8 = std::array<bool, 8>{false,  // not a portion
+                                      false,  // not 3D
+                                      m_orig_is_float,
+                                      false,   // no chunks within a slice
+                                      false,   // not 1D
+                                      true,    // a stack of slices
+                                      false,   // slice lengths follow instead
+                                      false};  // unused
+
+  header[pos++] = sperr::pack_8_booleans(b8);
+
+  // Slice dimensions and the number of slices
+  const auto dims = std::array<uint32_t, 3>{static_cast<uint32_t>(m_dims[0]),
+                                            static_cast<uint32_t>(m_dims[1]),
+                                            static_cast<uint32_t>(num_slices)};
+  std::memcpy(&header[pos], dims.data(), sizeof(dims));
+  pos += sizeof(dims);
+
+  // Length of bitstream for each slice.
+  for (const auto& stream : m_encoded_streams) {
+    assert(stream.size() <= uint64_t{std::numeric_limits<uint32_t>::max()});
+    uint32_t len = stream.size();
+    std::memcpy(&header[pos], &len, sizeof(len));
+    pos += sizeof(len);
+  }
+  assert(pos == header_size);
+
+  return header;
+}
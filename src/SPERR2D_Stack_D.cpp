@@ -0,0 +1,164 @@
+#include "SPERR2D_Stack_D.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+void sperr::SPERR2D_Stack_D::set_num_threads(size_t n)
+{
+#ifdef USE_OMP
+  if (n == 0)
+    m_num_threads = omp_get_max_threads();
+  else
+    m_num_threads = n;
+#endif
+}
+
+auto sperr::SPERR2D_Stack_D::use_bitstream(const void* p, size_t total_len) -> RTNType
+{
+  // This method gathers information from the header.
+  //    It does NOT, however, read the actual bitstream. The actual bitstream
+  //    will be provided when the decompress() method is called.
+  //    The header definition is in SPERR2D_Stack_C.cpp::m_generate_header().
+  //
+  if (total_len < m_header_magic + 4)
+    return RTNType::WrongLength;
+  const auto* const u8p = static_cast<const uint8_t*>(p);
+
+  // Verify some info.
+  if (u8p[0] != static_cast<uint8_t>(SPERR_VERSION_MAJOR))
+    return RTNType::VersionMismatch;
+  const auto b8 = sperr::unpack_8_booleans(u8p[1]);
+  if (b8[1] || b8[4] || !b8[5])
+    return RTNType::SliceVolumeMismatch;
+  m_orig_is_float = b8[2];
+  size_t pos = 2;
+
+  // Collect essential info.
+  uint32_t dims[3] = {0, 0, 0};
+  std::memcpy(dims, u8p + pos, sizeof(dims));
+  pos += sizeof(dims);
+  m_dims = {dims[0], dims[1], 1};
+  const size_t num_slices = dims[2];
+  if (m_dims[0] * m_dims[1] == 0 || num_slices == 0)
+    return RTNType::Error;
+  const auto header_len = m_header_magic + num_slices * 4;
+  if (total_len < header_len)
+    return RTNType::WrongLength;
+
+  // Figure out the location of each slice.
+  auto slice_len = std::vector<uint32_t>(num_slices);
+  std::memcpy(slice_len.data(), u8p + pos, num_slices * sizeof(uint32_t));
+  m_offsets.resize(num_slices * 2);
+  m_offsets[0] = header_len;
+  m_offsets[1] = slice_len[0];
+  for (size_t i = 1; i < num_slices; i++) {
+    m_offsets[i * 2] = m_offsets[i * 2 - 2] + m_offsets[i * 2 - 1];
+    m_offsets[i * 2 + 1] = slice_len[i];
+  }
+  if (m_offsets[num_slices * 2 - 2] + m_offsets[num_slices * 2 - 1] != total_len)
+    return RTNType::WrongLength;
+
+  // Finally, we keep a copy of the bitstream pointer
+  m_bitstream_ptr = u8p;
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR2D_Stack_D::decompress(const void* p) -> RTNType
+{
+  auto indices = std::vector<size_t>(get_num_slices());
+  std::iota(indices.begin(), indices.end(), 0);
+  return decompress_slices(p, indices);
+}
+
+auto sperr::SPERR2D_Stack_D::decompress_slice(const void* p, size_t idx) -> RTNType
+{
+  return decompress_slices(p, {idx});
+}
+
+auto sperr::SPERR2D_Stack_D::decompress_slices(const void* p, const std::vector<size_t>& indices)
+    -> RTNType
+{
+  if (p == nullptr || m_bitstream_ptr == nullptr)
+    return RTNType::Error;
+  if (static_cast<const uint8_t*>(p) != m_bitstream_ptr)
+    return RTNType::Error;
+  const auto num_slices = get_num_slices();
+  if (indices.empty() || std::any_of(indices.cbegin(), indices.cend(),
+                                     [num_slices](auto i) { return i >= num_slices; }))
+    return RTNType::Error;
+
+  const auto slice_len = m_dims[0] * m_dims[1];
+  const auto num_requests = indices.size();
+  m_vol_buf.resize(slice_len * num_requests);
+  auto slice_rtn = std::vector<RTNType>(num_requests * 2, RTNType::Good);
+
+#ifdef USE_OMP
+  m_decompressors.resize(m_num_threads);
+  std::for_each(m_decompressors.begin(), m_decompressors.end(), [](auto& p) {
+    if (p == nullptr)
+      p = std::make_unique<SPECK2D_FLT>();
+  });
+#else
+  if (m_decompressor == nullptr)
+    m_decompressor = std::make_unique<SPECK2D_FLT>();
+#endif
+
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < num_requests; i++) {
+#ifdef USE_OMP
+    auto& decompressor = m_decompressors[omp_get_thread_num()];
+#else
+    auto& decompressor = m_decompressor;
+#endif
+
+    const auto idx = indices[i];
+    decompressor->set_dims(m_dims);
+    slice_rtn[i * 2] =
+        decompressor->use_bitstream(m_bitstream_ptr + m_offsets[idx * 2], m_offsets[idx * 2 + 1]);
+    slice_rtn[i * 2 + 1] = decompressor->decompress();
+    const auto& small_vol = decompressor->view_decoded_data();
+    if (small_vol.size() == slice_len)
+      std::copy(small_vol.cbegin(), small_vol.cend(), m_vol_buf.begin() + i * slice_len);
+    else
+      slice_rtn[i * 2 + 1] = RTNType::WrongLength;
+  }  // End of OMP parallel section.
+
+  auto fail = std::find_if_not(slice_rtn.begin(), slice_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != slice_rtn.end())
+    return *fail;
+  else
+    return RTNType::Good;
+}
+
+auto sperr::SPERR2D_Stack_D::release_decoded_data() -> sperr::vecd_type&&
+{
+  return std::move(m_vol_buf);
+}
+
+auto sperr::SPERR2D_Stack_D::view_decoded_data() const -> const sperr::vecd_type&
+{
+  return m_vol_buf;
+}
+
+auto sperr::SPERR2D_Stack_D::get_slice_dims() const -> sperr::dims_type
+{
+  return m_dims;
+}
+
+auto sperr::SPERR2D_Stack_D::get_num_slices() const -> size_t
+{
+  return m_offsets.size() / 2;
+}
+
+auto sperr::SPERR2D_Stack_D::get_orig_is_float() const -> bool
+{
+  return m_orig_is_float;
+}
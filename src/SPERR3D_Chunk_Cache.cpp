@@ -0,0 +1,273 @@
+#include "SPERR3D_Chunk_Cache.h"
+
+#include <algorithm>
+#include <cassert>
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+void sperr::SPERR3D_Chunk_Cache::set_capacity(size_t bytes)
+{
+  auto lock = std::lock_guard(m_mutex);
+  m_capacity = bytes;
+  while (m_counters.bytes > m_capacity && !m_lru.empty()) {
+    m_counters.bytes -= m_lru.back().second->size() * sizeof(double);
+    m_index.erase(m_lru.back().first);
+    m_lru.pop_back();
+  }
+}
+
+void sperr::SPERR3D_Chunk_Cache::set_num_threads(size_t n)
+{
+#ifdef USE_OMP
+  if (n == 0)
+    m_num_threads = omp_get_max_threads();
+  else
+    m_num_threads = n;
+#endif
+}
+
+auto sperr::SPERR3D_Chunk_Cache::open_file(const std::string& filename,
+                                           std::shared_ptr<const SPERR3D_Stream>& stream)
+    -> RTNType
+{
+  {
+    auto lock = std::lock_guard(m_mutex);
+    auto it = m_files.find(filename);
+    if (it != m_files.end()) {
+      stream = it->second;
+      return RTNType::Good;
+    }
+  }
+
+  // Opening a file only maps it and parses the header, so it's done without holding the lock.
+  auto opened = std::make_shared<SPERR3D_Stream>();
+  auto rtn = opened->open_file(filename);
+  if (rtn != RTNType::Good)
+    return rtn;
+  if (!opened->view_header().is_3D)
+    return RTNType::SliceVolumeMismatch;
+
+  auto lock = std::lock_guard(m_mutex);
+  auto [it, inserted] = m_files.emplace(filename, std::move(opened));
+  stream = it->second;
+  return RTNType::Good;
+}
+
+void sperr::SPERR3D_Chunk_Cache::close_file(const std::string& filename)
+{
+  auto lock = std::lock_guard(m_mutex);
+  auto it = m_files.find(filename);
+  if (it == m_files.end())
+    return;
+  const auto* ptr = it->second.get();
+  for (auto e = m_lru.begin(); e != m_lru.end();) {
+    if (std::get<0>(e->first) == ptr) {
+      m_counters.bytes -= e->second->size() * sizeof(double);
+      m_index.erase(e->first);
+      e = m_lru.erase(e);
+    }
+    else
+      ++e;
+  }
+  m_files.erase(it);
+}
+
+auto sperr::SPERR3D_Chunk_Cache::level_dims(const SPERR3D_Stream& stream, size_t level) const
+    -> dims_type
+{
+  const auto& header = stream.view_header();
+  if (level == 0)
+    return header.vol_dims;
+  const auto res = sperr::coarsened_resolutions(header.vol_dims, header.chunk_dims);
+  if (level > res.size())
+    return {0, 0, 0};
+  return res[res.size() - level];
+}
+
+auto sperr::SPERR3D_Chunk_Cache::get_counters() const -> Counters
+{
+  auto lock = std::lock_guard(m_mutex);
+  return m_counters;
+}
+
+template <typename T>
+auto sperr::SPERR3D_Chunk_Cache::decode(const std::string& filename, const Request& req, T* dst)
+    -> RTNType
+{
+  if (dst == nullptr)
+    return RTNType::Error;
+  auto stream = std::shared_ptr<const SPERR3D_Stream>();
+  auto rtn = open_file(filename, stream);
+  if (rtn != RTNType::Good)
+    return rtn;
+
+  const auto vol = level_dims(*stream, req.level);
+  for (size_t d = 0; d < 3; d++) {
+    if (req.size[d] == 0 || req.start[d] + req.size[d] > vol[d])
+      return RTNType::Error;
+  }
+  const auto pct = (req.pct == 0 || req.pct > 100) ? 100u : req.pct;
+
+  // Find where each chunk is at the requested resolution, and keep those intersecting the
+  //    region. Coarsened volumes have chunks in the same order as the native one.
+  auto chunks = stream->view_chunks();
+  if (req.level > 0) {
+    const auto res = sperr::coarsened_resolutions(stream->view_header().chunk_dims);
+    chunks = sperr::chunk_volume(vol, res[res.size() - req.level]);
+  }
+  assert(chunks.size() == stream->view_chunks().size());
+  auto roi_chunks = std::vector<size_t>();
+  for (size_t i = 0; i < chunks.size(); i++) {
+    auto overlap = true;
+    for (size_t d = 0; d < 3; d++) {
+      const auto& c = chunks[i];
+      overlap &= c[d * 2] < req.start[d] + req.size[d] && req.start[d] < c[d * 2] + c[d * 2 + 1];
+    }
+    if (overlap)
+      roi_chunks.push_back(i);
+  }
+  const auto num_chunks = roi_chunks.size();
+  auto chunk_rtn = std::vector<RTNType>(num_chunks, RTNType::Good);
+
+#pragma omp parallel for num_threads(m_num_threads) schedule(dynamic)
+  for (size_t i = 0; i < num_chunks; i++) {
+    const auto& c = chunks[roi_chunks[i]];
+    auto [vals, r] = m_get_chunk(*stream, roi_chunks[i], req.level, pct);
+    chunk_rtn[i] = r;
+    if (r != RTNType::Good)
+      continue;
+    if (vals->size() != c[1] * c[3] * c[5]) {
+      chunk_rtn[i] = RTNType::WrongLength;
+      continue;
+    }
+
+    // Copy the intersection of this chunk and the region to the output buffer.
+    auto lo = std::array<size_t, 3>();
+    auto hi = std::array<size_t, 3>();
+    for (size_t d = 0; d < 3; d++) {
+      lo[d] = std::max(c[d * 2], req.start[d]);
+      hi[d] = std::min(c[d * 2] + c[d * 2 + 1], req.start[d] + req.size[d]);
+    }
+    const auto& start = req.start;
+    const auto& size = req.size;
+    for (size_t z = lo[2]; z < hi[2]; z++) {
+      for (size_t y = lo[1]; y < hi[1]; y++) {
+        const auto src_i = ((z - c[4]) * c[3] + (y - c[2])) * c[1] + (lo[0] - c[0]);
+        const auto dst_i =
+            ((z - start[2]) * size[1] + (y - start[1])) * size[0] + (lo[0] - start[0]);
+        std::transform(vals->begin() + src_i, vals->begin() + src_i + (hi[0] - lo[0]),
+                       dst + dst_i, [](auto v) { return static_cast<T>(v); });
+      }
+    }
+  }
+
+  auto fail = std::find_if_not(chunk_rtn.begin(), chunk_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != chunk_rtn.end())
+    return *fail;
+  else
+    return RTNType::Good;
+}
+template auto sperr::SPERR3D_Chunk_Cache::decode(const std::string&, const Request&, float*)
+    -> RTNType;
+template auto sperr::SPERR3D_Chunk_Cache::decode(const std::string&, const Request&, double*)
+    -> RTNType;
+
+auto sperr::SPERR3D_Chunk_Cache::m_get_chunk(const SPERR3D_Stream& stream,
+                                             size_t chunk,
+                                             size_t level,
+                                             unsigned pct)
+    -> std::pair<std::shared_ptr<const vecd_type>, RTNType>
+{
+  // Deduplicated chunks are looked up by the chunk whose bitstream they share.
+  const auto src = stream.view_header().chunk_sources[chunk];
+  const auto key = Key{&stream, src, level, pct};
+  {
+    auto lock = std::lock_guard(m_mutex);
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+      m_lru.splice(m_lru.begin(), m_lru, it->second);
+      m_counters.hits++;
+      return {it->second->second, RTNType::Good};
+    }
+    m_counters.misses++;
+  }
+
+  // Decode without holding the lock. Concurrent requests missing the same chunk might both
+  //    decode it, and the first one to finish inserts it.
+  auto rtn = m_decode_chunk(stream, src, level, pct);
+  if (rtn.second == RTNType::Good)
+    m_insert(key, rtn.first);
+  return rtn;
+}
+
+auto sperr::SPERR3D_Chunk_Cache::m_decode_chunk(const SPERR3D_Stream& stream,
+                                                size_t chunk,
+                                                size_t level,
+                                                unsigned pct)
+    -> std::pair<std::shared_ptr<const vecd_type>, RTNType>
+{
+  const auto& header = stream.view_header();
+  const auto& c = stream.view_chunks()[chunk];
+  const auto* p = stream.data() + header.chunk_offsets[chunk * 2];
+  const auto tools = SPERR3D_Stream_Tools();
+  const auto len = tools.progressive_chunk_len(header.chunk_offsets[chunk * 2 + 1], pct);
+  auto dims = dims_type{c[1], c[3], c[5]};
+  if (level > 0) {
+    const auto res = sperr::coarsened_resolutions(dims);
+    dims = res[res.size() - level];
+  }
+
+  // A constant chunk is the same at all resolutions.
+  const auto conditioner = Conditioner();
+  auto condi = condi_type();
+  if (len >= condi.size() && conditioner.is_constant(p[0])) {
+    std::copy(p, p + condi.size(), condi.begin());
+    const auto val = conditioner.retrieve_mean(condi);
+    return {std::make_shared<vecd_type>(dims[0] * dims[1] * dims[2], val), RTNType::Good};
+  }
+
+  auto decompressor = m_pool.acquire();
+  decompressor->set_dims({c[1], c[3], c[5]});
+  auto rtn = decompressor->use_bitstream(p, len);
+  if (rtn == RTNType::Good)
+    rtn = decompressor->decompress(level > 0);
+  auto vals = std::shared_ptr<vecd_type>();
+  if (rtn == RTNType::Good) {
+    if (level == 0)
+      vals = std::make_shared<vecd_type>(decompressor->release_decoded_data());
+    else {
+      auto&& hierarchy = decompressor->release_hierarchy();
+      vals = std::make_shared<vecd_type>(std::move(hierarchy[hierarchy.size() - level]));
+    }
+    if (vals->size() != dims[0] * dims[1] * dims[2])
+      rtn = RTNType::WrongLength;
+  }
+  m_pool.release(std::move(decompressor));
+
+  return {std::move(vals), rtn};
+}
+
+void sperr::SPERR3D_Chunk_Cache::m_insert(const Key& key, std::shared_ptr<const vecd_type> vals)
+{
+  auto lock = std::lock_guard(m_mutex);
+  if (m_capacity == 0 || m_index.count(key))
+    return;
+
+  // Skip chunks of a stream that has been closed in the meantime.
+  const auto* ptr = std::get<0>(key);
+  if (std::none_of(m_files.cbegin(), m_files.cend(),
+                   [ptr](const auto& f) { return f.second.get() == ptr; }))
+    return;
+
+  m_counters.bytes += vals->size() * sizeof(double);
+  m_lru.emplace_front(key, std::move(vals));
+  m_index.emplace(key, m_lru.begin());
+  while (m_counters.bytes > m_capacity && !m_lru.empty()) {
+    m_counters.bytes -= m_lru.back().second->size() * sizeof(double);
+    m_index.erase(m_lru.back().first);
+    m_lru.pop_back();
+  }
+}
@@ -2,8 +2,11 @@
 
 #include <algorithm>  // std::all_of()
 #include <cassert>
+#include <cmath>
 #include <cstring>
-#include <numeric>  // std::accumulate()
+#include <limits>
+#include <map>
+#include <numeric>  // std::accumulate(), std::iota()
 
 #ifdef USE_OMP
 #include <omp.h>
@@ -19,6 +22,11 @@ void sperr::SPERR3D_OMP_C::set_num_threads(size_t n)
 #endif
 }
 
+void sperr::SPERR3D_OMP_C::set_memory_budget(size_t bytes)
+{
+  m_mem_budget = bytes;
+}
+
 void sperr::SPERR3D_OMP_C::set_dims_and_chunks(dims_type vol_dims, dims_type chunk_dims)
 {
   m_dims = vol_dims;
@@ -28,6 +36,29 @@ void sperr::SPERR3D_OMP_C::set_dims_and_chunks(dims_type vol_dims, dims_type chu
     m_chunk_dims[i] = std::min(std::max(size_t{1}, chunk_dims[i]), vol_dims[i]);
 }
 
+void sperr::SPERR3D_OMP_C::set_chunk_stats(bool record)
+{
+  m_record_stats = record;
+}
+
+void sperr::SPERR3D_OMP_C::set_dedup_chunks(bool dedup)
+{
+  m_dedup = dedup;
+}
+
+auto sperr::SPERR3D_OMP_C::set_super_chunks(dims_type super_dims, size_t stripe) -> RTNType
+{
+  // The header keeps super-chunk dimensions in 16 bits, and the stripe size in 32 bits.
+  auto too_big = [](auto d) { return d > std::numeric_limits<uint16_t>::max(); };
+  if (stripe > std::numeric_limits<uint32_t>::max() ||
+      std::any_of(super_dims.cbegin(), super_dims.cend(), too_big))
+    return RTNType::Error;
+
+  m_super_dims = super_dims;
+  m_stripe = std::max(stripe, size_t{1});
+  return RTNType::Good;
+}
+
 void sperr::SPERR3D_OMP_C::set_psnr(double psnr)
 {
   assert(psnr > 0.0);
@@ -61,11 +92,10 @@ void sperr::SPERR3D_OMP_C::set_direct_q(double q)
 template <typename T>
 auto sperr::SPERR3D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
 {
-  static_assert(std::is_floating_point<T>::value, "!! Only floating point values are supported !!");
-  if constexpr (std::is_same<T, float>::value)
-    m_orig_is_float = true;
-  else
-    m_orig_is_float = false;
+  m_orig_type = sperr::data_type_of<T>();
+
+  m_profile.reset();
+  SPERR_PROFILE_WALL(&m_profile);
 
   if (m_mode == sperr::CompMode::Unknown)
     return RTNType::CompModeUnknown;
@@ -79,19 +109,42 @@ auto sperr::SPERR3D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
   // Let's prepare some data structures for compression!
   auto chunk_rtn = std::vector<RTNType>(num_chunks, RTNType::Good);
   m_encoded_streams.resize(num_chunks);
-
+#ifdef SPERR_INSTRUMENT
+  m_chunk_profiles.assign(num_chunks, Profile());
+#endif
+  m_chunk_stats.assign(m_record_stats ? num_chunks : 0, Chunk_Stats());
+  m_chunk_sources.resize(num_chunks);
+  std::iota(m_chunk_sources.begin(), m_chunk_sources.end(), size_t{0});
+  if (m_dedup && num_chunks > 1)
+    m_find_duplicates(buf, chunk_idx);
+
+  // Under a memory budget, use as many threads as the budget allows, and trim each bitstream.
+  //    The bitstreams are then checked against the budget as they accumulate.
 #ifdef USE_OMP
-  m_compressors.resize(m_num_threads);
-  for (auto& p : m_compressors) {
-    if (p == nullptr)
-      p = std::make_unique<SPECK3D_FLT>();
-  }
+  auto num_threads = m_num_threads;
 #else
-  if (m_compressor == nullptr)
-    m_compressor = std::make_unique<SPECK3D_FLT>();
+  const auto num_threads = size_t{1};
 #endif
+  const auto input_bytes = buf_len * sizeof(T);
+  auto max_len = size_t{1};
+  for (const auto& c : chunk_idx)
+    max_len = std::max(max_len, c[1] * c[3] * c[5]);
+  if (m_mem_budget > 0) {
+    if (m_estimate_mem(max_len, 1, input_bytes, 0) > m_mem_budget)
+      return RTNType::Error;
+#ifdef USE_OMP
+    while (m_estimate_mem(max_len, num_threads, input_bytes, 0) > m_mem_budget)
+      num_threads--;
+#endif
+  }
+  auto output_bytes = size_t{0};
+  auto over_budget = false;
 
-#pragma omp parallel for num_threads(m_num_threads)
+  m_prepare_compressors(num_threads);
+
+  const auto conditioner = Conditioner();
+
+#pragma omp parallel for num_threads(num_threads)
   for (size_t i = 0; i < num_chunks; i++) {
 #ifdef USE_OMP
     auto& compressor = m_compressors[omp_get_thread_num()];
@@ -99,9 +152,46 @@ auto sperr::SPERR3D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
     auto& compressor = m_compressor;
 #endif
 
+    // Duplicate chunks are left empty, and refer to their first copy.
+    m_encoded_streams[i].clear();
+    if (m_chunk_sources[i] != i)
+      continue;
+
+    bool stop;
+#pragma omp atomic read
+    stop = over_budget;
+    if (stop) {
+      chunk_rtn[i] = RTNType::Error;
+      continue;
+    }
+
+    // A constant chunk is detected on the input directly. Its bitstream is nothing but the
+    //    conditioner header, which is produced without gathering the chunk or the compressor.
+    const auto val = m_constant_value(buf, chunk_idx[i]);
+    if (val) {
+      const auto num_vals = chunk_idx[i][1] * chunk_idx[i][3] * chunk_idx[i][5];
+      const auto header = conditioner.constant_header(*val, num_vals);
+      m_encoded_streams[i].assign(header.cbegin(), header.cend());
+      SPERR_PROFILE_EXEC(m_chunk_profiles[i].add_chunks(1));
+      if (m_record_stats)
+        m_chunk_stats[i] = {*val, *val, *val, 0.0};
+      continue;
+    }
+
     // Gather data for this chunk, Setup compressor parameters, and compress!
-    auto chunk = m_gather_chunk<T>(buf, m_dims, chunk_idx[i]);
+    SPERR_PROFILE_EXEC(m_chunk_profiles[i].add_chunks(1));
+    auto chunk = vecd_type();
+    {
+      SPERR_PROFILE_SCOPE(&m_chunk_profiles[i], Stage::ChunkCopy,
+                          chunk_idx[i][1] * chunk_idx[i][3] * chunk_idx[i][5] * (sizeof(T) + 8));
+      chunk = m_gather_chunk<T>(buf, m_dims, chunk_idx[i]);
+    }
     assert(!chunk.empty());
+    if (m_record_stats) {
+      auto [min, max] = std::minmax_element(chunk.cbegin(), chunk.cend());
+      auto [mean, var] = sperr::calc_mean_var(chunk.data(), chunk.size(), 1);
+      m_chunk_stats[i] = {*min, *max, mean, var};
+    }
     compressor->take_data(std::move(chunk));
     compressor->set_dims({chunk_idx[i][1], chunk_idx[i][3], chunk_idx[i][5]});
     switch (m_mode) {
@@ -122,42 +212,320 @@ auto sperr::SPERR3D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
       default:;  // So the compiler doesn't complain about missing cases.
     }
     chunk_rtn[i] = compressor->compress();
+    SPERR_PROFILE_EXEC(m_chunk_profiles[i].merge(compressor->view_profile()));
 
     // Save bitstream for each chunk in `m_encoded_stream`.
-    m_encoded_streams[i].clear();
     m_encoded_streams[i].reserve(128);
     compressor->append_encoded_bitstream(m_encoded_streams[i]);
+    if (m_mem_budget > 0) {
+      m_encoded_streams[i].shrink_to_fit();
+      size_t total;
+#pragma omp atomic capture
+      total = output_bytes += m_encoded_streams[i].size();
+      if (m_estimate_mem(max_len, num_threads, input_bytes, total) > m_mem_budget) {
+#pragma omp atomic write
+        over_budget = true;
+      }
+    }
   }
 
+  m_mem.set_current(MemComp::Output,
+                    std::accumulate(m_encoded_streams.cbegin(), m_encoded_streams.cend(), 0lu,
+                                    [](size_t a, const auto& b) { return a + b.capacity(); }));
+
+#ifdef SPERR_INSTRUMENT
+  for (const auto& prof : m_chunk_profiles)
+    m_profile.merge(prof);
+#endif
+  for (size_t i = 0; i < m_chunk_stats.size(); i++)
+    m_chunk_stats[i] = m_chunk_stats[m_chunk_sources[i]];
+
   auto fail = std::find_if_not(chunk_rtn.begin(), chunk_rtn.end(),
                                [](auto r) { return r == RTNType::Good; });
   if (fail != chunk_rtn.end())
     return (*fail);
 
-  assert(std::none_of(m_encoded_streams.cbegin(), m_encoded_streams.cend(),
-                      [](auto& s) { return s.empty(); }));
+  for ([[maybe_unused]] size_t i = 0; i < num_chunks; i++)
+    assert(m_encoded_streams[i].empty() == (m_chunk_sources[i] != i));
 
   return RTNType::Good;
 }
 template auto sperr::SPERR3D_OMP_C::compress(const float*, size_t) -> RTNType;
 template auto sperr::SPERR3D_OMP_C::compress(const double*, size_t) -> RTNType;
+template auto sperr::SPERR3D_OMP_C::compress(const fp16_type*, size_t) -> RTNType;
+template auto sperr::SPERR3D_OMP_C::compress(const bf16_type*, size_t) -> RTNType;
+template auto sperr::SPERR3D_OMP_C::compress(const int8_t*, size_t) -> RTNType;
+template auto sperr::SPERR3D_OMP_C::compress(const uint8_t*, size_t) -> RTNType;
+template auto sperr::SPERR3D_OMP_C::compress(const int16_t*, size_t) -> RTNType;
+template auto sperr::SPERR3D_OMP_C::compress(const uint16_t*, size_t) -> RTNType;
+template auto sperr::SPERR3D_OMP_C::compress(const int32_t*, size_t) -> RTNType;
+
+template <typename T>
+auto sperr::SPERR3D_OMP_C::predict(const T* buf,
+                                   size_t buf_len,
+                                   CompMode mode,
+                                   const std::vector<double>& qualities,
+                                   double fraction) -> std::vector<Prediction>
+{
+  if (buf_len != m_dims[0] * m_dims[1] * m_dims[2] || buf_len == 0 || qualities.empty())
+    return {};
+
+  // Sample chunks systematically, at the center of equally sized strata of all chunks.
+  const auto chunk_idx = sperr::chunk_volume(m_dims, m_chunk_dims);
+  const auto num_chunks = chunk_idx.size();
+  const auto num_samples = std::clamp(static_cast<size_t>(std::ceil(fraction * num_chunks)),
+                                      std::min(size_t{2}, num_chunks), num_chunks);
+  auto samples = std::vector<size_t>(num_samples);
+  for (size_t k = 0; k < num_samples; k++)
+    samples[k] = static_cast<size_t>((double(k) + 0.5) * double(num_chunks) / num_samples);
+
+#ifdef USE_OMP
+  const auto num_threads = m_num_threads;
+#else
+  const auto num_threads = size_t{1};
+#endif
+  m_prepare_compressors(num_threads);
+
+  // Bits and squared errors per value of each sampled chunk, at each quality.
+  const auto num_q = qualities.size();
+  auto rates = std::vector<vecd_type>(num_samples);
+  auto errs = std::vector<vecd_type>(num_samples);
+
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+  for (size_t k = 0; k < num_samples; k++) {
+#ifdef USE_OMP
+    auto& compressor = m_compressors[omp_get_thread_num()];
+#else
+    auto& compressor = m_compressor;
+#endif
+    const auto& c = chunk_idx[samples[k]];
+    compressor->take_data(m_gather_chunk<T>(buf, m_dims, c));
+    compressor->set_dims({c[1], c[3], c[5]});
+    const auto est = compressor->estimate(mode, qualities);
+    if (est.size() != num_q)
+      continue;
+    const auto num_vals = double(c[1] * c[3] * c[5]);
+    for (const auto& e : est) {
+      rates[k].push_back(e.bits / num_vals);
+      errs[k].push_back(e.sse / num_vals);
+    }
+  }
+  if (std::any_of(rates.cbegin(), rates.cend(), [num_q](auto& r) { return r.size() != num_q; }))
+    return {};
+
+  // The data range of the entire volume.
+  auto min = sperr::to_double(buf[0]);
+  auto max = min;
+#pragma omp parallel for num_threads(num_threads) reduction(min : min) reduction(max : max)
+  for (size_t i = 0; i < buf_len; i++) {
+    min = std::min(min, sperr::to_double(buf[i]));
+    max = std::max(max, sperr::to_double(buf[i]));
+  }
+
+  // Mean and standard error of the mean of a quantity over the samples, with the finite
+  //    population correction, since chunks are sampled without replacement.
+  auto mean_err = [num_samples, num_chunks](const std::vector<vecd_type>& v, size_t j) {
+    auto sum = 0.0;
+    for (const auto& s : v)
+      sum += s[j];
+    const auto mean = sum / double(num_samples);
+    if (num_samples < 2 || num_samples == num_chunks)
+      return std::array{mean, 0.0};
+    auto var = 0.0;
+    for (const auto& s : v)
+      var += (s[j] - mean) * (s[j] - mean);
+    var /= double(num_samples - 1);
+    const auto fpc = double(num_chunks - num_samples) / double(num_chunks - 1);
+    return std::array{mean, std::sqrt(var / double(num_samples) * fpc)};
+  };
+
+  auto header_size = (num_chunks > 1 ? m_header_magic_nchunks : m_header_magic_1chunk);
+  header_size += num_chunks * 4;
+  if (m_record_stats)
+    header_size += num_chunks * sizeof(double) * 4;
+  const auto total_vals = double(buf_len);
+  const auto ln10 = std::log(10.0);
+  const auto psnr_cap = -20.0 * std::log10(std::numeric_limits<double>::epsilon());
+
+  auto pred = std::vector<Prediction>(num_q);
+  for (size_t j = 0; j < num_q; j++) {
+    const auto [rate, rate_err] = mean_err(rates, j);
+    const auto [mse, mse_err] = mean_err(errs, j);
+    pred[j].bytes = rate * total_vals / 8.0 + double(header_size);
+    pred[j].bytes_err = rate_err * total_vals / 8.0;
+    pred[j].psnr = psnr_cap;
+    if (mse > 0.0)
+      pred[j].psnr = std::min(20.0 * std::log10(max - min) - 10.0 * std::log10(mse), psnr_cap);
+    pred[j].psnr_err = (mse > 0.0) ? 10.0 / ln10 * mse_err / mse : 0.0;
+  }
+
+  return pred;
+}
+template auto sperr::SPERR3D_OMP_C::predict(const float*,
+                                            size_t,
+                                            CompMode,
+                                            const std::vector<double>&,
+                                            double) -> std::vector<Prediction>;
+template auto sperr::SPERR3D_OMP_C::predict(const double*,
+                                            size_t,
+                                            CompMode,
+                                            const std::vector<double>&,
+                                            double) -> std::vector<Prediction>;
+
+void sperr::SPERR3D_OMP_C::m_prepare_compressors([[maybe_unused]] size_t num_threads)
+{
+#ifdef USE_OMP
+  if (m_compressors.size() < num_threads)
+    m_compressors.resize(num_threads);
+  for (size_t i = 0; i < num_threads; i++) {
+    if (m_compressors[i] == nullptr)
+      m_compressors[i] = std::make_unique<SPECK3D_FLT>();
+  }
+#else
+  if (m_compressor == nullptr)
+    m_compressor = std::make_unique<SPECK3D_FLT>();
+#endif
+}
 
 auto sperr::SPERR3D_OMP_C::get_encoded_bitstream() const -> vec8_type
 {
-  auto header = m_generate_header();
+  const auto header = m_generate_header();
   assert(!header.empty());
-  auto header_size = header.size();
-  auto stream_size = std::accumulate(m_encoded_streams.cbegin(), m_encoded_streams.cend(), 0lu,
-                                     [](size_t a, const auto& b) { return a + b.size(); });
-  header.resize(header_size + stream_size);
-
-  auto itr = header.begin() + header_size;
-  for (const auto& s : m_encoded_streams) {
-    std::copy(s.cbegin(), s.cend(), itr);
-    itr += s.size();
+  auto layout = SPERR3D_Header();
+  auto stream = vec8_type(m_stream_len(header, layout));
+  m_write_stream(header, layout, stream.data());
+
+  return stream;
+}
+
+auto sperr::SPERR3D_OMP_C::view_profile() const -> const Profile&
+{
+  return m_profile;
+}
+
+auto sperr::SPERR3D_OMP_C::view_chunk_profiles() const -> const std::vector<Profile>&
+{
+  return m_chunk_profiles;
+}
+
+auto sperr::SPERR3D_OMP_C::get_memory_usage() const -> Memory_Usage
+{
+  auto mem = m_mem;
+#ifdef USE_OMP
+  for (const auto& p : m_compressors)
+    if (p)
+      mem.merge(p->view_memory_usage());
+#else
+  if (m_compressor)
+    mem.merge(m_compressor->view_memory_usage());
+#endif
+  return mem;
+}
+
+auto sperr::SPERR3D_OMP_C::encoded_bitstream_len() const -> size_t
+{
+  const auto num_chunks = m_encoded_streams.size();
+  if (num_chunks == 0)
+    return 0;
+
+  // Super-chunks are padded to the stripe size, which the header tells.
+  if (m_use_super_chunks()) {
+    auto layout = SPERR3D_Header();
+    return m_stream_len(m_generate_header(), layout);
   }
 
-  return header;
+  auto header_size = size_t{0};
+  if (num_chunks > 1)
+    header_size = m_header_magic_nchunks + num_chunks * 4;
+  else
+    header_size = m_header_magic_1chunk + num_chunks * 4;
+  if (!m_chunk_stats.empty())
+    header_size += num_chunks * sizeof(double) * 4;
+  const auto dedup = m_use_dedup();
+  auto stream_size = size_t{0};
+  for (size_t i = 0; i < num_chunks; i++)
+    stream_size += m_chunk_stream(i, dedup).size();
+
+  return header_size + stream_size;
+}
+
+auto sperr::SPERR3D_OMP_C::write_encoded_bitstream(void* p, size_t len) const -> RTNType
+{
+  const auto header = m_generate_header();
+  if (header.empty())
+    return RTNType::Error;
+  auto layout = SPERR3D_Header();
+  if (len < m_stream_len(header, layout))
+    return RTNType::WrongLength;
+  m_write_stream(header, layout, static_cast<uint8_t*>(p));
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR3D_OMP_C::m_stream_len(const vec8_type& header, SPERR3D_Header& layout) const
+    -> size_t
+{
+  if (header[0] & super_chunk_flag) {
+    layout = SPERR3D_Stream_Tools().get_stream_header(header.data());
+    return layout.stream_len;
+  }
+
+  const bool dedup = header[0] & dedup_flag;
+  auto len = header.size();
+  for (size_t i = 0; i < m_encoded_streams.size(); i++)
+    len += m_chunk_stream(i, dedup).size();
+  return len;
+}
+
+void sperr::SPERR3D_OMP_C::m_write_stream(const vec8_type& header,
+                                          const SPERR3D_Header& layout,
+                                          uint8_t* dst) const
+{
+  const bool dedup = header[0] & dedup_flag;
+  auto* itr = std::copy(header.cbegin(), header.cend(), dst);
+  if (header[0] & super_chunk_flag) {
+    // Place each chunk bitstream where the header says, and zero the padding in between.
+    std::fill(itr, dst + layout.stream_len, uint8_t{0});
+    for (size_t i = 0; i < m_encoded_streams.size(); i++) {
+      if (layout.chunk_sources[i] == i) {
+        const auto& s = m_chunk_stream(i, dedup);
+        std::copy(s.cbegin(), s.cend(), dst + layout.chunk_offsets[i * 2]);
+      }
+    }
+  }
+  else {
+    for (size_t i = 0; i < m_encoded_streams.size(); i++) {
+      const auto& s = m_chunk_stream(i, dedup);
+      itr = std::copy(s.cbegin(), s.cend(), itr);
+    }
+  }
+}
+
+auto sperr::SPERR3D_OMP_C::m_use_super_chunks() const -> bool
+{
+  return m_encoded_streams.size() > 1 &&
+         std::none_of(m_super_dims.cbegin(), m_super_dims.cend(), [](auto d) { return d == 0; });
+}
+
+auto sperr::SPERR3D_OMP_C::m_use_dedup() const -> bool
+{
+  const auto num_chunks = m_encoded_streams.size();
+  if (m_chunk_sources.size() != num_chunks)
+    return false;
+  auto has_ref = false;
+  for (size_t i = 0; i < num_chunks; i++) {
+    if (m_encoded_streams[i].size() >= chunk_ref_flag)
+      return false;
+    has_ref = has_ref || (m_chunk_sources[i] != i);
+  }
+  return has_ref;
+}
+
+auto sperr::SPERR3D_OMP_C::m_chunk_stream(size_t i, bool dedup) const -> const vec8_type&
+{
+  if (dedup || m_chunk_sources.size() != m_encoded_streams.size())
+    return m_encoded_streams[i];
+  return m_encoded_streams[m_chunk_sources[i]];
 }
 
 auto sperr::SPERR3D_OMP_C::m_generate_header() const -> sperr::vec8_type
@@ -169,7 +537,11 @@ auto sperr::SPERR3D_OMP_C::m_generate_header() const -> sperr::vec8_type
   //  -- 8 booleans                           (1 byte)
   //  -- volume dimensions                    (4 x 3 = 12 bytes)
   //  -- (optional) chunk dimensions          (2 x 3 = 6 bytes)
-  //  -- length of bitstream for each chunk   (4 x num_chunks)
+  //  -- (optional) super-chunk dimensions    (2 x 3 = 6 bytes), if flagged in the version number
+  //  -- (optional) stripe size               (4 bytes), if flagged in the version number
+  //  -- length of bitstream for each chunk   (4 x num_chunks), or a reference to an earlier chunk
+  //                                          if `dedup_flag` is set in the version number
+  //  -- (optional) statistics index          (8 x 4 x num_chunks)
   //
   auto chunk_idx = sperr::chunk_volume(m_dims, m_chunk_dims);
   const auto num_chunks = chunk_idx.size();
@@ -181,11 +553,22 @@ auto sperr::SPERR3D_OMP_C::m_generate_header() const -> sperr::vec8_type
     header_size = m_header_magic_nchunks + num_chunks * 4;
   else
     header_size = m_header_magic_1chunk + num_chunks * 4;
+  if (!m_chunk_stats.empty())
+    header_size += num_chunks * sizeof(double) * 4;
+  const auto use_super = m_use_super_chunks();
+  if (use_super)
+    header_size += m_header_super;
 
   header.resize(header_size);
 
-  // Version number
+  // Version number, with `super_chunk_flag` if chunks are grouped into super-chunks, and
+  //    `dedup_flag` if duplicate chunks refer to their sources.
+  const auto dedup = m_use_dedup();
   header[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+  if (use_super)
+    header[0] |= super_chunk_flag;
+  if (dedup)
+    header[0] |= dedup_flag;
   size_t pos = 1;
 
   // 8 booleans:
@@ -193,16 +576,18 @@ auto sperr::SPERR3D_OMP_C::m_generate_header() const -> sperr::vec8_type
   // bool[1]  : if this bitstream is for 3D (true) or 2D (false) data.
   // bool[2]  : if the original data is float (true) or double (false).
   // bool[3]  : if there are multiple chunks (true) or a single chunk (false).
-  // bool[4-7]: unused
+  // bool[4]  : if there is a statistics index of min, max, mean, and variance of each chunk.
+  // bool[5-7]: the original data type, if it's not float or double (see encode_data_type()).
   //
-  const auto b8 = std::array<bool, 8>{false,  // not a portion
-                                      true,   // 3D
-                                      m_orig_is_float,
-                                      (num_chunks > 1),
-                                      false,   // unused
-                                      false,   // unused
-                                      false,   // unused
-                                      false};  // unused
+  auto b8 = std::array<bool, 8>{false,  // not a portion
+                                true,   // 3D
+                                true,   // float, to be set by encode_data_type()
+                                (num_chunks > 1),
+                                !m_chunk_stats.empty(),  // statistics index
+                                false,   // data type
+                                false,   // data type
+                                false};  // data type
+  sperr::encode_data_type(m_orig_type, b8);
 
   header[pos++] = sperr::pack_8_booleans(b8);
 
@@ -221,18 +606,136 @@ auto sperr::SPERR3D_OMP_C::m_generate_header() const -> sperr::vec8_type
     pos += sizeof(vcdim);
   }
 
-  // Length of bitstream for each chunk.
-  for (const auto& stream : m_encoded_streams) {
-    assert(stream.size() <= uint64_t{std::numeric_limits<uint32_t>::max()});
-    uint32_t len = stream.size();
+  // Super-chunk dimensions and the stripe size, if there are super-chunks.
+  if (use_super) {
+    auto vsdim =
+        std::array{static_cast<uint16_t>(m_super_dims[0]), static_cast<uint16_t>(m_super_dims[1]),
+                   static_cast<uint16_t>(m_super_dims[2])};
+    std::memcpy(&header[pos], vsdim.data(), sizeof(vsdim));
+    pos += sizeof(vsdim);
+    const auto stripe = static_cast<uint32_t>(m_stripe);
+    std::memcpy(&header[pos], &stripe, sizeof(stripe));
+    pos += sizeof(stripe);
+  }
+
+  // Length of bitstream for each chunk, or the chunk that it refers to (see `chunk_ref_flag`).
+  for (size_t i = 0; i < num_chunks; i++) {
+    uint32_t len = m_chunk_stream(i, dedup).size();
+    if (dedup && m_chunk_sources[i] != i)
+      len = chunk_ref_flag | static_cast<uint32_t>(m_chunk_sources[i]);
     std::memcpy(&header[pos], &len, sizeof(len));
     pos += sizeof(len);
   }
+
+  // Statistics of each chunk, if recorded.
+  for (const auto& stats : m_chunk_stats) {
+    const auto d4 = std::array{stats.min, stats.max, stats.mean, stats.var};
+    std::memcpy(&header[pos], d4.data(), sizeof(d4));
+    pos += sizeof(d4);
+  }
   assert(pos == header_size);
 
   return header;
 }
 
+auto sperr::SPERR3D_OMP_C::m_estimate_mem(size_t chunk_vals,
+                                          size_t num_threads,
+                                          size_t input_bytes,
+                                          size_t output_bytes) const -> size_t
+{
+  // While a chunk is being encoded, there are its values in double precision, the quantized
+  //    integers (up to 64 bits) and their Morton-ordered copy, plus bitmasks and the bitstream.
+  //    PWE mode also keeps a copy of the original values, and the outliers.
+  auto bytes = chunk_vals * (sizeof(double) + sizeof(uint64_t) * 2) + chunk_vals / 2;
+  if (m_mode == CompMode::PWE)
+    bytes += chunk_vals * sizeof(double) * 2;
+
+  // The input volume and the bitstreams of finished chunks are kept throughout.
+  return bytes * num_threads + input_bytes + output_bytes;
+}
+
+template <typename T>
+void sperr::SPERR3D_OMP_C::m_find_duplicates(const T* vol,
+                                             const std::vector<std::array<size_t, 6>>& chunks)
+{
+  // Address of row `y` of slice `z` of a chunk in the volume.
+  auto row_of = [vol, &dims = m_dims](const std::array<size_t, 6>& c, size_t y, size_t z) {
+    return vol + (c[4] + z) * dims[0] * dims[1] + (c[2] + y) * dims[0] + c[0];
+  };
+
+  // Step 1: hash the bytes of every chunk (FNV-1a, mostly on 8-byte words) in parallel.
+  const auto num_chunks = chunks.size();
+  auto hashes = std::vector<uint64_t>(num_chunks);
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < num_chunks; i++) {
+    const auto& c = chunks[i];
+    auto h = uint64_t{14695981039346656037ull};
+    for (size_t z = 0; z < c[5]; z++) {
+      for (size_t y = 0; y < c[3]; y++) {
+        const auto* p = reinterpret_cast<const uint8_t*>(row_of(c, y, z));
+        auto len = c[1] * sizeof(T);
+        for (; len >= 8; len -= 8, p += 8) {
+          auto word = uint64_t{0};
+          std::memcpy(&word, p, sizeof(word));
+          h = (h ^ word) * uint64_t{1099511628211ull};
+        }
+        for (; len > 0; len--, p++)
+          h = (h ^ *p) * uint64_t{1099511628211ull};
+      }
+    }
+    hashes[i] = h;
+  }
+
+  // Step 2: a chunk with the same hash and dimensions as an earlier one is compared against it
+  //    byte by byte, so a hash collision never merges different chunks.
+  auto first = std::map<std::tuple<uint64_t, size_t, size_t, size_t>, size_t>();
+  for (size_t i = 0; i < num_chunks; i++) {
+    const auto& c = chunks[i];
+    auto [it, inserted] = first.emplace(std::tuple(hashes[i], c[1], c[3], c[5]), i);
+    if (inserted)
+      continue;
+    const auto& src = chunks[it->second];
+    auto same = true;
+    for (size_t z = 0; same && z < c[5]; z++) {
+      for (size_t y = 0; same && y < c[3]; y++)
+        same = (std::memcmp(row_of(c, y, z), row_of(src, y, z), c[1] * sizeof(T)) == 0);
+    }
+    if (same)
+      m_chunk_sources[i] = it->second;
+  }
+}
+
+template <typename T>
+auto sperr::SPERR3D_OMP_C::m_constant_value(const T* vol, std::array<size_t, 6> chunk) const
+    -> std::optional<double>
+{
+  // Values are compared as doubles, the same as in `Conditioner::condition()`. Each row is
+  //    compared in blocks without exiting early, so that the comparisons are vectorized, and
+  //    the test ends at the first block with a different value.
+  constexpr size_t block = 32;
+  const auto slice_len = m_dims[0] * m_dims[1];
+  const auto v0 = sperr::to_double(vol[chunk[4] * slice_len + chunk[2] * m_dims[0] + chunk[0]]);
+  for (size_t z = chunk[4]; z < chunk[4] + chunk[5]; z++) {
+    for (size_t y = chunk[2]; y < chunk[2] + chunk[3]; y++) {
+      const auto* row = vol + z * slice_len + y * m_dims[0] + chunk[0];
+      size_t x = 0;
+      for (; x + block <= chunk[1]; x += block) {
+        auto diff = uint8_t{0};
+        for (size_t j = 0; j < block; j++)
+          diff |= uint8_t(sperr::to_double(row[x + j]) != v0);
+        if (diff)
+          return std::nullopt;
+      }
+      for (; x < chunk[1]; x++) {
+        if (sperr::to_double(row[x]) != v0)
+          return std::nullopt;
+      }
+    }
+  }
+
+  return v0;
+}
+
 template <typename T>
 auto sperr::SPERR3D_OMP_C::m_gather_chunk(const T* vol,
                                           dims_type vol_dim,
@@ -251,7 +754,8 @@ auto sperr::SPERR3D_OMP_C::m_gather_chunk(const T* vol,
     const size_t plane_offset = z * vol_dim[0] * vol_dim[1];
     for (size_t y = chunk[2]; y < chunk[2] + chunk[3]; y++) {
       const auto start_i = plane_offset + y * vol_dim[0] + chunk[0];
-      std::copy(vol + start_i, vol + start_i + row_len, chunk_buf.begin() + idx);
+      std::transform(vol + start_i, vol + start_i + row_len, chunk_buf.begin() + idx,
+                     [](auto v) { return sperr::to_double(v); });
       idx += row_len;
     }
   }
@@ -263,3 +767,20 @@ template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const float*, dims_type, std:
     -> vecd_type;
 template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const double*, dims_type, std::array<size_t, 6>)
     -> vecd_type;
+template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const fp16_type*,
+                                                   dims_type,
+                                                   std::array<size_t, 6>) -> vecd_type;
+template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const bf16_type*,
+                                                   dims_type,
+                                                   std::array<size_t, 6>) -> vecd_type;
+template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const int8_t*, dims_type, std::array<size_t, 6>)
+    -> vecd_type;
+template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const uint8_t*, dims_type, std::array<size_t, 6>)
+    -> vecd_type;
+template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const int16_t*, dims_type, std::array<size_t, 6>)
+    -> vecd_type;
+template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const uint16_t*,
+                                                   dims_type,
+                                                   std::array<size_t, 6>) -> vecd_type;
+template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const int32_t*, dims_type, std::array<size_t, 6>)
+    -> vecd_type;
@@ -1,9 +1,9 @@
 #include "SPERR3D_OMP_D.h"
-#include "SPERR3D_Stream_Tools.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <map>
 #include <numeric>
 
 #ifdef USE_OMP
@@ -20,52 +20,150 @@ void sperr::SPERR3D_OMP_D::set_num_threads(size_t n)
 #endif
 }
 
+void sperr::SPERR3D_OMP_D::set_memory_budget(size_t bytes)
+{
+  m_mem_budget = bytes;
+}
+
+void sperr::SPERR3D_OMP_D::set_thread_binding(bool bind)
+{
+  m_bind_threads = bind;
+}
+
+void sperr::SPERR3D_OMP_D::set_decode_effort(Decode_Effort effort)
+{
+  m_effort = effort;
+}
+
+auto sperr::SPERR3D_OMP_D::m_chunk_effort() const -> Decode_Effort
+{
+  auto effort = m_effort;
+  const auto& stats = m_stream->view_header().chunk_stats;
+  if (effort.psnr > 0.0 && effort.data_range <= 0.0 && !stats.empty()) {
+    auto min = std::min_element(stats.cbegin(), stats.cend(),
+                                [](auto& a, auto& b) { return a.min < b.min; });
+    auto max = std::max_element(stats.cbegin(), stats.cend(),
+                                [](auto& a, auto& b) { return a.max < b.max; });
+    effort.data_range = max->max - min->min;
+  }
+  return effort;
+}
+
 auto sperr::SPERR3D_OMP_D::use_bitstream(const void* p, size_t total_len) -> RTNType
 {
   // This method gathers information from the header.
   //    It does NOT, however, read the actual bitstream. The actual bitstream
   //    will be provided when the decompress() method is called.
   //
-  auto tools = SPERR3D_Stream_Tools();
-  auto header = tools.get_stream_header(p);
+  auto stream = std::make_shared<SPERR3D_Stream>();
+  auto rtn = stream->open(p, total_len);
+  if (rtn != RTNType::Good)
+    return rtn;
+  return use_stream(std::move(stream));
+}
 
-  // Verify some info.
-  if (header.major_version != static_cast<uint8_t>(SPERR_VERSION_MAJOR))
-    return RTNType::VersionMismatch;
+auto sperr::SPERR3D_OMP_D::use_stream(std::shared_ptr<const SPERR3D_Stream> stream) -> RTNType
+{
+  m_stream.reset();
+  if (stream == nullptr || stream->data() == nullptr)
+    return RTNType::Error;
+  const auto& header = stream->view_header();
   if (!header.is_3D)
     return RTNType::SliceVolumeMismatch;
-  if (header.stream_len != total_len)
-    return RTNType::WrongLength;
 
   // Collect essential info.
   m_dims = header.vol_dims;
   m_chunk_dims = header.chunk_dims;
-  m_offsets = std::move(header.chunk_offsets);
-
-  // Finally, we keep a copy of the bitstream pointer
-  m_bitstream_ptr = static_cast<const uint8_t*>(p);
+  m_orig_type = header.data_type;
+  m_stream = std::move(stream);
 
   return RTNType::Good;
 }
 
+void sperr::SPERR3D_OMP_D::use_decoder_pool(std::shared_ptr<Decoder_Pool> pool)
+{
+  m_return_decompressors();
+  m_pool = std::move(pool);
+}
+
+auto sperr::SPERR3D_OMP_D::m_check_stream(const void* p) const -> bool
+{
+  if (p == nullptr || m_stream == nullptr)
+    return false;
+  if (static_cast<const uint8_t*>(p) != m_stream->data())
+    return false;
+  auto eq0 = [](auto v) { return v == 0; };
+  return std::none_of(m_dims.cbegin(), m_dims.cend(), eq0) &&
+         std::none_of(m_chunk_dims.cbegin(), m_chunk_dims.cend(), eq0);
+}
+
+void sperr::SPERR3D_OMP_D::m_prepare_decompressors([[maybe_unused]] size_t num_threads)
+{
+  auto make = [&pool = m_pool](auto& p) {
+    if (p == nullptr)
+      p = pool ? pool->acquire() : std::make_unique<SPECK3D_FLT>();
+  };
+#ifdef USE_OMP
+  m_decompressors.resize(num_threads);
+  std::for_each(m_decompressors.begin(), m_decompressors.end(), make);
+#else
+  make(m_decompressor);
+#endif
+}
+
+void sperr::SPERR3D_OMP_D::m_return_decompressors()
+{
+  if (m_pool == nullptr)
+    return;
+#ifdef USE_OMP
+  for (auto& p : m_decompressors)
+    m_pool->release(std::move(p));
+  m_decompressors.clear();
+#else
+  m_pool->release(std::move(m_decompressor));
+#endif
+}
+
 auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
 {
-  if (p == nullptr || m_bitstream_ptr == nullptr)
-    return RTNType::Error;
-  if (static_cast<const uint8_t*>(p) != m_bitstream_ptr)
+  // `m_vol_buf` gets zero-filled by the calling thread when it grows; use `decompress_into()`
+  //    to avoid that.
+  m_vol_buf.resize(m_dims[0] * m_dims[1] * m_dims[2]);
+  return m_decompress(p, m_vol_buf.data(), multi_res);
+}
+
+template <typename T>
+auto sperr::SPERR3D_OMP_D::decompress_into(const void* p, T* dst, bool multi_res) -> RTNType
+{
+  if (dst == nullptr)
     return RTNType::Error;
-  auto eq0 = [](auto v) { return v == 0; };
-  if (std::any_of(m_dims.cbegin(), m_dims.cend(), eq0) ||
-      std::any_of(m_chunk_dims.cbegin(), m_chunk_dims.cend(), eq0))
+  m_vol_buf.clear();
+  return m_decompress(p, dst, multi_res);
+}
+template auto sperr::SPERR3D_OMP_D::decompress_into(const void*, float*, bool) -> RTNType;
+template auto sperr::SPERR3D_OMP_D::decompress_into(const void*, double*, bool) -> RTNType;
+template auto sperr::SPERR3D_OMP_D::decompress_into(const void*, fp16_type*, bool) -> RTNType;
+template auto sperr::SPERR3D_OMP_D::decompress_into(const void*, bf16_type*, bool) -> RTNType;
+template auto sperr::SPERR3D_OMP_D::decompress_into(const void*, int8_t*, bool) -> RTNType;
+template auto sperr::SPERR3D_OMP_D::decompress_into(const void*, uint8_t*, bool) -> RTNType;
+template auto sperr::SPERR3D_OMP_D::decompress_into(const void*, int16_t*, bool) -> RTNType;
+template auto sperr::SPERR3D_OMP_D::decompress_into(const void*, uint16_t*, bool) -> RTNType;
+template auto sperr::SPERR3D_OMP_D::decompress_into(const void*, int32_t*, bool) -> RTNType;
+
+template <typename T>
+auto sperr::SPERR3D_OMP_D::m_decompress(const void* p, T* dst, bool multi_res) -> RTNType
+{
+  m_profile.reset();
+  SPERR_PROFILE_WALL(&m_profile);
+
+  if (!m_check_stream(p))
     return RTNType::Error;
 
-  // Let's figure out the chunk information
-  const auto chunks = sperr::chunk_volume(m_dims, m_chunk_dims);
+  // The chunk information comes with the stream.
+  const auto& chunks = m_stream->view_chunks();
   const auto num_chunks = chunks.size();
-  const auto total_vals = m_dims[0] * m_dims[1] * m_dims[2];
-
-  // Allocate a buffer to store the entire volume
-  m_vol_buf.resize(total_vals);
+  const auto& offsets = m_stream->view_header().chunk_offsets;
+  const auto& sources = m_stream->view_header().chunk_sources;
 
   // A few variables to support multi-resolution decoding.
   const auto vol_res = sperr::coarsened_resolutions(m_dims, m_chunk_dims);
@@ -84,35 +182,74 @@ auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
     }
   }
 
-  // Create number of decompressor instances equal to the number of threads
-  auto chunk_rtn = std::vector<RTNType>(num_chunks * 2, RTNType::Good);
-
+  // Under a memory budget, use as many threads as the budget allows after the output volume.
 #ifdef USE_OMP
-  m_decompressors.resize(m_num_threads);
-  std::for_each(m_decompressors.begin(), m_decompressors.end(), [](auto& p) {
-    if (p == nullptr)
-      p = std::make_unique<SPECK3D_FLT>();
-  });
+  auto num_threads = m_num_threads;
+  if (m_mem_budget > 0) {
+    auto max_len = size_t{1};
+    for (const auto& c : chunks)
+      max_len = std::max(max_len, c[1] * c[3] * c[5]);
+    auto out_bytes = m_dims[0] * m_dims[1] * m_dims[2] * sizeof(T);
+    for (const auto& h : m_hierarchy)
+      out_bytes += h.size() * sizeof(double);
+    const auto avail = m_mem_budget > out_bytes ? m_mem_budget - out_bytes : size_t{0};
+    num_threads = std::clamp(avail / m_estimate_chunk_mem(max_len), size_t{1}, m_num_threads);
+  }
 #else
-  if (m_decompressor == nullptr)
-    m_decompressor = std::make_unique<SPECK3D_FLT>();
+  const auto num_threads = size_t{1};
 #endif
 
-#pragma omp parallel for num_threads(m_num_threads)
-  for (size_t chunkI = 0; chunkI < num_chunks; chunkI++) {
+  // Create number of decompressor instances equal to the number of threads
+  auto chunk_rtn = std::vector<RTNType>(num_chunks * 2, RTNType::Good);
+#ifdef SPERR_INSTRUMENT
+  m_chunk_profiles.assign(num_chunks, Profile());
+#endif
+
+  m_prepare_decompressors(num_threads);
+
+  const auto conditioner = Conditioner();
+  const auto effort = m_chunk_effort();
+  auto decompress_chunk = [&](size_t chunkI) {
 #ifdef USE_OMP
     auto& decompressor = m_decompressors[omp_get_thread_num()];
 #else
     auto& decompressor = m_decompressor;
 #endif
 
+    // Deduplicated chunks are copied from their source chunk afterwards, unless multi-resolution
+    //    is requested, which is simpler to decode again.
+    if (sources[chunkI] != chunkI && !multi_res)
+      return;
+
+    // A constant chunk, whose bitstream is only a conditioner header, is filled straight into
+    //    the output without involving the decompressor.
+    const auto* chunk_p = m_stream->data() + offsets[chunkI * 2];
+    auto condi = condi_type();
+    if (offsets[chunkI * 2 + 1] >= condi.size() && conditioner.is_constant(chunk_p[0])) {
+      std::copy(chunk_p, chunk_p + condi.size(), condi.begin());
+      const auto val = conditioner.retrieve_mean(condi);
+      m_fill_chunk(dst, m_dims, val, chunks[chunkI]);
+      if (multi_res) {
+        for (size_t h = 0; h < m_hierarchy.size(); h++)
+          m_fill_chunk(m_hierarchy[h].data(), vol_res[h], val, hierarchy_chunks[h][chunkI]);
+      }
+      SPERR_PROFILE_EXEC(m_chunk_profiles[chunkI].add_chunks(1));
+      return;
+    }
+
     // Setup decompressor parameters, and decompress!
     decompressor->set_dims({chunks[chunkI][1], chunks[chunkI][3], chunks[chunkI][5]});
-    chunk_rtn[chunkI * 2] = decompressor->use_bitstream(m_bitstream_ptr + m_offsets[chunkI * 2],
-                                                        m_offsets[chunkI * 2 + 1]);
+    decompressor->set_decode_effort(effort);
+    chunk_rtn[chunkI * 2] = decompressor->use_bitstream(chunk_p, offsets[chunkI * 2 + 1]);
     chunk_rtn[chunkI * 2 + 1] = decompressor->decompress(multi_res);
+    SPERR_PROFILE_EXEC(m_chunk_profiles[chunkI].add_chunks(1));
+    SPERR_PROFILE_EXEC(m_chunk_profiles[chunkI].merge(decompressor->view_profile()));
     const auto& small_vol = decompressor->view_decoded_data();
-    m_scatter_chunk(m_vol_buf, m_dims, small_vol, chunks[chunkI]);
+    {
+      SPERR_PROFILE_SCOPE(&m_chunk_profiles[chunkI], Stage::ChunkCopy,
+                          small_vol.size() * sizeof(double) * 2);
+      m_scatter_chunk(dst, m_dims, small_vol, chunks[chunkI]);
+    }
 
     // Also assemble the full hierarchy.
     if (multi_res) {
@@ -121,10 +258,153 @@ auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
       for (size_t h = 0; h < low_res.size(); h++) {
         const auto& small_dim = chunk_res[h];
         assert(low_res[h].size() == small_dim[0] * small_dim[1] * small_dim[2]);
-        m_scatter_chunk(m_hierarchy[h], vol_res[h], low_res[h], hierarchy_chunks[h][chunkI]);
+        m_scatter_chunk(m_hierarchy[h].data(), vol_res[h], low_res[h],
+                        hierarchy_chunks[h][chunkI]);
+      }
+    }
+  };
+
+  // With a static schedule, each thread decodes a contiguous range of chunks, i.e., a slab of
+  //    the volume when there are multiple chunks along Z, and it's the first thread to write to
+  //    that part of the output buffer. If the output buffer isn't initialized yet, its pages are
+  //    thus placed on the NUMA node where that thread runs. Optionally, threads are spread over
+  //    and bound to the places in OMP_PLACES so that this placement holds for the whole run.
+  if (m_bind_threads) {
+#pragma omp parallel for num_threads(num_threads) schedule(static) proc_bind(spread)
+    for (size_t chunkI = 0; chunkI < num_chunks; chunkI++)
+      decompress_chunk(chunkI);
+  }
+  else {
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+    for (size_t chunkI = 0; chunkI < num_chunks; chunkI++)
+      decompress_chunk(chunkI);
+  }
+
+  if (!multi_res) {
+#pragma omp parallel for num_threads(num_threads)
+    for (size_t chunkI = 0; chunkI < num_chunks; chunkI++) {
+      if (sources[chunkI] != chunkI)
+        m_copy_chunk(dst, chunks[sources[chunkI]], chunks[chunkI]);
+    }
+  }
+
+  auto out_bytes = m_vol_buf.capacity() * sizeof(double);
+  for (const auto& h : m_hierarchy)
+    out_bytes += h.capacity() * sizeof(double);
+  m_mem.set_current(MemComp::Output, out_bytes);
+
+#ifdef SPERR_INSTRUMENT
+  for (const auto& prof : m_chunk_profiles)
+    m_profile.merge(prof);
+#endif
+  m_return_decompressors();
+
+  auto fail = std::find_if_not(chunk_rtn.begin(), chunk_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != chunk_rtn.end())
+    return *fail;
+  else
+    return RTNType::Good;
+}
+
+auto sperr::SPERR3D_OMP_D::decompress_region(const void* p, dims_type start, dims_type size)
+    -> RTNType
+{
+  m_profile.reset();
+  SPERR_PROFILE_WALL(&m_profile);
+  m_vol_buf.clear();
+
+  if (!m_check_stream(p))
+    return RTNType::Error;
+  for (size_t d = 0; d < 3; d++) {
+    if (size[d] == 0 || start[d] + size[d] > m_dims[d])
+      return RTNType::Error;
+  }
+
+  // Keep only the chunks intersecting the region. Deduplicated chunks share the offsets of
+  //    their source chunk, so each of them is simply decoded again.
+  const auto& all_chunks = m_stream->view_chunks();
+  const auto& offsets = m_stream->view_header().chunk_offsets;
+  auto roi_chunks = std::vector<size_t>();
+  for (size_t i = 0; i < all_chunks.size(); i++) {
+    const auto& c = all_chunks[i];
+    auto overlap = true;
+    for (size_t d = 0; d < 3; d++)
+      overlap &= c[d * 2] < start[d] + size[d] && start[d] < c[d * 2] + c[d * 2 + 1];
+    if (overlap)
+      roi_chunks.push_back(i);
+  }
+  const auto num_chunks = roi_chunks.size();
+
+  // Allocate a buffer to store the region
+  m_vol_buf.resize(size[0] * size[1] * size[2]);
+  auto chunk_rtn = std::vector<RTNType>(num_chunks * 2, RTNType::Good);
+#ifdef SPERR_INSTRUMENT
+  m_chunk_profiles.assign(num_chunks, Profile());
+#endif
+
+#ifdef USE_OMP
+  auto num_threads = std::min(m_num_threads, std::max(num_chunks, size_t{1}));
+  if (m_mem_budget > 0) {
+    auto max_len = size_t{1};
+    for (auto i : roi_chunks)
+      max_len = std::max(max_len, all_chunks[i][1] * all_chunks[i][3] * all_chunks[i][5]);
+    const auto out_bytes = m_vol_buf.size() * sizeof(double);
+    const auto avail = m_mem_budget > out_bytes ? m_mem_budget - out_bytes : size_t{0};
+    num_threads = std::clamp(avail / m_estimate_chunk_mem(max_len), size_t{1}, num_threads);
+  }
+#else
+  const auto num_threads = size_t{1};
+#endif
+  m_prepare_decompressors(num_threads);
+  const auto effort = m_chunk_effort();
+
+#pragma omp parallel for num_threads(num_threads)
+  for (size_t i = 0; i < num_chunks; i++) {
+#ifdef USE_OMP
+    auto& decompressor = m_decompressors[omp_get_thread_num()];
+#else
+    auto& decompressor = m_decompressor;
+#endif
+
+    const auto chunkI = roi_chunks[i];
+    const auto& c = all_chunks[chunkI];
+    decompressor->set_dims({c[1], c[3], c[5]});
+    decompressor->set_decode_effort(effort);
+    chunk_rtn[i * 2] = decompressor->use_bitstream(m_stream->data() + offsets[chunkI * 2],
+                                                   offsets[chunkI * 2 + 1]);
+    chunk_rtn[i * 2 + 1] = decompressor->decompress();
+    SPERR_PROFILE_EXEC(m_chunk_profiles[i].add_chunks(1));
+    SPERR_PROFILE_EXEC(m_chunk_profiles[i].merge(decompressor->view_profile()));
+    const auto& small_vol = decompressor->view_decoded_data();
+    if (small_vol.size() != c[1] * c[3] * c[5]) {
+      chunk_rtn[i * 2 + 1] = RTNType::WrongLength;
+      continue;
+    }
+
+    // Copy the intersection of this chunk and the region to the output buffer.
+    auto lo = std::array<size_t, 3>();
+    auto hi = std::array<size_t, 3>();
+    for (size_t d = 0; d < 3; d++) {
+      lo[d] = std::max(c[d * 2], start[d]);
+      hi[d] = std::min(c[d * 2] + c[d * 2 + 1], start[d] + size[d]);
+    }
+    for (size_t z = lo[2]; z < hi[2]; z++) {
+      for (size_t y = lo[1]; y < hi[1]; y++) {
+        const auto src_i = ((z - c[4]) * c[3] + (y - c[2])) * c[1] + (lo[0] - c[0]);
+        const auto dst_i =
+            ((z - start[2]) * size[1] + (y - start[1])) * size[0] + (lo[0] - start[0]);
+        std::copy(small_vol.begin() + src_i, small_vol.begin() + src_i + (hi[0] - lo[0]),
+                  m_vol_buf.begin() + dst_i);
       }
     }
-  }  // End of OMP parallel section.
+  }
+
+#ifdef SPERR_INSTRUMENT
+  for (const auto& prof : m_chunk_profiles)
+    m_profile.merge(prof);
+#endif
+  m_return_decompressors();
 
   auto fail = std::find_if_not(chunk_rtn.begin(), chunk_rtn.end(),
                                [](auto r) { return r == RTNType::Good; });
@@ -134,6 +414,145 @@ auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
     return RTNType::Good;
 }
 
+auto sperr::SPERR3D_OMP_D::decompress_coarse(const void* p, size_t num_bitplanes) -> RTNType
+{
+  m_profile.reset();
+  SPERR_PROFILE_WALL(&m_profile);
+  m_coarse_buf.clear();
+  m_coarse_dims = {0, 0, 0};
+
+  if (!m_check_stream(p))
+    return RTNType::Error;
+
+  const auto& chunks = m_stream->view_chunks();
+  const auto num_chunks = chunks.size();
+  const auto& offsets = m_stream->view_header().chunk_offsets;
+  const auto& sources = m_stream->view_header().chunk_sources;
+  auto chunk_rtn = std::vector<RTNType>(num_chunks * 2, RTNType::Good);
+  auto coarse_chunks = std::vector<vecd_type>(num_chunks);
+  auto coarse_dims = std::vector<dims_type>(num_chunks);
+  m_chunk_mean_var.assign(num_chunks, {0.0, 0.0});
+#ifdef SPERR_INSTRUMENT
+  m_chunk_profiles.assign(num_chunks, Profile());
+#endif
+
+#ifdef USE_OMP
+  auto num_threads = m_num_threads;
+  if (m_mem_budget > 0) {
+    auto max_len = size_t{1};
+    for (const auto& c : chunks)
+      max_len = std::max(max_len, c[1] * c[3] * c[5]);
+    num_threads = std::clamp(m_mem_budget / m_estimate_chunk_mem(max_len), size_t{1}, num_threads);
+  }
+#else
+  const auto num_threads = size_t{1};
+#endif
+  m_prepare_decompressors(num_threads);
+
+#pragma omp parallel for num_threads(num_threads)
+  for (size_t chunkI = 0; chunkI < num_chunks; chunkI++) {
+#ifdef USE_OMP
+    auto& decompressor = m_decompressors[omp_get_thread_num()];
+#else
+    auto& decompressor = m_decompressor;
+#endif
+
+    if (sources[chunkI] != chunkI)
+      continue;  // Deduplicated chunks are copied from their source chunk afterwards.
+    decompressor->set_dims({chunks[chunkI][1], chunks[chunkI][3], chunks[chunkI][5]});
+    chunk_rtn[chunkI * 2] = decompressor->use_bitstream(m_stream->data() + offsets[chunkI * 2],
+                                                        offsets[chunkI * 2 + 1]);
+    chunk_rtn[chunkI * 2 + 1] = decompressor->decompress_coarse(num_bitplanes);
+    SPERR_PROFILE_EXEC(m_chunk_profiles[chunkI].add_chunks(1));
+    SPERR_PROFILE_EXEC(m_chunk_profiles[chunkI].merge(decompressor->view_profile()));
+    m_chunk_mean_var[chunkI] = decompressor->get_mean_var();
+    coarse_dims[chunkI] = decompressor->get_coarse_dims();
+    coarse_chunks[chunkI] = decompressor->release_decoded_data();
+  }
+
+#ifdef SPERR_INSTRUMENT
+  for (const auto& prof : m_chunk_profiles)
+    m_profile.merge(prof);
+#endif
+  m_return_decompressors();
+  for (size_t i = 0; i < num_chunks; i++) {
+    if (sources[i] != i) {
+      m_chunk_mean_var[i] = m_chunk_mean_var[sources[i]];
+      coarse_dims[i] = coarse_dims[sources[i]];
+      coarse_chunks[i] = coarse_chunks[sources[i]];
+    }
+  }
+
+  auto fail = std::find_if_not(chunk_rtn.begin(), chunk_rtn.end(),
+                               [](auto r) { return r == RTNType::Good; });
+  if (fail != chunk_rtn.end())
+    return *fail;
+
+  // Tile the coarse chunks, which requires chunks starting at the same position along an axis
+  //    to have the same coarse length along that axis. Each map goes from the starting position
+  //    of chunks to their coarse length, and then to their coarse starting position.
+  auto axes = std::array<std::map<size_t, size_t>, 3>();
+  for (size_t i = 0; i < num_chunks; i++) {
+    for (size_t d = 0; d < 3; d++) {
+      auto [it, inserted] = axes[d].emplace(chunks[i][d * 2], coarse_dims[i][d]);
+      if (!inserted && it->second != coarse_dims[i][d])
+        return RTNType::Good;
+    }
+  }
+  for (size_t d = 0; d < 3; d++) {
+    for (auto& [start, len] : axes[d]) {
+      const auto coarse_len = len;
+      len = m_coarse_dims[d];
+      m_coarse_dims[d] += coarse_len;
+    }
+  }
+  m_coarse_buf.resize(m_coarse_dims[0] * m_coarse_dims[1] * m_coarse_dims[2]);
+  for (size_t i = 0; i < num_chunks; i++) {
+    auto coarse_chunk = std::array<size_t, 6>();
+    for (size_t d = 0; d < 3; d++) {
+      coarse_chunk[d * 2] = axes[d][chunks[i][d * 2]];
+      coarse_chunk[d * 2 + 1] = coarse_dims[i][d];
+    }
+    m_scatter_chunk(m_coarse_buf.data(), m_coarse_dims, coarse_chunks[i], coarse_chunk);
+  }
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR3D_OMP_D::view_coarse_data() const -> const vecd_type&
+{
+  return m_coarse_buf;
+}
+
+auto sperr::SPERR3D_OMP_D::get_coarse_dims() const -> dims_type
+{
+  return m_coarse_dims;
+}
+
+auto sperr::SPERR3D_OMP_D::view_chunk_mean_var() const -> const std::vector<std::array<double, 2>>&
+{
+  return m_chunk_mean_var;
+}
+
+auto sperr::SPERR3D_OMP_D::get_mean_var() const -> std::array<double, 2>
+{
+  // Combine chunks weighted by their number of values: the variance of the volume is the mean
+  //    of the chunk variances plus the variance of the chunk means.
+  const auto chunks = sperr::chunk_volume(m_dims, m_chunk_dims);
+  if (chunks.size() != m_chunk_mean_var.size())
+    return {0.0, 0.0};
+  auto sum = std::array<double, 3>{0.0, 0.0, 0.0};  // values, means, and squares.
+  for (size_t i = 0; i < chunks.size(); i++) {
+    const auto n = static_cast<double>(chunks[i][1] * chunks[i][3] * chunks[i][5]);
+    const auto [mean, var] = m_chunk_mean_var[i];
+    sum[0] += n;
+    sum[1] += n * mean;
+    sum[2] += n * (var + mean * mean);
+  }
+  const auto mean = sum[1] / sum[0];
+  return {mean, std::max(0.0, sum[2] / sum[0] - mean * mean)};
+}
+
 auto sperr::SPERR3D_OMP_D::release_decoded_data() -> sperr::vecd_type&&
 {
   return std::move(m_vol_buf);
@@ -154,6 +573,30 @@ auto sperr::SPERR3D_OMP_D::view_decoded_data() const -> const sperr::vecd_type&
   return m_vol_buf;
 }
 
+auto sperr::SPERR3D_OMP_D::view_profile() const -> const Profile&
+{
+  return m_profile;
+}
+
+auto sperr::SPERR3D_OMP_D::view_chunk_profiles() const -> const std::vector<Profile>&
+{
+  return m_chunk_profiles;
+}
+
+auto sperr::SPERR3D_OMP_D::get_memory_usage() const -> Memory_Usage
+{
+  auto mem = m_mem;
+#ifdef USE_OMP
+  for (const auto& p : m_decompressors)
+    if (p)
+      mem.merge(p->view_memory_usage());
+#else
+  if (m_decompressor)
+    mem.merge(m_decompressor->view_memory_usage());
+#endif
+  return mem;
+}
+
 auto sperr::SPERR3D_OMP_D::get_dims() const -> std::array<size_t, 3>
 {
   return m_dims;
@@ -164,7 +607,51 @@ auto sperr::SPERR3D_OMP_D::get_chunk_dims() const -> std::array<size_t, 3>
   return m_chunk_dims;
 }
 
-void sperr::SPERR3D_OMP_D::m_scatter_chunk(vecd_type& big_vol,
+auto sperr::SPERR3D_OMP_D::get_orig_type() const -> DataType
+{
+  return m_orig_type;
+}
+
+auto sperr::SPERR3D_OMP_D::m_estimate_chunk_mem(size_t num_vals) const -> size_t
+{
+  // While a chunk is being decoded, there are the quantized integers (up to 64 bits), their
+  //    values in double precision, and a few bitmasks.
+  return num_vals * (sizeof(double) + sizeof(uint64_t)) + num_vals / 2;
+}
+
+template <typename T>
+void sperr::SPERR3D_OMP_D::m_fill_chunk(T* big_vol,
+                                        dims_type vol_dim,
+                                        double val,
+                                        std::array<size_t, 6> chunk_info)
+{
+  const auto fill_val = sperr::from_double<T>(val);
+  for (size_t z = chunk_info[4]; z < chunk_info[4] + chunk_info[5]; z++) {
+    for (size_t y = chunk_info[2]; y < chunk_info[2] + chunk_info[3]; y++) {
+      auto* row = big_vol + z * vol_dim[0] * vol_dim[1] + y * vol_dim[0] + chunk_info[0];
+      std::fill(row, row + chunk_info[1], fill_val);
+    }
+  }
+}
+
+template <typename T>
+void sperr::SPERR3D_OMP_D::m_copy_chunk(T* vol,
+                                        std::array<size_t, 6> src,
+                                        std::array<size_t, 6> dst) const
+{
+  assert(src[1] == dst[1] && src[3] == dst[3] && src[5] == dst[5]);
+  const auto slice_len = m_dims[0] * m_dims[1];
+  for (size_t z = 0; z < dst[5]; z++) {
+    for (size_t y = 0; y < dst[3]; y++) {
+      const auto* beg = vol + (src[4] + z) * slice_len + (src[2] + y) * m_dims[0] + src[0];
+      auto* out = vol + (dst[4] + z) * slice_len + (dst[2] + y) * m_dims[0] + dst[0];
+      std::copy(beg, beg + dst[1], out);
+    }
+  }
+}
+
+template <typename T>
+void sperr::SPERR3D_OMP_D::m_scatter_chunk(T* big_vol,
                                            dims_type vol_dim,
                                            const vecd_type& small_vol,
                                            std::array<size_t, 6> chunk_info)
@@ -176,8 +663,8 @@ void sperr::SPERR3D_OMP_D::m_scatter_chunk(vecd_type& big_vol,
     const size_t plane_offset = z * vol_dim[0] * vol_dim[1];
     for (size_t y = chunk_info[2]; y < chunk_info[2] + chunk_info[3]; y++) {
       const auto start_i = plane_offset + y * vol_dim[0] + chunk_info[0];
-      std::copy(small_vol.begin() + idx, small_vol.begin() + idx + row_len,
-                big_vol.begin() + start_i);
+      std::transform(small_vol.begin() + idx, small_vol.begin() + idx + row_len, big_vol + start_i,
+                     [](auto v) { return sperr::from_double<T>(v); });
       idx += row_len;
     }
   }
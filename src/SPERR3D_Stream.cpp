@@ -0,0 +1,159 @@
+#include "SPERR3D_Stream.h"
+
+#include <algorithm>
+
+#if __has_include(<sys/mman.h>)
+#define SPERR_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+sperr::SPERR3D_Stream::~SPERR3D_Stream()
+{
+  m_close();
+}
+
+void sperr::SPERR3D_Stream::m_close()
+{
+#ifdef SPERR_HAS_MMAP
+  if (m_map)
+    munmap(m_map, m_len);
+#endif
+  m_map = nullptr;
+  m_buf.clear();
+  m_data = nullptr;
+  m_len = 0;
+  m_chunks.clear();
+  m_header = SPERR3D_Header();
+}
+
+auto sperr::SPERR3D_Stream::open(const void* p, size_t len) -> RTNType
+{
+  m_close();
+  if (p == nullptr)
+    return RTNType::Error;
+  m_data = static_cast<const uint8_t*>(p);
+  m_len = len;
+  return m_parse();
+}
+
+auto sperr::SPERR3D_Stream::open_file(std::string filename) -> RTNType
+{
+  m_close();
+
+#ifdef SPERR_HAS_MMAP
+  const auto fd = ::open(filename.data(), O_RDONLY);
+  if (fd < 0)
+    return RTNType::IOError;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    ::close(fd);
+    return RTNType::IOError;
+  }
+  const auto len = static_cast<size_t>(st.st_size);
+  auto* map = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);  // The mapping stays valid after closing the file.
+  if (map == MAP_FAILED)
+    return RTNType::IOError;
+  m_map = map;
+  m_data = static_cast<const uint8_t*>(map);
+  m_len = len;
+#else
+  m_buf = sperr::read_whole_file<uint8_t>(filename);
+  if (m_buf.empty())
+    return RTNType::IOError;
+  m_data = m_buf.data();
+  m_len = m_buf.size();
+#endif
+
+  return m_parse();
+}
+
+auto sperr::SPERR3D_Stream::m_parse() -> RTNType
+{
+  // Make sure that the header is complete before reading it.
+  auto magic = std::array<uint8_t, 20>();
+  if (m_len < magic.size())
+    return RTNType::WrongLength;
+  std::copy(m_data, m_data + magic.size(), magic.begin());
+  const auto version = m_data[0] & ~(super_chunk_flag | dedup_flag);
+  if (version != static_cast<uint8_t>(SPERR_VERSION_MAJOR))
+    return RTNType::VersionMismatch;
+  const auto tools = SPERR3D_Stream_Tools();
+  const auto header_len = tools.get_header_len(magic);
+  if (header_len == 0)
+    return RTNType::SliceVolumeMismatch;
+  if (header_len > m_len)
+    return RTNType::WrongLength;
+
+  m_header = tools.get_stream_header(m_data);
+  if (m_header.stream_len != m_len)
+    return RTNType::WrongLength;
+  auto eq0 = [](auto v) { return v == 0; };
+  if (std::any_of(m_header.vol_dims.cbegin(), m_header.vol_dims.cend(), eq0) ||
+      std::any_of(m_header.chunk_dims.cbegin(), m_header.chunk_dims.cend(), eq0))
+    return RTNType::Error;
+  m_chunks = sperr::chunk_volume(m_header.vol_dims, m_header.chunk_dims);
+  if (m_header.chunk_sources.size() != m_chunks.size())
+    return RTNType::Error;
+
+  return RTNType::Good;
+}
+
+auto sperr::SPERR3D_Stream::data() const -> const uint8_t*
+{
+  return m_data;
+}
+
+auto sperr::SPERR3D_Stream::size() const -> size_t
+{
+  return m_len;
+}
+
+auto sperr::SPERR3D_Stream::view_header() const -> const SPERR3D_Header&
+{
+  return m_header;
+}
+
+auto sperr::SPERR3D_Stream::view_chunks() const -> const std::vector<std::array<size_t, 6>>&
+{
+  return m_chunks;
+}
+
+auto sperr::Decoder_Pool::acquire() -> std::unique_ptr<SPECK3D_FLT>
+{
+  {
+    auto lock = std::lock_guard(m_mutex);
+    if (!m_idle.empty()) {
+      auto p = std::move(m_idle.back());
+      m_idle.pop_back();
+      return p;
+    }
+  }
+  return std::make_unique<SPECK3D_FLT>();
+}
+
+void sperr::Decoder_Pool::release(std::unique_ptr<SPECK3D_FLT> p)
+{
+  if (p == nullptr)
+    return;
+  auto lock = std::lock_guard(m_mutex);
+  if (m_max_idle == 0 || m_idle.size() < m_max_idle)
+    m_idle.push_back(std::move(p));
+}
+
+void sperr::Decoder_Pool::set_max_idle(size_t n)
+{
+  auto lock = std::lock_guard(m_mutex);
+  m_max_idle = n;
+  if (n > 0 && m_idle.size() > n)
+    m_idle.resize(n);
+}
+
+auto sperr::Decoder_Pool::num_idle() const -> size_t
+{
+  auto lock = std::lock_guard(m_mutex);
+  return m_idle.size();
+}
@@ -10,37 +10,23 @@
 
 auto sperr::SPERR3D_Stream_Tools::get_header_len(std::array<uint8_t, 20> magic) const -> size_t
 {
-  // Step 1: Decode the 8 booleans, and decide if there are multiple chunks.
-  const auto b8 = sperr::unpack_8_booleans(magic[1]);
-  const auto multi_chunk = b8[3];
+  // Step 1: Decode the 8 booleans, and extract volume and chunk dimensions.
+  auto header = SPERR3D_Header();
+  const auto magic_len = m_read_dims(magic.data(), header);
+  if (magic_len == 0)
+    return 0;
 
-  // Step 2: Extract volume and chunk dimensions
-  size_t pos = 2;
-  uint32_t int3[3] = {0, 0, 0};
-  std::memcpy(int3, magic.data() + pos, sizeof(int3));
-  pos += sizeof(int3);
-  dims_type vdim = {int3[0], int3[1], int3[2]};
-  dims_type cdim = {int3[0], int3[1], int3[2]};
-  if (multi_chunk) {
-    uint16_t short3[3] = {0, 0, 0};
-    std::memcpy(short3, magic.data() + pos, sizeof(short3));
-    pos += sizeof(short3);
-    cdim[0] = short3[0];
-    cdim[1] = short3[1];
-    cdim[2] = short3[2];
-  }
-
-  // Step 3: figure out how many chunks are there, and the header length.
-  auto chunks = sperr::chunk_volume(vdim, cdim);
+  // Step 2: figure out how many chunks are there, and the header length.
+  auto chunks = sperr::chunk_volume(header.vol_dims, header.chunk_dims);
   const auto num_chunks = chunks.size();
-  assert((multi_chunk && num_chunks > 1) || (!multi_chunk && num_chunks == 1));
-  size_t header_len = num_chunks * 4;
-  if (multi_chunk)
-    header_len += m_header_magic_nchunks;
-  else
-    header_len += m_header_magic_1chunk;
+  assert((header.multi_chunk && num_chunks > 1) || (!header.multi_chunk && num_chunks == 1));
 
-  return header_len;
+  auto len = magic_len + num_chunks * 4;
+  if (magic[0] & super_chunk_flag)
+    len += m_super_bytes;
+  if (header.has_stats)
+    len += num_chunks * m_stats_bytes;
+  return len;
 }
 
 auto sperr::SPERR3D_Stream_Tools::get_stream_header(const void* p) const -> SPERR3D_Header
@@ -48,34 +34,25 @@ auto sperr::SPERR3D_Stream_Tools::get_stream_header(const void* p) const -> SPER
   SPERR3D_Header header;
   const auto* const u8p = static_cast<const uint8_t*>(p);
 
-  // Step 1: major version number
-  header.major_version = u8p[0];
-  size_t pos = 1;
-
-  // Step 2: unpack 8 booleans.
-  const auto b8 = sperr::unpack_8_booleans(u8p[pos++]);
-  header.is_portion = b8[0];
-  header.is_3D = b8[1];
-  header.is_float = b8[2];
-  header.multi_chunk = b8[3];
+  // Step 1: major version number, and if chunks are grouped into super-chunks or deduplicated.
+  header.major_version = u8p[0] & ~(super_chunk_flag | dedup_flag);
+  header.super_chunks = u8p[0] & super_chunk_flag;
+  const bool dedup = u8p[0] & dedup_flag;
 
-  // Step 3: volume and chunk dimensions
-  uint32_t int3[3] = {0, 0, 0};
-  std::memcpy(int3, u8p + pos, sizeof(int3));
-  pos += sizeof(int3);
-  header.vol_dims[0] = int3[0];
-  header.vol_dims[1] = int3[1];
-  header.vol_dims[2] = int3[2];
-  if (header.multi_chunk) {
-    uint16_t short3[3] = {0, 0, 0};
+  // Step 2: unpack 8 booleans, and volume and chunk dimensions.
+  auto pos = m_read_dims(u8p, header);
+  if (pos == 0)
+    return header;
+  if (header.super_chunks) {
+    assert(header.multi_chunk);
+    uint16_t short3[3] = {1, 1, 1};
     std::memcpy(short3, u8p + pos, sizeof(short3));
-    pos += sizeof(short3);
-    header.chunk_dims[0] = short3[0];
-    header.chunk_dims[1] = short3[1];
-    header.chunk_dims[2] = short3[2];
+    uint32_t stripe = 1;
+    std::memcpy(&stripe, u8p + pos + sizeof(short3), sizeof(stripe));
+    pos += m_super_bytes;
+    header.super_dims = {short3[0], short3[1], short3[2]};
+    header.stripe = std::max(stripe, uint32_t{1});
   }
-  else
-    header.chunk_dims = header.vol_dims;
 
   auto chunks = sperr::chunk_volume(header.vol_dims, header.chunk_dims);
   const auto num_chunks = chunks.size();
@@ -84,21 +61,70 @@ auto sperr::SPERR3D_Stream_Tools::get_stream_header(const void* p) const -> SPER
   else
     assert(num_chunks == 1);
 
-  // Step 4: derived info!
-  if (header.multi_chunk)
-    header.header_len = m_header_magic_nchunks + num_chunks * 4;
-  else
-    header.header_len = m_header_magic_1chunk + num_chunks * 4;
+  // Step 3: derived info!
+  header.header_len = pos + num_chunks * 4;
+  if (header.has_stats)
+    header.header_len += num_chunks * m_stats_bytes;
 
+  // Chunk bitstreams follow the header in the order of chunks, or with super-chunks, in the
+  //    order of super-chunks, each of which starts at a multiple of the stripe size.
   const auto* chunk_len = reinterpret_cast<const uint32_t*>(u8p + pos);
-  header.stream_len = std::accumulate(chunk_len, chunk_len + num_chunks, header.header_len);
-
   header.chunk_offsets.resize(num_chunks * 2);
-  header.chunk_offsets[0] = header.header_len;
-  header.chunk_offsets[1] = chunk_len[0];
-  for (size_t i = 1; i < num_chunks; i++) {
-    header.chunk_offsets[i * 2] = header.chunk_offsets[i * 2 - 2] + header.chunk_offsets[i * 2 - 1];
+  header.chunk_sources.resize(num_chunks);
+  auto is_ref = [chunk_len, dedup](size_t i) { return dedup && (chunk_len[i] & chunk_ref_flag); };
+  auto place = [&header, chunk_len, is_ref](size_t i, size_t& offset) {
+    header.chunk_sources[i] = i;
+    if (is_ref(i))
+      return;
+    header.chunk_offsets[i * 2] = offset;
     header.chunk_offsets[i * 2 + 1] = chunk_len[i];
+    offset += chunk_len[i];
+  };
+  header.stream_len = header.header_len;
+  if (header.super_chunks) {
+    const auto supers =
+        sperr::super_chunk_volume(header.vol_dims, header.chunk_dims, header.super_dims);
+    header.super_offsets.reserve(supers.size() * 2);
+    for (const auto& members : supers) {
+      const auto stripe = header.stripe;
+      header.stream_len = (header.stream_len + stripe - 1) / stripe * stripe;
+      header.super_offsets.push_back(header.stream_len);
+      for (auto i : members)
+        place(i, header.stream_len);
+      header.super_offsets.push_back(header.stream_len - header.super_offsets.back());
+    }
+  }
+  else {
+    for (size_t i = 0; i < num_chunks; i++)
+      place(i, header.stream_len);
+  }
+
+  // A deduplicated chunk takes the offset and length of the bitstream that it refers to, which
+  //    has to be an earlier chunk that has its own bitstream.
+  for (size_t i = 0; i < num_chunks; i++) {
+    if (is_ref(i)) {
+      const auto src = size_t{chunk_len[i] & ~chunk_ref_flag};
+      if (src >= i || header.chunk_sources[src] != src) {
+        header.chunk_offsets.clear();
+        header.chunk_sources.clear();
+        break;
+      }
+      header.chunk_sources[i] = src;
+      header.chunk_offsets[i * 2] = header.chunk_offsets[src * 2];
+      header.chunk_offsets[i * 2 + 1] = header.chunk_offsets[src * 2 + 1];
+    }
+  }
+
+  // Step 4: the statistics index, if present, follows the chunk lengths.
+  if (header.has_stats) {
+    header.chunk_stats.resize(num_chunks);
+    const auto* index = u8p + pos + num_chunks * 4;
+    for (auto& stats : header.chunk_stats) {
+      auto d4 = std::array<double, 4>();
+      std::memcpy(d4.data(), index, sizeof(d4));
+      index += sizeof(d4);
+      stats = {d4[0], d4[1], d4[2], d4[3]};
+    }
   }
 
   return header;
@@ -155,6 +181,144 @@ auto sperr::SPERR3D_Stream_Tools::progressive_truncate(const void* stream,
   return stream_new;
 }
 
+auto sperr::SPERR3D_Stream_Tools::query_range(const void* stream,
+                                              dims_type start,
+                                              dims_type len) const -> std::optional<Range_Result>
+{
+  const auto header = this->get_stream_header(stream);
+  if (!header.has_stats)
+    return std::nullopt;
+  for (size_t i = 0; i < 3; i++) {
+    if (len[i] == 0 || start[i] + len[i] > header.vol_dims[i])
+      return std::nullopt;
+  }
+
+  // Chunks fully covered by the box contribute their exact min and max, while partially
+  //    covered chunks only bound the answer.
+  const auto chunks = sperr::chunk_volume(header.vol_dims, header.chunk_dims);
+  auto full_min = std::numeric_limits<double>::max();
+  auto full_max = std::numeric_limits<double>::lowest();
+  auto partial = std::vector<size_t>();
+  auto result = Range_Result();
+  result.min = full_min;
+  result.max = full_max;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    const auto& c = chunks[i];
+    auto touched = true, covered = true;
+    for (size_t d = 0; d < 3; d++) {
+      const auto c_beg = c[d * 2], c_end = c[d * 2] + c[d * 2 + 1];
+      touched = touched && c_beg < start[d] + len[d] && start[d] < c_end;
+      covered = covered && start[d] <= c_beg && c_end <= start[d] + len[d];
+    }
+    if (!touched)
+      continue;
+    const auto& stats = header.chunk_stats[i];
+    result.min = std::min(result.min, stats.min);
+    result.max = std::max(result.max, stats.max);
+    if (covered) {
+      full_min = std::min(full_min, stats.min);
+      full_max = std::max(full_max, stats.max);
+    }
+    else
+      partial.push_back(i);
+  }
+
+  // A partially covered chunk needs decoding only if it could extend the exact range.
+  for (auto i : partial) {
+    const auto& stats = header.chunk_stats[i];
+    if (stats.min < full_min || stats.max > full_max)
+      result.to_decode.push_back(i);
+  }
+
+  return result;
+}
+
+auto sperr::SPERR3D_Stream_Tools::query_threshold(const void* stream, double thld) const
+    -> std::optional<Threshold_Result>
+{
+  const auto header = this->get_stream_header(stream);
+  if (!header.has_stats)
+    return std::nullopt;
+
+  auto result = Threshold_Result();
+  for (size_t i = 0; i < header.chunk_stats.size(); i++) {
+    const auto& stats = header.chunk_stats[i];
+    if (stats.min > thld)
+      result.above.push_back(i);
+    else if (stats.max > thld)
+      result.to_decode.push_back(i);
+  }
+
+  return result;
+}
+
+auto sperr::SPERR3D_Stream_Tools::region_sections(const void* stream,
+                                                  dims_type start,
+                                                  dims_type len) const -> std::vector<size_t>
+{
+  auto sections = std::vector<size_t>();
+  const auto header = this->get_stream_header(stream);
+  if (header.chunk_sources.empty())
+    return sections;
+  for (size_t i = 0; i < 3; i++) {
+    if (len[i] == 0 || start[i] + len[i] > header.vol_dims[i])
+      return sections;
+  }
+
+  // Find the chunks whose bitstreams are needed, including those shared by duplicate chunks.
+  const auto chunks = sperr::chunk_volume(header.vol_dims, header.chunk_dims);
+  auto needed = std::vector<bool>(chunks.size(), false);
+  for (size_t i = 0; i < chunks.size(); i++) {
+    const auto& c = chunks[i];
+    auto touched = true;
+    for (size_t d = 0; d < 3; d++)
+      touched = touched && c[d * 2] < start[d] + len[d] && start[d] < c[d * 2] + c[d * 2 + 1];
+    if (touched)
+      needed[header.chunk_sources[i]] = true;
+  }
+
+  // With super-chunks, whole super-chunks are read. Sections are in increasing offsets in both
+  //    cases, and the ones separated by less than a stripe of padding are merged.
+  auto add = [&sections, stripe = header.stripe](size_t offset, size_t n) {
+    if (n == 0)
+      return;
+    const auto n_sec = sections.size();
+    if (n_sec > 0 && offset < sections[n_sec - 2] + sections[n_sec - 1] + stripe)
+      sections[n_sec - 1] = offset + n - sections[n_sec - 2];
+    else {
+      sections.push_back(offset);
+      sections.push_back(n);
+    }
+  };
+  if (header.super_chunks) {
+    const auto supers =
+        sperr::super_chunk_volume(header.vol_dims, header.chunk_dims, header.super_dims);
+    auto is_needed = [&needed](auto i) { return needed[i]; };
+    for (size_t s = 0; s < supers.size(); s++) {
+      if (std::any_of(supers[s].cbegin(), supers[s].cend(), is_needed))
+        add(header.super_offsets[s * 2], header.super_offsets[s * 2 + 1]);
+    }
+  }
+  else {
+    for (size_t i = 0; i < chunks.size(); i++) {
+      if (needed[i])
+        add(header.chunk_offsets[i * 2], header.chunk_offsets[i * 2 + 1]);
+    }
+  }
+
+  return sections;
+}
+
+auto sperr::SPERR3D_Stream_Tools::progressive_chunk_len(size_t chunk_len, unsigned pct) const
+    -> size_t
+{
+  // Only shorten a chunk if it's bigger than the minimal number of bytes to keep.
+  if (pct == 0 || pct >= 100 || chunk_len <= m_progressive_min_chunk_bytes)
+    return chunk_len;
+  auto request_len = static_cast<size_t>(double(pct) / 100.0 * double(chunk_len));
+  return std::max(m_progressive_min_chunk_bytes, request_len);
+}
+
 auto sperr::SPERR3D_Stream_Tools::m_progressive_helper(const void* header_buf,
                                                        size_t buf_len,
                                                        unsigned pct) const
@@ -166,15 +330,33 @@ auto sperr::SPERR3D_Stream_Tools::m_progressive_helper(const void* header_buf,
   // Parse the header.
   //
   auto header = this->get_stream_header(header_buf);
+  if (header.chunk_sources.empty())
+    return rtn_val;
 
-  // If the request is beyond range, return the complete bitstream!
+  // Only chunks with their own bitstreams are accessed; deduplicated chunks share them.
   //
-  if (pct == 0 || pct >= 100) {
+  auto unique_sections = [&header]() {
+    auto sections = std::vector<size_t>();
+    sections.reserve(header.chunk_offsets.size());
+    for (size_t i = 0; i < header.chunk_sources.size(); i++) {
+      if (header.chunk_sources[i] == i) {
+        sections.push_back(header.chunk_offsets[i * 2]);
+        sections.push_back(header.chunk_offsets[i * 2 + 1]);
+      }
+    }
+    return sections;
+  };
+
+  // If the request is beyond range, return the complete bitstream! Bitstreams with super-chunks
+  //    are rewritten with chunks in order though, as their alignment is lost in a new file.
+  //
+  const auto complete = (pct == 0 || pct >= 100);
+  if (complete && !header.super_chunks) {
     // Copy over the header.
     std::get<0>(rtn_val).reserve(header.header_len);
     std::copy(u8p, u8p + header.header_len, std::back_inserter(std::get<0>(rtn_val)));
     // Copy over the chunks info
-    std::get<1>(rtn_val) = std::move(header.chunk_offsets);
+    std::get<1>(rtn_val) = unique_sections();
     return rtn_val;
   }
 
@@ -184,43 +366,72 @@ auto sperr::SPERR3D_Stream_Tools::m_progressive_helper(const void* header_buf,
   assert(header.chunk_offsets.size() % 2 == 0);
   auto nchunks = header.chunk_offsets.size() / 2;
   for (size_t i = 0; i < nchunks; i++) {
-    // Only touch the value stored at `chunk_offsets_new[i * 2 + 1]` if it's bigger than
-    // the minimal number of bytes to keep.
-    auto orig_len = header.chunk_offsets[i * 2 + 1];
-    if (orig_len > m_progressive_min_chunk_bytes) {
-      auto request_len = static_cast<size_t>(double(pct) / 100.0 * double(orig_len));
-      request_len = std::max(m_progressive_min_chunk_bytes, request_len);
-      header.chunk_offsets[i * 2 + 1] = request_len;
-    }
+    auto& len = header.chunk_offsets[i * 2 + 1];
+    len = progressive_chunk_len(len, pct);
   }
 
-  // Finally, create a new header.
+  // Finally, create a new header, which drops the super-chunk dimensions and stripe size, but
+  //    keeps the deduplicated chunks.
   //
-  auto header_new = vec8_type(header.header_len);
-  header_new[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+  const auto super_bytes = header.super_chunks ? m_super_bytes : 0;
+  const auto stats_bytes = header.has_stats ? nchunks * m_stats_bytes : 0;
+  auto header_new = vec8_type(header.header_len - super_bytes);
+  header_new[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR) | (u8p[0] & dedup_flag);
   size_t pos = 1;
   auto b8 = sperr::unpack_8_booleans(u8p[pos]);
-  b8[0] = true;  // Record that this is a portion of another complete bitstream.
+  if (!complete)
+    b8[0] = true;  // Record that this is a portion of another complete bitstream.
   header_new[pos++] = sperr::pack_8_booleans(b8);
-  // Copy over the volume and chunk dimensions.
-  if (header.multi_chunk) {
-    std::copy(u8p + pos, u8p + m_header_magic_nchunks, header_new.begin() + pos);
-    pos = m_header_magic_nchunks;
-  }
-  else {
-    std::copy(u8p + pos, u8p + m_header_magic_1chunk, header_new.begin() + pos);
-    pos = m_header_magic_1chunk;
-  }
+  // Copy over the volume and chunk dimensions, and the statistics index which stays valid.
+  const auto dims_end = header.header_len - super_bytes - nchunks * 4 - stats_bytes;
+  std::copy(u8p + pos, u8p + dims_end, header_new.begin() + pos);
+  std::copy(u8p + header.header_len - stats_bytes, u8p + header.header_len,
+            header_new.end() - stats_bytes);
+  pos = dims_end;
 
-  // Record the length of bitstreams for each chunk.
+  // Record the length of bitstreams for each chunk, or the chunk it refers to.
   for (size_t i = 0; i < nchunks; i++) {
     uint32_t len = header.chunk_offsets[i * 2 + 1];
+    if (header.chunk_sources[i] != i)
+      len = chunk_ref_flag | static_cast<uint32_t>(header.chunk_sources[i]);
     std::memcpy(&header_new[pos], &len, sizeof(len));
     pos += sizeof(len);
   }
-  assert(pos == header.header_len);
+  assert(pos + stats_bytes == header_new.size());
   std::get<0>(rtn_val) = std::move(header_new);
-  std::get<1>(rtn_val) = std::move(header.chunk_offsets);
+  std::get<1>(rtn_val) = unique_sections();
 
   return rtn_val;
 }
+
+auto sperr::SPERR3D_Stream_Tools::m_read_dims(const uint8_t* p, SPERR3D_Header& header) const
+    -> size_t
+{
+  const auto b8 = sperr::unpack_8_booleans(p[1]);
+  header.is_portion = b8[0];
+  header.is_3D = b8[1];
+  header.is_float = b8[2];
+  header.multi_chunk = b8[3];
+  if (!header.is_3D && (b8[4] || b8[5] || !b8[6]))
+    return 0;  // 1D arrays, stacks of 2D slices, or 2D slices without chunk lengths.
+  header.has_stats = header.is_3D && b8[4];
+  header.data_type = header.is_3D ? sperr::decode_data_type(b8)
+                                  : (header.is_float ? DataType::Float : DataType::Double);
+  size_t pos = 2;
+
+  // 3D volumes record 3 dimensions, and 2D slices (SPERR2D_OMP_C) record 2 dimensions.
+  const size_t ndims = header.is_3D ? 3 : 2;
+  uint32_t int3[3] = {1, 1, 1};
+  std::memcpy(int3, p + pos, sizeof(uint32_t) * ndims);
+  pos += sizeof(uint32_t) * ndims;
+  header.vol_dims = {int3[0], int3[1], int3[2]};
+  header.chunk_dims = header.vol_dims;
+  if (header.multi_chunk) {
+    uint16_t short3[3] = {1, 1, 1};
+    std::memcpy(short3, p + pos, sizeof(uint16_t) * ndims);
+    pos += sizeof(uint16_t) * ndims;
+    header.chunk_dims = {short3[0], short3[1], short3[2]};
+  }
+
+  return pos;
+}
@@ -1,55 +1,78 @@
 #include <cassert>
+#include <new>  // std::nothrow
 
 #include "SPERR_C_API.h"
 
 #include "SPECK2D_FLT.h"
+#include "SPERR1D_OMP_C.h"
+#include "SPERR1D_OMP_D.h"
+#include "SPERR2D_Stack_C.h"
+#include "SPERR2D_Stack_D.h"
 #include "SPERR3D_OMP_C.h"
 #include "SPERR3D_OMP_D.h"
 
 #include "SPERR3D_Stream_Tools.h"
 
-int C_API::sperr_comp_2d(const void* src,
-                         int is_float,
-                         size_t dimx,
-                         size_t dimy,
-                         int mode,
-                         double quality,
-                         int out_inc_header,
-                         void** dst,
-                         size_t* dst_len)
+namespace {
+
+// Compress a 2D slice using `encoder`. It returns the same values as sperr_comp_2d().
+auto comp_2d_encoder(const void* src,
+                     int is_float,
+                     size_t dimx,
+                     size_t dimy,
+                     int mode,
+                     double quality,
+                     sperr::SPECK2D_FLT& encoder) -> int
 {
-  // Examine if `dst` is pointing to a NULL pointer
-  if (*dst != nullptr)
-    return 1;
   if (quality <= 0.0)
     return 2;
 
   // The actual encoding steps are just the same as in `utilities/sperr2d.cpp`.
-  auto encoder = std::make_unique<sperr::SPECK2D_FLT>();
-  encoder->set_dims({dimx, dimy, 1});
+  encoder.set_dims({dimx, dimy, 1});
   if (is_float)
-    encoder->copy_data(static_cast<const float*>(src), dimx * dimy);
+    encoder.copy_data(static_cast<const float*>(src), dimx * dimy);
   else
-    encoder->copy_data(static_cast<const double*>(src), dimx * dimy);
+    encoder.copy_data(static_cast<const double*>(src), dimx * dimy);
 
   switch (mode) {
     case 1:  // fixed bitrate
-      encoder->set_bitrate(quality);
+      encoder.set_bitrate(quality);
       break;
     case 2:  // fixed PSNR
-      encoder->set_psnr(quality);
+      encoder.set_psnr(quality);
       break;
     case 3:  // fixed PWE
-      encoder->set_tolerance(quality);
+      encoder.set_tolerance(quality);
       break;
     default:
       return 2;
   }
-  auto rtn = encoder->compress();
-  if (rtn != sperr::RTNType::Good)
+  if (encoder.compress() != sperr::RTNType::Good)
     return -1;
 
-  auto stream = sperr::vec8_type();
+  return 0;
+}
+
+// Size (in byte) of the header that sperr_comp_2d() optionally puts in front of a bitstream.
+constexpr size_t header_2d_len = 10;
+
+// Write the bitstream held by `encoder` to `dst`, optionally with a header in front of it.
+//    It returns the same values as sperr_comp_2d_into().
+auto write_2d_stream(const sperr::SPECK2D_FLT& encoder,
+                     int is_float,
+                     size_t dimx,
+                     size_t dimy,
+                     int out_inc_header,
+                     void* dst,
+                     size_t dst_cap,
+                     size_t* dst_len) -> int
+{
+  const auto hdr_len = out_inc_header ? header_2d_len : size_t{0};
+  *dst_len = hdr_len + encoder.encoded_bitstream_len();
+  if (dst_cap < *dst_len)
+    return 1;
+
+  auto* const ptr = static_cast<uint8_t*>(dst);
   if (out_inc_header) {  // Assemble a header that's the same as the header in SPERR3D_OMP_C().
     // The header would contain the following information
     //  -- a version number                     (1 byte)
@@ -58,8 +81,7 @@ int C_API::sperr_comp_2d(const void* src,
     //
 
     // Version number
-    stream.resize(10);
-    stream[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
+    ptr[0] = static_cast<uint8_t>(SPERR_VERSION_MAJOR);
 
     // 8 booleans:
     // bool[0]  : if this bitstream is a portion of another complete bitstream (progressive access).
@@ -75,26 +97,175 @@ int C_API::sperr_comp_2d(const void* src,
                                false,   // unused
                                false,   // unused
                                false};  // unused
-    stream[1] = sperr::pack_8_booleans(b8);
+    ptr[1] = sperr::pack_8_booleans(b8);
 
     // Slice dimension
     auto dims = std::array{static_cast<uint32_t>(dimx), static_cast<uint32_t>(dimy)};
-    std::memcpy(stream.data() + 2, dims.data(), sizeof(dims));
+    std::memcpy(ptr + 2, dims.data(), sizeof(dims));
   }
 
-  // Append the actual SPERR bitstream.
-  encoder->append_encoded_bitstream(stream);
-  encoder.reset();  // Free up some memory.
+  // Write the actual SPERR bitstream.
+  if (encoder.write_encoded_bitstream(ptr + hdr_len, dst_cap - hdr_len) != sperr::RTNType::Good)
+    return -1;
 
-  // Allocate buffer and copy over the content of stream.
-  *dst_len = stream.size();
-  auto* buf = (uint8_t*)std::malloc(*dst_len);
-  std::copy(stream.cbegin(), stream.cend(), buf);
+  return 0;
+}
+
+// Compress a 3D volume using `encoder`. It returns the same values as sperr_comp_3d().
+auto comp_3d_encoder(const void* src,
+                     int is_float,
+                     size_t dimx,
+                     size_t dimy,
+                     size_t dimz,
+                     size_t chunk_x,
+                     size_t chunk_y,
+                     size_t chunk_z,
+                     int mode,
+                     double quality,
+                     size_t nthreads,
+                     sperr::SPERR3D_OMP_C& encoder) -> int
+{
+  if (quality <= 0.0)
+    return 2;
+
+  const auto dims = sperr::dims_type{dimx, dimy, dimz};
+  const auto chunks = sperr::dims_type{chunk_x, chunk_y, chunk_z};
+
+  // Setup the compressor. Very similar steps as in `utilities/sperr3d.cpp`.
+  const auto total_vals = dimx * dimy * dimz;
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_num_threads(nthreads);
+  switch (mode) {
+    case 1:  // fixed bitrate
+      encoder.set_bitrate(quality);
+      break;
+    case 2:  // fixed PSNR
+      encoder.set_psnr(quality);
+      break;
+    case 3:  // fixed PWE
+      encoder.set_tolerance(quality);
+      break;
+    default:
+      return 2;
+  }
+  auto rtn = sperr::RTNType::Good;
+  if (is_float)
+    rtn = encoder.compress(static_cast<const float*>(src), total_vals);
+  else  // double
+    rtn = encoder.compress(static_cast<const double*>(src), total_vals);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+
+  return 0;
+}
+
+// Write the bitstream held by `encoder` to `dst`. It returns the same values as
+//    sperr_comp_3d_into().
+auto write_3d_stream(const sperr::SPERR3D_OMP_C& encoder,
+                     void* dst,
+                     size_t dst_cap,
+                     size_t* dst_len) -> int
+{
+  *dst_len = encoder.encoded_bitstream_len();
+  if (*dst_len == 0)
+    return -1;
+  if (dst_cap < *dst_len)
+    return 1;
+  if (encoder.write_encoded_bitstream(dst, dst_cap) != sperr::RTNType::Good)
+    return -1;
+
+  return 0;
+}
+
+// Worst-case size (in byte) of a SPECK_FLT bitstream encoding `len` values.
+auto chunk_comp_bound(size_t len, int mode, double quality) -> size_t
+{
+  // In each of (at most) 64 bitplanes, a SPECK encoder outputs at most 1 bit for every set
+  //    in the partition tree (fewer than 2 * len + 64 sets) and 1 bit for every coefficient,
+  //    plus 1 sign bit for every coefficient in total.
+  const auto speck_bits = size_t{64} * (size_t{3} * len + 64) + len;
+  const auto speck_bytes = sperr::SPECK_INT<uint8_t>::header_size + (speck_bits + 7) / 8;
+  const auto condi_bytes = sperr::condi_type().size();
+
+  switch (mode) {
+    case 1: {  // fixed bitrate: the encoder stops when the bit budget is met.
+      const auto budget = static_cast<size_t>(quality * double(len));
+      const auto budget_bytes = sperr::SPECK_INT<uint8_t>::header_size + (budget + 7) / 8;
+      return condi_bytes + std::min(speck_bytes, budget_bytes);
+    }
+    case 3:  // fixed PWE: there could be an outlier coder bitstream too.
+      return condi_bytes + speck_bytes * 2;
+    default:
+      return condi_bytes + speck_bytes;
+  }
+}
+
+// Copy a profile breakdown to `buf` with snprintf() semantics.
+auto copy_profile_string(const sperr::Profile& prof, char* buf, size_t buf_len) -> size_t
+{
+  const auto str = prof.to_string();
+  if (buf != nullptr && buf_len > 0) {
+    const auto n = std::min(str.size(), buf_len - 1);
+    std::copy(str.cbegin(), str.cbegin() + n, buf);
+    buf[n] = '\0';
+  }
+  return str.size();
+}
+
+}  // namespace
+
+int C_API::sperr_comp_2d(const void* src,
+                         int is_float,
+                         size_t dimx,
+                         size_t dimy,
+                         int mode,
+                         double quality,
+                         int out_inc_header,
+                         void** dst,
+                         size_t* dst_len)
+{
+  // Examine if `dst` is pointing to a NULL pointer
+  if (*dst != nullptr)
+    return 1;
+
+  auto encoder = std::make_unique<sperr::SPECK2D_FLT>();
+  auto rtn = comp_2d_encoder(src, is_float, dimx, dimy, mode, quality, *encoder);
+  if (rtn != 0)
+    return rtn;
+
+  // Allocate a buffer of the exact size, and write the bitstream to it.
+  const auto hdr_len = out_inc_header ? header_2d_len : size_t{0};
+  const auto len = hdr_len + encoder->encoded_bitstream_len();
+  auto* buf = std::malloc(len);
+  rtn = write_2d_stream(*encoder, is_float, dimx, dimy, out_inc_header, buf, len, dst_len);
+  if (rtn != 0) {
+    std::free(buf);
+    return -1;
+  }
   *dst = buf;
 
   return 0;
 }
 
+int C_API::sperr_comp_2d_into(const void* src,
+                              int is_float,
+                              size_t dimx,
+                              size_t dimy,
+                              int mode,
+                              double quality,
+                              int out_inc_header,
+                              void* dst,
+                              size_t dst_cap,
+                              size_t* dst_len)
+{
+  auto encoder = std::make_unique<sperr::SPECK2D_FLT>();
+  auto rtn = comp_2d_encoder(src, is_float, dimx, dimy, mode, quality, *encoder);
+  if (rtn != 0)
+    return rtn;
+
+  return write_2d_stream(*encoder, is_float, dimx, dimy, out_inc_header, dst, dst_cap, dst_len);
+}
+
 int C_API::sperr_decomp_2d(const void* src,
                            size_t src_len,
                            int output_float,
@@ -143,8 +314,19 @@ void C_API::sperr_parse_header(const void* src,
   auto is_3d = b8[1];
   *is_float = int(b8[2]);
 
+  // 1D arrays record their length using a uint64_t.
+  if (!is_3d && b8[4]) {
+    uint64_t len = 0;
+    std::memcpy(&len, srcp + 2, sizeof(len));
+    *dimx = len;
+    *dimy = 1;
+    *dimz = 1;
+    return;
+  }
+
+  // Stacks of 2D slices record the number of slices after the slice dimensions.
   auto dims = std::array<uint32_t, 3>{1, 1, 1};
-  if (is_3d)
+  if (is_3d || b8[5])
     std::memcpy(dims.data(), srcp + 2, sizeof(uint32_t) * 3);
   else
     std::memcpy(dims.data(), srcp + 2, sizeof(uint32_t) * 2);
@@ -170,16 +352,146 @@ int C_API::sperr_comp_3d(const void* src,
   // Examine if `dst` is pointing to a NULL pointer
   if (*dst != nullptr)
     return 1;
-  if (quality <= 0.0)
-    return 2;
 
-  const auto dims = sperr::dims_type{dimx, dimy, dimz};
-  const auto chunks = sperr::dims_type{chunk_x, chunk_y, chunk_z};
+  auto encoder = std::make_unique<sperr::SPERR3D_OMP_C>();
+  auto rtn = comp_3d_encoder(src, is_float, dimx, dimy, dimz, chunk_x, chunk_y, chunk_z, mode,
+                             quality, nthreads, *encoder);
+  if (rtn != 0)
+    return rtn;
 
-  // Setup the compressor. Very similar steps as in `utilities/sperr3d.cpp`.
-  const auto total_vals = dimx * dimy * dimz;
+  // Prepare the compressed bitstream.
+  auto stream = encoder->get_encoded_bitstream();
+  if (stream.empty())
+    return -1;
+  encoder.reset();
+  *dst_len = stream.size();
+  auto* buf = (uint8_t*)std::malloc(stream.size());
+  std::copy(stream.cbegin(), stream.cend(), buf);
+  *dst = buf;
+
+  return 0;
+}
+
+int C_API::sperr_comp_3d_into(const void* src,
+                              int is_float,
+                              size_t dimx,
+                              size_t dimy,
+                              size_t dimz,
+                              size_t chunk_x,
+                              size_t chunk_y,
+                              size_t chunk_z,
+                              int mode,
+                              double quality,
+                              size_t nthreads,
+                              void* dst,
+                              size_t dst_cap,
+                              size_t* dst_len)
+{
   auto encoder = std::make_unique<sperr::SPERR3D_OMP_C>();
-  encoder->set_dims_and_chunks(dims, chunks);
+  auto rtn = comp_3d_encoder(src, is_float, dimx, dimy, dimz, chunk_x, chunk_y, chunk_z, mode,
+                             quality, nthreads, *encoder);
+  if (rtn != 0)
+    return rtn;
+
+  // Write the compressed bitstream directly to `dst`.
+  return write_3d_stream(*encoder, dst, dst_cap, dst_len);
+}
+
+size_t C_API::sperr_comp_bound(size_t dimx,
+                               size_t dimy,
+                               size_t dimz,
+                               size_t chunk_x,
+                               size_t chunk_y,
+                               size_t chunk_z,
+                               int mode,
+                               double quality)
+{
+  if (dimx == 0 || dimy == 0 || dimz == 0 || quality <= 0.0 || mode < 1 || mode > 3)
+    return 0;
+
+  // Follow the same chunking logic as in `SPERR3D_OMP_C`.
+  const auto vol_dims = sperr::dims_type{dimx, dimy, dimz};
+  auto chunk_dims = sperr::dims_type{chunk_x, chunk_y, chunk_z};
+  for (size_t i = 0; i < chunk_dims.size(); i++)
+    chunk_dims[i] = std::min(std::max(size_t{1}, chunk_dims[i]), vol_dims[i]);
+  const auto chunks = sperr::chunk_volume(vol_dims, chunk_dims);
+
+  // The 3D header is always at least as big as the optional 2D header (10 bytes).
+  auto bound = size_t{20} + chunks.size() * 4;
+  for (const auto& c : chunks)
+    bound += chunk_comp_bound(c[1] * c[3] * c[5], mode, quality);
+
+  return bound;
+}
+
+int C_API::sperr_decomp_3d(const void* src,
+                           size_t src_len,
+                           int output_float,
+                           size_t nthreads,
+                           size_t* dimx,
+                           size_t* dimy,
+                           size_t* dimz,
+                           void** dst)
+{
+  // Examine if `dst` is pointing to a NULL pointer.
+  if (*dst != nullptr)
+    return 1;
+
+  // Use a decompressor to decompress this bitstream
+  auto decoder = std::make_unique<sperr::SPERR3D_OMP_D>();
+  decoder->set_num_threads(nthreads);
+  if (decoder->use_bitstream(src, src_len) != sperr::RTNType::Good)
+    return -1;
+  const auto dims = decoder->get_dims();
+  const auto total_vals = dims[0] * dims[1] * dims[2];
+
+  // Decode directly into an uninitialized output buffer, so its pages are first touched by
+  //    the threads that decode the corresponding chunks.
+  auto rtn = sperr::RTNType::Good;
+  void* buf = nullptr;
+  if (output_float) {
+    buf = std::malloc(total_vals * sizeof(float));
+    if (buf)
+      rtn = decoder->decompress_into(src, static_cast<float*>(buf));
+  }
+  else {  // double
+    buf = std::malloc(total_vals * sizeof(double));
+    if (buf)
+      rtn = decoder->decompress_into(src, static_cast<double*>(buf));
+  }
+  if (buf == nullptr || rtn != sperr::RTNType::Good) {
+    std::free(buf);
+    return -1;
+  }
+
+  // Provide the decompressed volume.
+  *dimx = dims[0];
+  *dimy = dims[1];
+  *dimz = dims[2];
+  *dst = buf;
+
+  return 0;
+}
+
+int C_API::sperr_comp_1d(const void* src,
+                         int is_float,
+                         size_t len,
+                         size_t chunk_len,
+                         int mode,
+                         double quality,
+                         size_t nthreads,
+                         void** dst,
+                         size_t* dst_len)
+{
+  // Examine if `dst` is pointing to a NULL pointer
+  if (*dst != nullptr)
+    return 1;
+  if (quality <= 0.0 || len == 0)
+    return 2;
+
+  // Setup the compressor.
+  auto encoder = std::make_unique<sperr::SPERR1D_OMP_C>();
+  encoder->set_length_and_chunk(len, chunk_len);
   encoder->set_num_threads(nthreads);
   switch (mode) {
     case 1:  // fixed bitrate
@@ -196,32 +508,31 @@ int C_API::sperr_comp_3d(const void* src,
   }
   auto rtn = sperr::RTNType::Good;
   if (is_float)
-    rtn = encoder->compress(static_cast<const float*>(src), total_vals);
+    rtn = encoder->compress(static_cast<const float*>(src), len);
   else  // double
-    rtn = encoder->compress(static_cast<const double*>(src), total_vals);
+    rtn = encoder->compress(static_cast<const double*>(src), len);
   if (rtn != sperr::RTNType::Good)
     return -1;
 
-  // Prepare the compressed bitstream.
-  auto stream = encoder->get_encoded_bitstream();
-  if (stream.empty())
+  // Write the compressed bitstream to a newly allocated buffer.
+  *dst_len = encoder->encoded_bitstream_len();
+  if (*dst_len == 0)
     return -1;
-  encoder.reset();
-  *dst_len = stream.size();
-  auto* buf = (uint8_t*)std::malloc(stream.size());
-  std::copy(stream.cbegin(), stream.cend(), buf);
+  auto* buf = (uint8_t*)std::malloc(*dst_len);
+  if (encoder->write_encoded_bitstream(buf, *dst_len) != sperr::RTNType::Good) {
+    std::free(buf);
+    return -1;
+  }
   *dst = buf;
 
   return 0;
 }
 
-int C_API::sperr_decomp_3d(const void* src,
+int C_API::sperr_decomp_1d(const void* src,
                            size_t src_len,
                            int output_float,
                            size_t nthreads,
-                           size_t* dimx,
-                           size_t* dimy,
-                           size_t* dimz,
+                           size_t* len,
                            void** dst)
 {
   // Examine if `dst` is pointing to a NULL pointer.
@@ -229,20 +540,111 @@ int C_API::sperr_decomp_3d(const void* src,
     return 1;
 
   // Use a decompressor to decompress this bitstream
-  auto decoder = std::make_unique<sperr::SPERR3D_OMP_D>();
+  auto decoder = std::make_unique<sperr::SPERR1D_OMP_D>();
   decoder->set_num_threads(nthreads);
-  decoder->use_bitstream(src, src_len);
-  auto rtn = decoder->decompress(src);
+  auto rtn = decoder->use_bitstream(src, src_len);
   if (rtn != sperr::RTNType::Good)
     return -1;
-  auto dims = decoder->get_dims();
-  auto outputd = decoder->release_decoded_data();
-  decoder.reset();
+  rtn = decoder->decompress(src);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+  const auto& outputd = decoder->view_decoded_data();
 
-  // Provide the decompressed volume.
-  *dimx = dims[0];
-  *dimy = dims[1];
-  *dimz = dims[2];
+  // Provide the decompressed array.
+  *len = outputd.size();
+  if (output_float) {
+    auto* buf = (float*)std::malloc(outputd.size() * sizeof(float));
+    std::copy(outputd.cbegin(), outputd.cend(), buf);
+    *dst = buf;
+  }
+  else {  // double
+    auto* buf = (double*)std::malloc(outputd.size() * sizeof(double));
+    std::copy(outputd.cbegin(), outputd.cend(), buf);
+    *dst = buf;
+  }
+
+  return 0;
+}
+
+int C_API::sperr_comp_2d_stack(const void* src,
+                               int is_float,
+                               size_t dimx,
+                               size_t dimy,
+                               size_t nslices,
+                               int mode,
+                               double quality,
+                               size_t nthreads,
+                               void** dst,
+                               size_t* dst_len)
+{
+  // Examine if `dst` is pointing to a NULL pointer
+  if (*dst != nullptr)
+    return 1;
+  if (quality <= 0.0 || dimx * dimy * nslices == 0)
+    return 2;
+
+  // Setup the compressor.
+  auto encoder = std::make_unique<sperr::SPERR2D_Stack_C>();
+  encoder->set_slice_dims({dimx, dimy, 1});
+  encoder->set_num_threads(nthreads);
+  switch (mode) {
+    case 1:  // fixed bitrate
+      encoder->set_bitrate(quality);
+      break;
+    case 2:  // fixed PSNR
+      encoder->set_psnr(quality);
+      break;
+    case 3:  // fixed PWE
+      encoder->set_tolerance(quality);
+      break;
+    default:
+      return 2;
+  }
+  const auto total_len = dimx * dimy * nslices;
+  auto rtn = sperr::RTNType::Good;
+  if (is_float)
+    rtn = encoder->compress(static_cast<const float*>(src), total_len);
+  else  // double
+    rtn = encoder->compress(static_cast<const double*>(src), total_len);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+
+  // Write the compressed bitstream to a newly allocated buffer.
+  *dst_len = encoder->encoded_bitstream_len();
+  if (*dst_len == 0)
+    return -1;
+  auto* buf = (uint8_t*)std::malloc(*dst_len);
+  if (encoder->write_encoded_bitstream(buf, *dst_len) != sperr::RTNType::Good) {
+    std::free(buf);
+    return -1;
+  }
+  *dst = buf;
+
+  return 0;
+}
+
+int C_API::sperr_decomp_2d_slice(const void* src,
+                                 size_t src_len,
+                                 int output_float,
+                                 size_t idx,
+                                 void** dst)
+{
+  // Examine if `dst` is pointing to a NULL pointer.
+  if (*dst != nullptr)
+    return 1;
+
+  auto decoder = std::make_unique<sperr::SPERR2D_Stack_D>();
+  auto rtn = decoder->use_bitstream(src, src_len);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+  if (idx >= decoder->get_num_slices())
+    return 2;
+  rtn = decoder->decompress_slice(src, idx);
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+  const auto& outputd = decoder->view_decoded_data();
+
+  // Provide the decompressed slice.
   if (output_float) {
     auto* buf = (float*)std::malloc(outputd.size() * sizeof(float));
     std::copy(outputd.cbegin(), outputd.cend(), buf);
@@ -257,6 +659,114 @@ int C_API::sperr_decomp_3d(const void* src,
   return 0;
 }
 
+struct C_API::sperr_cctx {
+  sperr::SPERR3D_OMP_C encoder;
+};
+
+struct C_API::sperr_dctx {
+  sperr::SPERR3D_OMP_D decoder;
+};
+
+C_API::sperr_cctx* C_API::sperr_cctx_create()
+{
+  return new (std::nothrow) sperr_cctx();
+}
+
+void C_API::sperr_cctx_free(sperr_cctx* ctx)
+{
+  delete ctx;
+}
+
+C_API::sperr_dctx* C_API::sperr_dctx_create()
+{
+  return new (std::nothrow) sperr_dctx();
+}
+
+void C_API::sperr_dctx_free(sperr_dctx* ctx)
+{
+  delete ctx;
+}
+
+int C_API::sperr_compress_cctx(sperr_cctx* ctx,
+                               const void* src,
+                               int is_float,
+                               size_t dimx,
+                               size_t dimy,
+                               size_t dimz,
+                               size_t chunk_x,
+                               size_t chunk_y,
+                               size_t chunk_z,
+                               int mode,
+                               double quality,
+                               size_t nthreads,
+                               void* dst,
+                               size_t dst_cap,
+                               size_t* dst_len)
+{
+  if (ctx == nullptr)
+    return 2;
+
+  auto rtn = comp_3d_encoder(src, is_float, dimx, dimy, dimz, chunk_x, chunk_y, chunk_z, mode,
+                             quality, nthreads, ctx->encoder);
+  if (rtn != 0)
+    return rtn;
+
+  return write_3d_stream(ctx->encoder, dst, dst_cap, dst_len);
+}
+
+int C_API::sperr_decompress_dctx(sperr_dctx* ctx,
+                                 const void* src,
+                                 size_t src_len,
+                                 int output_float,
+                                 size_t nthreads,
+                                 size_t* dimx,
+                                 size_t* dimy,
+                                 size_t* dimz,
+                                 void* dst,
+                                 size_t dst_cap)
+{
+  if (ctx == nullptr)
+    return 2;
+
+  auto& decoder = ctx->decoder;
+  decoder.set_num_threads(nthreads);
+  if (decoder.use_bitstream(src, src_len) != sperr::RTNType::Good)
+    return -1;
+
+  // Check the output capacity before doing the heavy lifting.
+  const auto dims = decoder.get_dims();
+  *dimx = dims[0];
+  *dimy = dims[1];
+  *dimz = dims[2];
+  const auto total_vals = dims[0] * dims[1] * dims[2];
+  if (dst_cap < total_vals * (output_float ? sizeof(float) : sizeof(double)))
+    return 1;
+
+  auto rtn = sperr::RTNType::Good;
+  if (output_float)
+    rtn = decoder.decompress_into(src, static_cast<float*>(dst));
+  else  // double
+    rtn = decoder.decompress_into(src, static_cast<double*>(dst));
+  if (rtn != sperr::RTNType::Good)
+    return -1;
+
+  return 0;
+}
+
+size_t C_API::sperr_cctx_profile(const sperr_cctx* ctx, char* buf, size_t buf_len)
+{
+  if (ctx == nullptr)
+    return 0;
+  return copy_profile_string(ctx->encoder.view_profile(), buf, buf_len);
+}
+
+size_t C_API::sperr_dctx_profile(const sperr_dctx* ctx, char* buf, size_t buf_len)
+{
+  if (ctx == nullptr)
+    return 0;
+  return copy_profile_string(ctx->decoder.view_profile(), buf, buf_len);
+}
+
 int C_API::sperr_trunc_3d(const void* src,
                           size_t src_len,
                           unsigned pct,
@@ -264,6 +264,64 @@ auto sperr::unpack_8_booleans(uint8_t src) -> std::array<bool, 8>
   return b8;
 }
 
+void sperr::encode_data_type(DataType type, std::array<bool, 8>& b8)
+{
+  // Float and double have code 0, and the other types have codes 1 to 7 in bool[5-7].
+  auto code = unsigned{0};
+  switch (type) {
+    case DataType::FP16:
+      code = 1;
+      break;
+    case DataType::BF16:
+      code = 2;
+      break;
+    case DataType::Int8:
+      code = 3;
+      break;
+    case DataType::UInt8:
+      code = 4;
+      break;
+    case DataType::Int16:
+      code = 5;
+      break;
+    case DataType::UInt16:
+      code = 6;
+      break;
+    case DataType::Int32:
+      code = 7;
+      break;
+    default:
+      code = 0;
+  }
+  b8[2] = (type != DataType::Double && type != DataType::Int32);
+  b8[5] = code & 1u;
+  b8[6] = code & 2u;
+  b8[7] = code & 4u;
+}
+
+auto sperr::decode_data_type(const std::array<bool, 8>& b8) -> DataType
+{
+  const auto code = unsigned(b8[5]) | (unsigned(b8[6]) << 1) | (unsigned(b8[7]) << 2);
+  switch (code) {
+    case 1:
+      return DataType::FP16;
+    case 2:
+      return DataType::BF16;
+    case 3:
+      return DataType::Int8;
+    case 4:
+      return DataType::UInt8;
+    case 5:
+      return DataType::Int16;
+    case 6:
+      return DataType::UInt16;
+    case 7:
+      return DataType::Int32;
+    default:
+      return b8[2] ? DataType::Float : DataType::Double;
+  }
+}
+
 auto sperr::read_n_bytes(std::string filename, size_t n_bytes) -> vec8_type
 {
   auto buf = vec8_type();
@@ -566,6 +624,32 @@ auto sperr::chunk_volume(dims_type vol_dim, dims_type chunk_dim)
   return chunks;
 }
 
+auto sperr::super_chunk_volume(dims_type vol_dim, dims_type chunk_dim, dims_type super_dim)
+    -> std::vector<std::vector<size_t>>
+{
+  // Chunks start at multiples of `chunk_dim`, which gives their positions in the grid of chunks.
+  const auto chunks = sperr::chunk_volume(vol_dim, chunk_dim);
+  auto n_segs = std::array<size_t, 3>{0, 0, 0};
+  for (size_t i = 0; i < 3; i++)
+    n_segs[i] = chunks.back()[i * 2] / chunk_dim[i] + 1;
+
+  auto n_supers = std::array<size_t, 3>{0, 0, 0};
+  for (size_t i = 0; i < 3; i++) {
+    super_dim[i] = std::max(super_dim[i], size_t{1});
+    n_supers[i] = (n_segs[i] + super_dim[i] - 1) / super_dim[i];
+  }
+
+  auto supers = std::vector<std::vector<size_t>>(n_supers[0] * n_supers[1] * n_supers[2]);
+  for (size_t i = 0; i < chunks.size(); i++) {
+    const auto sx = chunks[i][0] / chunk_dim[0] / super_dim[0];
+    const auto sy = chunks[i][2] / chunk_dim[1] / super_dim[1];
+    const auto sz = chunks[i][4] / chunk_dim[2] / super_dim[2];
+    supers[(sz * n_supers[1] + sy) * n_supers[0] + sx].push_back(i);
+  }
+
+  return supers;
+}
+
 template <typename T>
 auto sperr::calc_mean_var(const T* arr, size_t len, size_t omp_nthreads) -> std::array<T, 2>
 {
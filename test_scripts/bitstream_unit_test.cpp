@@ -3,6 +3,7 @@
 #include "Bitmask.h"
 #include "Bitstream.h"
 
+#include <algorithm>
 #include <random>
 #include <vector>
 
@@ -210,6 +211,57 @@ TEST(Bitstream, CompactStream)
     EXPECT_EQ(s1.rbit(), s2.rbit());
 }
 
+TEST(Bitstream, ViewStream)
+{
+  size_t N = 200;
+  std::random_device rd;
+  std::mt19937 gen(rd());
+  std::uniform_int_distribution<unsigned int> distrib1(0, 1);
+  auto s1 = Stream();
+
+  for (size_t i = 0; i < N; i++)
+    s1.wbit(distrib1(gen));
+  s1.flush();
+
+  // Place the compact bitstream at an unaligned address.
+  auto compact = s1.get_bitstream(N);
+  auto buf = std::vector<std::byte>(compact.size() + 1);
+  std::copy(compact.cbegin(), compact.cend(), buf.begin() + 1);
+
+  // Test full 64-bit multiples, 8-bit multiples, and bits beyond the viewed ones.
+  auto s2 = Stream();
+  s2.view_bitstream(buf.data() + 1, 136);
+  s1.rewind();
+  for (size_t i = 0; i < 136; i++)
+    EXPECT_EQ(s1.rbit(), s2.rbit());
+  EXPECT_EQ(s2.rtell(), 136);
+  for (size_t i = 136; i < 320; i++)
+    EXPECT_EQ(s2.rbit(), false);
+
+  // Test random access using rseek()
+  for (size_t pos : {size_t{0}, size_t{5}, size_t{64}, size_t{100}}) {
+    s1.rseek(pos);
+    s2.rseek(pos);
+    for (size_t i = pos; i < 136; i++)
+      EXPECT_EQ(s1.rbit(), s2.rbit());
+    EXPECT_EQ(s2.rtell(), 136);
+  }
+
+  // Test less than 64 bits
+  s2.view_bitstream(buf.data() + 1, 48);
+  s1.rewind();
+  for (size_t i = 0; i < 48; i++)
+    EXPECT_EQ(s1.rbit(), s2.rbit());
+  for (size_t i = 48; i < 128; i++)
+    EXPECT_EQ(s2.rbit(), false);
+
+  // Test that parsing a bitstream ends the view mode.
+  s2.parse_bitstream(compact.data(), N);
+  s1.rewind();
+  for (size_t i = 0; i < N; i++)
+    EXPECT_EQ(s1.rbit(), s2.rbit());
+}
+
 TEST(Bitstream, Reserve)
 {
   std::random_device rd;
@@ -0,0 +1,264 @@
+#include "SPERR2D_Stack_D.h"
+#include "SPERR_C_API.h"
+#include "sperr_helper.h"
+
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+
+namespace {
+
+//
+// The `*_into` functions write the same bitstreams as their allocating counterparts, fit in
+//    the capacity given by sperr_comp_bound(), and report the needed size when it's too small.
+//
+TEST(sperr_c_api, comp_2d_into)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.512_512");
+  const size_t dimx = 512, dimy = 512;
+  ASSERT_EQ(input.size(), dimx * dimy);
+
+  for (auto [mode, quality] : {std::pair{1, 2.5}, std::pair{2, 80.0}, std::pair{3, 1.0e-3}}) {
+    const auto bound = C_API::sperr_comp_bound(dimx, dimy, 1, dimx, dimy, 1, mode, quality);
+    ASSERT_GT(bound, 0);
+
+    for (int header : {0, 1}) {
+      void* ref = nullptr;
+      auto ref_len = size_t{0};
+      ASSERT_EQ(C_API::sperr_comp_2d(input.data(), 1, dimx, dimy, mode, quality, header, &ref,
+                                     &ref_len),
+                0);
+
+      auto dst = sperr::vec8_type(bound);
+      auto dst_len = size_t{0};
+      ASSERT_EQ(C_API::sperr_comp_2d_into(input.data(), 1, dimx, dimy, mode, quality, header,
+                                          dst.data(), dst.size(), &dst_len),
+                0);
+      EXPECT_LE(dst_len, bound);
+      ASSERT_EQ(dst_len, ref_len);
+      EXPECT_TRUE(std::equal(dst.cbegin(), dst.cbegin() + dst_len, static_cast<uint8_t*>(ref)));
+      std::free(ref);
+
+      auto needed = size_t{0};
+      EXPECT_EQ(C_API::sperr_comp_2d_into(input.data(), 1, dimx, dimy, mode, quality, header,
+                                          dst.data(), dst_len - 1, &needed),
+                1);
+      EXPECT_EQ(needed, dst_len);
+    }
+  }
+}
+
+TEST(sperr_c_api, comp_3d_into)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const size_t dimx = 128, dimy = 128, dimz = 41;
+  const size_t chunk = 64;
+  ASSERT_EQ(input.size(), dimx * dimy * dimz);
+
+  for (auto [mode, quality] : {std::pair{1, 2.5}, std::pair{2, 80.0}, std::pair{3, 1.0e-3}}) {
+    const auto bound =
+        C_API::sperr_comp_bound(dimx, dimy, dimz, chunk, chunk, chunk, mode, quality);
+    ASSERT_GT(bound, 0);
+
+    void* ref = nullptr;
+    auto ref_len = size_t{0};
+    ASSERT_EQ(C_API::sperr_comp_3d(input.data(), 1, dimx, dimy, dimz, chunk, chunk, chunk, mode,
+                                   quality, 0, &ref, &ref_len),
+              0);
+
+    auto dst = sperr::vec8_type(bound);
+    auto dst_len = size_t{0};
+    ASSERT_EQ(C_API::sperr_comp_3d_into(input.data(), 1, dimx, dimy, dimz, chunk, chunk, chunk,
+                                        mode, quality, 0, dst.data(), dst.size(), &dst_len),
+              0);
+    EXPECT_LE(dst_len, bound);
+    ASSERT_EQ(dst_len, ref_len);
+    EXPECT_TRUE(std::equal(dst.cbegin(), dst.cbegin() + dst_len, static_cast<uint8_t*>(ref)));
+    std::free(ref);
+
+    auto needed = size_t{0};
+    EXPECT_EQ(C_API::sperr_comp_3d_into(input.data(), 1, dimx, dimy, dimz, chunk, chunk, chunk,
+                                        mode, quality, 0, dst.data(), dst_len - 1, &needed),
+              1);
+    EXPECT_EQ(needed, dst_len);
+  }
+}
+
+//
+// One pair of contexts compresses and decompresses volumes of different shapes and modes, with
+//    the same results as the context-free functions.
+//
+TEST(sperr_c_api, contexts)
+{
+  struct Volume {
+    std::vector<float> vals;
+    size_t dimx, dimy, dimz, chunk;
+    int mode;
+    double quality;
+  };
+  auto vols = std::vector<Volume>();
+  vols.push_back({sperr::read_whole_file<float>("../test_data/vorticity.128_128_41"), 128, 128,
+                  41, 64, 2, 80.0});
+  vols.push_back({sperr::read_whole_file<float>("../test_data/wmag17.float"), 17, 17, 17, 16, 3,
+                  1.0e-2});
+
+  auto* cctx = C_API::sperr_cctx_create();
+  auto* dctx = C_API::sperr_dctx_create();
+  ASSERT_NE(cctx, nullptr);
+  ASSERT_NE(dctx, nullptr);
+
+  for (const auto& v : vols) {
+    ASSERT_EQ(v.vals.size(), v.dimx * v.dimy * v.dimz);
+    void* ref = nullptr;
+    auto ref_len = size_t{0};
+    ASSERT_EQ(C_API::sperr_comp_3d(v.vals.data(), 1, v.dimx, v.dimy, v.dimz, v.chunk, v.chunk,
+                                   v.chunk, v.mode, v.quality, 2, &ref, &ref_len),
+              0);
+    const auto ref_stream = sperr::vec8_type(static_cast<uint8_t*>(ref),
+                                             static_cast<uint8_t*>(ref) + ref_len);
+    std::free(ref);
+
+    auto stream = sperr::vec8_type(ref_len);
+    auto len = size_t{0};
+    ASSERT_EQ(C_API::sperr_compress_cctx(cctx, v.vals.data(), 1, v.dimx, v.dimy, v.dimz, v.chunk,
+                                         v.chunk, v.chunk, v.mode, v.quality, 2, stream.data(),
+                                         stream.size(), &len),
+              0);
+    EXPECT_EQ(stream, ref_stream);
+
+    void* ref_out = nullptr;
+    size_t dimx = 0, dimy = 0, dimz = 0;
+    ASSERT_EQ(C_API::sperr_decomp_3d(stream.data(), stream.size(), 1, 2, &dimx, &dimy, &dimz,
+                                     &ref_out),
+              0);
+    auto out = std::vector<float>(v.vals.size());
+    dimx = dimy = dimz = 0;
+    ASSERT_EQ(C_API::sperr_decompress_dctx(dctx, stream.data(), stream.size(), 1, 2, &dimx, &dimy,
+                                           &dimz, out.data(), out.size() * sizeof(float)),
+              0);
+    EXPECT_EQ(dimx, v.dimx);
+    EXPECT_EQ(dimy, v.dimy);
+    EXPECT_EQ(dimz, v.dimz);
+    EXPECT_TRUE(std::equal(out.cbegin(), out.cend(), static_cast<float*>(ref_out)));
+    std::free(ref_out);
+
+    // Too small an output buffer reports the volume dimensions.
+    dimx = dimy = dimz = 0;
+    EXPECT_EQ(C_API::sperr_decompress_dctx(dctx, stream.data(), stream.size(), 0, 2, &dimx, &dimy,
+                                           &dimz, out.data(), out.size() * sizeof(float)),
+              1);
+    EXPECT_EQ(dimx, v.dimx);
+    EXPECT_EQ(dimy, v.dimy);
+    EXPECT_EQ(dimz, v.dimz);
+  }
+
+  // Null contexts are rejected.
+  const auto& v = vols[1];
+  auto buf = sperr::vec8_type(1024);
+  auto len = size_t{0};
+  size_t dimx = 0, dimy = 0, dimz = 0;
+  EXPECT_EQ(C_API::sperr_compress_cctx(nullptr, v.vals.data(), 1, v.dimx, v.dimy, v.dimz, v.chunk,
+                                       v.chunk, v.chunk, v.mode, v.quality, 1, buf.data(),
+                                       buf.size(), &len),
+            2);
+  EXPECT_EQ(C_API::sperr_decompress_dctx(nullptr, buf.data(), buf.size(), 1, 1, &dimx, &dimy,
+                                         &dimz, buf.data(), buf.size()),
+            2);
+
+  C_API::sperr_cctx_free(cctx);
+  C_API::sperr_dctx_free(dctx);
+}
+
+TEST(sperr_c_api, comp_1d)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.512_512");
+  const size_t len = 100'000;
+  const double tol = 1.0e-3;
+  ASSERT_GE(input.size(), len);
+
+  void* stream = nullptr;
+  auto stream_len = size_t{0};
+  ASSERT_EQ(C_API::sperr_comp_1d(input.data(), 1, len, 30'000, 3, tol, 2, &stream, &stream_len),
+            0);
+
+  // The header records the length as a 1D array.
+  size_t dimx = 0, dimy = 0, dimz = 0;
+  int is_float = 0;
+  C_API::sperr_parse_header(stream, &dimx, &dimy, &dimz, &is_float);
+  EXPECT_EQ(dimx, len);
+  EXPECT_EQ(dimy, 1);
+  EXPECT_EQ(dimz, 1);
+  EXPECT_EQ(is_float, 1);
+
+  void* output = nullptr;
+  auto out_len = size_t{0};
+  ASSERT_EQ(C_API::sperr_decomp_1d(stream, stream_len, 0, 2, &out_len, &output), 0);
+  ASSERT_EQ(out_len, len);
+  const auto* outputd = static_cast<double*>(output);
+  for (size_t i = 0; i < len; i++)
+    ASSERT_LE(std::abs(outputd[i] - double(input[i])), tol);
+  std::free(output);
+
+  // A non-null `dst` is rejected.
+  EXPECT_EQ(C_API::sperr_decomp_1d(stream, stream_len, 0, 2, &out_len, &stream), 1);
+  std::free(stream);
+}
+
+TEST(sperr_c_api, comp_2d_stack)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const size_t dimx = 128, dimy = 128, nslices = 8;
+  ASSERT_GE(input.size(), dimx * dimy * nslices);
+
+  void* stream = nullptr;
+  auto stream_len = size_t{0};
+  ASSERT_EQ(C_API::sperr_comp_2d_stack(input.data(), 1, dimx, dimy, nslices, 2, 90.0, 2, &stream,
+                                       &stream_len),
+            0);
+
+  // The header records the number of slices in `dimz`.
+  size_t hdr_x = 0, hdr_y = 0, hdr_z = 0;
+  int is_float = 0;
+  C_API::sperr_parse_header(stream, &hdr_x, &hdr_y, &hdr_z, &is_float);
+  EXPECT_EQ(hdr_x, dimx);
+  EXPECT_EQ(hdr_y, dimy);
+  EXPECT_EQ(hdr_z, nslices);
+  EXPECT_EQ(is_float, 1);
+
+  // A single slice decodes the same as through the stack decoder.
+  const size_t idx = 5;
+  auto decoder = sperr::SPERR2D_Stack_D();
+  ASSERT_EQ(decoder.use_bitstream(stream, stream_len), sperr::RTNType::Good);
+  ASSERT_EQ(decoder.decompress_slice(stream, idx), sperr::RTNType::Good);
+  const auto& ref = decoder.view_decoded_data();
+  ASSERT_EQ(ref.size(), dimx * dimy);
+
+  void* slice = nullptr;
+  ASSERT_EQ(C_API::sperr_decomp_2d_slice(stream, stream_len, 0, idx, &slice), 0);
+  EXPECT_TRUE(std::equal(ref.cbegin(), ref.cend(), static_cast<double*>(slice)));
+  std::free(slice);
+
+  // Out-of-range slices are rejected.
+  slice = nullptr;
+  EXPECT_EQ(C_API::sperr_decomp_2d_slice(stream, stream_len, 0, nslices, &slice), 2);
+  EXPECT_EQ(slice, nullptr);
+  std::free(stream);
+}
+
+TEST(sperr_c_api, comp_bound)
+{
+  // Invalid parameters give a zero bound.
+  EXPECT_EQ(C_API::sperr_comp_bound(0, 64, 64, 64, 64, 64, 2, 80.0), 0);
+  EXPECT_EQ(C_API::sperr_comp_bound(64, 64, 64, 64, 64, 64, 2, 0.0), 0);
+
+  // In fixed-rate mode, the bound grows with the bitrate, and stays near the requested size.
+  const auto low = C_API::sperr_comp_bound(128, 128, 41, 64, 64, 64, 1, 1.0);
+  const auto high = C_API::sperr_comp_bound(128, 128, 41, 64, 64, 64, 1, 4.0);
+  EXPECT_LT(low, high);
+  EXPECT_LT(high, size_t{128} * 128 * 41 * 4 / 8 * 2);
+}
+
+}  // namespace
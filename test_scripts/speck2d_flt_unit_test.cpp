@@ -379,4 +379,34 @@ TEST(SPECK2D_FLT, TargetBPP)
   EXPECT_LT(stats[1], 8.173e-06);
 }
 
+//
+// Slices of transposed shapes have the same number of values, but different morton orders.
+//
+TEST(SPECK2D_FLT, TransposedShapes)
+{
+  auto inputf = sperr::read_whole_file<float>("../test_data/999x999.float");
+  const auto total_vals = size_t{300} * 61;
+  auto inputd = sperr::vecd_type(inputf.cbegin(), inputf.cbegin() + total_vals);
+  const double tol = 1.0e-3;
+
+  for (auto dims : {sperr::dims_type{300, 61, 1}, sperr::dims_type{61, 300, 1}}) {
+    auto encoder = sperr::SPECK2D_FLT();
+    encoder.set_dims(dims);
+    encoder.set_tolerance(tol);
+    encoder.copy_data(inputd.data(), total_vals);
+    ASSERT_EQ(encoder.compress(), sperr::RTNType::Good);
+    auto bitstream = sperr::vec8_type();
+    encoder.append_encoded_bitstream(bitstream);
+
+    auto decoder = sperr::SPECK2D_FLT();
+    decoder.set_dims(dims);
+    ASSERT_EQ(decoder.use_bitstream(bitstream.data(), bitstream.size()), sperr::RTNType::Good);
+    ASSERT_EQ(decoder.decompress(), sperr::RTNType::Good);
+    auto outputd = decoder.release_decoded_data();
+    ASSERT_EQ(outputd.size(), total_vals);
+    for (size_t i = 0; i < total_vals; i++)
+      EXPECT_NEAR(inputd[i], outputd[i], tol);
+  }
+}
+
 }  // namespace
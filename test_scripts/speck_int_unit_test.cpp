@@ -497,6 +497,31 @@ TEST(SPECK2D_INT, RandomRandom)
     EXPECT_EQ(input_signs.rbit(i), output_signs.rbit(i));
 }
 
+TEST(SPECK2D_INT, RasterLayout)
+{
+  // Testing sets on the morton-ordered copy produces the same bitstream as testing them in
+  //    raster order, and the copy is released once encoding finishes.
+  for (auto dims : {sperr::dims_type{63, 130, 1}, sperr::dims_type{130, 63, 1}}) {
+    auto [input, input_signs] = ProduceRandomArray<uint32_t>(dims[0] * dims[1], 4321.0, 4);
+
+    for (size_t budget : {0ul, 20'000ul}) {
+      auto morton = sperr::SPECK2D_INT_ENC<uint32_t>();
+      auto raster = sperr::SPECK2D_INT_ENC<uint32_t>();
+      raster.set_morton_layout(false);
+      auto streams = std::array<sperr::vec8_type, 2>();
+      for (auto* encoder : {&morton, &raster}) {
+        encoder->set_budget(budget);
+        encoder->use_coeffs(input, input_signs);
+        encoder->set_dims(dims);
+        encoder->encode();
+        encoder->append_encoded_bitstream(streams[encoder == &raster]);
+      }
+      EXPECT_EQ(streams[0], streams[1]);
+      EXPECT_EQ(morton.memory_usage(), raster.memory_usage());
+    }
+  }
+}
+
 //
 // Starting 3D test cases
 //
@@ -742,4 +767,97 @@ TEST(SPECK3D_INT, RandomRandom)
     EXPECT_EQ(input_signs.rbit(i), output_signs.rbit(i));
 }
 
+TEST(SPECK3D_INT, PowerOfTwoCube)
+{
+  // Power-of-two cubes take the specialized code paths.
+  for (size_t edge : {64ul, 128ul}) {
+    const auto dims = sperr::dims_type{edge, edge, edge};
+    const auto total_vals = dims[0] * dims[1] * dims[2];
+
+    auto [input, input_signs] = ProduceRandomArray<uint32_t>(total_vals, 4321.0, 3);
+
+    // Encode
+    auto encoder = sperr::SPECK3D_INT_ENC<uint32_t>();
+    encoder.use_coeffs(input, input_signs);
+    encoder.set_dims(dims);
+    encoder.encode();
+    sperr::vec8_type bitstream;
+    encoder.append_encoded_bitstream(bitstream);
+
+    // Decode
+    auto decoder = sperr::SPECK3D_INT_DEC<uint32_t>();
+    decoder.set_dims(dims);
+    decoder.use_bitstream(bitstream.data(), bitstream.size());
+    decoder.decode();
+    auto output = decoder.release_coeffs();
+    auto output_signs = decoder.release_signs();
+
+    EXPECT_EQ(input, output);
+    EXPECT_EQ(input_signs.size(), output_signs.size());
+    for (size_t i = 0; i < input_signs.size(); i++)
+      EXPECT_EQ(input_signs.rbit(i), output_signs.rbit(i));
+  }
+}
+
+TEST(SPECK3D_INT, PowerOfTwoCubeGenericPath)
+{
+  // The specialized paths for power-of-two cubes produce the same bitstream as the generic ones.
+  for (size_t edge : {64ul, 128ul}) {
+    const auto dims = sperr::dims_type{edge, edge, edge};
+    const auto total_vals = dims[0] * dims[1] * dims[2];
+
+    auto [input, input_signs] = ProduceRandomArray<uint32_t>(total_vals, 4321.0, 3);
+
+    auto encode = [&](bool cube_paths) {
+      auto encoder = sperr::SPECK3D_INT_ENC<uint32_t>();
+      encoder.set_cube_paths(cube_paths);
+      encoder.use_coeffs(input, input_signs);
+      encoder.set_dims(dims);
+      encoder.encode();
+      auto bitstream = sperr::vec8_type();
+      encoder.append_encoded_bitstream(bitstream);
+      return bitstream;
+    };
+    const auto specialized = encode(true);
+    const auto generic = encode(false);
+    EXPECT_EQ(specialized, generic);
+
+    // The decoder also takes either path.
+    auto decoder = sperr::SPECK3D_INT_DEC<uint32_t>();
+    decoder.set_cube_paths(false);
+    decoder.set_dims(dims);
+    decoder.use_bitstream(specialized.data(), specialized.size());
+    decoder.decode();
+    EXPECT_EQ(input, decoder.release_coeffs());
+  }
+}
+
+TEST(SPECK3D_INT, ArrangedCoeffs)
+{
+  // Coefficients arranged in the morton order up front produce the same bitstream.
+  for (auto dims : {sperr::dims_type{30, 20, 17}, sperr::dims_type{64, 64, 64}}) {
+    const auto total_vals = dims[0] * dims[1] * dims[2];
+    auto [input, input_signs] = ProduceRandomArray<uint16_t>(total_vals, 499.0, 4);
+
+    auto encoder = sperr::SPECK3D_INT_ENC<uint16_t>();
+    encoder.set_dims(dims);
+    encoder.use_coeffs(input, input_signs);
+    encoder.encode();
+    sperr::vec8_type bitstream1;
+    encoder.append_encoded_bitstream(bitstream1);
+
+    const auto order = sperr::speck3d_morton_order(dims);
+    ASSERT_NE(order, nullptr);
+    auto arranged = std::vector<uint16_t>(total_vals);
+    for (size_t i = 0; i < total_vals; i++)
+      arranged[order->dest[i]] = input[i];
+    encoder.use_arranged_coeffs(arranged, input_signs);
+    encoder.encode();
+    sperr::vec8_type bitstream2;
+    encoder.append_encoded_bitstream(bitstream2);
+
+    EXPECT_EQ(bitstream1, bitstream2);
+  }
+}
+
 }  // namespace
@@ -0,0 +1,105 @@
+#include "SPERR1D_OMP_C.h"
+#include "SPERR1D_OMP_D.h"
+#include "SPERR3D_OMP_C.h"
+
+#include <cstring>
+#include "gtest/gtest.h"
+
+namespace {
+
+using sperr::RTNType;
+
+//
+// Test constant arrays.
+//
+TEST(sperr1d_constant, omp_chunks)
+{
+  const auto total_len = size_t{10'000};
+  auto inputd = sperr::vecd_type(total_len, 3.14);
+
+  // Use an encoder
+  auto encoder = sperr::SPERR1D_OMP_C();
+  encoder.set_length_and_chunk(total_len, 3'000);
+  encoder.set_psnr(99.0);
+  encoder.set_num_threads(3);
+  auto rtn = encoder.compress(inputd.data(), inputd.size());
+  EXPECT_EQ(rtn, RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+
+  // Use a decoder
+  auto decoder = sperr::SPERR1D_OMP_D();
+  decoder.set_num_threads(4);
+  rtn = decoder.use_bitstream(stream.data(), stream.size());
+  EXPECT_EQ(rtn, RTNType::Good);
+  rtn = decoder.decompress(stream.data());
+  EXPECT_EQ(rtn, RTNType::Good);
+  EXPECT_EQ(decoder.get_length(), total_len);
+  EXPECT_EQ(decoder.get_orig_is_float(), false);
+  EXPECT_EQ(decoder.view_decoded_data(), inputd);
+}
+
+//
+// Test target PWE
+//
+TEST(sperr1d_target_pwe, omp_chunks)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto total_len = input.size();
+
+  // Use an encoder
+  double tol = 1.5e-6;
+  auto encoder = sperr::SPERR1D_OMP_C();
+  encoder.set_length_and_chunk(total_len, 100'000);
+  encoder.set_tolerance(tol);
+  encoder.set_num_threads(4);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+  EXPECT_EQ(stream.size(), encoder.encoded_bitstream_len());
+
+  // Use a decoder
+  auto decoder = sperr::SPERR1D_OMP_D();
+  decoder.set_num_threads(3);
+  auto rtn = decoder.use_bitstream(stream.data(), stream.size());
+  EXPECT_EQ(rtn, RTNType::Good);
+  decoder.decompress(stream.data());
+  EXPECT_EQ(decoder.get_length(), total_len);
+  EXPECT_EQ(decoder.get_orig_is_float(), true);
+  const auto& output = decoder.view_decoded_data();
+  for (size_t i = 0; i < input.size(); i++)
+    EXPECT_NEAR(input[i], output[i], tol);
+
+  // Test a single chunk, and writing to a caller-provided buffer.
+  encoder.set_length_and_chunk(total_len, total_len);
+  encoder.compress(input.data(), input.size());
+  auto buf = sperr::vec8_type(encoder.encoded_bitstream_len());
+  EXPECT_EQ(encoder.write_encoded_bitstream(buf.data(), buf.size() - 1), RTNType::WrongLength);
+  EXPECT_EQ(encoder.write_encoded_bitstream(buf.data(), buf.size()), RTNType::Good);
+
+  rtn = decoder.use_bitstream(buf.data(), buf.size());
+  EXPECT_EQ(rtn, RTNType::Good);
+  decoder.decompress(buf.data());
+  EXPECT_EQ(decoder.get_chunk_length(), total_len);
+  const auto& output2 = decoder.view_decoded_data();
+  for (size_t i = 0; i < input.size(); i++)
+    EXPECT_NEAR(input[i], output2[i], tol);
+}
+
+//
+// Test that a 3D bitstream is rejected.
+//
+TEST(sperr1d_stream, reject_3d)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, dims);
+  encoder.set_bitrate(2.0);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR1D_OMP_D();
+  EXPECT_EQ(decoder.use_bitstream(stream.data(), stream.size()), RTNType::SliceVolumeMismatch);
+}
+
+}  // anonymous namespace
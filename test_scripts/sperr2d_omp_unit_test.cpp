@@ -0,0 +1,251 @@
+#include "SPERR1D_OMP_C.h"
+#include "SPERR2D_OMP_C.h"
+#include "SPERR2D_OMP_D.h"
+#include "SPERR2D_Stack_C.h"
+#include "SPERR2D_Stack_D.h"
+#include "SPERR3D_Stream_Tools.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+
+using sperr::RTNType;
+
+//
+// Test target PWE, with multiple chunks and a single chunk.
+//
+TEST(sperr2d_target_pwe, omp_chunks)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.512_512");
+  const auto dims = sperr::dims_type{512, 512, 1};
+  assert(input.size() == dims[0] * dims[1]);
+
+  // Use an encoder
+  double tol = 1.5e-5;
+  auto encoder = sperr::SPERR2D_OMP_C();
+  encoder.set_dims_and_chunks(dims, {200, 150, 1});
+  encoder.set_tolerance(tol);
+  encoder.set_num_threads(4);
+  auto rtn = encoder.compress(input.data(), input.size());
+  EXPECT_EQ(rtn, RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+  EXPECT_EQ(stream.size(), encoder.encoded_bitstream_len());
+
+  // Use a decoder
+  auto decoder = sperr::SPERR2D_OMP_D();
+  decoder.set_num_threads(3);
+  rtn = decoder.use_bitstream(stream.data(), stream.size());
+  EXPECT_EQ(rtn, RTNType::Good);
+  rtn = decoder.decompress(stream.data());
+  EXPECT_EQ(rtn, RTNType::Good);
+  EXPECT_EQ(decoder.get_dims(), dims);
+  EXPECT_EQ(decoder.get_chunk_dims(), (sperr::dims_type{200, 150, 1}));
+  EXPECT_EQ(decoder.get_orig_is_float(), true);
+  const auto& output = decoder.view_decoded_data();
+  ASSERT_EQ(output.size(), input.size());
+  for (size_t i = 0; i < input.size(); i++)
+    EXPECT_NEAR(input[i], output[i], tol);
+
+  // Test a single chunk, and writing to a caller-provided buffer.
+  encoder.set_dims_and_chunks(dims, dims);
+  encoder.compress(input.data(), input.size());
+  auto buf = sperr::vec8_type(encoder.encoded_bitstream_len());
+  EXPECT_EQ(encoder.write_encoded_bitstream(buf.data(), buf.size() - 1), RTNType::WrongLength);
+  EXPECT_EQ(encoder.write_encoded_bitstream(buf.data(), buf.size()), RTNType::Good);
+
+  rtn = decoder.use_bitstream(buf.data(), buf.size());
+  EXPECT_EQ(rtn, RTNType::Good);
+  decoder.decompress(buf.data());
+  EXPECT_EQ(decoder.get_chunk_dims(), dims);
+  const auto& output2 = decoder.view_decoded_data();
+  for (size_t i = 0; i < input.size(); i++)
+    EXPECT_NEAR(input[i], output2[i], tol);
+}
+
+//
+// Test decoding a region of interest, which should be identical to the same region
+// of the whole slice.
+//
+TEST(sperr2d_region, omp_chunks)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.512_512");
+  const auto dims = sperr::dims_type{512, 512, 1};
+
+  auto encoder = sperr::SPERR2D_OMP_C();
+  encoder.set_dims_and_chunks(dims, {128, 100, 1});
+  encoder.set_psnr(80.0);
+  encoder.set_num_threads(4);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR2D_OMP_D();
+  decoder.set_num_threads(4);
+  decoder.use_bitstream(stream.data(), stream.size());
+  decoder.decompress(stream.data());
+  const auto whole = decoder.release_decoded_data();
+
+  const auto start = std::array<size_t, 2>{100, 250};
+  const auto size = std::array<size_t, 2>{300, 77};
+  auto rtn = decoder.decompress_region(stream.data(), start, size);
+  EXPECT_EQ(rtn, RTNType::Good);
+  const auto& roi = decoder.view_decoded_data();
+  ASSERT_EQ(roi.size(), size[0] * size[1]);
+  for (size_t y = 0; y < size[1]; y++)
+    for (size_t x = 0; x < size[0]; x++)
+      EXPECT_EQ(roi[y * size[0] + x], whole[(y + start[1]) * dims[0] + x + start[0]]);
+
+  // Regions going beyond the slice are rejected.
+  rtn = decoder.decompress_region(stream.data(), {500, 0}, {20, 10});
+  EXPECT_EQ(rtn, RTNType::Error);
+}
+
+//
+// Test progressive truncation of a chunked 2D bitstream.
+//
+TEST(sperr2d_stream_tools, truncate)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.512_512");
+  const auto dims = sperr::dims_type{512, 512, 1};
+
+  auto encoder = sperr::SPERR2D_OMP_C();
+  encoder.set_dims_and_chunks(dims, {256, 256, 1});
+  encoder.set_psnr(100.0);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  auto header = tools.get_stream_header(stream.data());
+  EXPECT_EQ(header.is_3D, false);
+  EXPECT_EQ(header.multi_chunk, true);
+  EXPECT_EQ(header.vol_dims, dims);
+  EXPECT_EQ(header.chunk_dims, (sperr::dims_type{256, 256, 1}));
+  EXPECT_EQ(header.header_len, 14 + 4 * 4);
+  EXPECT_EQ(header.stream_len, stream.size());
+
+  // A full truncation keeps the bitstream intact.
+  EXPECT_EQ(tools.progressive_truncate(stream.data(), stream.size(), 100), stream);
+
+  // A partial bitstream is still decodable, with a lower quality.
+  auto part = tools.progressive_truncate(stream.data(), stream.size(), 20);
+  EXPECT_LT(part.size(), stream.size() / 4);
+  auto decoder = sperr::SPERR2D_OMP_D();
+  auto rtn = decoder.use_bitstream(part.data(), part.size());
+  EXPECT_EQ(rtn, RTNType::Good);
+  rtn = decoder.decompress(part.data());
+  EXPECT_EQ(rtn, RTNType::Good);
+  const auto& output = decoder.view_decoded_data();
+  ASSERT_EQ(output.size(), input.size());
+  const auto inputd = sperr::vecd_type(input.cbegin(), input.cend());
+  const auto stats = sperr::calc_stats(inputd.data(), output.data(), input.size());
+  EXPECT_GT(stats[2], 50.0);
+  EXPECT_LT(stats[2], 100.0);
+}
+
+//
+// Test that a single-chunk slice is told apart from the output of `sperr_comp_2d()`, and that
+//    the stream tools reject what they don't read.
+//
+TEST(sperr2d_stream, reject_others)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.512_512");
+  const auto dims = sperr::dims_type{512, 512, 1};
+
+  auto encoder = sperr::SPERR2D_OMP_C();
+  encoder.set_dims_and_chunks(dims, dims);
+  encoder.set_psnr(80.0);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+  auto b8 = sperr::unpack_8_booleans(stream[1]);
+  EXPECT_TRUE(b8[6]);
+
+  // The same header without the mark is what `sperr_comp_2d()` produces.
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  auto arr20 = std::array<uint8_t, 20>();
+  std::copy(stream.cbegin(), stream.cbegin() + 20, arr20.begin());
+  EXPECT_EQ(tools.get_header_len(arr20), 14);
+  b8[6] = false;
+  stream[1] = sperr::pack_8_booleans(b8);
+  auto decoder = sperr::SPERR2D_OMP_D();
+  EXPECT_EQ(decoder.use_bitstream(stream.data(), stream.size()), RTNType::Error);
+  std::copy(stream.cbegin(), stream.cbegin() + 20, arr20.begin());
+  EXPECT_EQ(tools.get_header_len(arr20), 0);
+
+  // 1D bitstreams.
+  auto encoder1 = sperr::SPERR1D_OMP_C();
+  encoder1.set_length_and_chunk(input.size(), 100'000);
+  encoder1.set_psnr(80.0);
+  ASSERT_EQ(encoder1.compress(input.data(), input.size()), RTNType::Good);
+  auto stream1 = encoder1.get_encoded_bitstream();
+  std::copy(stream1.cbegin(), stream1.cbegin() + 20, arr20.begin());
+  EXPECT_EQ(tools.get_header_len(arr20), 0);
+  EXPECT_TRUE(tools.get_stream_header(stream1.data()).chunk_sources.empty());
+  EXPECT_EQ(decoder.use_bitstream(stream1.data(), stream1.size()),
+            RTNType::SliceVolumeMismatch);
+}
+
+//
+// Test a stack of slices, which is the 41 slices of a 3D volume.
+//
+TEST(sperr2d_stack, random_access)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 1};
+  const auto slice_len = dims[0] * dims[1];
+  const auto num_slices = size_t{41};
+  assert(input.size() == slice_len * num_slices);
+
+  double tol = 1.5e-6;
+  auto encoder = sperr::SPERR2D_Stack_C();
+  encoder.set_slice_dims(dims);
+  encoder.set_tolerance(tol);
+  encoder.set_num_threads(4);
+  EXPECT_EQ(encoder.compress(input.data(), input.size() - 1), RTNType::WrongLength);
+  auto rtn = encoder.compress(input.data(), input.size());
+  EXPECT_EQ(rtn, RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+  EXPECT_EQ(stream.size(), encoder.encoded_bitstream_len());
+  EXPECT_EQ(encoder.view_slice_streams().size(), num_slices);
+
+  // Decode all slices.
+  auto decoder = sperr::SPERR2D_Stack_D();
+  decoder.set_num_threads(3);
+  rtn = decoder.use_bitstream(stream.data(), stream.size());
+  EXPECT_EQ(rtn, RTNType::Good);
+  EXPECT_EQ(decoder.get_num_slices(), num_slices);
+  EXPECT_EQ(decoder.get_slice_dims(), dims);
+  EXPECT_EQ(decoder.get_orig_is_float(), true);
+  rtn = decoder.decompress(stream.data());
+  EXPECT_EQ(rtn, RTNType::Good);
+  const auto whole = decoder.release_decoded_data();
+  ASSERT_EQ(whole.size(), input.size());
+  for (size_t i = 0; i < input.size(); i++)
+    EXPECT_NEAR(input[i], whole[i], tol);
+
+  // Decode a few slices in a random order.
+  const auto indices = std::vector<size_t>{40, 3, 17};
+  rtn = decoder.decompress_slices(stream.data(), indices);
+  EXPECT_EQ(rtn, RTNType::Good);
+  const auto& part = decoder.view_decoded_data();
+  ASSERT_EQ(part.size(), slice_len * indices.size());
+  for (size_t i = 0; i < indices.size(); i++)
+    for (size_t j = 0; j < slice_len; j++)
+      EXPECT_EQ(part[i * slice_len + j], whole[indices[i] * slice_len + j]);
+  EXPECT_EQ(decoder.decompress_slice(stream.data(), num_slices), RTNType::Error);
+
+  // An individual slice stream is decodable by SPECK2D_FLT alone.
+  const auto& s17 = encoder.view_slice_streams()[17];
+  auto speck = sperr::SPECK2D_FLT();
+  speck.set_dims(dims);
+  speck.use_bitstream(s17.data(), s17.size());
+  EXPECT_EQ(speck.decompress(), RTNType::Good);
+  const auto& slice = speck.view_decoded_data();
+  for (size_t j = 0; j < slice_len; j++)
+    EXPECT_EQ(slice[j], whole[17 * slice_len + j]);
+
+  // A stack is not a chunked slice.
+  auto slice_decoder = sperr::SPERR2D_OMP_D();
+  EXPECT_EQ(slice_decoder.use_bitstream(stream.data(), stream.size()),
+            RTNType::SliceVolumeMismatch);
+}
+
+}  // namespace
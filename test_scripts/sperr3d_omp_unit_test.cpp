@@ -1,7 +1,12 @@
+#include "SPERR3D_Chunk_Cache.h"
 #include "SPERR3D_OMP_C.h"
 #include "SPERR3D_OMP_D.h"
+#include "SPERR3D_Stream_Tools.h"
 
+#include <cstdio>
 #include <cstring>
+#include <memory>
+#include <thread>
 #include "gtest/gtest.h"
 
 namespace {
@@ -344,4 +349,720 @@ TEST(sperr3d_multi_res, canonical)
   }
 }
 
+//
+// Test per-stage profiling
+//
+TEST(sperr3d_profile, chunks)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/wmag91.float");
+  const auto dims = sperr::dims_type{91, 91, 91};
+  const auto chunks = sperr::dims_type{48, 48, 48};
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_tolerance(0.5);
+  encoder.set_num_threads(4);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(4);
+  decoder.use_bitstream(stream.data(), stream.size());
+  decoder.decompress(stream.data());
+
+#ifndef SPERR_INSTRUMENT
+  EXPECT_TRUE(encoder.view_chunk_profiles().empty());
+  EXPECT_TRUE(decoder.view_chunk_profiles().empty());
+#else
+  const auto num_chunks = sperr::chunk_volume(dims, chunks).size();
+  EXPECT_EQ(encoder.view_chunk_profiles().size(), num_chunks);
+  EXPECT_EQ(decoder.view_chunk_profiles().size(), num_chunks);
+  EXPECT_EQ(encoder.view_profile().num_chunks(), num_chunks);
+  EXPECT_EQ(decoder.view_profile().num_chunks(), num_chunks);
+
+  const auto& cprof = encoder.view_profile();
+  const auto& dprof = decoder.view_profile();
+  EXPECT_GT(cprof.time(sperr::Stage::Wavelet), 0.0);
+  EXPECT_GT(cprof.time(sperr::Stage::SpeckSorting), 0.0);
+  EXPECT_GT(cprof.wall_time(), 0.0);
+  EXPECT_EQ(cprof.bytes(sperr::Stage::Wavelet), input.size() * sizeof(double));
+  EXPECT_GT(cprof.num_bitplanes(), 0);
+  EXPECT_GT(cprof.peak_LIS_size(), 0);
+  EXPECT_EQ(cprof.num_bitplanes(), dprof.num_bitplanes());
+  EXPECT_EQ(cprof.num_outliers(), dprof.num_outliers());
+  EXPECT_GT(dprof.time(sperr::Stage::InverseWavelet), 0.0);
+  EXPECT_GT(dprof.time(sperr::Stage::ChunkCopy), 0.0);
+
+  // Stage times of the aggregate profile are sums over chunks.
+  auto sum = 0.0;
+  for (const auto& prof : encoder.view_chunk_profiles())
+    sum += prof.time(sperr::Stage::Wavelet);
+  EXPECT_DOUBLE_EQ(sum, cprof.time(sperr::Stage::Wavelet));
+
+  // In Rate mode, a chunk encoded again with a higher precision counts its bitplanes once,
+  //    and the SPECK stages produce the bitstream.
+  encoder.set_bitrate(4.0);
+  encoder.compress(input.data(), input.size());
+  stream = encoder.get_encoded_bitstream();
+  decoder.use_bitstream(stream.data(), stream.size());
+  decoder.decompress(stream.data());
+  EXPECT_EQ(cprof.num_bitplanes(), dprof.num_bitplanes());
+  const auto speck_bytes =
+      cprof.bytes(sperr::Stage::SpeckSorting) + cprof.bytes(sperr::Stage::SpeckRefinement);
+  EXPECT_GT(speck_bytes, stream.size() * 9 / 10);
+  EXPECT_LE(speck_bytes, stream.size());
+#endif
+}
+
+//
+// Test memory accounting and budget
+//
+TEST(sperr3d_memory, budget)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/wmag128.float");
+  const auto dims = sperr::dims_type{128, 128, 128};
+  const auto chunks = sperr::dims_type{64, 64, 64};
+
+  // No budget: 4 threads.
+  auto encoder1 = sperr::SPERR3D_OMP_C();
+  encoder1.set_dims_and_chunks(dims, chunks);
+  encoder1.set_tolerance(1e-2);
+  encoder1.set_num_threads(4);
+  encoder1.compress(input.data(), input.size());
+  const auto stream1 = encoder1.get_encoded_bitstream();
+  const auto mem1 = encoder1.get_memory_usage();
+  EXPECT_GT(mem1.peak(sperr::MemComp::Coeffs), 0);
+  EXPECT_GT(mem1.peak(sperr::MemComp::Original), 0);
+  EXPECT_GT(mem1.peak(sperr::MemComp::Speck), 0);
+  EXPECT_GE(mem1.current(sperr::MemComp::Output), stream1.size() - 100);
+  EXPECT_GE(mem1.peak_total(), mem1.current_total());
+
+  // A budget that doesn't even fit one thread, or the bitstreams, fails.
+  auto encoder2 = sperr::SPERR3D_OMP_C();
+  encoder2.set_dims_and_chunks(dims, chunks);
+  encoder2.set_tolerance(1e-2);
+  encoder2.set_num_threads(4);
+  encoder2.set_memory_budget(1024);
+  EXPECT_EQ(encoder2.compress(input.data(), input.size()), RTNType::Error);
+  const auto one_thread = size_t{11} << 20;  // A little more than a 64^3 chunk takes.
+  const auto input_bytes = input.size() * sizeof(float);
+  encoder2.set_memory_budget(input_bytes + one_thread + 1024);
+  EXPECT_EQ(encoder2.compress(input.data(), input.size()), RTNType::Error);
+
+  // A budget that fits one thread: same bitstream, less memory.
+  encoder2.set_memory_budget(input_bytes + one_thread + stream1.size());
+  ASSERT_EQ(encoder2.compress(input.data(), input.size()), RTNType::Good);
+  const auto stream2 = encoder2.get_encoded_bitstream();
+  const auto mem2 = encoder2.get_memory_usage();
+  EXPECT_EQ(stream1, stream2);
+#ifdef USE_OMP  // Without OpenMP, both encoders use one thread anyway.
+  EXPECT_LT(mem2.peak_total(), mem1.peak_total());
+#endif
+  EXPECT_LE(mem2.current(sperr::MemComp::Output), mem1.current(sperr::MemComp::Output));
+
+  // Decompression under a budget gives the same result too.
+  auto decoder1 = sperr::SPERR3D_OMP_D();
+  decoder1.set_num_threads(4);
+  decoder1.use_bitstream(stream1.data(), stream1.size());
+  decoder1.decompress(stream1.data());
+  auto decoder2 = sperr::SPERR3D_OMP_D();
+  decoder2.set_num_threads(4);
+  decoder2.set_memory_budget(input.size() * sizeof(double) + 1024);
+  decoder2.use_bitstream(stream1.data(), stream1.size());
+  decoder2.decompress(stream1.data());
+  EXPECT_EQ(decoder1.view_decoded_data(), decoder2.view_decoded_data());
+  const auto dmem1 = decoder1.get_memory_usage();
+  const auto dmem2 = decoder2.get_memory_usage();
+  EXPECT_EQ(dmem1.current(sperr::MemComp::Output), input.size() * sizeof(double));
+#ifdef USE_OMP
+  EXPECT_LT(dmem2.peak_total(), dmem1.peak_total());
+#endif
+}
+
+TEST(sperr3d_decompress_into, float_double)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/wmag128.float");
+  const auto dims = sperr::dims_type{128, 128, 128};
+  const auto chunks = sperr::dims_type{64, 64, 48};
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_psnr(80.0);
+  encoder.set_num_threads(4);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(4);
+  decoder.use_bitstream(stream.data(), stream.size());
+  decoder.decompress(stream.data());
+  const auto outputd = decoder.release_decoded_data();
+
+  // Decode into uninitialized buffers, with and without thread binding.
+  auto bufd = std::make_unique_for_overwrite<double[]>(input.size());
+  decoder.set_thread_binding(true);
+  decoder.use_bitstream(stream.data(), stream.size());
+  EXPECT_EQ(decoder.decompress_into(stream.data(), bufd.get()), RTNType::Good);
+  EXPECT_TRUE(std::equal(outputd.cbegin(), outputd.cend(), bufd.get()));
+  EXPECT_TRUE(decoder.view_decoded_data().empty());
+
+  auto buff = std::make_unique_for_overwrite<float[]>(input.size());
+  decoder.set_thread_binding(false);
+  decoder.use_bitstream(stream.data(), stream.size());
+  EXPECT_EQ(decoder.decompress_into(stream.data(), buff.get()), RTNType::Good);
+  EXPECT_TRUE(std::equal(outputd.cbegin(), outputd.cend(), buff.get(),
+                         [](double d, float f) { return static_cast<float>(d) == f; }));
+}
+
+TEST(sperr3d_data_types, int16_fp16)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/wmag128.float");
+  const auto dims = sperr::dims_type{128, 128, 128};
+  const auto chunks = sperr::dims_type{64, 64, 64};
+
+  // 16-bit integers are compressed without an intermediate float buffer.
+  auto input16 = std::vector<int16_t>(input.size());
+  std::transform(input.cbegin(), input.cend(), input16.begin(),
+                 [](auto v) { return static_cast<int16_t>(v * 10.f); });
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_tolerance(0.4);
+  encoder.set_num_threads(4);
+  EXPECT_EQ(encoder.compress(input16.data(), input16.size()), RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(4);
+  decoder.use_bitstream(stream.data(), stream.size());
+  EXPECT_EQ(decoder.get_orig_type(), sperr::DataType::Int16);
+  auto output16 = std::vector<int16_t>(input.size());
+  EXPECT_EQ(decoder.decompress_into(stream.data(), output16.data()), RTNType::Good);
+  EXPECT_EQ(output16, input16);  // Errors less than 0.5 round away.
+
+  // Half precision values.
+  auto input_h = std::vector<sperr::fp16_type>(input.size());
+  std::transform(input.cbegin(), input.cend(), input_h.begin(),
+                 [](auto v) { return sperr::from_double<sperr::fp16_type>(v); });
+  encoder.set_tolerance(1e-3);
+  EXPECT_EQ(encoder.compress(input_h.data(), input_h.size()), RTNType::Good);
+  stream = encoder.get_encoded_bitstream();
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  EXPECT_EQ(tools.get_stream_header(stream.data()).data_type, sperr::DataType::FP16);
+  EXPECT_EQ(tools.get_stream_header(stream.data()).is_float, true);
+
+  decoder.use_bitstream(stream.data(), stream.size());
+  EXPECT_EQ(decoder.get_orig_type(), sperr::DataType::FP16);
+  decoder.decompress(stream.data());
+  const auto& outputd = decoder.view_decoded_data();
+  for (size_t i = 0; i < input.size(); i++)
+    EXPECT_NEAR(outputd[i], sperr::to_double(input_h[i]), 1e-3);
+}
+
+TEST(sperr3d_coarse, mean_var)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  ASSERT_EQ(input.size(), 128 * 128 * 41);
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto chunk_dims = sperr::dims_type{64, 64, 41};
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, chunk_dims);
+  encoder.set_psnr(80.0);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+  auto in_d = sperr::vecd_type(input.cbegin(), input.cend());
+  const auto [mean, var] = sperr::calc_mean_var(in_d.data(), in_d.size(), 1);
+
+  // Without decoding any bitplane, the means are exact, and the coarse volume is constant
+  //    within each chunk.
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.use_bitstream(stream.data(), stream.size());
+  ASSERT_EQ(decoder.decompress_coarse(stream.data(), 0), RTNType::Good);
+  const auto chunks = sperr::chunk_volume(dims, chunk_dims);
+  ASSERT_EQ(decoder.view_chunk_mean_var().size(), chunks.size());
+  for (size_t i = 0; i < chunks.size(); i++) {
+    auto chunk_mean = 0.0;
+    const auto& c = chunks[i];
+    for (size_t z = c[4]; z < c[4] + c[5]; z++)
+      for (size_t y = c[2]; y < c[2] + c[3]; y++)
+        for (size_t x = c[0]; x < c[0] + c[1]; x++)
+          chunk_mean += in_d[z * dims[0] * dims[1] + y * dims[0] + x];
+    chunk_mean /= double(c[1] * c[3] * c[5]);
+    EXPECT_NEAR(decoder.view_chunk_mean_var()[i][0], chunk_mean, 1e-12);
+  }
+  EXPECT_NEAR(decoder.get_mean_var()[0], mean, 1e-12);
+  EXPECT_LT(decoder.get_mean_var()[1], var / 10.0);
+  auto coarse_dims = decoder.get_coarse_dims();
+  EXPECT_EQ(coarse_dims, (sperr::dims_type{16, 16, 6}));
+  EXPECT_EQ(decoder.view_coarse_data().size(), 16 * 16 * 6);
+  EXPECT_EQ(decoder.view_coarse_data()[0], decoder.view_chunk_mean_var()[0][0]);
+
+  // More bitplanes approach the variance, and the coarse volume resembles the input.
+  decoder.decompress_coarse(stream.data(), 8);
+  EXPECT_NEAR(decoder.get_mean_var()[1], var, var * 0.1);
+  coarse_dims = decoder.get_coarse_dims();
+  const auto& coarse = decoder.view_coarse_data();
+  ASSERT_EQ(coarse.size(), 16 * 16 * 6);
+  auto orig = sperr::vecd_type();
+  for (size_t z = 0; z < 6; z++)
+    for (size_t y = 0; y < 16; y++)
+      for (size_t x = 0; x < 16; x++)
+        orig.push_back(in_d[(z * 41 / 6) * 128 * 128 + (y * 8 + 3) * 128 + x * 8 + 3]);
+  auto [rmse, linfty, psnr, arr1min, arr1max] =
+      sperr::calc_stats(orig.data(), coarse.data(), orig.size(), 1);
+  EXPECT_GT(psnr, 20.0);
+
+  // A volume whose chunks are transformed differently has no tiled coarse volume.
+  encoder.set_dims_and_chunks(dims, {40, 50, 20});
+  encoder.compress(input.data(), input.size());
+  stream = encoder.get_encoded_bitstream();
+  decoder.use_bitstream(stream.data(), stream.size());
+  ASSERT_EQ(decoder.decompress_coarse(stream.data(), 4), RTNType::Good);
+  EXPECT_TRUE(decoder.view_coarse_data().empty());
+  EXPECT_NEAR(decoder.get_mean_var()[0], mean, 1e-12);
+}
+
+TEST(sperr3d_coarse, constant)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/const32x20x16.float");
+  ASSERT_EQ(input.size(), 32 * 20 * 16);
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks({32, 20, 16}, {16, 10, 16});
+  encoder.set_psnr(99.0);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.use_bitstream(stream.data(), stream.size());
+  ASSERT_EQ(decoder.decompress_coarse(stream.data(), 5), RTNType::Good);
+  EXPECT_EQ(decoder.get_mean_var(), (std::array<double, 2>{input[0], 0.0}));
+  const auto& coarse = decoder.view_coarse_data();
+  ASSERT_FALSE(coarse.empty());
+  for (auto v : coarse)
+    EXPECT_EQ(v, input[0]);
+}
+
+TEST(sperr3d_dedup, repeated_chunks)
+{
+  // A 64x64x64 volume made of 8 copies of a 32^3 block, with one value changed in the last copy.
+  auto block = sperr::read_whole_file<float>("../test_data/wmag128.float");
+  ASSERT_EQ(block.size(), 128 * 128 * 128);
+  const auto dims = sperr::dims_type{64, 64, 64};
+  auto input = std::vector<float>(64 * 64 * 64);
+  for (size_t z = 0; z < 64; z++)
+    for (size_t y = 0; y < 64; y++)
+      for (size_t x = 0; x < 64; x++)
+        input[z * 64 * 64 + y * 64 + x] = block[(z % 32) * 128 * 128 + (y % 32) * 128 + x % 32];
+  input.back() += 1.0f;
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, {32, 32, 32});
+  encoder.set_psnr(90.0);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  auto plain = encoder.get_encoded_bitstream();
+  encoder.set_dedup_chunks(true);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+  EXPECT_EQ(stream.size(), encoder.encoded_bitstream_len());
+  EXPECT_LT(stream.size() * 3, plain.size());
+
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  auto header = tools.get_stream_header(stream.data());
+  EXPECT_EQ(header.stream_len, stream.size());
+  EXPECT_EQ(header.chunk_sources, (std::vector<size_t>{0, 0, 0, 0, 0, 0, 0, 7}));
+  EXPECT_TRUE(stream[0] & sperr::dedup_flag);
+  EXPECT_FALSE(plain[0] & sperr::dedup_flag);
+
+  // A reference to a later chunk is rejected.
+  auto bad = stream;
+  const auto bad_ref = sperr::chunk_ref_flag | uint32_t{7};
+  std::memcpy(bad.data() + 20 + 4, &bad_ref, sizeof(bad_ref));
+  EXPECT_TRUE(tools.get_stream_header(bad.data()).chunk_sources.empty());
+  EXPECT_NE(sperr::SPERR3D_OMP_D().use_bitstream(bad.data(), bad.size()), RTNType::Good);
+
+  // Decoding the deduplicated stream gives the same result.
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(2);
+  ASSERT_EQ(decoder.use_bitstream(plain.data(), plain.size()), RTNType::Good);
+  ASSERT_EQ(decoder.decompress(plain.data()), RTNType::Good);
+  const auto plain_out = decoder.view_decoded_data();
+  ASSERT_EQ(decoder.use_bitstream(stream.data(), stream.size()), RTNType::Good);
+  ASSERT_EQ(decoder.decompress(stream.data()), RTNType::Good);
+  EXPECT_EQ(decoder.view_decoded_data(), plain_out);
+  ASSERT_EQ(decoder.decompress(stream.data(), true), RTNType::Good);
+  EXPECT_EQ(decoder.view_decoded_data(), plain_out);
+
+  // Progressive access keeps a single copy of the shared bitstream.
+  auto trunc = tools.progressive_truncate(stream.data(), stream.size(), 30);
+  auto plain_trunc = tools.progressive_truncate(plain.data(), plain.size(), 30);
+  EXPECT_EQ(tools.get_stream_header(trunc.data()).stream_len, trunc.size());
+  EXPECT_LT(trunc.size() * 3, plain_trunc.size());
+  ASSERT_EQ(decoder.use_bitstream(plain_trunc.data(), plain_trunc.size()), RTNType::Good);
+  ASSERT_EQ(decoder.decompress(plain_trunc.data()), RTNType::Good);
+  const auto plain_trunc_out = decoder.view_decoded_data();
+  ASSERT_EQ(decoder.use_bitstream(trunc.data(), trunc.size()), RTNType::Good);
+  ASSERT_EQ(decoder.decompress(trunc.data()), RTNType::Good);
+  EXPECT_EQ(decoder.view_decoded_data(), plain_trunc_out);
+}
+
+TEST(sperr3d_constant, masked_chunks)
+{
+  // Mask the lower half of a volume with a constant, so that 3 of the 8 chunks are constant;
+  //    chunk 1 differs from the constant in a single value.
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  ASSERT_EQ(input.size(), 128 * 128 * 41);
+  const auto dims = sperr::dims_type{128, 128, 41};
+  std::fill(input.begin(), input.begin() + 128 * 128 * 20, -0.5f);
+  input[128 * 128 * 19 + 64] = 0.0f;
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, {64, 64, 20});
+  encoder.set_psnr(90.0);
+  encoder.set_num_threads(2);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+
+  // Constant chunks carry exactly what the compressor produces for them.
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  auto header = tools.get_stream_header(stream.data());
+  auto chunk = sperr::vecd_type(64 * 64 * 20, -0.5);
+  auto compressor = sperr::SPECK3D_FLT();
+  compressor.set_dims({64, 64, 20});
+  compressor.set_psnr(90.0);
+  compressor.copy_data(chunk.data(), chunk.size());
+  ASSERT_EQ(compressor.compress(), RTNType::Good);
+  auto const_stream = sperr::vec8_type();
+  compressor.append_encoded_bitstream(const_stream);
+  const auto chunk_len = [&header](size_t i) { return header.chunk_offsets[i * 2 + 1]; };
+  for (size_t i : {0, 2, 3}) {
+    ASSERT_EQ(chunk_len(i), const_stream.size()) << i;
+    EXPECT_TRUE(std::equal(const_stream.cbegin(), const_stream.cend(),
+                           stream.cbegin() + header.chunk_offsets[i * 2]));
+  }
+  EXPECT_GT(chunk_len(1), const_stream.size());
+  EXPECT_GT(chunk_len(5), const_stream.size());
+
+  // Decoded constant chunks are exact, in both single and multi-resolution decoding.
+  for (auto multi_res : {false, true}) {
+    auto decoder = sperr::SPERR3D_OMP_D();
+    decoder.set_num_threads(2);
+    ASSERT_EQ(decoder.use_bitstream(stream.data(), stream.size()), RTNType::Good);
+    auto output = std::vector<float>(input.size());
+    ASSERT_EQ(decoder.decompress_into(stream.data(), output.data(), multi_res), RTNType::Good);
+    for (size_t i = 0; i < 128 * 128 * 20; i++) {
+      const auto in_chunk1 = (i % 128 >= 64) && (i / 128 % 128 < 64);
+      if (!in_chunk1) {
+        ASSERT_EQ(output[i], -0.5f) << i;
+      }
+    }
+    auto [rmse, linfty, psnr, arr1min, arr1max] =
+        sperr::calc_stats(input.data(), output.data(), input.size(), 1);
+    EXPECT_GT(psnr, 89.0);
+  }
+}
+
+TEST(sperr3d_stream, concurrent_sessions)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  ASSERT_EQ(input.size(), 128 * 128 * 41);
+  const auto dims = sperr::dims_type{128, 128, 41};
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, {64, 64, 20});
+  encoder.set_psnr(90.0);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  auto bitstream = encoder.get_encoded_bitstream();
+  const auto filename = std::string("sperr3d_stream.tmp");
+  sperr::write_n_bytes(filename, bitstream.size(), bitstream.data());
+
+  // Reference results from a decoder working on its own.
+  auto decoder = sperr::SPERR3D_OMP_D();
+  ASSERT_EQ(decoder.use_bitstream(bitstream.data(), bitstream.size()), RTNType::Good);
+  ASSERT_EQ(decoder.decompress(bitstream.data(), true), RTNType::Good);
+  const auto full = decoder.release_decoded_data();
+  const auto hierarchy = decoder.release_hierarchy();
+
+  auto opened = std::make_shared<sperr::SPERR3D_Stream>();
+  ASSERT_EQ(opened->open_file(filename), RTNType::Good);
+  EXPECT_EQ(opened->size(), bitstream.size());
+  auto stream = std::shared_ptr<const sperr::SPERR3D_Stream>(opened);
+  auto pool = std::make_shared<sperr::Decoder_Pool>();
+
+  // Sessions in different threads decode full volumes, hierarchies, and regions at once.
+  const auto start = sperr::dims_type{30, 50, 10};
+  const auto size = sperr::dims_type{70, 40, 25};
+  auto fails = std::vector<int>(8, 0);
+  auto threads = std::vector<std::thread>();
+  for (size_t t = 0; t < fails.size(); t++) {
+    threads.emplace_back([&, t]() {
+      auto session = sperr::SPERR3D_OMP_D();
+      session.set_num_threads(2);
+      session.use_decoder_pool(pool);
+      if (session.use_stream(stream) != RTNType::Good)
+        fails[t]++;
+      for (size_t rep = 0; rep < 3; rep++) {
+        if (t % 2 == 0) {
+          if (session.decompress(stream->data(), t % 4 == 0) != RTNType::Good ||
+              session.view_decoded_data() != full)
+            fails[t]++;
+          if (t % 4 == 0 && session.view_hierarchy() != hierarchy)
+            fails[t]++;
+        }
+        else {
+          if (session.decompress_region(stream->data(), start, size) != RTNType::Good)
+            fails[t]++;
+          const auto& roi = session.view_decoded_data();
+          for (size_t z = 0; z < size[2]; z++)
+            for (size_t y = 0; y < size[1]; y++)
+              for (size_t x = 0; x < size[0]; x++) {
+                const auto big = ((z + start[2]) * 128 + y + start[1]) * 128 + x + start[0];
+                fails[t] += (roi[(z * size[1] + y) * size[0] + x] != full[big]);
+              }
+        }
+      }
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+  EXPECT_EQ(fails, std::vector<int>(fails.size(), 0));
+  EXPECT_GT(pool->num_idle(), 0);
+  EXPECT_LE(pool->num_idle(), fails.size() * 2);
+
+  // Regions outside of the volume, and bitstreams not in use, are rejected.
+  auto session = sperr::SPERR3D_OMP_D();
+  ASSERT_EQ(session.use_stream(stream), RTNType::Good);
+  EXPECT_EQ(session.decompress_region(stream->data(), {100, 0, 0}, {29, 1, 1}), RTNType::Error);
+  EXPECT_EQ(session.decompress_region(bitstream.data(), {0, 0, 0}, {1, 1, 1}), RTNType::Error);
+  std::remove(filename.data());
+}
+
+TEST(sperr3d_chunk_cache, requests)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/wmag128.float");
+  ASSERT_EQ(input.size(), 128 * 128 * 128);
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks({128, 128, 128}, {64, 64, 64});
+  encoder.set_psnr(80.0);
+  encoder.set_num_threads(4);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+  const auto filename = std::string("sperr3d_chunk_cache.tmp");
+  sperr::write_n_bytes(filename, stream.size(), stream.data());
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(4);
+  ASSERT_EQ(decoder.use_bitstream(stream.data(), stream.size()), RTNType::Good);
+  ASSERT_EQ(decoder.decompress(stream.data(), true), RTNType::Good);
+  const auto full = decoder.release_decoded_data();
+  const auto hierarchy = decoder.release_hierarchy();
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  auto trunc = tools.progressive_truncate(stream.data(), stream.size(), 30);
+  ASSERT_EQ(decoder.use_bitstream(trunc.data(), trunc.size()), RTNType::Good);
+  ASSERT_EQ(decoder.decompress(trunc.data()), RTNType::Good);
+  const auto trunc_full = decoder.release_decoded_data();
+
+  auto cache = sperr::SPERR3D_Chunk_Cache();
+  cache.set_num_threads(4);
+
+  // A region at the native resolution, twice. The second time, chunks come from the cache.
+  auto req = sperr::SPERR3D_Chunk_Cache::Request();
+  req.start = {10, 60, 30};
+  req.size = {100, 20, 50};
+  auto region = [](auto start, auto size, const auto& vol, auto dims) {
+    auto out = std::vector<double>(size[0] * size[1] * size[2]);
+    for (size_t z = 0; z < size[2]; z++)
+      for (size_t y = 0; y < size[1]; y++)
+        for (size_t x = 0; x < size[0]; x++)
+          out[(z * size[1] + y) * size[0] + x] =
+              vol[((z + start[2]) * dims[1] + y + start[1]) * dims[0] + x + start[0]];
+    return out;
+  };
+  auto out = std::vector<double>(100 * 20 * 50);
+  ASSERT_EQ(cache.decode(filename, req, out.data()), RTNType::Good);
+  EXPECT_EQ(out, region(req.start, req.size, full, sperr::dims_type{128, 128, 128}));
+  EXPECT_EQ(cache.get_counters().misses, 8);
+  ASSERT_EQ(cache.decode(filename, req, out.data()), RTNType::Good);
+  EXPECT_EQ(out, region(req.start, req.size, full, sperr::dims_type{128, 128, 128}));
+  EXPECT_EQ(cache.get_counters().hits, 8);
+  EXPECT_EQ(cache.get_counters().bytes, 128 * 128 * 128 * sizeof(double));
+
+  // A coarsened resolution, and a lower precision.
+  auto stream_p = std::shared_ptr<const sperr::SPERR3D_Stream>();
+  ASSERT_EQ(cache.open_file(filename, stream_p), RTNType::Good);
+  const auto coarse_dims = cache.level_dims(*stream_p, 2);
+  ASSERT_EQ(coarse_dims, (sperr::dims_type{32, 32, 32}));
+  EXPECT_EQ(cache.level_dims(*stream_p, 10), (sperr::dims_type{0, 0, 0}));
+  req.level = 2;
+  req.start = {0, 0, 0};
+  req.size = coarse_dims;
+  out.resize(32 * 32 * 32);
+  ASSERT_EQ(cache.decode(filename, req, out.data()), RTNType::Good);
+  EXPECT_EQ(out, hierarchy[hierarchy.size() - 2]);
+  req.level = 0;
+  req.pct = 30;
+  req.start = {64, 0, 0};
+  req.size = {64, 128, 128};
+  out.resize(64 * 128 * 128);
+  ASSERT_EQ(cache.decode(filename, req, out.data()), RTNType::Good);
+  EXPECT_EQ(out, region(req.start, req.size, trunc_full, sperr::dims_type{128, 128, 128}));
+  auto out_f = std::vector<float>(out.size());
+  ASSERT_EQ(cache.decode(filename, req, out_f.data()), RTNType::Good);
+  EXPECT_EQ(out_f, std::vector<float>(out.begin(), out.end()));
+
+  // Evictions, bad requests, and closing the file.
+  cache.set_capacity(64 * 64 * 64 * sizeof(double) * 3);
+  EXPECT_LE(cache.get_counters().bytes, 64 * 64 * 64 * sizeof(double) * 3);
+  req.size = {65, 128, 128};
+  EXPECT_EQ(cache.decode(filename, req, out.data()), RTNType::Error);
+  EXPECT_EQ(cache.decode("no_such_file", req, out.data()), RTNType::IOError);
+  cache.close_file(filename);
+  EXPECT_EQ(cache.get_counters().bytes, 0);
+  std::remove(filename.data());
+}
+
+TEST(sperr3d_decode_effort, caps)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+  auto [min, max] = std::minmax_element(input.cbegin(), input.cend());
+  const auto range = double(*max) - double(*min);
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, {64, 64, 41});
+  encoder.set_chunk_stats(true);
+  encoder.set_psnr(110.0);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(2);
+  ASSERT_EQ(decoder.use_bitstream(stream.data(), stream.size()), RTNType::Good);
+  auto psnr = [&](sperr::Decode_Effort effort) {
+    decoder.set_decode_effort(effort);
+    decoder.decompress(stream.data());
+    const auto& output = decoder.view_decoded_data();
+    auto sse = 0.0;
+    for (size_t i = 0; i < input.size(); i++)
+      sse += (output[i] - input[i]) * (output[i] - input[i]);
+    return 20.0 * std::log10(range) - 10.0 * std::log10(sse / double(input.size()));
+  };
+  const auto full = psnr({});
+  EXPECT_GT(full, 110.0);
+
+  // A target PSNR is met without decoding much more than needed; the range is in the index.
+  for (auto target : {50.0, 70.0, 90.0}) {
+    auto effort = sperr::Decode_Effort();
+    effort.psnr = target;
+    auto p = psnr(effort);
+    EXPECT_GE(p, target);
+    EXPECT_LT(p, target + 8.0);
+  }
+
+  // Fewer bitplanes, or fewer bits, give lower quality.
+  auto effort = sperr::Decode_Effort();
+  effort.bitplanes = 4;
+  const auto p4 = psnr(effort);
+  effort.bitplanes = 8;
+  const auto p8 = psnr(effort);
+  EXPECT_LT(p4, p8);
+  EXPECT_LT(p8, full);
+  effort = sperr::Decode_Effort();
+  effort.bit_fraction = 0.3;
+  const auto p30 = psnr(effort);
+  EXPECT_LT(p30, full);
+
+  // Capping the bits is at least as good as decoding a truncated copy of the bitstream.
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  auto trunc = tools.progressive_truncate(stream.data(), stream.size(), 30);
+  auto trunc_decoder = sperr::SPERR3D_OMP_D();
+  ASSERT_EQ(trunc_decoder.use_bitstream(trunc.data(), trunc.size()), RTNType::Good);
+  ASSERT_EQ(trunc_decoder.decompress(trunc.data()), RTNType::Good);
+  const auto& trunc_out = trunc_decoder.view_decoded_data();
+  auto sse = 0.0;
+  for (size_t i = 0; i < input.size(); i++)
+    sse += (trunc_out[i] - input[i]) * (trunc_out[i] - input[i]);
+  EXPECT_GE(p30, 20.0 * std::log10(range) - 10.0 * std::log10(sse / double(input.size())));
+
+  // No caps decode the same as before.
+  EXPECT_EQ(psnr({}), full);
+}
+
+TEST(sperr3d_predict, sampled_chunks)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/wmag91.float");
+  const auto dims = sperr::dims_type{91, 91, 91};
+  const auto total_vals = input.size();
+  auto [min, max] = std::minmax_element(input.cbegin(), input.cend());
+  const auto range = double(*max) - double(*min);
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_num_threads(4);
+  encoder.set_dims_and_chunks(dims, {32, 32, 32});
+  auto actual = [&](auto mode, double quality) {
+    if (mode == sperr::CompMode::PSNR)
+      encoder.set_psnr(quality);
+    else if (mode == sperr::CompMode::Rate)
+      encoder.set_bitrate(quality);
+    else
+      encoder.set_tolerance(quality);
+    encoder.compress(input.data(), total_vals);
+    auto stream = encoder.get_encoded_bitstream();
+    auto decoder = sperr::SPERR3D_OMP_D();
+    decoder.use_bitstream(stream.data(), stream.size());
+    decoder.decompress(stream.data());
+    const auto& output = decoder.view_decoded_data();
+    auto sse = 0.0;
+    for (size_t i = 0; i < total_vals; i++)
+      sse += (output[i] - input[i]) * (output[i] - input[i]);
+    auto psnr = 20.0 * std::log10(range) - 10.0 * std::log10(sse / double(total_vals));
+    return std::pair{double(stream.size()), psnr};
+  };
+
+  // Sampling all chunks leaves no sampling error.
+  const auto psnrs = std::vector<double>{60.0, 90.0};
+  auto pred = encoder.predict(input.data(), total_vals, sperr::CompMode::PSNR, psnrs, 1.0);
+  ASSERT_EQ(pred.size(), psnrs.size());
+  for (size_t i = 0; i < psnrs.size(); i++) {
+    auto [bytes, psnr] = actual(sperr::CompMode::PSNR, psnrs[i]);
+    EXPECT_EQ(pred[i].bytes_err, 0.0);
+    EXPECT_NEAR(pred[i].bytes, bytes, bytes * 0.03);
+    EXPECT_NEAR(pred[i].psnr, psnr, 0.5);
+  }
+
+  // A sample of chunks is within a few standard errors.
+  const auto tols = std::vector<double>{range * 1e-3, range * 1e-5};
+  pred = encoder.predict(input.data(), total_vals, sperr::CompMode::PWE, tols, 0.1);
+  ASSERT_EQ(pred.size(), tols.size());
+  for (size_t i = 0; i < tols.size(); i++) {
+    auto [bytes, psnr] = actual(sperr::CompMode::PWE, tols[i]);
+    EXPECT_GT(pred[i].bytes_err, 0.0);
+    EXPECT_NEAR(pred[i].bytes, bytes, pred[i].bytes_err * 3.0 + bytes * 0.03);
+    EXPECT_NEAR(pred[i].psnr, psnr, pred[i].psnr_err * 3.0 + 0.5);
+  }
+
+  // In Rate mode, the size is about the requested bitrate.
+  const auto rates = std::vector<double>{2.0};
+  pred = encoder.predict(input.data(), total_vals, sperr::CompMode::Rate, rates, 0.1);
+  ASSERT_EQ(pred.size(), rates.size());
+  for (size_t i = 0; i < rates.size(); i++) {
+    auto [bytes, psnr] = actual(sperr::CompMode::Rate, rates[i]);
+    EXPECT_NEAR(pred[i].bytes, bytes, bytes * 0.03);
+    EXPECT_NEAR(pred[i].psnr, psnr, pred[i].psnr_err * 3.0 + 0.5);
+  }
+
+  EXPECT_TRUE(encoder.predict(input.data(), total_vals - 1, sperr::CompMode::PSNR, psnrs).empty());
+}
+
+TEST(sperr3d_predict, lossless)
+{
+  // Constant data is reconstructed exactly, and the predicted PSNR stays finite.
+  auto input = sperr::read_whole_file<float>("../test_data/const32x32x59.float");
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_num_threads(4);
+  encoder.set_dims_and_chunks({32, 32, 59}, {32, 32, 32});
+  const auto tols = std::vector<double>{1e-3};
+  const auto pred = encoder.predict(input.data(), input.size(), sperr::CompMode::PWE, tols, 1.0);
+  ASSERT_EQ(pred.size(), tols.size());
+  EXPECT_TRUE(std::isfinite(pred[0].psnr));
+  EXPECT_EQ(pred[0].psnr_err, 0.0);
+}
+
 }  // anonymous namespace
@@ -293,4 +293,41 @@ TEST(sperr_helper, read_sections)
   EXPECT_EQ(buf, buf2);
 }
 
+TEST(sperr_helper, data_types)
+{
+  // Half precision values
+  const auto halves = std::array<std::pair<uint16_t, double>, 7>{
+      {{0x3c00, 1.0}, {0xc000, -2.0}, {0x7bff, 65504.0}, {0x0001, 5.960464477539063e-8},
+       {0x3555, 0.333251953125}, {0x0000, 0.0}, {0x7c00, std::numeric_limits<double>::infinity()}}};
+  for (auto [bits, val] : halves) {
+    EXPECT_EQ(sperr::to_double(sperr::fp16_type{bits}), val);
+    EXPECT_EQ(sperr::from_double<sperr::fp16_type>(val).bits, bits);
+  }
+  EXPECT_EQ(sperr::from_double<sperr::fp16_type>(1.0 / 3.0).bits, 0x3555);
+  EXPECT_EQ(sperr::from_double<sperr::fp16_type>(1e6).bits, 0x7c00);
+  EXPECT_TRUE(std::isnan(sperr::to_double(sperr::fp16_type{0x7e00})));
+
+  // Bfloat16 values
+  EXPECT_EQ(sperr::to_double(sperr::bf16_type{0x3f80}), 1.0);
+  EXPECT_EQ(sperr::to_double(sperr::bf16_type{0xc040}), -3.0);
+  EXPECT_EQ(sperr::from_double<sperr::bf16_type>(1.0).bits, 0x3f80);
+  EXPECT_EQ(sperr::from_double<sperr::bf16_type>(1.0 / 3.0).bits, 0x3eab);
+
+  // Integers are rounded and clamped.
+  EXPECT_EQ(sperr::from_double<int8_t>(-200.0), -128);
+  EXPECT_EQ(sperr::from_double<uint8_t>(-1.0), 0);
+  EXPECT_EQ(sperr::from_double<uint16_t>(1.6), 2);
+  EXPECT_EQ(sperr::from_double<int32_t>(-2.4), -2);
+
+  // Data types survive the header booleans.
+  for (auto t : {sperr::DataType::Float, sperr::DataType::Double, sperr::DataType::FP16,
+                 sperr::DataType::BF16, sperr::DataType::Int8, sperr::DataType::UInt8,
+                 sperr::DataType::Int16, sperr::DataType::UInt16, sperr::DataType::Int32}) {
+    auto b8 = std::array<bool, 8>{false, true, false, true, false, false, false, false};
+    sperr::encode_data_type(t, b8);
+    EXPECT_EQ(sperr::decode_data_type(sperr::unpack_8_booleans(sperr::pack_8_booleans(b8))), t);
+    EXPECT_EQ(b8[2], t != sperr::DataType::Double && t != sperr::DataType::Int32);
+  }
+}
+
 }  // namespace
@@ -1,4 +1,5 @@
 #include "SPERR3D_OMP_C.h"
+#include "SPERR3D_OMP_D.h"
 #include "SPERR3D_Stream_Tools.h"
 
 #include "gtest/gtest.h"
@@ -183,4 +184,157 @@ TEST(stream_tools, min_chunk_len)
   EXPECT_EQ(trunc, part);
 }
 
+TEST(stream_tools, chunk_stats)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  assert(!input.empty());
+  const auto dims = sperr::dims_type{128, 128, 41};
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, {31, 40, 21});
+  encoder.set_psnr(100.0);
+  encoder.compress(input.data(), input.size());
+  auto plain = encoder.get_encoded_bitstream();
+  encoder.set_chunk_stats(true);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+  EXPECT_EQ(stream.size(), encoder.encoded_bitstream_len());
+
+  // The index should describe each chunk exactly, and leave the chunk bitstreams untouched.
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  EXPECT_FALSE(tools.query_threshold(plain.data(), 0.0));
+  auto header = tools.get_stream_header(stream.data());
+  auto plain_header = tools.get_stream_header(plain.data());
+  const auto chunks = sperr::chunk_volume(dims, {31, 40, 21});
+  ASSERT_TRUE(header.has_stats);
+  ASSERT_EQ(header.chunk_stats.size(), chunks.size());
+  EXPECT_EQ(header.header_len, plain_header.header_len + chunks.size() * 32);
+  EXPECT_EQ(header.stream_len, stream.size());
+  for (size_t i = 0; i < chunks.size(); i++) {
+    const auto& c = chunks[i];
+    auto vals = sperr::vecd_type();
+    for (size_t z = c[4]; z < c[4] + c[5]; z++)
+      for (size_t y = c[2]; y < c[2] + c[3]; y++)
+        for (size_t x = c[0]; x < c[0] + c[1]; x++)
+          vals.push_back(input[z * dims[0] * dims[1] + y * dims[0] + x]);
+    auto [mean, var] = sperr::calc_mean_var(vals.data(), vals.size(), 1);
+    EXPECT_EQ(header.chunk_stats[i].min, *std::min_element(vals.cbegin(), vals.cend()));
+    EXPECT_EQ(header.chunk_stats[i].max, *std::max_element(vals.cbegin(), vals.cend()));
+    EXPECT_DOUBLE_EQ(header.chunk_stats[i].mean, mean);
+    EXPECT_DOUBLE_EQ(header.chunk_stats[i].var, var);
+    const auto* beg = stream.data() + header.chunk_offsets[i * 2];
+    EXPECT_TRUE(std::equal(beg, beg + header.chunk_offsets[i * 2 + 1],
+                           plain.data() + plain_header.chunk_offsets[i * 2]));
+  }
+
+  // Range query over the whole volume is settled by the index alone.
+  auto range = tools.query_range(stream.data(), {0, 0, 0}, dims);
+  ASSERT_TRUE(range);
+  EXPECT_EQ(range->min, *std::min_element(input.cbegin(), input.cend()));
+  EXPECT_EQ(range->max, *std::max_element(input.cbegin(), input.cend()));
+  EXPECT_TRUE(range->to_decode.empty());
+
+  // A box inside of the first chunk needs to decode it.
+  range = tools.query_range(stream.data(), {1, 1, 1}, {4, 4, 4});
+  ASSERT_TRUE(range);
+  EXPECT_EQ(range->to_decode, std::vector<size_t>{0});
+  EXPECT_EQ(range->min, header.chunk_stats[0].min);
+  EXPECT_FALSE(tools.query_range(stream.data(), {100, 0, 0}, {29, 1, 1}));
+
+  // Threshold query: every chunk is classified correctly.
+  const auto thld = header.chunk_stats[0].max;
+  auto result = tools.query_threshold(stream.data(), thld);
+  ASSERT_TRUE(result);
+  EXPECT_EQ(std::find(result->to_decode.cbegin(), result->to_decode.cend(), 0),
+            result->to_decode.cend());
+  for (size_t i = 0; i < chunks.size(); i++) {
+    const auto& stats = header.chunk_stats[i];
+    auto above = std::find(result->above.cbegin(), result->above.cend(), i) != result->above.cend();
+    auto decode = std::find(result->to_decode.cbegin(), result->to_decode.cend(), i) !=
+                  result->to_decode.cend();
+    EXPECT_EQ(above, stats.min > thld);
+    EXPECT_EQ(decode, stats.min <= thld && stats.max > thld);
+  }
+
+  // Progressive access keeps the index, and the decoder is not affected by it.
+  auto trunc = tools.progressive_truncate(stream.data(), stream.size(), 50);
+  auto trunc_header = tools.get_stream_header(trunc.data());
+  EXPECT_EQ(trunc_header.header_len, header.header_len);
+  EXPECT_EQ(trunc_header.stream_len, trunc.size());
+  EXPECT_EQ(trunc_header.chunk_stats[3].var, header.chunk_stats[3].var);
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  ASSERT_EQ(decoder.use_bitstream(stream.data(), stream.size()), RTNType::Good);
+  ASSERT_EQ(decoder.decompress(stream.data()), RTNType::Good);
+  auto plain_decoder = sperr::SPERR3D_OMP_D();
+  plain_decoder.use_bitstream(plain.data(), plain.size());
+  plain_decoder.decompress(plain.data());
+  EXPECT_EQ(decoder.view_decoded_data(), plain_decoder.view_decoded_data());
+}
+
+TEST(stream_tools, super_chunks)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  assert(!input.empty());
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto stripe = size_t{4096};
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, {31, 40, 21});
+  encoder.set_psnr(100.0);
+  encoder.compress(input.data(), input.size());
+  auto plain = encoder.get_encoded_bitstream();
+  EXPECT_EQ(encoder.set_super_chunks({2, 70'000, 1}, stripe), RTNType::Error);
+  EXPECT_EQ(encoder.set_super_chunks({2, 2, 1}, size_t{1} << 33), RTNType::Error);
+  EXPECT_EQ(encoder.set_super_chunks({2, 2, 1}, stripe), RTNType::Good);
+  auto stream = encoder.get_encoded_bitstream();
+  EXPECT_EQ(stream.size(), encoder.encoded_bitstream_len());
+
+  // 4 x 3 x 2 chunks make 2 x 2 x 2 super-chunks, each starting at a multiple of the stripe.
+  auto tools = sperr::SPERR3D_Stream_Tools();
+  auto header = tools.get_stream_header(stream.data());
+  auto plain_header = tools.get_stream_header(plain.data());
+  ASSERT_TRUE(header.super_chunks);
+  EXPECT_EQ(header.major_version, plain[0]);
+  EXPECT_EQ(header.stripe, stripe);
+  EXPECT_EQ(header.header_len, plain_header.header_len + 10);
+  EXPECT_EQ(header.stream_len, stream.size());
+  ASSERT_EQ(header.super_offsets.size(), 8 * 2);
+  for (size_t s = 0; s < 8; s++)
+    EXPECT_EQ(header.super_offsets[s * 2] % stripe, 0);
+  const auto supers = sperr::super_chunk_volume(dims, header.chunk_dims, {2, 2, 1});
+  EXPECT_EQ(supers[0], (std::vector<size_t>{0, 1, 4, 5}));
+  EXPECT_EQ(supers[3], (std::vector<size_t>{10, 11}));
+
+  // Chunk bitstreams are the same, only moved.
+  for (size_t i = 0; i < header.chunk_sources.size(); i++) {
+    const auto* beg = stream.data() + header.chunk_offsets[i * 2];
+    ASSERT_EQ(header.chunk_offsets[i * 2 + 1], plain_header.chunk_offsets[i * 2 + 1]);
+    EXPECT_TRUE(std::equal(beg, beg + header.chunk_offsets[i * 2 + 1],
+                           plain.data() + plain_header.chunk_offsets[i * 2]));
+  }
+
+  // A box in the first chunk reads its super-chunk, and a slab in the lower half of Z reads the
+  //    first 4 super-chunks in one read.
+  auto sections = tools.region_sections(stream.data(), {1, 1, 1}, {4, 4, 4});
+  EXPECT_EQ(sections, (std::vector<size_t>{header.super_offsets[0], header.super_offsets[1]}));
+  sections = tools.region_sections(stream.data(), {0, 0, 0}, {128, 128, 10});
+  ASSERT_EQ(sections.size(), 2);
+  EXPECT_EQ(sections[0], header.super_offsets[0]);
+  EXPECT_EQ(sections[0] + sections[1], header.super_offsets[6] + header.super_offsets[7]);
+  sections = tools.region_sections(plain.data(), {1, 1, 1}, {4, 4, 4});
+  EXPECT_EQ(sections, (std::vector<size_t>{plain_header.chunk_offsets[0],
+                                           plain_header.chunk_offsets[1]}));
+
+  // Decoding gives the same volume, and progressive access gives plain bitstreams.
+  auto decoder = sperr::SPERR3D_OMP_D();
+  ASSERT_EQ(decoder.use_bitstream(stream.data(), stream.size()), RTNType::Good);
+  ASSERT_EQ(decoder.decompress(stream.data()), RTNType::Good);
+  auto plain_decoder = sperr::SPERR3D_OMP_D();
+  plain_decoder.use_bitstream(plain.data(), plain.size());
+  plain_decoder.decompress(plain.data());
+  EXPECT_EQ(decoder.view_decoded_data(), plain_decoder.view_decoded_data());
+  EXPECT_EQ(tools.progressive_truncate(stream.data(), stream.size(), 100), plain);
+  EXPECT_EQ(tools.progressive_truncate(stream.data(), stream.size(), 35),
+            tools.progressive_truncate(plain.data(), plain.size(), 35));
+}
+
 }  // anonymous namespace
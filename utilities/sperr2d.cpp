@@ -156,6 +156,12 @@ int main(int argc, char* argv[])
       ->needs(cptr)
       ->group("Output settings");
 
+  auto print_profile = bool{false};
+  app.add_flag("--profile", print_profile,
+               "Print a per-stage timing breakdown.\n"
+               "(Only available when SPERR is built with SPERR_INSTRUMENT=ON.)")
+      ->group("Output settings");
+
   //
   // Compression settings
   //
@@ -266,6 +272,8 @@ int main(int argc, char* argv[])
       std::cout << "Compression failed!" << std::endl;
       return __LINE__ % 256;
     }
+    if (print_profile)
+      std::cout << "Compression profile:\n" << encoder->view_profile().to_string();
 
     // Assemble the output bitstream.
     auto stream = sperr::vec8_type(header_len);
@@ -306,6 +314,8 @@ int main(int argc, char* argv[])
         std::cout << "Decompression failed!" << std::endl;
         return __LINE__ % 256;
       }
+      if (print_profile)
+        std::cout << "Decompression profile:\n" << decoder->view_profile().to_string();
 
       // Save the decompressed data, and then deconstruct the decoder to free up some memory!
       auto hierarchy = decoder->release_hierarchy();
@@ -374,6 +384,11 @@ int main(int argc, char* argv[])
       std::cout << "This bitstream appears to represent a 3D volume!" << std::endl;
       return __LINE__ % 256;
     }
+    if (booleans[4] || booleans[5] || booleans[6]) {
+      std::cout << "This bitstream appears to be a 1D array, a stack, or a chunked 2D slice!"
+                << std::endl;
+      return __LINE__ % 256;
+    }
 
     // Retrieve the slice dimension from the header.
     std::memcpy(dim2d.data(), input.data() + 2, sizeof(dim2d));
@@ -387,6 +402,8 @@ int main(int argc, char* argv[])
       std::cout << "Decompression failed!" << std::endl;
       return __LINE__ % 256;
     }
+    if (print_profile)
+      std::cout << "Decompression profile:\n" << decoder->view_profile().to_string();
 
     // Save the decompressed data, and then deconstruct the decoder to free up some memory!
     auto hierarchy = decoder->release_hierarchy();
@@ -167,6 +167,12 @@ int main(int argc, char* argv[])
       ->needs(cptr)
       ->group("Output settings");
 
+  auto print_profile = bool{false};
+  app.add_flag("--profile", print_profile,
+               "Print a per-stage timing breakdown.\n"
+               "(Only available when SPERR is built with SPERR_INSTRUMENT=ON.)")
+      ->group("Output settings");
+
   //
   // Compression settings
   //
@@ -291,6 +297,8 @@ int main(int argc, char* argv[])
       std::cout << "Compression failed!" << std::endl;
       return __LINE__ % 256;
     }
+    if (print_profile)
+      std::cout << "Compression profile:\n" << encoder->view_profile().to_string();
 
     // If not calculating stats, we can free up some memory now!
     if (!print_stats) {
@@ -323,6 +331,8 @@ int main(int argc, char* argv[])
         std::cout << "Decompression failed!" << std::endl;
         return __LINE__ % 256;
       }
+      if (print_profile)
+        std::cout << "Decompression profile:\n" << decoder->view_profile().to_string();
 
       // Save the decompressed data, and then deconstruct the decoder to free up some memory!
       auto outputd = decoder->release_decoded_data();
@@ -389,6 +399,8 @@ int main(int argc, char* argv[])
       std::cout << "Decompression failed!" << std::endl;
       return __LINE__ % 256;
     }
+    if (print_profile)
+      std::cout << "Decompression profile:\n" << decoder->view_profile().to_string();
 
     auto hierarchy = decoder->release_hierarchy();
     auto outputd = decoder->release_decoded_data();
@@ -0,0 +1,309 @@
+//
+// A long-running decode daemon of 3D SPERR bitstreams on an analysis node. It keeps opened files
+// memory-mapped and their decoded chunks cached, and answers requests of many client processes
+// over a Unix domain socket, handing over decoded regions in shared memory.
+// See sperrd_protocol.h for the messages.
+//
+
+#include "SPERR3D_Chunk_Cache.h"
+#include "sperrd_protocol.h"
+
+#include "CLI/App.hpp"
+#include "CLI/Config.hpp"
+#include "CLI/Formatter.hpp"
+
+#include <atomic>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <semaphore>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+auto socket_path = std::string();
+auto root_path = std::filesystem::path();  // Empty means any file that the daemon can read.
+
+void on_signal(int)
+{
+  ::unlink(socket_path.data());
+  std::_Exit(0);
+}
+
+auto recv_exact(int sock, void* buf, size_t len) -> bool
+{
+  auto* p = static_cast<char*>(buf);
+  while (len > 0) {
+    auto n = ::recv(sock, p, len, 0);
+    if (n <= 0)
+      return false;
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+// Send a reply, with a file descriptor attached if `fd` is not negative.
+auto send_reply(int sock, sperrd::Reply reply, int fd) -> bool
+{
+  auto iov = iovec{&reply, sizeof(reply)};
+  auto msg = msghdr{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(int))] = {};
+  if (fd >= 0) {
+    msg.msg_control = ctrl;
+    msg.msg_controllen = sizeof(ctrl);
+    auto* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+  }
+  return ::sendmsg(sock, &msg, 0) == static_cast<ssize_t>(sizeof(reply));
+}
+
+// Only serve processes of the same user, so the daemon never reads files for anyone else.
+auto peer_allowed(int sock) -> bool
+{
+#ifdef SO_PEERCRED
+  auto cred = ucred{};
+  auto len = socklen_t{sizeof(cred)};
+  return ::getsockopt(sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 &&
+         cred.uid == ::geteuid();
+#else
+  auto uid = uid_t{0};
+  auto gid = gid_t{0};
+  return ::getpeereid(sock, &uid, &gid) == 0 && uid == ::geteuid();
+#endif
+}
+
+// With `--root`, a file name is resolved and has to be under the root directory.
+auto path_allowed(std::string& filename) -> bool
+{
+  if (root_path.empty())
+    return true;
+  auto ec = std::error_code();
+  const auto path = std::filesystem::weakly_canonical(filename, ec);
+  if (ec)
+    return false;
+  const auto rel = path.lexically_relative(root_path);
+  if (rel.empty() || *rel.begin() == "..")
+    return false;
+  filename = path.string();
+  return true;
+}
+
+// Create an anonymous shared memory object of `len` bytes, and map it.
+auto create_shm(size_t len, int& fd) -> void*
+{
+  static auto counter = std::atomic<uint64_t>{0};
+  const auto name = "/sperrd." + std::to_string(::getpid()) + "." + std::to_string(counter++);
+  fd = ::shm_open(name.data(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+    return nullptr;
+  ::shm_unlink(name.data());  // Only the file descriptor is passed around.
+  if (::ftruncate(fd, static_cast<off_t>(len)) != 0) {
+    ::close(fd);
+    return nullptr;
+  }
+  auto* p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    ::close(fd);
+    return nullptr;
+  }
+  return p;
+}
+
+auto handle(sperr::SPERR3D_Chunk_Cache& cache, const sperrd::Request& req, std::string filename)
+    -> std::pair<sperrd::Reply, int>
+{
+  auto reply = sperrd::Reply();
+  auto fail = [&reply](sperr::RTNType rtn) {
+    reply.status = static_cast<int32_t>(rtn);
+    return std::pair{reply, -1};
+  };
+
+  switch (static_cast<sperrd::Op>(req.op)) {
+    case sperrd::Op::Stats: {
+      const auto counters = cache.get_counters();
+      reply.cache_hits = counters.hits;
+      reply.cache_misses = counters.misses;
+      reply.cache_bytes = counters.bytes;
+      return {reply, -1};
+    }
+    case sperrd::Op::Close:
+      cache.close_file(filename);
+      return {reply, -1};
+    case sperrd::Op::Info: {
+      auto stream = std::shared_ptr<const sperr::SPERR3D_Stream>();
+      auto rtn = cache.open_file(filename, stream);
+      if (rtn != sperr::RTNType::Good)
+        return fail(rtn);
+      const auto& header = stream->view_header();
+      const auto dims = cache.level_dims(*stream, req.level);
+      std::copy(dims.cbegin(), dims.cend(), reply.dims);
+      std::copy(header.chunk_dims.cbegin(), header.chunk_dims.cend(), reply.chunk_dims);
+      reply.num_levels = sperr::coarsened_resolutions(header.vol_dims, header.chunk_dims).size();
+      reply.data_type = static_cast<uint32_t>(header.data_type);
+      return {reply, -1};
+    }
+    case sperrd::Op::Decode: {
+      auto creq = sperr::SPERR3D_Chunk_Cache::Request();
+      std::copy(req.start, req.start + 3, creq.start.begin());
+      std::copy(req.size, req.size + 3, creq.size.begin());
+      creq.level = req.level;
+      creq.pct = req.pct;
+
+      // The region has to be inside the volume, and its size in bytes representable, before
+      //    any memory is allocated for it.
+      auto stream = std::shared_ptr<const sperr::SPERR3D_Stream>();
+      auto rtn = cache.open_file(filename, stream);
+      if (rtn != sperr::RTNType::Good)
+        return fail(rtn);
+      const auto dims = cache.level_dims(*stream, creq.level);
+      const auto is_float = static_cast<sperrd::Out>(req.out_type) == sperrd::Out::Float;
+      auto bytes = is_float ? sizeof(float) : sizeof(double);
+      for (size_t i = 0; i < 3; i++) {
+        const auto n = creq.size[i];
+        if (n == 0 || creq.start[i] > dims[i] || n > dims[i] - creq.start[i] ||
+            n > std::numeric_limits<size_t>::max() / bytes)
+          return fail(sperr::RTNType::Error);
+        bytes *= n;
+      }
+
+      int fd = -1;
+      auto* buf = create_shm(bytes, fd);
+      if (buf == nullptr)
+        return fail(sperr::RTNType::IOError);
+      rtn = is_float ? cache.decode(filename, creq, static_cast<float*>(buf))
+                     : cache.decode(filename, creq, static_cast<double*>(buf));
+      ::munmap(buf, bytes);
+      if (rtn != sperr::RTNType::Good) {
+        ::close(fd);
+        return fail(rtn);
+      }
+      std::copy(creq.size.cbegin(), creq.size.cend(), reply.dims);
+      reply.payload_bytes = bytes;
+      return {reply, fd};
+    }
+    default:
+      return fail(sperr::RTNType::Error);
+  }
+}
+
+void serve(sperr::SPERR3D_Chunk_Cache& cache, int sock)
+{
+  auto req = sperrd::Request();
+  const auto allowed = peer_allowed(sock);
+  while (allowed && recv_exact(sock, &req, sizeof(req))) {
+    if (req.magic != sperrd::magic || req.path_len > 4096)
+      break;
+    auto filename = std::string(req.path_len, '\0');
+    if (!recv_exact(sock, filename.data(), filename.size()))
+      break;
+    auto [reply, fd] = std::pair{sperrd::Reply(), -1};
+    if (static_cast<sperrd::Op>(req.op) == sperrd::Op::Stats || path_allowed(filename))
+      std::tie(reply, fd) = handle(cache, req, std::move(filename));
+    else
+      reply.status = static_cast<int32_t>(sperr::RTNType::IOError);
+    auto sent = send_reply(sock, reply, fd);
+    if (fd >= 0)
+      ::close(fd);
+    if (!sent)
+      break;
+  }
+  ::close(sock);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  // Parse command line options
+  CLI::App app(
+      "A decode daemon of 3D SPERR bitstreams, which keeps files opened and decoded chunks\n"
+      "cached, and serves requests of local clients over a Unix domain socket.\n");
+
+  app.add_option("--socket", socket_path, "Path of the Unix domain socket to listen on.")
+      ->required();
+
+  auto cache_mb = size_t{1024};
+  app.add_option("--cache", cache_mb, "Megabytes of decoded chunks to keep. Default is 1024.");
+
+  auto max_clients = size_t{16};
+  app.add_option("--clients", max_clients,
+                 "Number of client connections served at the same time; more connections wait\n"
+                 "until one closes. Default is 16.")
+      ->check(CLI::PositiveNumber);
+
+  auto root = std::string();
+  app.add_option("--root", root, "Only serve files under this directory.")
+      ->check(CLI::ExistingDirectory);
+
+  auto omp_num_threads = size_t{0};  // meaning to use the maximum number of threads.
+#ifdef USE_OMP
+  app.add_option("--omp", omp_num_threads,
+                 "Number of OpenMP threads decoding each request. Default (or 0) to use all.");
+#endif
+
+  CLI11_PARSE(app, argc, argv);
+
+  if (!root.empty())
+    root_path = std::filesystem::canonical(root);
+
+  auto addr = sockaddr_un{};
+  addr.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(addr.sun_path)) {
+    std::cerr << "Socket path too long: " << socket_path << std::endl;
+    return __LINE__;
+  }
+  std::strcpy(addr.sun_path, socket_path.data());
+
+  // The socket is only accessible to the owner, whatever the umask is.
+  auto listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ::unlink(socket_path.data());
+  if (listener < 0 || ::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      ::chmod(socket_path.data(), S_IRUSR | S_IWUSR) != 0 || ::listen(listener, 64) != 0) {
+    std::cerr << "Cannot listen on " << socket_path << ": " << std::strerror(errno) << std::endl;
+    return __LINE__;
+  }
+  std::signal(SIGPIPE, SIG_IGN);  // A client going away only ends its own connection.
+  std::signal(SIGINT, on_signal);
+  std::signal(SIGTERM, on_signal);
+
+  auto cache = sperr::SPERR3D_Chunk_Cache();
+  cache.set_capacity(cache_mb * 1024 * 1024);
+  cache.set_num_threads(omp_num_threads);
+
+  // Each client connection is served by its own thread, and at most `max_clients` of them
+  //    exist at the same time. Further connections wait in the listening queue.
+  auto slots = std::counting_semaphore<>(static_cast<std::ptrdiff_t>(max_clients));
+  while (true) {
+    slots.acquire();
+    auto sock = ::accept(listener, nullptr, nullptr);
+    if (sock < 0) {
+      slots.release();
+      if (errno == EINTR)
+        continue;
+      std::cerr << "accept() failed: " << std::strerror(errno) << std::endl;
+      break;
+    }
+    std::thread([&cache, &slots, sock]() {
+      serve(cache, sock);
+      slots.release();
+    }).detach();
+  }
+
+  ::unlink(socket_path.data());
+  return 0;
+}
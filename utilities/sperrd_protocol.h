@@ -0,0 +1,59 @@
+//
+// Messages between the `sperrd` decode daemon and its clients over a Unix domain socket.
+//
+// A client sends a `Request` followed by `path_len` bytes of a file name (better an absolute
+// path), and receives a `Reply`. A connection can carry any number of requests in turn.
+// Only clients of the same user as the daemon are served, and with `--root`, only files under
+// that directory. For `Op::Decode`, the decoded region is in a shared memory object whose file
+// descriptor is attached to the reply (SCM_RIGHTS); the client maps `payload_bytes` bytes of it,
+// and then closes the descriptor. All fields are in the native byte order, as both ends are on
+// one node.
+//
+
+#ifndef SPERRD_PROTOCOL_H
+#define SPERRD_PROTOCOL_H
+
+#include <cstdint>
+
+namespace sperrd {
+
+constexpr uint32_t magic = 0x44525053;  // "SPRD"
+
+enum class Op : uint32_t {
+  Info = 0,    // Dimensions of a file at a resolution level, and its number of levels.
+  Decode = 1,  // Decode a region at a resolution level and precision.
+  Close = 2,   // Forget a file and its decoded chunks, e.g., after it changed on disk.
+  Stats = 3    // Cache hits, misses, and bytes of decoded chunks. No file name needed.
+};
+
+enum class Out : uint32_t { Float = 0, Double = 1 };
+
+struct Request {
+  uint32_t magic = sperrd::magic;
+  uint32_t op = 0;                // `Op`
+  uint64_t start[3] = {0, 0, 0};  // Region, in the dimensions of `level`.
+  uint64_t size[3] = {0, 0, 0};
+  uint32_t level = 0;     // Coarsening steps from the native resolution.
+  uint32_t pct = 100;     // Percentage of each chunk bitstream to decode.
+  uint32_t out_type = 0;  // `Out`
+  uint32_t path_len = 0;
+};
+
+struct Reply {
+  uint32_t magic = sperrd::magic;
+  int32_t status = 0;            // `sperr::RTNType`, with 0 being good.
+  uint64_t dims[3] = {0, 0, 0};  // Info: volume at `level`; Decode: region.
+  uint64_t chunk_dims[3] = {0, 0, 0};
+  uint32_t num_levels = 0;  // Number of coarsened resolutions available.
+  uint32_t data_type = 0;   // `sperr::DataType` of the original data.
+  uint64_t payload_bytes = 0;
+  uint64_t cache_hits = 0;    // Stats: chunk lookups answered by the cache,
+  uint64_t cache_misses = 0;  // lookups that decoded chunks,
+  uint64_t cache_bytes = 0;   // and bytes of decoded chunks kept.
+};
+
+static_assert(sizeof(Request) == 72 && sizeof(Reply) == 96);
+
+}  // namespace sperrd
+
+#endif